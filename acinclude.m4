@@ -268,6 +268,20 @@ AC_DEFUN([OFP_CHECK_IF_PACKET],
                 [Define to 1 if net/if_packet.h is available.])
    fi])
 
+dnl Checks for AF_XDP socket and XDP program (BPF link) support.
+AC_DEFUN([OFP_CHECK_AF_XDP],
+  [AC_CHECK_DECL([BPF_LINK_CREATE],
+                 [HAVE_AF_XDP=yes],
+                 [HAVE_AF_XDP=no],
+                 [#include <linux/bpf.h>
+   #include <linux/if_xdp.h>
+   ])
+   AM_CONDITIONAL([HAVE_AF_XDP], [test "$HAVE_AF_XDP" = yes])
+   if test "$HAVE_AF_XDP" = yes; then
+      AC_DEFINE([HAVE_AF_XDP], [1],
+                [Define to 1 if AF_XDP sockets can be used for network devices.])
+   fi])
+
 dnl Checks for dpkg-buildpackage.  If this is available then we check
 dnl that the Debian packaging is functional at "make distcheck" time.
 AC_DEFUN([OFP_CHECK_DPKG_BUILDPACKAGE],
@@ -142,7 +142,13 @@ enum nx_action_subtype {
      * This is useful because OpenFlow does not provide a way to match on the
      * Ethernet addresses inside ARP packets, so there is no other way to drop
      * spoofed ARPs other than sending every packet up to the controller. */
-    NXAST_DROP_SPOOFED_ARP
+    NXAST_DROP_SPOOFED_ARP,
+
+    /* Subtypes 4 to 15 are Open vSwitch actions not supported here. */
+
+    /* Adds or modifies a flow in a flow table, built from the packet being
+     * processed.  See struct nx_action_learn. */
+    NXAST_LEARN = 16
 };
 
 /* Action structure for NXAST_RESUBMIT. */
@@ -177,6 +183,76 @@ struct nx_action_header {
 };
 OFP_ASSERT(sizeof(struct nx_action_header) == 16);
 
+/* Action structure for NXAST_LEARN.
+ *
+ * The action adds a flow to table 'table_id', with the given timeouts,
+ * priority and cookie, as a flow_mod with OFPFC_ADD would.  The flow's match
+ * and actions are built by the flow_mod_spec elements that follow the
+ * structure, from fields of the packet or from immediate values.
+ *
+ * A flow_mod_spec starts with a 16-bit header:
+ *
+ *    bits 15-14: zero
+ *    bit     13: source, one of NX_LEARN_SRC_*
+ *    bits 12-11: destination, one of NX_LEARN_DST_*
+ *    bit     10: zero
+ *    bits   9-0: number of bits copied, 'n_bits'
+ *
+ * The header is followed by the source: for NX_LEARN_SRC_FIELD, the 32-bit
+ * OXM header of a field of the packet and the 16-bit offset of the first
+ * bit copied; for NX_LEARN_SRC_IMMEDIATE, 'n_bits' bits of value, in
+ * network byte order, padded on the left to a multiple of 16 bits.
+ *
+ * Then comes the destination: for NX_LEARN_DST_MATCH and NX_LEARN_DST_LOAD,
+ * the 32-bit OXM header of a field and the 16-bit offset of the first bit
+ * written; nothing for NX_LEARN_DST_OUTPUT.  NX_LEARN_DST_MATCH adds the
+ * value to the flow's match, NX_LEARN_DST_LOAD adds an action setting the
+ * field to it, NX_LEARN_DST_OUTPUT an action outputting to the port it
+ * holds.
+ *
+ * The elements end at the end of the action, or at a header of zero, which
+ * the zero padding of the action to a multiple of 8 bytes provides.
+ *
+ * For example, the MAC learning of a switch in table 1 is:
+ *
+ *    eth_dst=eth_src (match), vlan_vid=vlan_vid (match), in_port (output)
+ */
+struct nx_action_learn {
+    uint16_t type;                  /* OFPAT_VENDOR. */
+    uint16_t len;                   /* At least 32. */
+    uint32_t vendor;                /* NX_VENDOR_ID. */
+    uint16_t subtype;               /* NXAST_LEARN. */
+    uint16_t idle_timeout;          /* Idle time before discarding (seconds). */
+    uint16_t hard_timeout;          /* Max time before discarding (seconds). */
+    uint16_t priority;              /* Priority level of flow entry. */
+    uint64_t cookie;                /* Cookie for new flow. */
+    uint16_t flags;                 /* NX_LEARN_F_*. */
+    uint8_t table_id;               /* Table to insert flow entry. */
+    uint8_t pad;                    /* Must be zero. */
+    uint16_t fin_idle_timeout;      /* Idle timeout after FIN, if nonzero. */
+    uint16_t fin_hard_timeout;      /* Hard timeout after FIN, if nonzero. */
+    /* Followed by flow_mod_spec elements. */
+};
+OFP_ASSERT(sizeof(struct nx_action_learn) == 32);
+
+/* Flags of NXAST_LEARN. */
+#define NX_LEARN_F_SEND_FLOW_REM     (1 << 0) /* Set OFPFF_SEND_FLOW_REM. */
+#define NX_LEARN_F_DELETE_LEARNED    (1 << 1) /* Delete the learned flows with
+                                                 the flow of the action. */
+
+/* Fields of a flow_mod_spec header. */
+#define NX_LEARN_N_BITS_MASK    0x3ff
+
+#define NX_LEARN_SRC_FIELD     (0 << 13) /* Copy from field. */
+#define NX_LEARN_SRC_IMMEDIATE (1 << 13) /* Copy from immediate value. */
+#define NX_LEARN_SRC_MASK      (1 << 13)
+
+#define NX_LEARN_DST_MATCH     (0 << 11) /* Add match criterion. */
+#define NX_LEARN_DST_LOAD      (1 << 11) /* Add action setting a field. */
+#define NX_LEARN_DST_OUTPUT    (2 << 11) /* Add OFPAT_OUTPUT action. */
+#define NX_LEARN_DST_RESERVED  (3 << 11) /* Not yet defined. */
+#define NX_LEARN_DST_MASK      (3 << 11)
+
 /* Wildcard for tunnel ID. */
 #define NXFW_TUN_ID  (1 << 25)
 #define NXFW_NW_SRC  (1 << 26)
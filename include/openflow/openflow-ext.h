@@ -24,9 +24,25 @@ enum ofp_extension_commands { /* Queue configuration commands */
     OFP_EXT_QUEUE_DELETE,  /* Remove a queue */
     OFP_EXT_SET_DESC,      /* Set ofp_desc_stat->dp_desc */
 
+    /* Statistics */
+    OFP_EXT_RX_STATS_REQUEST, /* Request receive statistics */
+    OFP_EXT_RX_STATS_REPLY,   /* Receive statistics */
+
+    /* Packet output */
+    OFP_EXT_PACKET_OUT_BATCH, /* Several packet_outs in one message */
+
+    /* Neighbor responder */
+    OFP_EXT_RESPONDER_MOD,    /* Modify the ARP and ND responder table */
+
     OFP_EXT_COUNT
 };
 
+/* Subtypes of the OPENFLOW_VENDOR_ID experimenter actions. */
+enum ofp_extension_action_subtype {
+    OFP_EXT_ACT_RESPOND       /* Answer ARP requests and neighbor
+                               * solicitations from the responder table */
+};
+
 struct ofp_extension_header {
     struct ofp_header header;
     uint32_t vendor;            /* OPENFLOW_VENDOR_ID. */
@@ -87,6 +103,148 @@ struct openflow_ext_set_dp_desc {
 };
 OFP_ASSERT(sizeof(struct openflow_ext_set_dp_desc) == 272);
 
+/* Receive statistics of a port that OFPMP_PORT_STATS has no room for. */
+struct openflow_ext_port_rx_stats {
+    uint32_t port_no;
+    uint8_t pad[4];             /* Align to 64-bits */
+    uint64_t kernel_drops;      /* Frames dropped by the kernel before the
+                                 * switch read them; included in the port's
+                                 * rx_dropped. */
+    uint64_t full_bursts;       /* Receive bursts that ended because the
+                                 * burst was full rather than the port
+                                 * drained. */
+};
+OFP_ASSERT(sizeof(struct openflow_ext_port_rx_stats) == 24);
+
+/* OFP_EXT_RX_STATS_REQUEST. */
+struct openflow_ext_rx_stats_request {
+    struct ofp_extension_header header;
+    uint32_t port_no;           /* Port to report, or OFPP_ANY for all. */
+    uint8_t pad[4];             /* Align to 64-bits */
+};
+OFP_ASSERT(sizeof(struct openflow_ext_rx_stats_request) == 24);
+
+/* OFP_EXT_RX_STATS_REPLY. */
+struct openflow_ext_rx_stats_reply {
+    struct ofp_extension_header header;
+    uint64_t polls;             /* Passes of the receive loop over the ports. */
+    uint64_t busy_polls;        /* Passes that left at least one port with
+                                 * more than a burst of packets pending. */
+    uint64_t pktmem_buffers;    /* Buffers in the packet memory region, 0 if
+                                 * packet buffers are malloc()'d. */
+    uint64_t pktmem_free;       /* Those of them not in use. */
+    uint64_t pktmem_exhausted;  /* Packet buffers malloc()'d because the
+                                 * region had none free. */
+    uint64_t pktmem_oversize;   /* Packet buffers malloc()'d because the
+                                 * packet was too large for the region's. */
+    uint64_t pin_suppressed;    /* Packet_ins of table misses not sent,
+                                 * because one was sent for the same flow. */
+    uint64_t pin_released;      /* Packets held meanwhile that a new flow
+                                 * entry ran through the pipeline again. */
+    uint64_t pin_dropped;       /* Packets held meanwhile that were
+                                 * dropped. */
+    uint64_t conn_dropped;      /* Messages to the requesting controller
+                                 * dropped on its main connection's full tx
+                                 * queue. */
+    uint64_t aux_dropped;       /* Those dropped on its auxiliary
+                                 * connections' full tx queues. */
+    uint64_t aux_failover;      /* Packet-ins for its auxiliary connections
+                                 * sent on the main connection, because the
+                                 * auxiliary one was down. */
+    uint64_t hw_dropped;        /* Packets received by the hardware driver
+                                 * dropped because the queue to the datapath
+                                 * thread was full. */
+    struct openflow_ext_port_rx_stats ports[0];
+};
+OFP_ASSERT(sizeof(struct openflow_ext_rx_stats_reply) == 120);
+
+/* OFP_EXT_PACKET_OUT_BATCH: a sequence of packet_outs.  The entries are
+ * executed in order, and one that fails does not keep the others from being
+ * executed: the switch sends an OFPT_ERROR for it, whose data is an
+ * openflow_ext_packet_out_batch_error. */
+struct openflow_ext_packet_out_batch {
+    struct ofp_extension_header header;
+    uint8_t entries[0];         /* openflow_ext_packet_out_entry's. */
+};
+OFP_ASSERT(sizeof(struct openflow_ext_packet_out_batch) == 16);
+
+/* An entry of OFP_EXT_PACKET_OUT_BATCH, the equivalent of an ofp_packet_out.
+ * It is followed by 'actions_len' bytes of actions, then 'data_len' bytes of
+ * packet data, then zero padding to a multiple of 8 bytes. */
+struct openflow_ext_packet_out_entry {
+    uint16_t len;               /* Length of this entry, including the
+                                 * padding. */
+    uint16_t actions_len;       /* Size of the actions in bytes. */
+    uint16_t data_len;          /* Size of the packet data in bytes, 0 if
+                                 * 'buffer_id' is not -1. */
+    uint8_t pad[2];             /* Align to 64-bits */
+    uint32_t buffer_id;         /* ID assigned by datapath (-1 if none). */
+    uint32_t in_port;           /* Packet's input port or OFPP_CONTROLLER. */
+    struct ofp_action_header actions[0]; /* Action list. */
+};
+OFP_ASSERT(sizeof(struct openflow_ext_packet_out_entry) == 16);
+
+/* Data of the OFPT_ERROR reporting a failed entry of an
+ * OFP_EXT_PACKET_OUT_BATCH; the error has the xid of the batch. */
+struct openflow_ext_packet_out_batch_error {
+    struct ofp_extension_header header; /* Header of the batch. */
+    uint32_t entry;             /* Index of the entry, starting at 0. */
+    uint8_t pad[4];             /* Align to 64-bits */
+};
+OFP_ASSERT(sizeof(struct openflow_ext_packet_out_batch_error) == 24);
+
+/* Commands of OFP_EXT_RESPONDER_MOD. */
+enum openflow_ext_responder_command {
+    OFP_EXT_RESPONDER_ADD,      /* Add the entries, replacing those with the
+                                 * same VLAN and address. */
+    OFP_EXT_RESPONDER_DELETE,   /* Delete the entries with the VLAN and
+                                 * address of the given ones. */
+    OFP_EXT_RESPONDER_REPLACE   /* Delete all entries, then add the given
+                                 * ones. */
+};
+
+/* An entry of OFP_EXT_RESPONDER_MOD: the host with address 'ip_addr' on
+ * VLAN 'vlan_vid' has Ethernet address 'eth_addr'. */
+struct openflow_ext_responder_entry {
+    uint16_t vlan_vid;          /* OFPVID_PRESENT | VLAN id, or OFPVID_NONE
+                                 * for untagged packets. */
+    uint8_t eth_addr[OFP_ETH_ALEN]; /* Ignored by OFP_EXT_RESPONDER_DELETE. */
+    uint8_t ip_addr[16];        /* IPv6 address, or IPv4-mapped IPv6 address
+                                 * (::ffff:a.b.c.d) of an IPv4 host. */
+};
+OFP_ASSERT(sizeof(struct openflow_ext_responder_entry) == 24);
+
+/* OFP_EXT_RESPONDER_MOD: updates the table of the addresses the switch
+ * answers ARP requests and IPv6 neighbor solicitations for, on behalf of
+ * the controller, when a flow entry applies an OFP_EXT_ACT_RESPOND action.
+ * A message either applies as a whole or fails without changing the
+ * table. */
+struct openflow_ext_responder_mod {
+    struct ofp_extension_header header;
+    uint16_t command;           /* One of OFP_EXT_RESPONDER_*. */
+    uint8_t pad[6];             /* Align to 64-bits */
+    struct openflow_ext_responder_entry entries[0];
+};
+OFP_ASSERT(sizeof(struct openflow_ext_responder_mod) == 24);
+
+/* Action structure for OFP_EXT_ACT_RESPOND.
+ *
+ * The action answers an ARP request or an IPv6 neighbor solicitation for an
+ * address in the responder table with a reply sent out the packet's input
+ * port.  Any other packet, including requests for unknown addresses, is
+ * output to 'miss_port' instead, as the output action would, or dropped if
+ * 'miss_port' is OFPP_ANY. */
+struct openflow_ext_action_respond {
+    uint16_t type;              /* OFPAT_EXPERIMENTER. */
+    uint16_t len;               /* Length is 16. */
+    uint32_t vendor;            /* OPENFLOW_VENDOR_ID. */
+    uint16_t subtype;           /* OFP_EXT_ACT_RESPOND. */
+    uint16_t max_len;           /* Max length to send to the controller, if
+                                 * 'miss_port' is OFPP_CONTROLLER. */
+    uint32_t miss_port;         /* Output port of the other packets. */
+};
+OFP_ASSERT(sizeof(struct openflow_ext_action_respond) == 16);
+
 #define ofq_error_string(rv) (((rv) < OFQ_ERR_COUNT) && ((rv) >= 0) ? \
     openflow_queue_error_strings[rv] : "Unknown error code")
 
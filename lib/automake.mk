@@ -25,6 +25,8 @@ lib_libopenflow_a_SOURCES = \
 	lib/fault.h \
 	lib/flow.c \
 	lib/flow.h \
+	lib/gso.c \
+	lib/gso.h \
 	lib/hash.c \
 	lib/hash.h \
 	lib/hmap.c \
@@ -37,6 +39,7 @@ lib_libopenflow_a_SOURCES = \
 	lib/list.h \
 	lib/mac-learning.c \
 	lib/mac-learning.h \
+	lib/netdev-afxdp.h \
 	lib/netdev.c \
 	lib/netdev.h \
 	lib/ofp.c \
@@ -47,6 +50,10 @@ lib_libopenflow_a_SOURCES = \
 	lib/packets.h \
 	lib/pcap.c \
 	lib/pcap.h \
+	lib/pkt-queue.c \
+	lib/pkt-queue.h \
+	lib/pktmem.c \
+	lib/pktmem.h \
 	lib/poll-loop.c \
 	lib/poll-loop.h \
 	lib/port-array.c \
@@ -59,6 +66,8 @@ lib_libopenflow_a_SOURCES = \
 	lib/random.h \
 	lib/rconn.c \
 	lib/rconn.h \
+	lib/samples.c \
+	lib/samples.h \
 	lib/sat-math.h \
 	lib/shash.c \
 	lib/shash.h \
@@ -66,6 +75,8 @@ lib_libopenflow_a_SOURCES = \
 	lib/signals.h \
 	lib/socket-util.c \
 	lib/socket-util.h \
+	lib/stats-shm.c \
+	lib/stats-shm.h \
 	lib/stp.c \
 	lib/stp.h \
 	lib/svec.c \
@@ -122,6 +133,10 @@ lib_libopenflow_a_SOURCES += \
 	lib/vconn-netlink.c
 endif
 
+if HAVE_AF_XDP
+lib_libopenflow_a_SOURCES += lib/netdev-afxdp.c
+endif
+
 if HAVE_OPENSSL
 lib_libopenflow_a_SOURCES += \
 	lib/vconn-ssl.c 
@@ -83,7 +83,10 @@ csum_continue(uint32_t partial, const void *data_, size_t n)
 uint16_t
 csum_finish(uint32_t partial)
 {
-    return ~((partial & 0xffff) + (partial >> 16));
+    while (partial >> 16) {
+        partial = (partial & 0xffff) + (partial >> 16);
+    }
+    return ~partial;
 }
 
 /* Returns the new checksum for a packet in which the checksum field previously
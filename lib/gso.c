@@ -0,0 +1,223 @@
+/* Copyright (c) 2008, 2009 The Board of Trustees of The Leland Stanford
+ * Junior University
+ *
+ * We are making the OpenFlow specification and associated documentation
+ * (Software) available for public use and benefit with the expectation
+ * that others will use, modify and enhance the Software and contribute
+ * those enhancements back to the community. However, since we would
+ * like to make the Software available for broadest use, with as few
+ * restrictions as possible permission is hereby granted, free of
+ * charge, to any person obtaining a copy of this Software to deal in
+ * the Software under the copyrights without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * The name and trademarks of copyright holder(s) may NOT be used in
+ * advertising or publicity pertaining to the Software or any
+ * derivatives without specific, written prior permission.
+ */
+
+#include <config.h>
+#include "gso.h"
+
+#include <netinet/in.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "csum.h"
+#include "ofpbuf.h"
+#include "packets.h"
+#include "util.h"
+
+#define LOG_MODULE VLM_gso
+#include "vlog.h"
+
+static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(5, 20);
+
+/* Completes the partial transport checksum of 'b', if any, in place. */
+void
+gso_complete_csum(struct ofpbuf *b)
+{
+    size_t start;
+    uint16_t *field;
+
+    if (!(b->offload.flags & OFPBUF_CSUM_PARTIAL)) {
+        return;
+    }
+    b->offload.flags &= ~OFPBUF_CSUM_PARTIAL;
+    if (b->offload.csum_tail > b->size
+        || b->offload.csum_offset + sizeof *field > b->offload.csum_tail) {
+        VLOG_WARN_RL(LOG_MODULE, &rl, "checksum offsets out of range");
+        return;
+    }
+
+    /* The field holds the pseudo-header sum, so summing from the start of
+     * the transport header through the end yields the whole checksum. */
+    start = b->size - b->offload.csum_tail;
+    field = (uint16_t *) ((uint8_t *) b->data + start + b->offload.csum_offset);
+    *field = csum((uint8_t *) b->data + start, b->offload.csum_tail);
+}
+
+/* Returns the offset of the network header in Ethernet frame 'b', skipping
+ * VLAN tags and MPLS labels, or 0 if there is none. */
+static size_t
+l3_offset(const struct ofpbuf *b)
+{
+    const uint8_t *data = b->data;
+    size_t ofs = ETH_ADDR_LEN * 2;
+    uint16_t type;
+
+    for (;;) {
+        if (ofs + 2 > b->size) {
+            return 0;
+        }
+        type = (data[ofs] << 8) | data[ofs + 1];
+        ofs += 2;
+        if (type != ETH_TYPE_VLAN && type != ETH_TYPE_VLAN_PBB_B
+            && type != ETH_TYPE_VLAN_QinQ && type != ETH_TYPE_SVLAN) {
+            break;
+        }
+        ofs += 2;
+    }
+    if (type == ETH_TYPE_MPLS || type == ETH_TYPE_MPLS_MCAST) {
+        /* Labels up to and including the one with the bottom-of-stack bit. */
+        do {
+            ofs += MPLS_HEADER_LEN;
+        } while (ofs <= b->size && !(data[ofs - 2] & 0x01));
+    }
+    return ofs < b->size ? ofs : 0;
+}
+
+/* Returns the offset of the TCP header in super-frame 'b', whose IP version
+ * is given by 'b->offload.gso_type', or 0 if it cannot be found.  IPv6
+ * extension headers are not skipped. */
+size_t
+gso_tcp_offset(const struct ofpbuf *b)
+{
+    const uint8_t *data = b->data;
+    size_t l3 = l3_offset(b);
+    size_t l4;
+
+    if (!l3) {
+        return 0;
+    }
+    if (b->offload.gso_type == OFPBUF_GSO_TCPV4) {
+        const struct ip_header *ip = (const struct ip_header *) (data + l3);
+
+        if (l3 + IP_HEADER_LEN > b->size || ip->ip_proto != IP_TYPE_TCP
+            || IP_IHL(ip->ip_ihl_ver) * 4 < IP_HEADER_LEN) {
+            return 0;
+        }
+        l4 = l3 + IP_IHL(ip->ip_ihl_ver) * 4;
+    } else {
+        const struct ipv6_header *ip6 = (const struct ipv6_header *)
+                                                (data + l3);
+
+        if (l3 + IPV6_HEADER_LEN > b->size
+            || ip6->ipv6_next_hd != IP_TYPE_TCP) {
+            return 0;
+        }
+        l4 = l3 + IPV6_HEADER_LEN;
+    }
+    return l4 + TCP_HEADER_LEN <= b->size ? l4 : 0;
+}
+
+/* Splits TCP super-frame 'b' into segments of at most 'b->offload.gso_size'
+ * payload bytes, each with its own complete IP and TCP headers and
+ * checksums, as a device with TCP segmentation offload would.  Returns the
+ * segments linked through their 'next' members, or a null pointer if 'b'
+ * cannot be segmented.  The caller must free the segments. */
+struct ofpbuf *
+gso_segment(const struct ofpbuf *b)
+{
+    const struct ofpbuf_offload *o = &b->offload;
+    struct ofpbuf *head = NULL;
+    struct ofpbuf **tail = &head;
+    const struct tcp_header *tcp;
+    size_t l3, l4, hdr_len, ofs;
+    uint16_t ip_id = 0;
+    uint32_t seq;
+    bool ipv4 = o->gso_type == OFPBUF_GSO_TCPV4;
+
+    l3 = l3_offset(b);
+    l4 = o->csum_tail <= b->size ? b->size - o->csum_tail : 0;
+    if (!l3 || l4 < l3 + (ipv4 ? IP_HEADER_LEN : IPV6_HEADER_LEN)
+        || l4 + TCP_HEADER_LEN > b->size || !o->gso_size) {
+        VLOG_WARN_RL(LOG_MODULE, &rl, "cannot segment malformed GSO frame");
+        return NULL;
+    }
+    tcp = (const struct tcp_header *) ((const uint8_t *) b->data + l4);
+    hdr_len = l4 + TCP_OFFSET(tcp->tcp_ctl) * 4;
+    if (hdr_len > b->size || hdr_len < l4 + TCP_HEADER_LEN) {
+        VLOG_WARN_RL(LOG_MODULE, &rl, "cannot segment malformed GSO frame");
+        return NULL;
+    }
+    seq = ntohl(tcp->tcp_seq);
+    if (ipv4) {
+        ip_id = ntohs(((const struct ip_header *)
+                       ((const uint8_t *) b->data + l3))->ip_id);
+    }
+
+    for (ofs = hdr_len; ofs < b->size; ofs += o->gso_size) {
+        size_t payload = MIN(o->gso_size, b->size - ofs);
+        size_t l4_len = hdr_len - l4 + payload;
+        struct ofpbuf *seg;
+        struct tcp_header *stcp;
+        uint32_t partial;
+
+        seg = ofpbuf_new(hdr_len + payload);
+        ofpbuf_put(seg, b->data, hdr_len);
+        ofpbuf_put(seg, (const uint8_t *) b->data + ofs, payload);
+        stcp = (struct tcp_header *) ((uint8_t *) seg->data + l4);
+
+        if (ipv4) {
+            struct ip_header *ip = (struct ip_header *)
+                                        ((uint8_t *) seg->data + l3);
+            ip->ip_tot_len = htons(hdr_len - l3 + payload);
+            ip->ip_id = htons(ip_id++);
+            ip->ip_csum = 0;
+            ip->ip_csum = csum(ip, IP_IHL(ip->ip_ihl_ver) * 4);
+            partial = csum_add32(0, ip->ip_src);
+            partial = csum_add32(partial, ip->ip_dst);
+        } else {
+            struct ipv6_header *ip6 = (struct ipv6_header *)
+                                        ((uint8_t *) seg->data + l3);
+            ip6->ipv6_pay_len = htons(hdr_len - l3 - IPV6_HEADER_LEN
+                                      + payload);
+            partial = csum_continue(0, &ip6->ipv6_src, sizeof ip6->ipv6_src);
+            partial = csum_continue(partial, &ip6->ipv6_dst,
+                                    sizeof ip6->ipv6_dst);
+        }
+
+        /* FIN and PSH belong to the last segment, CWR to the first. */
+        stcp->tcp_seq = htonl(seq + (ofs - hdr_len));
+        if (ofs + payload < b->size) {
+            stcp->tcp_ctl &= ~htons(TCP_FIN | TCP_PSH);
+        }
+        if (ofs != hdr_len) {
+            stcp->tcp_ctl &= ~htons(0x80);
+        }
+        stcp->tcp_csum = 0;
+        partial = csum_add16(partial, htons(IPPROTO_TCP));
+        partial = csum_add16(partial, htons(l4_len));
+        stcp->tcp_csum = csum_finish(csum_continue(partial, stcp, l4_len));
+
+        *tail = seg;
+        tail = &seg->next;
+    }
+    return head;
+}
@@ -0,0 +1,897 @@
+/* Copyright (c) 2008, 2009 The Board of Trustees of The Leland Stanford
+ * Junior University
+ *
+ * We are making the OpenFlow specification and associated documentation
+ * (Software) available for public use and benefit with the expectation
+ * that others will use, modify and enhance the Software and contribute
+ * those enhancements back to the community. However, since we would
+ * like to make the Software available for broadest use, with as few
+ * restrictions as possible permission is hereby granted, free of
+ * charge, to any person obtaining a copy of this Software to deal in
+ * the Software under the copyrights without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * The name and trademarks of copyright holder(s) may NOT be used in
+ * advertising or publicity pertaining to the Software or any
+ * derivatives without specific, written prior permission.
+ */
+
+#include <config.h>
+#include "netdev-afxdp.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/bpf.h>
+#include <linux/if_link.h>
+#include <linux/if_xdp.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+
+#include "list.h"
+#include "ofpbuf.h"
+#include "packets.h"
+#include "pktmem.h"
+#include "util.h"
+
+#define LOG_MODULE VLM_netdev_afxdp
+#include "vlog.h"
+
+#ifndef AF_XDP
+#define AF_XDP 44
+#endif
+#ifndef SOL_XDP
+#define SOL_XDP 283
+#endif
+
+/* Size of a frame of a socket's own UMEM.  Each frame holds one packet. */
+#define FRAME_SIZE 4096
+
+static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(5, 20);
+
+/* One of the four rings shared with the kernel.  On the fill and TX rings
+ * user space is the producer, on the RX and completion rings the consumer;
+ * only the index the other side writes needs atomic access. */
+struct xsk_ring {
+    uint32_t *producer;
+    uint32_t *consumer;
+    uint32_t *flags;
+    void *descs;                /* 'uint64_t' or 'struct xdp_desc' array. */
+    uint32_t mask;              /* Ring size minus 1. */
+    void *map;
+    size_t map_size;
+};
+
+struct netdev_afxdp {
+    char *name;
+    int fd;                     /* AF_XDP socket. */
+    int map_fd;                 /* XSKMAP the XDP program redirects to. */
+    int prog_fd;                /* XDP program. */
+    int link_fd;                /* Attachment of the program to the device. */
+    bool need_wakeup;           /* Kernel asks to be kicked via syscalls. */
+
+    /* The UMEM is either the socket's own, with RX frames first, then TX
+     * frames, or the chunks of packet memory region 'pm', shared by all the
+     * sockets on 'pm'. */
+    uint8_t *umem;
+    size_t umem_size;
+    uint32_t frame_size;        /* FRAME_SIZE or PKTMEM_BUF_SIZE. */
+    struct pktmem *pm;          /* Region used as UMEM, or NULL. */
+    struct list node;           /* In 'shared_xsks', if 'pm' is nonnull. */
+
+    struct xsk_ring rx, fill;   /* 'rx_ring' frames cycle through these. */
+    struct xsk_ring tx, comp;   /* 'tx_ring' frames cycle through these. */
+
+    size_t n_tx_free;           /* Number of TX frames not in use. */
+    uint64_t *tx_free;          /* Their addresses, if the UMEM is the
+                                 * socket's own. */
+    uint32_t n_fill_short;      /* Fill ring entries lacking a chunk, if the
+                                 * UMEM is shared. */
+};
+
+/* Sockets whose UMEM is a packet memory region.  The first socket on a region
+ * registers it with the kernel, the others share its registration. */
+static struct list shared_xsks = LIST_INITIALIZER(&shared_xsks);
+
+/* Parses 'spec', of the form "IFNAME[:QUEUE][:rx=N][:tx=N]", into '*ifname',
+ * which the caller must free, and 'opts'.  Returns 0 if successful, otherwise
+ * EINVAL. */
+int
+netdev_afxdp_parse(const char *spec, char **ifname,
+                   struct netdev_afxdp_options *opts)
+{
+    char *copy, *token, *save_ptr;
+    int error = 0;
+
+    opts->queue = 0;
+    opts->rx_ring = NETDEV_AFXDP_RING_SIZE;
+    opts->tx_ring = NETDEV_AFXDP_RING_SIZE;
+
+    copy = xstrdup(spec);
+    token = strtok_r(copy, ":", &save_ptr);
+    if (token == NULL) {
+        free(copy);
+        return EINVAL;
+    }
+    *ifname = xstrdup(token);
+    while ((token = strtok_r(NULL, ":", &save_ptr)) != NULL) {
+        uint32_t *value;
+        char *end;
+
+        if (!strncmp(token, "rx=", 3)) {
+            value = &opts->rx_ring;
+            token += 3;
+        } else if (!strncmp(token, "tx=", 3)) {
+            value = &opts->tx_ring;
+            token += 3;
+        } else {
+            value = &opts->queue;
+        }
+        *value = strtoul(token, &end, 10);
+        if (*token == '\0' || *end != '\0') {
+            error = EINVAL;
+            break;
+        }
+    }
+    if (!error && (opts->rx_ring == 0 || opts->rx_ring & (opts->rx_ring - 1)
+                   || opts->tx_ring == 0
+                   || opts->tx_ring & (opts->tx_ring - 1))) {
+        VLOG_ERR(LOG_MODULE, "%s: ring sizes must be powers of 2", spec);
+        error = EINVAL;
+    }
+    if (error) {
+        free(*ifname);
+        *ifname = NULL;
+    }
+    free(copy);
+    return error;
+}
+
+static int
+sys_bpf(int cmd, union bpf_attr *attr)
+{
+    return syscall(__NR_bpf, cmd, attr, sizeof *attr);
+}
+
+/* Creates the XSKMAP and the XDP program that redirects every frame received
+ * on a queue to the socket at that queue's index in the map, falling back to
+ * the kernel stack when there is none, and attaches the program to device
+ * 'ifindex', natively if the driver supports XDP, otherwise generically. */
+static int
+load_xdp_program(struct netdev_afxdp *xsk, int ifindex, uint32_t queue)
+{
+    struct bpf_insn insns[] = {
+        /* r2 = ((struct xdp_md *) r1)->rx_queue_index */
+        { .code = BPF_LDX | BPF_W | BPF_MEM, .dst_reg = BPF_REG_2,
+          .src_reg = BPF_REG_1,
+          .off = offsetof(struct xdp_md, rx_queue_index) },
+        /* r1 = map */
+        { .code = BPF_LD | BPF_DW | BPF_IMM, .dst_reg = BPF_REG_1,
+          .src_reg = BPF_PSEUDO_MAP_FD },
+        { .code = 0 },
+        /* return bpf_redirect_map(r1, r2, XDP_PASS) */
+        { .code = BPF_ALU64 | BPF_MOV | BPF_K, .dst_reg = BPF_REG_3,
+          .imm = XDP_PASS },
+        { .code = BPF_JMP | BPF_CALL, .imm = BPF_FUNC_redirect_map },
+        { .code = BPF_JMP | BPF_EXIT },
+    };
+    static const char license[] = "BSD";
+    union bpf_attr attr;
+
+    memset(&attr, 0, sizeof attr);
+    attr.map_type = BPF_MAP_TYPE_XSKMAP;
+    attr.key_size = sizeof(uint32_t);
+    attr.value_size = sizeof(int);
+    attr.max_entries = queue + 1;
+    xsk->map_fd = sys_bpf(BPF_MAP_CREATE, &attr);
+    if (xsk->map_fd < 0) {
+        VLOG_ERR(LOG_MODULE, "%s: creating XSKMAP failed: %s",
+                 xsk->name, strerror(errno));
+        return errno;
+    }
+    insns[1].imm = xsk->map_fd;
+
+    memset(&attr, 0, sizeof attr);
+    attr.prog_type = BPF_PROG_TYPE_XDP;
+    attr.expected_attach_type = BPF_XDP;
+    attr.insns = (uintptr_t) insns;
+    attr.insn_cnt = ARRAY_SIZE(insns);
+    attr.license = (uintptr_t) license;
+    xsk->prog_fd = sys_bpf(BPF_PROG_LOAD, &attr);
+    if (xsk->prog_fd < 0) {
+        VLOG_ERR(LOG_MODULE, "%s: loading XDP program failed: %s",
+                 xsk->name, strerror(errno));
+        return errno;
+    }
+
+    memset(&attr, 0, sizeof attr);
+    attr.link_create.prog_fd = xsk->prog_fd;
+    attr.link_create.target_ifindex = ifindex;
+    attr.link_create.attach_type = BPF_XDP;
+    xsk->link_fd = sys_bpf(BPF_LINK_CREATE, &attr);
+    if (xsk->link_fd < 0) {
+        attr.link_create.flags = XDP_FLAGS_SKB_MODE;
+        xsk->link_fd = sys_bpf(BPF_LINK_CREATE, &attr);
+    }
+    if (xsk->link_fd < 0) {
+        VLOG_ERR(LOG_MODULE, "%s: attaching XDP program failed: %s",
+                 xsk->name, strerror(errno));
+        return errno;
+    }
+
+    memset(&attr, 0, sizeof attr);
+    attr.map_fd = xsk->map_fd;
+    attr.key = (uintptr_t) &queue;
+    attr.value = (uintptr_t) &xsk->fd;
+    if (sys_bpf(BPF_MAP_UPDATE_ELEM, &attr) < 0) {
+        VLOG_ERR(LOG_MODULE, "%s: adding socket to XSKMAP failed: %s",
+                 xsk->name, strerror(errno));
+        return errno;
+    }
+    return 0;
+}
+
+/* Maps ring 'r' of 'n' entries of 'desc_size' bytes from the socket at page
+ * offset 'pgoff', using the kernel's layout in 'off'. */
+static int
+map_ring(struct netdev_afxdp *xsk, struct xsk_ring *r,
+         const struct xdp_ring_offset *off, uint32_t n, size_t desc_size,
+         off_t pgoff)
+{
+    uint8_t *map;
+
+    r->map_size = off->desc + n * desc_size;
+    map = mmap(NULL, r->map_size, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_POPULATE, xsk->fd, pgoff);
+    if (map == MAP_FAILED) {
+        VLOG_ERR(LOG_MODULE, "%s: mapping ring failed: %s",
+                 xsk->name, strerror(errno));
+        r->map = NULL;
+        return errno;
+    }
+    r->map = map;
+    r->producer = (uint32_t *) (map + off->producer);
+    r->consumer = (uint32_t *) (map + off->consumer);
+    r->flags = (uint32_t *) (map + off->flags);
+    r->descs = map + off->desc;
+    r->mask = n - 1;
+    return 0;
+}
+
+static void
+unmap_ring(struct xsk_ring *r)
+{
+    if (r->map) {
+        munmap(r->map, r->map_size);
+    }
+}
+
+/* Returns the number of entries the kernel has produced on consumer ring 'r'
+ * that have not been consumed yet. */
+static inline uint32_t
+ring_ready(const struct xsk_ring *r)
+{
+    return __atomic_load_n(r->producer, __ATOMIC_ACQUIRE) - *r->consumer;
+}
+
+/* Returns the number of free entries on producer ring 'r'. */
+static inline uint32_t
+ring_room(const struct xsk_ring *r)
+{
+    return r->mask + 1 - (*r->producer
+                          - __atomic_load_n(r->consumer, __ATOMIC_ACQUIRE));
+}
+
+static inline void
+ring_consume(struct xsk_ring *r, uint32_t n)
+{
+    __atomic_store_n(r->consumer, *r->consumer + n, __ATOMIC_RELEASE);
+}
+
+static inline void
+ring_produce(struct xsk_ring *r, uint32_t n)
+{
+    __atomic_store_n(r->producer, *r->producer + n, __ATOMIC_RELEASE);
+}
+
+static inline bool
+ring_needs_wakeup(const struct netdev_afxdp *xsk, const struct xsk_ring *r)
+{
+    return !xsk->need_wakeup
+           || __atomic_load_n(r->flags, __ATOMIC_RELAXED) & XDP_RING_NEED_WAKEUP;
+}
+
+/* Binds the socket to 'queue' of 'ifindex', preferring zero-copy mode.  If
+ * 'owner' is nonnull, the socket shares the UMEM registered on 'owner' and
+ * the mode that goes with it. */
+static int
+bind_socket(struct netdev_afxdp *xsk, int ifindex, uint32_t queue,
+            const struct netdev_afxdp *owner)
+{
+    static const uint16_t modes[] = {
+        XDP_ZEROCOPY | XDP_USE_NEED_WAKEUP,
+        XDP_COPY | XDP_USE_NEED_WAKEUP,
+        XDP_COPY,
+    };
+    struct sockaddr_xdp sxdp;
+    size_t i;
+
+    memset(&sxdp, 0, sizeof sxdp);
+    sxdp.sxdp_family = AF_XDP;
+    sxdp.sxdp_ifindex = ifindex;
+    sxdp.sxdp_queue_id = queue;
+    if (owner) {
+        sxdp.sxdp_flags = XDP_SHARED_UMEM;
+        sxdp.sxdp_shared_umem_fd = owner->fd;
+        if (!bind(xsk->fd, (struct sockaddr *) &sxdp, sizeof sxdp)) {
+            xsk->need_wakeup = owner->need_wakeup;
+            VLOG_INFO(LOG_MODULE, "%s: AF_XDP socket bound to queue %"PRIu32
+                      " sharing the UMEM of %s", xsk->name, queue,
+                      owner->name);
+            return 0;
+        }
+    }
+    for (i = 0; !owner && i < ARRAY_SIZE(modes); i++) {
+        sxdp.sxdp_flags = modes[i];
+        if (!bind(xsk->fd, (struct sockaddr *) &sxdp, sizeof sxdp)) {
+            xsk->need_wakeup = (modes[i] & XDP_USE_NEED_WAKEUP) != 0;
+            VLOG_INFO(LOG_MODULE, "%s: AF_XDP socket bound to queue %"PRIu32
+                      " in %s mode", xsk->name, queue,
+                      modes[i] & XDP_ZEROCOPY ? "zero-copy" : "copy");
+            return 0;
+        }
+    }
+    VLOG_ERR(LOG_MODULE, "%s: binding AF_XDP socket to queue %"PRIu32
+             " failed: %s", xsk->name, queue, strerror(errno));
+    return errno;
+}
+
+/* Returns a socket whose UMEM is 'pm', or NULL if there is none. */
+static struct netdev_afxdp *
+find_umem_owner(const struct pktmem *pm)
+{
+    struct netdev_afxdp *xsk;
+
+    LIST_FOR_EACH (xsk, struct netdev_afxdp, node, &shared_xsks) {
+        if (xsk->pm == pm) {
+            return xsk;
+        }
+    }
+    return NULL;
+}
+
+/* Takes a free chunk of 'xsk->pm' with room for 'size' bytes of data.
+ * Returns NULL if the region has none left. */
+static struct ofpbuf *
+take_chunk(struct netdev_afxdp *xsk, size_t size)
+{
+    struct ofpbuf *b = pktmem_ofpbuf_new(xsk->pm, size, 0);
+
+    if (b->pktmem != xsk->pm) {
+        ofpbuf_delete(b);
+        return NULL;
+    }
+    return b;
+}
+
+static void
+kick_fill(struct netdev_afxdp *xsk)
+{
+    if (xsk->need_wakeup && ring_needs_wakeup(xsk, &xsk->fill)) {
+        recvfrom(xsk->fd, NULL, 0, MSG_DONTWAIT, NULL, NULL);
+    }
+}
+
+/* Hands the kernel a free chunk for each fill ring entry of 'xsk' that lacks
+ * one, as far as the region has chunks left. */
+static void
+fill_chunks(struct netdev_afxdp *xsk)
+{
+    uint32_t n;
+
+    for (n = 0; n < xsk->n_fill_short; n++) {
+        struct ofpbuf *b = take_chunk(xsk, 0);
+
+        if (b == NULL) {
+            break;
+        }
+        ((uint64_t *) xsk->fill.descs)[(*xsk->fill.producer + n)
+                                       & xsk->fill.mask]
+            = pktmem_offset(xsk->pm, b);
+    }
+    if (n) {
+        ring_produce(&xsk->fill, n);
+        xsk->n_fill_short -= n;
+    }
+}
+
+/* Stores in 'addrs' the addresses in the entries of ring 'r' that its
+ * consumer has yet to take, and returns their number. */
+static size_t
+ring_addrs(const struct xsk_ring *r, bool is_desc, uint64_t *addrs)
+{
+    uint32_t cons, prod;
+    size_t n = 0;
+
+    if (r->map == NULL) {
+        return 0;
+    }
+    cons = __atomic_load_n(r->consumer, __ATOMIC_ACQUIRE);
+    prod = __atomic_load_n(r->producer, __ATOMIC_ACQUIRE);
+    if (prod - cons > r->mask + 1) {
+        return 0;
+    }
+    for (; cons != prod; cons++) {
+        addrs[n++] = (is_desc
+                      ? ((const struct xdp_desc *) r->descs)[cons & r->mask].addr
+                      : ((const uint64_t *) r->descs)[cons & r->mask]);
+    }
+    return n;
+}
+
+/* Opens an AF_XDP socket with the UMEM 'pm', or one of its own if 'pm' is
+ * NULL, for netdev_afxdp_open(). */
+static int
+open_socket(const char *ifname, int ifindex, struct pktmem *pm,
+            const struct netdev_afxdp_options *opts,
+            struct netdev_afxdp **xskp)
+{
+    const struct netdev_afxdp *owner = NULL;
+    struct netdev_afxdp *xsk;
+    struct xdp_umem_reg reg;
+    struct xdp_mmap_offsets off;
+    socklen_t optlen;
+    uint32_t n_frames;
+    uint32_t i;
+    int error;
+
+    xsk = xcalloc(1, sizeof *xsk);
+    xsk->name = xstrdup(ifname);
+    xsk->map_fd = xsk->prog_fd = xsk->link_fd = -1;
+    list_init(&xsk->node);
+
+    xsk->fd = socket(AF_XDP, SOCK_RAW, 0);
+    if (xsk->fd < 0) {
+        error = errno;
+        VLOG_ERR(LOG_MODULE, "%s: creating AF_XDP socket failed: %s",
+                 ifname, strerror(error));
+        goto error;
+    }
+
+    if (pm) {
+        void *base;
+
+        xsk->pm = pm;
+        xsk->frame_size = PKTMEM_BUF_SIZE;
+        pktmem_get_area(pm, &base, &xsk->umem_size);
+        xsk->umem = base;
+        owner = find_umem_owner(pm);
+    } else {
+        n_frames = opts->rx_ring + opts->tx_ring;
+        xsk->frame_size = FRAME_SIZE;
+        xsk->umem_size = (size_t) n_frames * FRAME_SIZE;
+        xsk->umem = mmap(NULL, xsk->umem_size, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (xsk->umem == MAP_FAILED) {
+            error = errno;
+            xsk->umem = NULL;
+            goto error;
+        }
+    }
+
+    /* The kernel places received frames after 'headroom' bytes of each
+     * chunk, which in a region leaves its struct ofpbuf alone. */
+    memset(&reg, 0, sizeof reg);
+    reg.addr = (uintptr_t) xsk->umem;
+    reg.len = xsk->umem_size;
+    reg.chunk_size = xsk->frame_size;
+    reg.headroom = pm ? PKTMEM_BUF_HEADER : 0;
+    if ((!owner && setsockopt(xsk->fd, SOL_XDP, XDP_UMEM_REG,
+                              &reg, sizeof reg))
+        || setsockopt(xsk->fd, SOL_XDP, XDP_UMEM_FILL_RING,
+                      &opts->rx_ring, sizeof opts->rx_ring)
+        || setsockopt(xsk->fd, SOL_XDP, XDP_UMEM_COMPLETION_RING,
+                      &opts->tx_ring, sizeof opts->tx_ring)
+        || setsockopt(xsk->fd, SOL_XDP, XDP_RX_RING,
+                      &opts->rx_ring, sizeof opts->rx_ring)
+        || setsockopt(xsk->fd, SOL_XDP, XDP_TX_RING,
+                      &opts->tx_ring, sizeof opts->tx_ring)) {
+        error = errno;
+        VLOG_ERR(LOG_MODULE, "%s: configuring AF_XDP socket failed: %s",
+                 ifname, strerror(error));
+        goto error;
+    }
+
+    optlen = sizeof off;
+    if (getsockopt(xsk->fd, SOL_XDP, XDP_MMAP_OFFSETS, &off, &optlen)) {
+        error = errno;
+        goto error;
+    }
+    error = map_ring(xsk, &xsk->rx, &off.rx, opts->rx_ring,
+                     sizeof(struct xdp_desc), XDP_PGOFF_RX_RING);
+    if (!error) {
+        error = map_ring(xsk, &xsk->fill, &off.fr, opts->rx_ring,
+                         sizeof(uint64_t), XDP_UMEM_PGOFF_FILL_RING);
+    }
+    if (!error) {
+        error = map_ring(xsk, &xsk->tx, &off.tx, opts->tx_ring,
+                         sizeof(struct xdp_desc), XDP_PGOFF_TX_RING);
+    }
+    if (!error) {
+        error = map_ring(xsk, &xsk->comp, &off.cr, opts->tx_ring,
+                         sizeof(uint64_t), XDP_UMEM_PGOFF_COMPLETION_RING);
+    }
+    if (error) {
+        goto error;
+    }
+
+    if (pm) {
+        /* A received chunk travels with its packet and is replaced on the
+         * fill ring by a free one; a transmitted one is freed on
+         * completion. */
+        xsk->n_fill_short = opts->rx_ring;
+        fill_chunks(xsk);
+    } else {
+        /* Hand every RX frame to the kernel; a received frame is copied out
+         * and returned right away, so the fill ring never overflows. */
+        for (i = 0; i < opts->rx_ring; i++) {
+            ((uint64_t *) xsk->fill.descs)[i] = (uint64_t) i * FRAME_SIZE;
+        }
+        ring_produce(&xsk->fill, opts->rx_ring);
+
+        xsk->tx_free = xmalloc(opts->tx_ring * sizeof *xsk->tx_free);
+        for (i = 0; i < opts->tx_ring; i++) {
+            xsk->tx_free[i] = (uint64_t) (opts->rx_ring + i) * FRAME_SIZE;
+        }
+    }
+    xsk->n_tx_free = opts->tx_ring;
+
+    error = bind_socket(xsk, ifindex, opts->queue, owner);
+    if (!error) {
+        error = load_xdp_program(xsk, ifindex, opts->queue);
+    }
+    if (error) {
+        goto error;
+    }
+
+    if (pm) {
+        list_push_back(&shared_xsks, &xsk->node);
+    }
+    *xskp = xsk;
+    return 0;
+
+error:
+    netdev_afxdp_close(xsk);
+    return error;
+}
+
+/* Opens an AF_XDP socket on queue 'opts->queue' of device 'ifname', whose
+ * index is 'ifindex' and MTU is 'mtu'.  If 'pm' is nonnull and its chunks can
+ * hold a frame of that MTU, the socket uses 'pm' as its UMEM, so that frames
+ * are received into and transmitted from packet buffers without a copy.
+ * Returns 0 if successful, otherwise a positive errno value.  On success,
+ * stores the new socket in '*xskp'. */
+int
+netdev_afxdp_open(const char *ifname, int ifindex, int mtu,
+                  struct pktmem *pm, const struct netdev_afxdp_options *opts,
+                  struct netdev_afxdp **xskp)
+{
+    *xskp = NULL;
+    if (pm && mtu + VLAN_ETH_HEADER_LEN
+              > PKTMEM_BUF_DATA - XDP_PACKET_HEADROOM) {
+        VLOG_INFO(LOG_MODULE, "%s: MTU %d too large for packet memory, "
+                  "copying AF_XDP frames", ifname, mtu);
+        pm = NULL;
+    }
+    if (pm) {
+        if (!open_socket(ifname, ifindex, pm, opts, xskp)) {
+            return 0;
+        }
+        VLOG_WARN(LOG_MODULE, "%s: cannot use packet memory as UMEM, "
+                  "copying AF_XDP frames", ifname);
+    }
+    if (mtu + VLAN_ETH_HEADER_LEN > FRAME_SIZE - XDP_PACKET_HEADROOM) {
+        VLOG_ERR(LOG_MODULE, "%s: MTU %d too large for AF_XDP", ifname, mtu);
+        return EINVAL;
+    }
+    return open_socket(ifname, ifindex, NULL, opts, xskp);
+}
+
+/* Closes 'xsk', detaching its XDP program from the device. */
+void
+netdev_afxdp_close(struct netdev_afxdp *xsk)
+{
+    if (xsk) {
+        uint64_t *addrs = NULL;
+        size_t n_addrs = 0;
+        size_t i;
+
+        if (xsk->link_fd >= 0) {
+            close(xsk->link_fd);
+        }
+        if (xsk->prog_fd >= 0) {
+            close(xsk->prog_fd);
+        }
+        if (xsk->map_fd >= 0) {
+            close(xsk->map_fd);
+        }
+        if (xsk->pm) {
+            /* Note the chunks still on the rings, to free them once the
+             * kernel is done with the socket.  Each pair of rings is read
+             * downstream first, so a chunk the kernel moves between them
+             * meanwhile is leaked rather than freed twice. */
+            addrs = xmalloc((xsk->rx.mask + xsk->fill.mask + xsk->tx.mask
+                             + xsk->comp.mask + 4) * sizeof *addrs);
+            n_addrs += ring_addrs(&xsk->rx, true, addrs + n_addrs);
+            n_addrs += ring_addrs(&xsk->fill, false, addrs + n_addrs);
+            n_addrs += ring_addrs(&xsk->comp, false, addrs + n_addrs);
+            n_addrs += ring_addrs(&xsk->tx, true, addrs + n_addrs);
+        }
+        unmap_ring(&xsk->rx);
+        unmap_ring(&xsk->fill);
+        unmap_ring(&xsk->tx);
+        unmap_ring(&xsk->comp);
+        if (xsk->fd >= 0) {
+            close(xsk->fd);
+        }
+        for (i = 0; i < n_addrs; i++) {
+            ofpbuf_delete(pktmem_ofpbuf_at(xsk->pm, addrs[i]));
+        }
+        free(addrs);
+        if (xsk->umem && !xsk->pm) {
+            munmap(xsk->umem, xsk->umem_size);
+        }
+        list_remove(&xsk->node);
+        free(xsk->tx_free);
+        free(xsk->name);
+        free(xsk);
+    }
+}
+
+/* Returns the RX frame at 'addr' to the kernel. */
+static void
+refill(struct netdev_afxdp *xsk, uint64_t addr)
+{
+    ((uint64_t *) xsk->fill.descs)[*xsk->fill.producer & xsk->fill.mask]
+        = addr & ~(uint64_t) (xsk->frame_size - 1);
+    ring_produce(&xsk->fill, 1);
+    kick_fill(xsk);
+}
+
+/* Receives a packet from 'xsk' into 'buffer', like netdev_recv(). */
+int
+netdev_afxdp_recv(struct netdev_afxdp *xsk, struct ofpbuf *buffer)
+{
+    const struct xdp_desc *desc;
+    int error = 0;
+
+    if (!ring_ready(&xsk->rx)) {
+        kick_fill(xsk);
+        return EAGAIN;
+    }
+    desc = &((const struct xdp_desc *) xsk->rx.descs)[*xsk->rx.consumer
+                                                      & xsk->rx.mask];
+    if (desc->len <= ofpbuf_tailroom(buffer)) {
+        ofpbuf_put(buffer, xsk->umem + desc->addr, desc->len);
+    } else {
+        VLOG_WARN_RL(LOG_MODULE, &rl, "%s: dropping oversized %"PRIu32
+                     "-byte frame", xsk->name, desc->len);
+        error = EMSGSIZE;
+    }
+    refill(xsk, desc->addr);
+    ring_consume(&xsk->rx, 1);
+    return error;
+}
+
+/* Receives a packet from 'xsk' into a buffer of its own, which it stores in
+ * '*bufferp' and the caller must free, like netdev_recv_zerocopy().  Returns
+ * EOPNOTSUPP if the UMEM of 'xsk' is not a packet memory region. */
+int
+netdev_afxdp_recv_zerocopy(struct netdev_afxdp *xsk, struct ofpbuf **bufferp)
+{
+    const struct xdp_desc *desc;
+
+    if (!xsk->pm) {
+        return EOPNOTSUPP;
+    }
+    if (!ring_ready(&xsk->rx)) {
+        /* Make up for chunks the region lacked earlier. */
+        fill_chunks(xsk);
+        kick_fill(xsk);
+        return EAGAIN;
+    }
+    desc = &((const struct xdp_desc *) xsk->rx.descs)[*xsk->rx.consumer
+                                                      & xsk->rx.mask];
+    *bufferp = pktmem_ofpbuf_received(xsk->pm, desc->addr, desc->len);
+    ring_consume(&xsk->rx, 1);
+    xsk->n_fill_short++;
+    fill_chunks(xsk);
+    kick_fill(xsk);
+    return 0;
+}
+
+/* Discards all frames waiting to be received on 'xsk'. */
+void
+netdev_afxdp_drain(struct netdev_afxdp *xsk)
+{
+    uint32_t n = ring_ready(&xsk->rx);
+
+    while (n-- > 0) {
+        const struct xdp_desc *desc = &((const struct xdp_desc *)
+                        xsk->rx.descs)[*xsk->rx.consumer & xsk->rx.mask];
+        refill(xsk, desc->addr);
+        ring_consume(&xsk->rx, 1);
+    }
+}
+
+/* Takes back the TX frames the kernel has finished transmitting. */
+static void
+reap_completions(struct netdev_afxdp *xsk)
+{
+    uint32_t n = ring_ready(&xsk->comp);
+    uint32_t i;
+
+    for (i = 0; i < n; i++) {
+        uint64_t addr = ((uint64_t *) xsk->comp.descs)
+                                [(*xsk->comp.consumer + i) & xsk->comp.mask];
+
+        if (xsk->pm) {
+            ofpbuf_delete(pktmem_ofpbuf_at(xsk->pm, addr));
+        } else {
+            xsk->tx_free[xsk->n_tx_free] = addr;
+        }
+        xsk->n_tx_free++;
+    }
+    ring_consume(&xsk->comp, n);
+}
+
+/* Asks the kernel to transmit the frames queued on the TX ring.  In copy
+ * mode each call transmits a limited batch synchronously, so keep asking for
+ * as long as that makes progress. */
+static void
+kick_tx(struct netdev_afxdp *xsk)
+{
+    uint32_t consumer = __atomic_load_n(xsk->tx.consumer, __ATOMIC_ACQUIRE);
+
+    while (consumer != *xsk->tx.producer && ring_needs_wakeup(xsk, &xsk->tx)) {
+        uint32_t prev = consumer;
+
+        if (sendto(xsk->fd, NULL, 0, MSG_DONTWAIT, NULL, 0) < 0
+            && errno != EAGAIN && errno != EBUSY && errno != ENOBUFS) {
+            if (errno != ENETDOWN) {
+                VLOG_WARN_RL(LOG_MODULE, &rl, "%s: AF_XDP transmit failed: "
+                             "%s", xsk->name, strerror(errno));
+            }
+            break;
+        }
+        consumer = __atomic_load_n(xsk->tx.consumer, __ATOMIC_ACQUIRE);
+        if (consumer == prev) {
+            break;
+        }
+    }
+}
+
+/* Returns the largest packet 'xsk' can transmit. */
+size_t
+netdev_afxdp_get_max_send(const struct netdev_afxdp *xsk)
+{
+    return xsk->pm ? PKTMEM_BUF_DATA : FRAME_SIZE;
+}
+
+/* Queues the 'n' packets in 'buffers' for transmission on 'xsk' and kicks
+ * the kernel once for all of them.  A packet larger than
+ * netdev_afxdp_get_max_send() is dropped, and so are the packets for which no
+ * frame is free.  Returns the number of packets queued and stores the number
+ * of bytes they contained in '*n_bytes'.
+ *
+ * A packet is copied into a frame, except that if 'take' is true, one whose
+ * data already lies in a chunk of the UMEM is transmitted in place: its
+ * buffer is freed once the kernel is done with it, and replaced by NULL in
+ * 'buffers'.  The caller still owns the other buffers. */
+size_t
+netdev_afxdp_send(struct netdev_afxdp *xsk, struct ofpbuf **buffers, size_t n,
+                  bool take, size_t *n_bytes)
+{
+    uint32_t room;
+    size_t n_sent = 0;
+    size_t i;
+
+    *n_bytes = 0;
+    reap_completions(xsk);
+    if (xsk->n_tx_free < n) {
+        kick_tx(xsk);
+        reap_completions(xsk);
+    }
+    room = ring_room(&xsk->tx);
+
+    for (i = 0; i < n; i++) {
+        const struct ofpbuf *buffer = buffers[i];
+        struct xdp_desc *desc;
+        uint64_t addr;
+
+        if (!xsk->n_tx_free || !room) {
+            break;
+        }
+        if (buffer->size > netdev_afxdp_get_max_send(xsk)) {
+            VLOG_WARN_RL(LOG_MODULE, &rl, "%s: cannot send %zu-byte packet",
+                         xsk->name, buffer->size);
+            continue;
+        }
+        if (!xsk->pm) {
+            addr = xsk->tx_free[--xsk->n_tx_free];
+            memcpy(xsk->umem + addr, buffer->data, buffer->size);
+        } else if (take && buffer->pktmem == xsk->pm
+                   && pktmem_contains(xsk->pm, buffer->base)) {
+            addr = pktmem_offset(xsk->pm, buffer->data);
+            buffers[i] = NULL;
+            xsk->n_tx_free--;
+        } else {
+            struct ofpbuf *copy = take_chunk(xsk, buffer->size);
+
+            if (copy == NULL) {
+                break;
+            }
+            ofpbuf_put(copy, buffer->data, buffer->size);
+            addr = pktmem_offset(xsk->pm, copy->data);
+            xsk->n_tx_free--;
+        }
+        desc = &((struct xdp_desc *) xsk->tx.descs)
+                            [(*xsk->tx.producer + n_sent) & xsk->tx.mask];
+        desc->addr = addr;
+        desc->len = buffer->size;
+        desc->options = 0;
+        n_sent++;
+        room--;
+        *n_bytes += buffer->size;
+    }
+    if (n_sent) {
+        ring_produce(&xsk->tx, n_sent);
+        kick_tx(xsk);
+    }
+    return n_sent;
+}
+
+/* Stores in '*drops' the number of frames the kernel dropped on their way to
+ * 'xsk', because its RX ring was full or for other reasons, since it was
+ * opened.  Returns 0 if successful, otherwise a positive errno value. */
+int
+netdev_afxdp_get_drops(const struct netdev_afxdp *xsk, uint64_t *drops)
+{
+    struct xdp_statistics stats;
+    socklen_t len = sizeof stats;
+
+    /* Older kernels fill in only a prefix of the structure. */
+    memset(&stats, 0, sizeof stats);
+    if (getsockopt(xsk->fd, SOL_XDP, XDP_STATISTICS, &stats, &len) < 0) {
+        *drops = 0;
+        return errno;
+    }
+    *drops = stats.rx_dropped + stats.rx_ring_full;
+    return 0;
+}
+
+/* Returns the file descriptor to poll for frames to receive on 'xsk'. */
+int
+netdev_afxdp_get_fd(const struct netdev_afxdp *xsk)
+{
+    return xsk->fd;
+}
@@ -0,0 +1,149 @@
+/* Copyright (c) 2008, 2009 The Board of Trustees of The Leland Stanford
+ * Junior University
+ *
+ * We are making the OpenFlow specification and associated documentation
+ * (Software) available for public use and benefit with the expectation
+ * that others will use, modify and enhance the Software and contribute
+ * those enhancements back to the community. However, since we would
+ * like to make the Software available for broadest use, with as few
+ * restrictions as possible permission is hereby granted, free of
+ * charge, to any person obtaining a copy of this Software to deal in
+ * the Software under the copyrights without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * The name and trademarks of copyright holder(s) may NOT be used in
+ * advertising or publicity pertaining to the Software or any
+ * derivatives without specific, written prior permission.
+ */
+
+#ifndef NETDEV_AFXDP_H
+#define NETDEV_AFXDP_H 1
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "compiler.h"
+
+/* AF_XDP sockets for network devices.
+ *
+ * An AF_XDP socket is bound to a single receive queue of a device.  A small
+ * XDP program redirects the frames arriving on that queue into the socket's
+ * UMEM, an area of user memory shared with the kernel, bypassing the kernel
+ * network stack; frames on other queues are passed to the stack as usual.
+ * Frames are transmitted by placing them in the UMEM as well.
+ *
+ * Zero-copy mode is used when the driver supports it.  Otherwise the socket
+ * falls back to copy mode, which works on any device, including veth pairs,
+ * through generic XDP.
+ *
+ * Given a packet memory region, the sockets use it as a shared UMEM: a
+ * received frame becomes a packet buffer as it lies, and a packet buffer
+ * from the region is transmitted in place, so that frames forwarded between
+ * AF_XDP devices are never copied in user space.  Otherwise each socket has
+ * a UMEM of its own and frames are copied in and out of it. */
+
+#include <stdbool.h>
+
+struct ofpbuf;
+struct netdev_afxdp;
+struct pktmem;
+
+/* Default number of descriptors in the RX and TX rings. */
+#define NETDEV_AFXDP_RING_SIZE 1024
+
+struct netdev_afxdp_options {
+    uint32_t queue;             /* Device receive queue to bind to. */
+    uint32_t rx_ring;           /* RX (and fill) ring size, a power of 2. */
+    uint32_t tx_ring;           /* TX (and completion) ring size, likewise. */
+};
+
+#ifdef HAVE_AF_XDP
+int netdev_afxdp_parse(const char *spec, char **ifname,
+                       struct netdev_afxdp_options *);
+int netdev_afxdp_open(const char *ifname, int ifindex, int mtu,
+                      struct pktmem *, const struct netdev_afxdp_options *,
+                      struct netdev_afxdp **);
+void netdev_afxdp_close(struct netdev_afxdp *);
+
+int netdev_afxdp_recv(struct netdev_afxdp *, struct ofpbuf *);
+int netdev_afxdp_recv_zerocopy(struct netdev_afxdp *, struct ofpbuf **);
+void netdev_afxdp_drain(struct netdev_afxdp *);
+size_t netdev_afxdp_get_max_send(const struct netdev_afxdp *);
+size_t netdev_afxdp_send(struct netdev_afxdp *, struct ofpbuf **buffers,
+                         size_t n, bool take, size_t *n_bytes);
+int netdev_afxdp_get_drops(const struct netdev_afxdp *, uint64_t *drops);
+int netdev_afxdp_get_fd(const struct netdev_afxdp *);
+#else /* !HAVE_AF_XDP */
+/* Without AF_XDP support no socket can be opened, so the functions that
+ * operate on an open one are never reached. */
+static inline int
+netdev_afxdp_parse(const char *spec UNUSED, char **ifname UNUSED,
+                   struct netdev_afxdp_options *opts UNUSED)
+{
+    return EAFNOSUPPORT;
+}
+static inline int
+netdev_afxdp_open(const char *ifname UNUSED, int ifindex UNUSED,
+                  int mtu UNUSED, struct pktmem *pm UNUSED,
+                  const struct netdev_afxdp_options *opts UNUSED,
+                  struct netdev_afxdp **xskp)
+{
+    *xskp = NULL;
+    return EAFNOSUPPORT;
+}
+static inline void netdev_afxdp_close(struct netdev_afxdp *xsk UNUSED) {}
+static inline int
+netdev_afxdp_recv(struct netdev_afxdp *xsk UNUSED,
+                  struct ofpbuf *buffer UNUSED)
+{
+    return EAFNOSUPPORT;
+}
+static inline int
+netdev_afxdp_recv_zerocopy(struct netdev_afxdp *xsk UNUSED,
+                           struct ofpbuf **bufferp UNUSED)
+{
+    return EAFNOSUPPORT;
+}
+static inline void netdev_afxdp_drain(struct netdev_afxdp *xsk UNUSED) {}
+static inline size_t
+netdev_afxdp_get_max_send(const struct netdev_afxdp *xsk UNUSED)
+{
+    return 0;
+}
+static inline size_t
+netdev_afxdp_send(struct netdev_afxdp *xsk UNUSED,
+                  struct ofpbuf **buffers UNUSED, size_t n UNUSED,
+                  bool take UNUSED, size_t *n_bytes)
+{
+    *n_bytes = 0;
+    return 0;
+}
+static inline int
+netdev_afxdp_get_drops(const struct netdev_afxdp *xsk UNUSED, uint64_t *drops)
+{
+    *drops = 0;
+    return EAFNOSUPPORT;
+}
+static inline int
+netdev_afxdp_get_fd(const struct netdev_afxdp *xsk UNUSED)
+{
+    return -1;
+}
+#endif /* !HAVE_AF_XDP */
+
+#endif /* netdev-afxdp.h */
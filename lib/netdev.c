@@ -73,6 +73,7 @@
 #include <inttypes.h>
 #include <linux/if_tun.h>
 #include <linux/if_packet.h>
+#include <linux/virtio_net.h>
 
 
 #ifdef PACKET_AUXDATA
@@ -102,6 +103,7 @@
 #include <sys/types.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <net/ethernet.h>
 #include <net/if.h>
 #include <net/if_arp.h>
@@ -112,7 +114,9 @@
 #include <unistd.h>
 
 #include "fatal-signal.h"
+#include "gso.h"
 #include "list.h"
+#include "netdev-afxdp.h"
 #include "netlink.h"
 #include "ofpbuf.h"
 #include "openflow/openflow.h"
@@ -131,6 +135,9 @@
 #define LOG_MODULE VLM_netdev
 #include "vlog.h"
 
+/* Largest frame a device hands over with segmentation offload. */
+#define NETDEV_GSO_MAX_LEN (65535 + VLAN_ETH_HEADER_LEN)
+
 struct netdev {
     struct list node;
     char *name;
@@ -140,6 +147,13 @@ struct netdev {
     int netdev_fd;              /* Network device. */
     int tap_fd;                 /* TAP character device, if any, otherwise the
                                  * network device. */
+    struct netdev_afxdp *afxdp; /* AF_XDP socket used instead of the network
+                                 * device for best-effort traffic, if any. */
+    bool vnet_hdr;              /* Frames on 'tap_fd' have a virtio-net
+                                 * header, carrying checksum and segmentation
+                                 * offloads. */
+    uint64_t rx_drops;          /* Frames dropped by the kernel because the
+                                 * socket's receive queue was full. */
 
     /* one socket per queue.These are valid only for ordinary network devices*/
     int queue_fd[NETDEV_MAX_QUEUES + 1];
@@ -171,6 +185,9 @@ static struct list netdev_list = LIST_INITIALIZER(&netdev_list);
 /* An AF_INET socket (used for ioctl operations). */
 static int af_inet_sock = -1;
 
+/* Packet memory that AF_XDP sockets opened from now on use as UMEM. */
+static struct pktmem *afxdp_pktmem;
+
 /* This is set pretty low because we probably won't learn anything from the
  * additional log messages. */
 static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(5, 20);
@@ -179,6 +196,8 @@ static void init_netdev(void);
 static int do_open_netdev(const char *name, int ethertype, int tap_fd,
                           struct netdev **netdev_);
 static int restore_flags(struct netdev *netdev);
+static int send_segments(struct netdev *, const struct ofpbuf *,
+                         uint16_t class_id);
 static int get_flags(const char *netdev_name, int *flagsp);
 static int set_flags(const char *netdev_name, int flags);
 
@@ -665,6 +684,8 @@ netdev_open(const char *name, int ethertype, struct netdev **netdevp)
 {
     if (!strncmp(name, "tap:", 4)) {
         return netdev_open_tap(name + 4, netdevp);
+    } else if (!strncmp(name, "afxdp:", 6)) {
+        return netdev_open_afxdp(name + 6, netdevp);
     } else {
         return do_open_netdev(name, ethertype, -1, netdevp);
     }
@@ -690,7 +711,7 @@ netdev_open_tap(const char *name, struct netdev **netdevp)
     }
 
     memset(&ifr, 0, sizeof ifr);
-    ifr.ifr_flags = IFF_TAP | IFF_NO_PI;
+    ifr.ifr_flags = IFF_TAP | IFF_NO_PI | IFF_VNET_HDR;
     if (name) {
         strncpy(ifr.ifr_name, name, sizeof ifr.ifr_name);
     }
@@ -708,14 +729,70 @@ netdev_open_tap(const char *name, struct netdev **netdevp)
         return error;
     }
 
+    /* Let the kernel hand over unchecksummed frames and TCP super-frames
+     * instead of checksumming and segmenting them first. */
+    if (ioctl(tap_fd, TUNSETOFFLOAD,
+              TUN_F_CSUM | TUN_F_TSO4 | TUN_F_TSO6 | TUN_F_TSO_ECN) < 0) {
+        VLOG_WARN(LOG_MODULE, "ioctl(TUNSETOFFLOAD) on %s failed: %s",
+                  ifr.ifr_name, strerror(errno));
+    }
+
     error = do_open_netdev(ifr.ifr_name, NETDEV_ETH_TYPE_NONE, tap_fd,
                            netdevp);
     if (error) {
         close(tap_fd);
+    } else {
+        (*netdevp)->vnet_hdr = true;
     }
     return error;
 }
 
+/* Makes the AF_XDP sockets that netdev_open_afxdp() opens from now on share
+ * packet memory region 'pm' as their UMEM, so that netdev_recv_zerocopy()
+ * hands over their frames without a copy.  'pm' must outlive them. */
+void
+netdev_use_pktmem(struct pktmem *pm)
+{
+    afxdp_pktmem = pm;
+}
+
+/* Opens network device 'spec', of the form "IFNAME[:QUEUE][:rx=N][:tx=N]",
+ * receiving from and transmitting to receive queue QUEUE (default 0) of
+ * IFNAME through an AF_XDP socket with RX and TX rings of N descriptors.
+ * Returns zero if successful, otherwise a positive errno value.  On success,
+ * sets '*netdevp' to the new network device, otherwise to null. */
+int
+netdev_open_afxdp(const char *spec, struct netdev **netdevp)
+{
+    struct netdev_afxdp_options opts;
+    struct netdev_afxdp *afxdp;
+    char *ifname;
+    int error;
+
+    *netdevp = NULL;
+    error = netdev_afxdp_parse(spec, &ifname, &opts);
+    if (error) {
+        return error;
+    }
+
+    /* The packet socket is only used for configuration and for traffic to
+     * queues other than the best-effort one, so it need not receive. */
+    error = do_open_netdev(ifname, NETDEV_ETH_TYPE_NONE, -1, netdevp);
+    free(ifname);
+    if (error) {
+        return error;
+    }
+    error = netdev_afxdp_open((*netdevp)->name, (*netdevp)->ifindex,
+                              (*netdevp)->mtu, afxdp_pktmem, &opts, &afxdp);
+    if (error) {
+        netdev_close(*netdevp);
+        *netdevp = NULL;
+        return error;
+    }
+    (*netdevp)->afxdp = afxdp;
+    return 0;
+}
+
 static int
 do_open_netdev(const char *name, int ethertype, int tap_fd,
                struct netdev **netdev_)
@@ -729,6 +806,7 @@ do_open_netdev(const char *name, int ethertype, int tap_fd,
     int mtu;
     int txqlen;
     int hwaddr_family;
+    bool vnet_hdr = false;
     int error;
     struct netdev *netdev;
 
@@ -752,6 +830,14 @@ do_open_netdev(const char *name, int ethertype, int tap_fd,
           }
   #endif
 
+    /* Exchange frames with a virtio-net header, so that super-frames and
+     * unchecksummed frames can be received and sent as they are. */
+    if (tap_fd < 0) {
+        int val = 1;
+        vnet_hdr = !setsockopt(netdev_fd, SOL_PACKET, PACKET_VNET_HDR, &val,
+                               sizeof val);
+    }
+
     /* Set non-blocking mode. */
     error = set_nonblocking(netdev_fd);
     if (error) {
@@ -827,6 +913,9 @@ do_open_netdev(const char *name, int ethertype, int tap_fd,
     netdev->netdev_fd = netdev_fd;
     netdev->tap_fd = tap_fd < 0 ? netdev_fd : tap_fd;
     netdev->queue_fd[0] = netdev->tap_fd;
+    netdev->afxdp = NULL;
+    netdev->vnet_hdr = vnet_hdr;
+    netdev->rx_drops = 0;
     memcpy(netdev->etheraddr, etheraddr, sizeof etheraddr);
     netdev->mtu = mtu;
     netdev->in6 = in6;
@@ -879,6 +968,7 @@ netdev_close(struct netdev *netdev)
         }
 
         /* Free. */
+        netdev_afxdp_close(netdev->afxdp);
         free(netdev->name);
         close(netdev->netdev_fd);
         if (netdev->netdev_fd != netdev->tap_fd) {
@@ -898,10 +988,103 @@ static void
 pad_to_minimum_length(struct ofpbuf *buffer)
 {
     if (buffer->size < ETH_TOTAL_MIN) {
-        ofpbuf_put_zeros(buffer, ETH_TOTAL_MIN - buffer->size);
+        size_t pad = ETH_TOTAL_MIN - buffer->size;
+
+        ofpbuf_put_zeros(buffer, pad);
+        /* Zero bytes do not change a checksum, but they do move the end. */
+        if (buffer->offload.flags & OFPBUF_CSUM_PARTIAL) {
+            buffer->offload.csum_tail += pad;
+        }
+    }
+}
+
+/* Fills in the offload metadata of 'buffer', just received, from 'vnet'.
+ * Returns 0 if successful, otherwise a positive errno value. */
+static int
+offload_from_vnet_hdr(struct ofpbuf *buffer, const struct virtio_net_hdr *vnet)
+{
+    struct ofpbuf_offload *o = &buffer->offload;
+
+    memset(o, 0, sizeof *o);
+    if (vnet->flags & VIRTIO_NET_HDR_F_NEEDS_CSUM) {
+        if (vnet->csum_start + vnet->csum_offset + sizeof(uint16_t)
+            > buffer->size) {
+            return EINVAL;
+        }
+        o->flags |= OFPBUF_CSUM_PARTIAL;
+        o->csum_tail = buffer->size - vnet->csum_start;
+        o->csum_offset = vnet->csum_offset;
+    }
+
+    switch (vnet->gso_type & ~VIRTIO_NET_HDR_GSO_ECN) {
+    case VIRTIO_NET_HDR_GSO_NONE:
+        return 0;
+    case VIRTIO_NET_HDR_GSO_TCPV4:
+        o->gso_type = OFPBUF_GSO_TCPV4;
+        break;
+    case VIRTIO_NET_HDR_GSO_TCPV6:
+        o->gso_type = OFPBUF_GSO_TCPV6;
+        break;
+    default:
+        return EPROTONOSUPPORT;
+    }
+    o->gso_size = vnet->gso_size;
+    if (!(o->flags & OFPBUF_CSUM_PARTIAL)) {
+        /* A super-frame merged by GRO has complete checksums instead, so
+         * only the parsed headers tell where its TCP header starts. */
+        size_t l4;
+
+        if (!(vnet->flags & VIRTIO_NET_HDR_F_DATA_VALID)) {
+            return EINVAL;
+        }
+        l4 = gso_tcp_offset(buffer);
+        if (!l4) {
+            return EINVAL;
+        }
+        o->csum_tail = buffer->size - l4;
+        o->csum_offset = offsetof(struct tcp_header, tcp_csum);
+    }
+    return 0;
+}
+
+/* Fills in 'vnet' from the offload metadata of 'buffer', to be sent. */
+static void
+offload_to_vnet_hdr(const struct ofpbuf *buffer, struct virtio_net_hdr *vnet)
+{
+    const struct ofpbuf_offload *o = &buffer->offload;
+    size_t csum_start = buffer->size - o->csum_tail;
+
+    memset(vnet, 0, sizeof *vnet);
+    if (o->flags & OFPBUF_CSUM_PARTIAL) {
+        vnet->flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+        vnet->csum_start = csum_start;
+        vnet->csum_offset = o->csum_offset;
+    }
+    if (o->gso_type != OFPBUF_GSO_NONE
+        && csum_start + TCP_HEADER_LEN <= buffer->size) {
+        const struct tcp_header *tcp = (const struct tcp_header *)
+                                ((const uint8_t *) buffer->data + csum_start);
+
+        vnet->gso_type = (o->gso_type == OFPBUF_GSO_TCPV4
+                          ? VIRTIO_NET_HDR_GSO_TCPV4
+                          : VIRTIO_NET_HDR_GSO_TCPV6);
+        if (tcp->tcp_ctl & htons(0x80)) {
+            /* CWR must be cleared after the first segment. */
+            vnet->gso_type |= VIRTIO_NET_HDR_GSO_ECN;
+        }
+        vnet->gso_size = o->gso_size;
+        vnet->hdr_len = csum_start + TCP_OFFSET(tcp->tcp_ctl) * 4;
     }
 }
 
+/* Returns true if packets sent to 'class_id' of 'netdev' carry a virtio-net
+ * header, so that the device takes care of their offloads. */
+static bool
+tx_vnet_hdr(const struct netdev *netdev, uint16_t class_id)
+{
+    return netdev->vnet_hdr && class_id == 0 && !netdev->afxdp;
+}
+
 /* Attempts to receive a packet from 'netdev' into 'buffer', which the caller
  * must have initialized with sufficient room for the packet.  The space
  * required to receive any packet is ETH_HEADER_LEN bytes, plus VLAN_HEADER_LEN
@@ -913,70 +1096,77 @@ pad_to_minimum_length(struct ofpbuf *buffer)
  * guaranteed to contain at least ETH_TOTAL_MIN bytes.  Otherwise, returns a
  * positive errno value.  Returns EAGAIN immediately if no packet is ready to
  * be returned.
+ *
+ * A device that supports offloads may hand over a TCP super-frame larger than
+ * the MTU, in which case 'buffer' is expanded to hold it, and frames whose
+ * checksum is still to be completed; 'buffer->offload' describes both.
  */
 int
 netdev_recv(struct netdev *netdev, struct ofpbuf *buffer)
 {
-
+    /* Receives the part of a super-frame that does not fit in 'buffer'. */
+    static uint8_t overflow[NETDEV_GSO_MAX_LEN];
+    struct virtio_net_hdr vnet;
+    struct iovec iov[3];
+    size_t n_iov = 0;
+    size_t tailroom;
+    struct msghdr msg;
+    struct sockaddr_ll sll;
 #ifdef HAVE_PACKET_AUXDATA
     /* Code from libpcap to reconstruct VLAN header */
-    struct iovec    iov;
     struct cmsghdr    *cmsg;
-    struct msghdr     msg;
-    struct sockaddr   from;
     union {
       struct cmsghdr  cmsg;
       char    buf[CMSG_SPACE(sizeof(struct tpacket_auxdata))];
     } cmsg_buf;
-#else
-    struct sockaddr_ll sll;
-    socklen_t sll_len;
 #endif
     ssize_t n_bytes;
 
     assert(buffer->size == 0);
     assert(ofpbuf_tailroom(buffer) >= ETH_TOTAL_MIN);
 
+    if (netdev->afxdp) {
+        int error = netdev_afxdp_recv(netdev->afxdp, buffer);
+        if (!error) {
+            pad_to_minimum_length(buffer);
+        }
+        return error;
+    }
+
+    tailroom = ofpbuf_tailroom(buffer);
+    if (netdev->vnet_hdr) {
+        iov[n_iov].iov_base = &vnet;
+        iov[n_iov++].iov_len = sizeof vnet;
+    }
+    iov[n_iov].iov_base = ofpbuf_tail(buffer);
+    iov[n_iov++].iov_len = tailroom;
+    if (netdev->vnet_hdr) {
+        iov[n_iov].iov_base = overflow;
+        iov[n_iov++].iov_len = sizeof overflow;
+    }
+
+    memset(&msg, 0, sizeof msg);
+    memset(&sll, 0, sizeof sll);
+    msg.msg_name = &sll;
+    msg.msg_namelen = sizeof sll;
+    msg.msg_iov = iov;
+    msg.msg_iovlen = n_iov;
 #ifdef HAVE_PACKET_AUXDATA
     /* Code from libpcap to reconstruct VLAN header */
-    memset(&msg, 0, sizeof(struct msghdr));
     memset(cmsg_buf.buf, 0, CMSG_SPACE(sizeof(struct tpacket_auxdata)));
-
-    msg.msg_name    = &from;
-    msg.msg_namelen   = sizeof(from);
-    msg.msg_iov   = &iov;
-    msg.msg_iovlen    = 1;
-    msg.msg_control   = &cmsg_buf;
-    msg.msg_controllen  = sizeof(cmsg_buf);
-    msg.msg_flags   = 0;
-
-    iov.iov_len   = buffer->allocated;
-    iov.iov_base    = buffer->data;
-
-#else
-    /* prepare to call recvfrom */
-    memset(&sll,0,sizeof sll);
-    sll_len = sizeof sll;
+    msg.msg_control = &cmsg_buf;
+    msg.msg_controllen = sizeof cmsg_buf;
 #endif
 
-    /* cannot execute recvfrom over a tap device */
-    if (!strncmp(netdev->name, "tap", 3)) {
+    /* cannot execute recvmsg over a tap device */
+    if (netdev->tap_fd != netdev->netdev_fd) {
+        msg.msg_controllen = 0;
         do {
-            n_bytes = read(netdev->tap_fd, ofpbuf_tail(buffer),
-                           (ssize_t)ofpbuf_tailroom(buffer));
+            n_bytes = readv(netdev->tap_fd, iov, n_iov);
         } while (n_bytes < 0 && errno == EINTR);
-    }
-    else {
+    } else {
         do {
-#ifdef HAVE_PACKET_AUXDATA
-            /* Code from libpcap to reconstruct VLAN header */
             n_bytes = recvmsg(netdev->tap_fd, &msg, 0);
-#else
-            n_bytes = recvfrom(netdev->tap_fd, ofpbuf_tail(buffer),
-                               (ssize_t)ofpbuf_tailroom(buffer), 0,
-                               (struct sockaddr *)&sll, &sll_len);
-
-#endif /* ifdef HAVE_PACKET_AUXDATA  */
         } while (n_bytes < 0 && errno == EINTR);
     }
     if (n_bytes < 0) {
@@ -985,50 +1175,89 @@ netdev_recv(struct netdev *netdev, struct ofpbuf *buffer)
                          strerror(errno), netdev->name);
         }
         return errno;
-    } else {
-
-#ifdef HAVE_PACKET_AUXDATA
-            /* Code from libpcap to reconstruct VLAN header */
-            for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
-                struct tpacket_auxdata *aux;
-                struct vlan_tag *tag;
-
-                buffer->size += n_bytes;
+    }
+#ifndef HAVE_PACKET_AUXDATA
+    /* we have multiple raw sockets at the same interface, so we also
+     * receive what others send, and need to filter them out.
+     * TODO(yiannisy): can we install this as a BPF at kernel?*/
+    if (sll.sll_pkttype == PACKET_OUTGOING) {
+        return EAGAIN;
+    }
+#endif
 
-                if (cmsg->cmsg_len < CMSG_LEN(sizeof(struct tpacket_auxdata)) ||
-                    cmsg->cmsg_level != SOL_PACKET ||
-                    cmsg->cmsg_type != PACKET_AUXDATA){
-                    continue;
-                }
-                aux = (struct tpacket_auxdata *)CMSG_DATA(cmsg);
-                if (aux->tp_vlan_tci == 0)
-                  continue;
-                buffer->size += + sizeof(struct vlan_tag);
-                buffer->data = (uint8_t *)(buffer->data) - VLAN_HEADER_LEN;
-                memmove(buffer->data,(uint8_t*)buffer->data + VLAN_HEADER_LEN, ETH_ALEN * 2);
-                tag = (struct vlan_tag *)((uint8_t*)buffer->data + ETH_ALEN * 2);
-                tag->vlan_tp_id = htons(ETH_P_8021Q);
-                tag->vlan_tci = htons(aux->tp_vlan_tci);
-            }
-#else
-        /* we have multiple raw sockets at the same interface, so we also
-         * receive what others send, and need to filter them out.
-         * TODO(yiannisy): can we install this as a BPF at kernel?*/
-        if (sll.sll_pkttype == PACKET_OUTGOING) {
+    if (netdev->vnet_hdr) {
+        if (n_bytes < sizeof vnet) {
             return EAGAIN;
         }
+        n_bytes -= sizeof vnet;
+    }
+    if (n_bytes > tailroom) {
+        buffer->size += tailroom;
+        ofpbuf_put(buffer, overflow, n_bytes - tailroom);
+    } else {
         buffer->size += n_bytes;
+    }
+    if (netdev->vnet_hdr) {
+        int error = offload_from_vnet_hdr(buffer, &vnet);
+        if (error) {
+            VLOG_WARN_RL(LOG_MODULE, &rl, "dropping frame with unsupported "
+                         "offloads (flags %#x, GSO type %#x) on %s",
+                         vnet.flags, vnet.gso_type, netdev->name);
+            buffer->size = 0;
+            memset(&buffer->offload, 0, sizeof buffer->offload);
+            return EAGAIN;
+        }
+    }
 
-        /* When the kernel internally sends out an Ethernet frame on an
-         * interface, it gives us a copy *before* padding the frame to the
-         * minimum length.  Thus, when it sends out something like an ARP
-         * request, we see a too-short frame.  So pad it out to the minimum
-         * length. */
-        pad_to_minimum_length(buffer);
-#endif
-        return 0;
+#ifdef HAVE_PACKET_AUXDATA
+    /* Code from libpcap to reconstruct VLAN header */
+    for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        struct tpacket_auxdata *aux;
+        struct vlan_tag *tag;
+
+        if (cmsg->cmsg_len < CMSG_LEN(sizeof(struct tpacket_auxdata)) ||
+            cmsg->cmsg_level != SOL_PACKET ||
+            cmsg->cmsg_type != PACKET_AUXDATA){
+            continue;
+        }
+        aux = (struct tpacket_auxdata *)CMSG_DATA(cmsg);
+        if (aux->tp_vlan_tci == 0)
+          continue;
+        buffer->size += + sizeof(struct vlan_tag);
+        buffer->data = (uint8_t *)(buffer->data) - VLAN_HEADER_LEN;
+        memmove(buffer->data,(uint8_t*)buffer->data + VLAN_HEADER_LEN, ETH_ALEN * 2);
+        tag = (struct vlan_tag *)((uint8_t*)buffer->data + ETH_ALEN * 2);
+        tag->vlan_tp_id = htons(ETH_P_8021Q);
+        tag->vlan_tci = htons(aux->tp_vlan_tci);
     }
+#endif
 
+    /* When the kernel internally sends out an Ethernet frame on an
+     * interface, it gives us a copy *before* padding the frame to the
+     * minimum length.  Thus, when it sends out something like an ARP
+     * request, we see a too-short frame.  So pad it out to the minimum
+     * length. */
+    pad_to_minimum_length(buffer);
+    return 0;
+}
+
+/* Like netdev_recv(), but hands over the packet in a buffer that 'netdev'
+ * received it into, which it stores in '*bufferp' and the caller must free.
+ * Returns EOPNOTSUPP if 'netdev' cannot do so, which is the case unless it is
+ * an AF_XDP device sharing packet memory (see netdev_use_pktmem()). */
+int
+netdev_recv_zerocopy(struct netdev *netdev, struct ofpbuf **bufferp)
+{
+    int error;
+
+    if (!netdev->afxdp) {
+        return EOPNOTSUPP;
+    }
+    error = netdev_afxdp_recv_zerocopy(netdev->afxdp, bufferp);
+    if (!error) {
+        pad_to_minimum_length(*bufferp);
+    }
+    return error;
 }
 
 /* Registers with the poll loop to wake up from the next call to poll_block()
@@ -1036,14 +1265,21 @@ netdev_recv(struct netdev *netdev, struct ofpbuf *buffer)
 void
 netdev_recv_wait(struct netdev *netdev)
 {
-    poll_fd_wait(netdev->tap_fd, POLLIN);
+    if (netdev->afxdp) {
+        poll_fd_wait(netdev_afxdp_get_fd(netdev->afxdp), POLLIN);
+    } else {
+        poll_fd_wait(netdev->tap_fd, POLLIN);
+    }
 }
 
 /* Discards all packets waiting to be received from 'netdev'. */
 int
 netdev_drain(struct netdev *netdev)
 {
-    if (netdev->tap_fd != netdev->netdev_fd) {
+    if (netdev->afxdp) {
+        netdev_afxdp_drain(netdev->afxdp);
+        return 0;
+    } else if (netdev->tap_fd != netdev->netdev_fd) {
         drain_fd(netdev->tap_fd, netdev->txqlen);
         return 0;
     } else {
@@ -1059,7 +1295,9 @@ netdev_drain(struct netdev *netdev)
  * class_id denotes the queue to send the packet. If 0, it goes to the
  * default,best-effort queue.
  *
- * The caller retains ownership of 'buffer' in all cases.
+ * The caller retains ownership of 'buffer' in all cases.  If 'netdev' cannot
+ * take the offloads 'buffer' carries, its checksum is completed in place and
+ * a super-frame is sent as separate segments.
  *
  * The kernel maintains a packet transmission queue, so the caller is not
  * expected to do additional queuing of packets.
@@ -1068,12 +1306,45 @@ int
 netdev_send(struct netdev *netdev, const struct ofpbuf *buffer,
             uint16_t class_id)
 {
+    struct virtio_net_hdr vnet;
+    struct iovec iov[2];
+    size_t n_iov = 0;
+    size_t hdr_len = 0;
     ssize_t n_bytes;
 
     assert(class_id <= NETDEV_MAX_QUEUES);
 
+    if (!tx_vnet_hdr(netdev, class_id)) {
+        if (buffer->offload.gso_type != OFPBUF_GSO_NONE) {
+            return send_segments(netdev, buffer, class_id);
+        }
+        /* Completing the checksum leaves the packet's contents the same. */
+        gso_complete_csum((struct ofpbuf *) buffer);
+    }
+
+    if (netdev->afxdp && class_id == 0) {
+        struct ofpbuf *buffers[1];
+        size_t n_sent_bytes;
+
+        if (buffer->size > netdev_afxdp_get_max_send(netdev->afxdp)) {
+            return EMSGSIZE;
+        }
+        buffers[0] = (struct ofpbuf *) buffer;
+        return (netdev_afxdp_send(netdev->afxdp, buffers, 1, false,
+                                  &n_sent_bytes)
+                ? 0 : EAGAIN);
+    }
+
+    if (tx_vnet_hdr(netdev, class_id)) {
+        offload_to_vnet_hdr(buffer, &vnet);
+        iov[n_iov].iov_base = &vnet;
+        iov[n_iov++].iov_len = hdr_len = sizeof vnet;
+    }
+    iov[n_iov].iov_base = buffer->data;
+    iov[n_iov++].iov_len = buffer->size;
+
     do {
-        n_bytes = write(netdev->queue_fd[class_id], buffer->data, buffer->size);
+        n_bytes = writev(netdev->queue_fd[class_id], iov, n_iov);
     } while (n_bytes < 0 && errno == EINTR);
 
     if (n_bytes < 0) {
@@ -1087,7 +1358,7 @@ netdev_send(struct netdev *netdev, const struct ofpbuf *buffer,
                          netdev->name, strerror(errno));
         }
         return errno;
-    } else if (n_bytes != buffer->size) {
+    } else if (n_bytes != hdr_len + buffer->size) {
         VLOG_WARN_RL(LOG_MODULE, &rl,
                      "send partial Ethernet packet (%d bytes of %zu) on %s",
                      (int) n_bytes, buffer->size, netdev->name);
@@ -1097,6 +1368,147 @@ netdev_send(struct netdev *netdev, const struct ofpbuf *buffer,
     }
 }
 
+/* Sends super-frame 'buffer' on 'netdev', which cannot take it whole, as
+ * separate segments. */
+static int
+send_segments(struct netdev *netdev, const struct ofpbuf *buffer,
+              uint16_t class_id)
+{
+    struct ofpbuf *seg, *next;
+    int error = 0;
+
+    seg = gso_segment(buffer);
+    if (seg == NULL) {
+        return EINVAL;
+    }
+    for (; seg != NULL; seg = next) {
+        next = seg->next;
+        if (!error) {
+            error = netdev_send(netdev, seg, class_id);
+        }
+        ofpbuf_delete(seg);
+    }
+    return error;
+}
+
+/* Maximum number of packets handed to the kernel in one sendmmsg() call. */
+#define NETDEV_SEND_BATCH 32
+
+/* Sends the 'n' packets in 'buffers' on 'netdev' in order, like as many calls
+ * to netdev_send() would, but with a single sendmmsg() system call for every
+ * NETDEV_SEND_BATCH packets when 'netdev' is a packet socket.  A packet that
+ * cannot be sent, e.g. for being too large, is dropped and the remaining ones
+ * are still attempted.
+ *
+ * Returns the number of packets sent, and stores the number of bytes they
+ * contained in '*n_bytes'.  The buffers are not freed, except that an AF_XDP
+ * device may transmit a buffer from its UMEM in place, in which case it
+ * takes the buffer over and replaces it by NULL in 'buffers'. */
+size_t
+netdev_send_batch(struct netdev *netdev, struct ofpbuf **buffers, size_t n,
+                  uint16_t class_id, size_t *n_bytes)
+{
+    struct mmsghdr msgs[NETDEV_SEND_BATCH];
+    struct iovec iovs[NETDEV_SEND_BATCH][2];
+    struct virtio_net_hdr vnets[NETDEV_SEND_BATCH];
+    bool vnet_hdr = tx_vnet_hdr(netdev, class_id);
+    size_t hdr_len = vnet_hdr ? sizeof *vnets : 0;
+    int fd;
+    size_t n_sent = 0;
+    size_t i = 0;
+
+    assert(class_id <= NETDEV_MAX_QUEUES);
+    fd = netdev->queue_fd[class_id];
+    *n_bytes = 0;
+
+    if (!vnet_hdr) {
+        /* Complete checksums up to the first super-frame, which must be
+         * segmented, then carry on after it. */
+        for (i = 0; i < n; i++) {
+            if (buffers[i]->offload.gso_type != OFPBUF_GSO_NONE) {
+                size_t rest_bytes;
+
+                n_sent = netdev_send_batch(netdev, buffers, i, class_id,
+                                           n_bytes);
+                if (!send_segments(netdev, buffers[i], class_id)) {
+                    n_sent++;
+                    *n_bytes += buffers[i]->size;
+                }
+                n_sent += netdev_send_batch(netdev, buffers + i + 1,
+                                            n - i - 1, class_id, &rest_bytes);
+                *n_bytes += rest_bytes;
+                return n_sent;
+            }
+            gso_complete_csum(buffers[i]);
+        }
+        i = 0;
+    }
+
+    if (netdev->afxdp && class_id == 0) {
+        return netdev_afxdp_send(netdev->afxdp, buffers, n, true, n_bytes);
+    }
+
+    /* A TAP character device is not a socket. */
+    if (netdev->tap_fd != netdev->netdev_fd && fd == netdev->tap_fd) {
+        for (i = 0; i < n; i++) {
+            if (!netdev_send(netdev, buffers[i], class_id)) {
+                n_sent++;
+                *n_bytes += buffers[i]->size;
+            }
+        }
+        return n_sent;
+    }
+
+    while (i < n) {
+        size_t n_msgs = MIN(n - i, NETDEV_SEND_BATCH);
+        size_t j;
+        int retval;
+
+        for (j = 0; j < n_msgs; j++) {
+            struct iovec *iov = iovs[j];
+
+            memset(&msgs[j], 0, sizeof msgs[j]);
+            msgs[j].msg_hdr.msg_iov = iov;
+            if (vnet_hdr) {
+                offload_to_vnet_hdr(buffers[i + j], &vnets[j]);
+                iov->iov_base = &vnets[j];
+                iov->iov_len = hdr_len;
+                iov++;
+            }
+            iov->iov_base = buffers[i + j]->data;
+            iov->iov_len = buffers[i + j]->size;
+            msgs[j].msg_hdr.msg_iovlen = iov - iovs[j] + 1;
+        }
+
+        do {
+            retval = sendmmsg(fd, msgs, n_msgs, 0);
+        } while (retval < 0 && errno == EINTR);
+
+        if (retval <= 0) {
+            /* The first packet failed.  Drop it, as netdev_send() would, and
+             * carry on with the next one. */
+            if (retval < 0 && errno != EAGAIN && errno != ENOBUFS) {
+                VLOG_WARN_RL(LOG_MODULE, &rl, "error sending Ethernet packet "
+                             "on %s: %s", netdev->name, strerror(errno));
+            }
+            i++;
+            continue;
+        }
+        for (j = 0; j < retval; j++) {
+            if (msgs[j].msg_len == hdr_len + buffers[i + j]->size) {
+                n_sent++;
+                *n_bytes += buffers[i + j]->size;
+            } else {
+                VLOG_WARN_RL(LOG_MODULE, &rl, "send partial Ethernet packet "
+                             "(%u bytes of %zu) on %s", msgs[j].msg_len,
+                             buffers[i + j]->size, netdev->name);
+            }
+        }
+        i += retval;
+    }
+    return n_sent;
+}
+
 /* Registers with the poll loop to wake up from the next call to poll_block()
  * when the packet transmission queue has sufficient room to transmit a packet
  * with netdev_send().
@@ -1160,6 +1572,35 @@ netdev_get_mtu(const struct netdev *netdev)
     return netdev->mtu;
 }
 
+/* Stores in '*drops' the number of received frames that the kernel dropped
+ * since 'netdev' was opened, because they were not read quickly enough.
+ * Returns 0 if successful, otherwise a positive errno value; EOPNOTSUPP for
+ * tap devices, whose drops are not attributed to any socket. */
+int
+netdev_get_rx_drops(struct netdev *netdev, uint64_t *drops)
+{
+    struct tpacket_stats stats;
+    socklen_t len = sizeof stats;
+
+    if (netdev->afxdp) {
+        return netdev_afxdp_get_drops(netdev->afxdp, drops);
+    }
+    if (netdev->tap_fd != netdev->netdev_fd) {
+        *drops = 0;
+        return EOPNOTSUPP;
+    }
+
+    /* Reading the statistics resets them, so they are accumulated. */
+    if (getsockopt(netdev->netdev_fd, SOL_PACKET, PACKET_STATISTICS,
+                   &stats, &len) < 0) {
+        *drops = netdev->rx_drops;
+        return errno;
+    }
+    netdev->rx_drops += stats.tp_drops;
+    *drops = netdev->rx_drops;
+    return 0;
+}
+
 /* Returns the features supported by 'netdev' of type 'type', as a bitmap
  * of bits from enum ofp_phy_features, in host byte order. */
 uint32_t
@@ -1437,7 +1878,10 @@ netdev_nodev_get_flags(const char *netdev_name, enum netdev_flags *flagsp)
     if (flags & IFF_PROMISC) {
         *flagsp |= NETDEV_PROMISC;
     }
-    if (flags & IFF_LOWER_UP) {
+    /* SIOCGIFFLAGS only returns the low 16 bits of the flags, which do not
+     * include IFF_LOWER_UP, but the kernel sets IFF_RUNNING only while the
+     * device is up and has carrier. */
+    if (flags & IFF_RUNNING) {
         *flagsp |= NETDEV_CARRIER;
     }
     return 0;
@@ -1555,6 +1999,7 @@ netdev_monitor_poll(struct netdev_monitor *mon)
                                  rtnlgrp_link_policy,
                                  attrs, ARRAY_SIZE(rtnlgrp_link_policy))) {
                 VLOG_WARN_RL(LOG_MODULE, &slow_rl, "received bad rtnl message");
+                ofpbuf_delete(buf);
                 return all_netdevs_changed(mon);
             }
             name = lookup_netdev(mon, nl_attr_get_string(attrs[IFLA_IFNAME]));
@@ -45,6 +45,7 @@
  * operating systems as well. */
 
 struct ofpbuf;
+struct pktmem;
 struct in_addr;
 struct in6_addr;
 struct svec;
@@ -74,17 +75,23 @@ struct netdev;
 
 int netdev_open(const char *name, int ethertype, struct netdev **);
 int netdev_open_tap(const char *name, struct netdev **);
+int netdev_open_afxdp(const char *spec, struct netdev **);
+void netdev_use_pktmem(struct pktmem *);
 void netdev_close(struct netdev *);
 
 int netdev_recv(struct netdev *, struct ofpbuf *);
+int netdev_recv_zerocopy(struct netdev *, struct ofpbuf **);
 void netdev_recv_wait(struct netdev *);
 int netdev_drain(struct netdev *);
 int netdev_send(struct netdev *, const struct ofpbuf *, uint16_t class_id);
+size_t netdev_send_batch(struct netdev *, struct ofpbuf **, size_t n,
+                         uint16_t class_id, size_t *n_bytes);
 void netdev_send_wait(struct netdev *);
 int netdev_set_etheraddr(struct netdev *, const uint8_t mac[6]);
 const uint8_t *netdev_get_etheraddr(const struct netdev *);
 const char *netdev_get_name(const struct netdev *);
 int netdev_get_mtu(const struct netdev *);
+int netdev_get_rx_drops(struct netdev *, uint64_t *drops);
 uint32_t netdev_get_features(struct netdev *, int);
 bool netdev_get_in4(const struct netdev *, struct in_addr *);
 int netdev_set_in4(struct netdev *, struct in_addr addr, struct in_addr mask);
@@ -36,6 +36,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "dynamic-string.h"
+#include "pktmem.h"
 #include "util.h"
 
 /* Initializes 'b' as an empty ofpbuf that contains the 'allocated' bytes of
@@ -50,10 +51,21 @@ ofpbuf_use(struct ofpbuf *b, void *base, size_t allocated)
 {
     b->base = b->data = base;
     b->allocated = allocated;
+    b->conn_id = 0;
     b->size = 0;
     b->l2 = b->l3 = b->l4 = b->l7 = NULL;
     b->next = NULL;
     b->private_p = NULL;
+    memset(&b->offload, 0, sizeof b->offload);
+    b->pktmem = NULL;
+}
+
+/* Returns true if the data of 'b' is in its packet memory chunk, rather than
+ * malloc()'d. */
+static bool
+ofpbuf_data_in_pktmem(const struct ofpbuf *b)
+{
+    return b->pktmem != NULL && pktmem_contains(b->pktmem, b->base);
 }
 
 /* Initializes 'b' as an empty ofpbuf with an initial capacity of 'size'
@@ -68,7 +80,7 @@ ofpbuf_init(struct ofpbuf *b, size_t size)
 void
 ofpbuf_uninit(struct ofpbuf *b)
 {
-    if (b) {
+    if (b && !ofpbuf_data_in_pktmem(b)) {
         free(b->base);
     }
 }
@@ -104,7 +116,10 @@ ofpbuf_new_with_headroom(size_t size, size_t headroom)
 struct ofpbuf *
 ofpbuf_clone(const struct ofpbuf *buffer)
 {
-    return ofpbuf_clone_data(buffer->data, buffer->size);
+    struct ofpbuf *b = ofpbuf_clone_data(buffer->data, buffer->size);
+    b->conn_id = buffer->conn_id;
+    b->offload = buffer->offload;
+    return b;
 }
 
 /* Creates and returns a new ofpbuf whose data are copied from 'buffer'.   The
@@ -114,6 +129,8 @@ ofpbuf_clone_with_headroom(const struct ofpbuf *buffer, size_t headroom)
 {
     struct ofpbuf *b = ofpbuf_new_with_headroom(buffer->size, headroom);
     ofpbuf_put(b, buffer->data, buffer->size);
+    b->conn_id = buffer->conn_id;
+    b->offload = buffer->offload;
     return b;
 }
 
@@ -131,7 +148,11 @@ ofpbuf_delete(struct ofpbuf *b)
 {
     if (b) {
         ofpbuf_uninit(b);
-        free(b);
+        if (b->pktmem) {
+            pktmem_ofpbuf_free(b);
+        } else {
+            free(b);
+        }
     }
 }
 
@@ -177,12 +198,22 @@ ofpbuf_rebase__(struct ofpbuf *b, void *new_base)
     }
 }
 
-/* Reallocates 'b' so that it has exactly 'new_tailroom' bytes of tailroom. */
+/* Reallocates 'b' so that it has exactly 'new_tailroom' bytes of tailroom.
+ * Data in a packet memory chunk, which cannot be resized, moves to malloc()'d
+ * memory. */
 static void
 ofpbuf_resize_tailroom__(struct ofpbuf *b, size_t new_tailroom)
 {
-    b->allocated = ofpbuf_headroom(b) + b->size + new_tailroom;
-    ofpbuf_rebase__(b, xrealloc(b->base, b->allocated));
+    size_t used = ofpbuf_headroom(b) + b->size;
+
+    b->allocated = used + new_tailroom;
+    if (ofpbuf_data_in_pktmem(b)) {
+        void *new_base = xmalloc(b->allocated);
+        memcpy(new_base, b->base, used);
+        ofpbuf_rebase__(b, new_base);
+    } else {
+        ofpbuf_rebase__(b, xrealloc(b->base, b->allocated));
+    }
 }
 
 /* Ensures that 'b' has room for at least 'size' bytes at its tail end,
@@ -37,6 +37,32 @@
 #include <stddef.h>
 #include <stdint.h>
 
+struct pktmem;
+
+/* Offload metadata of a packet exchanged with a device through a virtio-net
+ * header: a transport checksum still to be completed, and segmentation of a
+ * TCP super-frame into 'gso_size'-byte segments.  'csum_tail' counts back
+ * from the end of the packet, so it stays valid while actions push and pop
+ * headers at the front.  It locates the TCP header of a super-frame even if
+ * the checksum is complete. */
+struct ofpbuf_offload {
+    uint8_t flags;              /* OFPBUF_CSUM_PARTIAL. */
+    uint8_t gso_type;           /* One of OFPBUF_GSO_*. */
+    uint16_t gso_size;          /* Segment payload size, for GSO. */
+    uint16_t csum_offset;       /* Checksum field offset from its start. */
+    uint32_t csum_tail;         /* Bytes from checksum start to packet end. */
+};
+
+/* The transport checksum field holds only the pseudo-header sum, and the
+ * checksum must be computed from 'csum_tail' bytes before the end. */
+#define OFPBUF_CSUM_PARTIAL 0x01
+
+enum {
+    OFPBUF_GSO_NONE,
+    OFPBUF_GSO_TCPV4,
+    OFPBUF_GSO_TCPV6
+};
+
 /* Buffer for holding arbitrary data.  An ofpbuf is automatically reallocated
  * as necessary if it grows too large for the available memory. */
 struct ofpbuf {
@@ -56,6 +82,11 @@ struct ofpbuf {
 
     struct ofpbuf *next;        /* Next in a list of ofpbufs. */
     void *private_p;            /* Private pointer for use by owner. */
+
+    struct ofpbuf_offload offload; /* Zero unless received with offloads. */
+
+    struct pktmem *pktmem;      /* Region whose chunk holds this ofpbuf, or
+                                 * NULL if it was allocated otherwise. */
 };
 
 void ofpbuf_use(struct ofpbuf *, void *, size_t);
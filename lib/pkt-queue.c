@@ -0,0 +1,211 @@
+/* Copyright (c) 2008, 2009 The Board of Trustees of The Leland Stanford
+ * Junior University
+ *
+ * We are making the OpenFlow specification and associated documentation
+ * (Software) available for public use and benefit with the expectation
+ * that others will use, modify and enhance the Software and contribute
+ * those enhancements back to the community. However, since we would
+ * like to make the Software available for broadest use, with as few
+ * restrictions as possible permission is hereby granted, free of
+ * charge, to any person obtaining a copy of this Software to deal in
+ * the Software under the copyrights without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * The name and trademarks of copyright holder(s) may NOT be used in
+ * advertising or publicity pertaining to the Software or any
+ * derivatives without specific, written prior permission.
+ */
+
+#include <config.h>
+#include "pkt-queue.h"
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include "ofpbuf.h"
+#include "poll-loop.h"
+#include "util.h"
+
+#define LOG_MODULE VLM_pkt_queue
+#include "vlog.h"
+
+static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(5, 20);
+
+/* 'head' and 'tail' are free-running counters, each written by one side
+ * only, on separate cache lines.  The full fences in pkt_queue_enqueue() and
+ * pkt_queue_wait() make sure that at least one side sees the other's
+ * update, so a packet is never left behind while the consumer sleeps. */
+struct pkt_queue {
+    /* Written by the producer. */
+    unsigned int head __attribute__((aligned(64))); /* Next slot to fill. */
+    unsigned int tail_cache;    /* Last 'tail' the producer read. */
+    uint64_t dropped;           /* Packets dropped because the queue was
+                                 * full. */
+
+    /* Written by the consumer. */
+    unsigned int tail __attribute__((aligned(64))); /* Next slot to drain. */
+
+    int wake_fd;                /* eventfd, signalled when a packet is queued
+                                 * while the consumer may be waiting. */
+    struct pkt_queue_entry entries[PKT_QUEUE_SIZE];
+};
+
+/* Creates an empty packet queue and stores it in '*qp'.  Returns 0 if
+ * successful, otherwise a positive errno value. */
+int
+pkt_queue_create(struct pkt_queue **qp)
+{
+    struct pkt_queue *q;
+    int fd;
+
+    *qp = NULL;
+    fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd < 0) {
+        int error = errno;
+        VLOG_ERR(LOG_MODULE, "eventfd failed: %s", strerror(error));
+        return error;
+    }
+    q = xmalloc(sizeof *q);
+    memset(q, 0, sizeof *q);
+    q->wake_fd = fd;
+    *qp = q;
+    return 0;
+}
+
+/* Destroys 'q' and the packets still queued on it.  Neither side may use
+ * 'q' any longer. */
+void
+pkt_queue_destroy(struct pkt_queue *q)
+{
+    if (q) {
+        struct pkt_queue_entry e;
+
+        while (pkt_queue_dequeue(q, &e, 1)) {
+            ofpbuf_delete(e.buffer);
+        }
+        close(q->wake_fd);
+        free(q);
+    }
+}
+
+/* Queues 'buffer', received on 'port_no' for 'reason', on 'q', or drops it
+ * if 'q' is full.  Takes ownership of 'buffer' either way.  Called from the
+ * producer's thread only. */
+void
+pkt_queue_enqueue(struct pkt_queue *q, struct ofpbuf *buffer,
+                  uint32_t port_no, int reason)
+{
+    unsigned int head = q->head;
+    struct pkt_queue_entry *e;
+
+    if (head - q->tail_cache >= PKT_QUEUE_SIZE) {
+        q->tail_cache = __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+        if (head - q->tail_cache >= PKT_QUEUE_SIZE) {
+            __atomic_store_n(&q->dropped, q->dropped + 1, __ATOMIC_RELAXED);
+            ofpbuf_delete(buffer);
+            return;
+        }
+    }
+    e = &q->entries[head & (PKT_QUEUE_SIZE - 1)];
+    e->buffer = buffer;
+    e->port_no = port_no;
+    e->reason = reason;
+    __atomic_store_n(&q->head, head + 1, __ATOMIC_RELEASE);
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&q->tail, __ATOMIC_RELAXED) == head) {
+        uint64_t one = 1;
+        ssize_t n;
+
+        do {
+            n = write(q->wake_fd, &one, sizeof one);
+        } while (n < 0 && errno == EINTR);
+        /* EAGAIN means the counter is about to overflow, so the consumer
+         * is due to wake up anyway. */
+        if (n < 0 && errno != EAGAIN) {
+            VLOG_WARN_RL(LOG_MODULE, &rl, "eventfd write failed: %s",
+                         strerror(errno));
+        } else if (n >= 0 && n != sizeof one) {
+            VLOG_WARN_RL(LOG_MODULE, &rl, "short eventfd write (%zd bytes)",
+                         n);
+        }
+    }
+}
+
+/* Resets the signal of 'q', so that the next pkt_queue_wait() sleeps until
+ * a packet is queued after this call.  The consumer calls it before draining
+ * 'q'. */
+void
+pkt_queue_clear_wakeup(struct pkt_queue *q)
+{
+    uint64_t count;
+    ssize_t n;
+
+    do {
+        n = read(q->wake_fd, &count, sizeof count);
+    } while (n < 0 && errno == EINTR);
+    /* EAGAIN just means that no signal is pending. */
+    if (n < 0 && errno != EAGAIN) {
+        VLOG_WARN_RL(LOG_MODULE, &rl, "eventfd read failed: %s",
+                     strerror(errno));
+    } else if (n >= 0 && n != sizeof count) {
+        VLOG_WARN_RL(LOG_MODULE, &rl, "short eventfd read (%zd bytes)", n);
+    }
+}
+
+/* Moves up to 'max' queued packets into 'entries' and returns the number
+ * moved.  Called from the consumer's thread only. */
+size_t
+pkt_queue_dequeue(struct pkt_queue *q, struct pkt_queue_entry *entries,
+                  size_t max)
+{
+    unsigned int tail = q->tail;
+    unsigned int head = __atomic_load_n(&q->head, __ATOMIC_ACQUIRE);
+    size_t n = MIN(head - tail, max);
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        entries[i] = q->entries[(tail + i) & (PKT_QUEUE_SIZE - 1)];
+    }
+    if (n) {
+        __atomic_store_n(&q->tail, tail + n, __ATOMIC_RELEASE);
+    }
+    return n;
+}
+
+/* Arranges for the poll loop to wake up when a packet is queued on 'q'.
+ * Called from the consumer's thread only. */
+void
+pkt_queue_wait(struct pkt_queue *q)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&q->head, __ATOMIC_RELAXED) != q->tail) {
+        poll_immediate_wake();
+    } else {
+        poll_fd_wait(q->wake_fd, POLLIN);
+    }
+}
+
+/* Returns the number of packets dropped because 'q' was full. */
+uint64_t
+pkt_queue_get_dropped(const struct pkt_queue *q)
+{
+    return __atomic_load_n(&q->dropped, __ATOMIC_RELAXED);
+}
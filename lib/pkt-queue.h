@@ -0,0 +1,80 @@
+/* Copyright (c) 2008, 2009 The Board of Trustees of The Leland Stanford
+ * Junior University
+ *
+ * We are making the OpenFlow specification and associated documentation
+ * (Software) available for public use and benefit with the expectation
+ * that others will use, modify and enhance the Software and contribute
+ * those enhancements back to the community. However, since we would
+ * like to make the Software available for broadest use, with as few
+ * restrictions as possible permission is hereby granted, free of
+ * charge, to any person obtaining a copy of this Software to deal in
+ * the Software under the copyrights without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * The name and trademarks of copyright holder(s) may NOT be used in
+ * advertising or publicity pertaining to the Software or any
+ * derivatives without specific, written prior permission.
+ */
+
+#ifndef PKT_QUEUE_H
+#define PKT_QUEUE_H 1
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Bounded single-producer, single-consumer packet queue.
+ *
+ * A packet queue hands packets from one thread, the producer, to another,
+ * the consumer, without locking.  It is how the packets that a hardware
+ * driver receives on its own thread reach the datapath thread.  A packet
+ * enqueued while the queue is full is dropped and counted.
+ *
+ * The consumer may sleep in the poll loop until packets arrive: the
+ * producer signals an eventfd when it finds that the consumer had drained
+ * the queue, and pkt_queue_wait() only waits on the eventfd after checking
+ * that the queue is empty. */
+
+struct ofpbuf;
+struct pkt_queue;
+
+/* Number of packets a queue holds.  Must be a power of 2. */
+#define PKT_QUEUE_SIZE 1024
+
+struct pkt_queue_entry {
+    struct ofpbuf *buffer;
+    uint32_t port_no;
+    int reason;
+};
+
+int pkt_queue_create(struct pkt_queue **);
+void pkt_queue_destroy(struct pkt_queue *);
+
+/* Producer side. */
+void pkt_queue_enqueue(struct pkt_queue *, struct ofpbuf *, uint32_t port_no,
+                       int reason);
+
+/* Consumer side. */
+void pkt_queue_clear_wakeup(struct pkt_queue *);
+size_t pkt_queue_dequeue(struct pkt_queue *, struct pkt_queue_entry *,
+                         size_t max);
+void pkt_queue_wait(struct pkt_queue *);
+
+/* Either side. */
+uint64_t pkt_queue_get_dropped(const struct pkt_queue *);
+
+#endif /* pkt-queue.h */
@@ -0,0 +1,296 @@
+/* Copyright (c) 2008, 2009 The Board of Trustees of The Leland Stanford
+ * Junior University
+ *
+ * We are making the OpenFlow specification and associated documentation
+ * (Software) available for public use and benefit with the expectation
+ * that others will use, modify and enhance the Software and contribute
+ * those enhancements back to the community. However, since we would
+ * like to make the Software available for broadest use, with as few
+ * restrictions as possible permission is hereby granted, free of
+ * charge, to any person obtaining a copy of this Software to deal in
+ * the Software under the copyrights without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * The name and trademarks of copyright holder(s) may NOT be used in
+ * advertising or publicity pertaining to the Software or any
+ * derivatives without specific, written prior permission.
+ */
+
+#include <config.h>
+#include "pktmem.h"
+#include <errno.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "ofpbuf.h"
+#include "util.h"
+
+#define LOG_MODULE VLM_pktmem
+#include "vlog.h"
+
+static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(1, 5);
+
+/* Size of a hugepage, to which regions are sized and aligned. */
+#define PKTMEM_HUGEPAGE (2 * 1024 * 1024)
+
+BUILD_ASSERT_DECL(sizeof(struct ofpbuf) <= PKTMEM_BUF_HEADER);
+
+struct pktmem {
+    char *base;                 /* Start of the mapping. */
+    size_t size;                /* Bytes in the mapping. */
+    bool hugetlb;               /* Mapped with MAP_HUGETLB? */
+
+    struct ofpbuf *free;        /* Free chunks, linked through 'next'. */
+    size_t n_buffers;
+    size_t n_free;
+    uint64_t n_exhausted;
+    uint64_t n_oversize;
+};
+
+/* Maps 'size' bytes of anonymous memory aligned on a hugepage boundary and
+ * advises the kernel to back it with transparent hugepages.  Returns the
+ * mapping, or NULL with errno set on failure. */
+static void *
+map_thp(size_t size)
+{
+    char *map, *aligned;
+    size_t head;
+
+    /* Over-allocate by a hugepage and trim to get the alignment, without
+     * which the kernel cannot use hugepages for the first and last parts. */
+    map = mmap(NULL, size + PKTMEM_HUGEPAGE, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+    aligned = (char *) ROUND_UP((uintptr_t) map, PKTMEM_HUGEPAGE);
+    head = aligned - map;
+    if (head) {
+        munmap(map, head);
+    }
+    munmap(aligned + size, PKTMEM_HUGEPAGE - head);
+
+#ifdef MADV_HUGEPAGE
+    if (madvise(aligned, size, MADV_HUGEPAGE) < 0) {
+        VLOG_WARN(LOG_MODULE, "transparent hugepages unavailable: %s",
+                  strerror(errno));
+    }
+#endif
+    return aligned;
+}
+
+/* Creates a packet memory region of 'size' bytes, rounded up to a whole
+ * number of hugepages, and stores it in '*pmp'.  Returns 0 if successful,
+ * otherwise a positive errno value, with '*pmp' set to NULL. */
+int
+pktmem_create(size_t size, struct pktmem **pmp)
+{
+    struct pktmem *pm;
+    void *map = MAP_FAILED;
+    bool hugetlb = false;
+    size_t i;
+
+    *pmp = NULL;
+    size = ROUND_UP(MAX(size, 1), PKTMEM_HUGEPAGE);
+
+#ifdef MAP_HUGETLB
+    /* Hugetlbfs pages must be reserved beforehand, through
+     * /proc/sys/vm/nr_hugepages, and are populated at once so that a
+     * shortage shows here rather than as a SIGBUS later. */
+    map = mmap(NULL, size, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE,
+               -1, 0);
+    hugetlb = map != MAP_FAILED;
+#endif
+    if (map == MAP_FAILED) {
+        map = map_thp(size);
+        if (map == NULL) {
+            int error = errno;
+            VLOG_ERR(LOG_MODULE, "mapping %zu bytes of packet memory "
+                     "failed: %s", size, strerror(error));
+            return error;
+        }
+    }
+
+    pm = xcalloc(1, sizeof *pm);
+    pm->base = map;
+    pm->size = size;
+    pm->hugetlb = hugetlb;
+    pm->n_buffers = size / PKTMEM_BUF_SIZE;
+
+    /* Chain the chunks so that the lowest addresses are handed out first.
+     * This also faults in the whole region now, rather than on the packet
+     * path. */
+    for (i = pm->n_buffers; i-- > 0; ) {
+        struct ofpbuf *b = (struct ofpbuf *) (pm->base + i * PKTMEM_BUF_SIZE);
+        b->next = pm->free;
+        pm->free = b;
+    }
+    pm->n_free = pm->n_buffers;
+
+    VLOG_INFO(LOG_MODULE, "%zu MB of packet memory in %s hugepages, "
+              "%zu buffers", size >> 20,
+              hugetlb ? "hugetlbfs" : "transparent", pm->n_buffers);
+    *pmp = pm;
+    return 0;
+}
+
+/* Unmaps 'pm'.  All of its buffers must have been freed. */
+void
+pktmem_destroy(struct pktmem *pm)
+{
+    if (pm) {
+        munmap(pm->base, pm->size);
+        free(pm);
+    }
+}
+
+/* Returns a new ofpbuf with room for 'size' bytes of data after 'headroom'
+ * bytes of headroom, taken from 'pm' if it has a chunk free and the data
+ * fits in one, otherwise malloc()'d.  'pm' may be NULL, to malloc() the
+ * buffer. */
+struct ofpbuf *
+pktmem_ofpbuf_new(struct pktmem *pm, size_t size, size_t headroom)
+{
+    struct ofpbuf *b;
+
+    if (pm == NULL) {
+        return ofpbuf_new_with_headroom(size, headroom);
+    }
+    if (size + headroom > PKTMEM_BUF_DATA) {
+        pm->n_oversize++;
+        return ofpbuf_new_with_headroom(size, headroom);
+    }
+    if (pm->free == NULL) {
+        pm->n_exhausted++;
+        VLOG_WARN_RL(LOG_MODULE, &rl, "all %zu packet buffers in use, "
+                     "falling back to malloc", pm->n_buffers);
+        return ofpbuf_new_with_headroom(size, headroom);
+    }
+
+    b = pm->free;
+    pm->free = b->next;
+    pm->n_free--;
+
+    ofpbuf_use(b, (char *) b + PKTMEM_BUF_HEADER, PKTMEM_BUF_DATA);
+    b->pktmem = pm;
+    ofpbuf_reserve(b, headroom);
+    return b;
+}
+
+/* Returns a copy of 'buffer' with 'headroom' bytes of headroom, allocated as
+ * by pktmem_ofpbuf_new(). */
+struct ofpbuf *
+pktmem_ofpbuf_clone(struct pktmem *pm, const struct ofpbuf *buffer,
+                    size_t headroom)
+{
+    struct ofpbuf *b;
+
+    b = pktmem_ofpbuf_clone_data(pm, buffer->data, buffer->size, headroom);
+    b->offload = buffer->offload;
+    return b;
+}
+
+/* Returns an ofpbuf holding a copy of the 'size' bytes at 'data', after
+ * 'headroom' bytes of headroom, allocated as by pktmem_ofpbuf_new(). */
+struct ofpbuf *
+pktmem_ofpbuf_clone_data(struct pktmem *pm, const void *data, size_t size,
+                         size_t headroom)
+{
+    struct ofpbuf *b = pktmem_ofpbuf_new(pm, size, headroom);
+    ofpbuf_put(b, data, size);
+    return b;
+}
+
+/* Returns the chunk of 'b', whose data ofpbuf_delete() has already dealt
+ * with, to its region. */
+void
+pktmem_ofpbuf_free(struct ofpbuf *b)
+{
+    struct pktmem *pm = b->pktmem;
+
+    b->next = pm->free;
+    pm->free = b;
+    pm->n_free++;
+}
+
+/* Returns true if 'p' points into the region 'pm'. */
+bool
+pktmem_contains(const struct pktmem *pm, const void *p)
+{
+    return (const char *) p >= pm->base
+           && (const char *) p < pm->base + pm->size;
+}
+
+/* Stores in '*base' and '*size' the memory 'pm' carves its chunks from. */
+void
+pktmem_get_area(const struct pktmem *pm, void **base, size_t *size)
+{
+    *base = pm->base;
+    *size = pm->n_buffers * PKTMEM_BUF_SIZE;
+}
+
+/* Returns the offset of 'p', which must point into 'pm', from the start of
+ * the region. */
+size_t
+pktmem_offset(const struct pktmem *pm, const void *p)
+{
+    return (const char *) p - pm->base;
+}
+
+/* Returns the buffer of the chunk of 'pm' that holds the byte at 'offset'. */
+struct ofpbuf *
+pktmem_ofpbuf_at(struct pktmem *pm, size_t offset)
+{
+    return (struct ofpbuf *) (pm->base + offset / PKTMEM_BUF_SIZE
+                                         * PKTMEM_BUF_SIZE);
+}
+
+/* Returns the buffer of the chunk of 'pm' that holds the byte at 'offset',
+ * reinitialized to have the 'size' bytes from there as its data.  This is
+ * for a chunk taken with pktmem_ofpbuf_new() whose data area was filled by
+ * someone else, e.g. the kernel. */
+struct ofpbuf *
+pktmem_ofpbuf_received(struct pktmem *pm, size_t offset, size_t size)
+{
+    struct ofpbuf *b = pktmem_ofpbuf_at(pm, offset);
+    char *chunk = (char *) b;
+
+    ofpbuf_use(b, chunk + PKTMEM_BUF_HEADER, PKTMEM_BUF_DATA);
+    b->pktmem = pm;
+    ofpbuf_reserve(b, pm->base + offset - (chunk + PKTMEM_BUF_HEADER));
+    ofpbuf_put_uninit(b, size);
+    return b;
+}
+
+/* Stores the statistics of 'pm' in 'stats'.  'pm' may be NULL, for all
+ * zeros. */
+void
+pktmem_get_stats(const struct pktmem *pm, struct pktmem_stats *stats)
+{
+    memset(stats, 0, sizeof *stats);
+    if (pm) {
+        stats->n_buffers = pm->n_buffers;
+        stats->n_free = pm->n_free;
+        stats->n_exhausted = pm->n_exhausted;
+        stats->n_oversize = pm->n_oversize;
+        stats->hugetlb = pm->hugetlb;
+    }
+}
@@ -0,0 +1,105 @@
+/* Copyright (c) 2008, 2009 The Board of Trustees of The Leland Stanford
+ * Junior University
+ *
+ * We are making the OpenFlow specification and associated documentation
+ * (Software) available for public use and benefit with the expectation
+ * that others will use, modify and enhance the Software and contribute
+ * those enhancements back to the community. However, since we would
+ * like to make the Software available for broadest use, with as few
+ * restrictions as possible permission is hereby granted, free of
+ * charge, to any person obtaining a copy of this Software to deal in
+ * the Software under the copyrights without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * The name and trademarks of copyright holder(s) may NOT be used in
+ * advertising or publicity pertaining to the Software or any
+ * derivatives without specific, written prior permission.
+ */
+
+
+#ifndef PKTMEM_H
+#define PKTMEM_H 1
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Packet buffer memory.
+ *
+ * A packet memory region is one large mapping, backed by 2 MB hugepages
+ * when the system has them reserved and by transparent hugepages otherwise,
+ * that is carved into fixed-size chunks of PKTMEM_BUF_SIZE bytes.  Each chunk
+ * holds a struct ofpbuf followed by its data, so taking a packet buffer from
+ * the region costs no malloc() and packet data stays within a few TLB
+ * entries however many buffers are in flight.
+ *
+ * An ofpbuf from a region is freed with ofpbuf_delete() as usual, which
+ * returns its chunk.  If such a buffer has to grow beyond its chunk, its data
+ * moves to malloc()'d memory while the struct ofpbuf stays in the chunk.
+ *
+ * A region is not thread-safe: its buffers must be allocated and freed by a
+ * single thread.
+ *
+ * Since every chunk is aligned on PKTMEM_BUF_SIZE bytes, a region can also
+ * serve as the UMEM of AF_XDP sockets, which then receive into and transmit
+ * from its chunks directly (see netdev-afxdp.h). */
+
+struct ofpbuf;
+struct pktmem;
+
+/* Bytes per chunk, the struct ofpbuf included. */
+#define PKTMEM_BUF_SIZE 2048
+
+/* Bytes of data a chunk holds, headroom included. */
+#define PKTMEM_BUF_DATA (PKTMEM_BUF_SIZE - 128)
+
+/* Offset of the data in a chunk, after its struct ofpbuf. */
+#define PKTMEM_BUF_HEADER (PKTMEM_BUF_SIZE - PKTMEM_BUF_DATA)
+
+struct pktmem_stats {
+    uint64_t n_buffers;         /* Chunks in the region. */
+    uint64_t n_free;            /* Chunks not in use. */
+    uint64_t n_exhausted;       /* Allocations malloc()'d for lack of a free
+                                 * chunk. */
+    uint64_t n_oversize;        /* Allocations malloc()'d for not fitting in
+                                 * a chunk. */
+    bool hugetlb;               /* Backed by hugetlbfs pages, rather than
+                                 * transparent hugepages. */
+};
+
+int pktmem_create(size_t size, struct pktmem **);
+void pktmem_destroy(struct pktmem *);
+
+struct ofpbuf *pktmem_ofpbuf_new(struct pktmem *, size_t size,
+                                 size_t headroom);
+struct ofpbuf *pktmem_ofpbuf_clone(struct pktmem *, const struct ofpbuf *,
+                                   size_t headroom);
+struct ofpbuf *pktmem_ofpbuf_clone_data(struct pktmem *, const void *,
+                                        size_t size, size_t headroom);
+void pktmem_ofpbuf_free(struct ofpbuf *);
+bool pktmem_contains(const struct pktmem *, const void *);
+
+void pktmem_get_area(const struct pktmem *, void **base, size_t *size);
+size_t pktmem_offset(const struct pktmem *, const void *);
+struct ofpbuf *pktmem_ofpbuf_at(struct pktmem *, size_t offset);
+struct ofpbuf *pktmem_ofpbuf_received(struct pktmem *, size_t offset,
+                                      size_t size);
+
+void pktmem_get_stats(const struct pktmem *, struct pktmem_stats *);
+
+#endif /* pktmem.h */
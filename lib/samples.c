@@ -0,0 +1,103 @@
+/* Copyright (c) 2008, 2009 The Board of Trustees of The Leland Stanford
+ * Junior University
+ *
+ * We are making the OpenFlow specification and associated documentation
+ * (Software) available for public use and benefit with the expectation
+ * that others will use, modify and enhance the Software and contribute
+ * those enhancements back to the community. However, since we would
+ * like to make the Software available for broadest use, with as few
+ * restrictions as possible permission is hereby granted, free of
+ * charge, to any person obtaining a copy of this Software to deal in
+ * the Software under the copyrights without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * The name and trademarks of copyright holder(s) may NOT be used in
+ * advertising or publicity pertaining to the Software or any
+ * derivatives without specific, written prior permission.
+ */
+
+#include <config.h>
+#include "samples.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include "util.h"
+
+void
+samples_init(struct samples *s)
+{
+    s->values = NULL;
+    s->n = s->allocated = 0;
+}
+
+void
+samples_destroy(struct samples *s)
+{
+    free(s->values);
+}
+
+void
+samples_add(struct samples *s, long long int value)
+{
+    if (s->n >= s->allocated) {
+        s->values = x2nrealloc(s->values, &s->allocated, sizeof *s->values);
+    }
+    s->values[s->n++] = value;
+}
+
+static int
+compare_llongs(const void *a_, const void *b_)
+{
+    const long long int *a = a_;
+    const long long int *b = b_;
+
+    return *a < *b ? -1 : *a > *b;
+}
+
+/* Sorts the values in 's', as samples_percentile() requires. */
+void
+samples_sort(struct samples *s)
+{
+    qsort(s->values, s->n, sizeof *s->values, compare_llongs);
+}
+
+/* Returns the 'p'th percentile, by nearest rank, of the sorted and non-empty
+ * samples 's'. */
+long long int
+samples_percentile(const struct samples *s, double p)
+{
+    size_t rank = (size_t) (p / 100.0 * s->n + 0.999999);
+
+    return s->values[rank > 0 ? rank - 1 : 0];
+}
+
+/* Sorts 's' and prints a line with its minimum, median, 90th, 99th and 99.9th
+ * percentiles and maximum to stdout, headed by 'name' and with values in
+ * 'unit'.  Prints nothing if 's' is empty. */
+void
+samples_print(struct samples *s, const char *name, const char *unit)
+{
+    if (!s->n) {
+        return;
+    }
+    samples_sort(s);
+    printf("%-12s min %lld  p50 %lld  p90 %lld  p99 %lld  p99.9 %lld  "
+           "max %lld %s (%zu samples)\n", name, s->values[0],
+           samples_percentile(s, 50), samples_percentile(s, 90),
+           samples_percentile(s, 99), samples_percentile(s, 99.9),
+           s->values[s->n - 1], unit, s->n);
+}
@@ -0,0 +1,428 @@
+/* Copyright (c) 2008, 2009 The Board of Trustees of The Leland Stanford
+ * Junior University
+ *
+ * We are making the OpenFlow specification and associated documentation
+ * (Software) available for public use and benefit with the expectation
+ * that others will use, modify and enhance the Software and contribute
+ * those enhancements back to the community. However, since we would
+ * like to make the Software available for broadest use, with as few
+ * restrictions as possible permission is hereby granted, free of
+ * charge, to any person obtaining a copy of this Software to deal in
+ * the Software under the copyrights without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * The name and trademarks of copyright holder(s) may NOT be used in
+ * advertising or publicity pertaining to the Software or any
+ * derivatives without specific, written prior permission.
+ */
+
+#include <config.h>
+#include "stats-shm.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "fatal-signal.h"
+#include "timeval.h"
+#include "util.h"
+
+/* Size of the file as first created. */
+#define STATS_SHM_MIN_SIZE 4096
+
+/* Times a reader retries a copy torn by an update before giving up. */
+#define STATS_SHM_MAX_TRIES 1000
+
+static const size_t record_sizes[STATS_SHM_N_TYPES] = {
+    sizeof(struct stats_shm_port),
+    sizeof(struct stats_shm_queue),
+    sizeof(struct stats_shm_table),
+    sizeof(struct stats_shm_group),
+    sizeof(struct stats_shm_meter),
+    sizeof(struct stats_shm_cookie),
+};
+
+struct stats_shm {
+    char *path;
+    int fd;
+    struct stats_shm_header *header; /* Mapping of the whole file. */
+    size_t size;                /* Bytes in the file and the mapping. */
+};
+
+/* Grows the file of 'shm' to 'size' bytes and maps all of it. */
+static int
+stats_shm_resize(struct stats_shm *shm, size_t size)
+{
+    void *map;
+
+    if (ftruncate(shm->fd, size) < 0) {
+        return errno;
+    }
+    map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, shm->fd, 0);
+    if (map == MAP_FAILED) {
+        return errno;
+    }
+    if (shm->header) {
+        munmap(shm->header, shm->size);
+    }
+    shm->header = map;
+    shm->size = size;
+    return 0;
+}
+
+/* Creates a statistics file named 'path', replacing any existing file, and
+ * stores a writer for it in '*shmp'.  The file is removed when the writer is
+ * destroyed or the program exits.  Returns 0 if successful, otherwise a
+ * positive errno value and stores a null pointer in '*shmp'. */
+int
+stats_shm_create(const char *path, struct stats_shm **shmp)
+{
+    struct stats_shm *shm;
+    int error;
+    int fd;
+
+    *shmp = NULL;
+
+    /* Readers of the file of a previous writer keep their mapping of it, so
+     * it must not be truncated under them. */
+    if (unlink(path) < 0 && errno != ENOENT) {
+        return errno;
+    }
+    fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        return errno;
+    }
+
+    shm = xmalloc(sizeof *shm);
+    shm->path = xstrdup(path);
+    shm->fd = fd;
+    shm->header = NULL;
+    shm->size = 0;
+    fatal_signal_add_file_to_unlink(path);
+    error = stats_shm_resize(shm, STATS_SHM_MIN_SIZE);
+    if (error) {
+        stats_shm_destroy(shm);
+        return error;
+    }
+
+    shm->header->version = STATS_SHM_VERSION;
+    shm->header->size = shm->size;
+    __atomic_store_n(&shm->header->magic, STATS_SHM_MAGIC, __ATOMIC_RELEASE);
+    *shmp = shm;
+    return 0;
+}
+
+/* Closes and removes the file of 'shm', and frees 'shm'. */
+void
+stats_shm_destroy(struct stats_shm *shm)
+{
+    if (shm) {
+        if (shm->header) {
+            munmap(shm->header, shm->size);
+        }
+        close(shm->fd);
+        unlink(shm->path);
+        fatal_signal_remove_file_to_unlink(shm->path);
+        free(shm->path);
+        free(shm);
+    }
+}
+
+/* Starts an update of 'shm' with 'n_records[i]' records of each type 'i',
+ * growing the file if they do not fit.  Readers see nothing of the update
+ * until stats_shm_commit() is called.  Returns 0 if successful, otherwise a
+ * positive errno value, in which case the update is not started. */
+int
+stats_shm_begin(struct stats_shm *shm,
+                const size_t n_records[STATS_SHM_N_TYPES])
+{
+    struct stats_shm_header *h;
+    size_t size, offset;
+    int i;
+
+    size = sizeof *h;
+    for (i = 0; i < STATS_SHM_N_TYPES; i++) {
+        size += n_records[i] * record_sizes[i];
+    }
+    if (size > shm->size) {
+        size_t new_size = shm->size;
+        int error;
+
+        while (new_size < size) {
+            new_size *= 2;
+        }
+        error = stats_shm_resize(shm, new_size);
+        if (error) {
+            return error;
+        }
+    }
+
+    h = shm->header;
+    __atomic_store_n(&h->seq, h->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    h->size = shm->size;
+    offset = sizeof *h;
+    for (i = 0; i < STATS_SHM_N_TYPES; i++) {
+        struct stats_shm_section *s = &h->sections[i];
+
+        s->offset = offset;
+        s->n_records = n_records[i];
+        s->record_size = record_sizes[i];
+        offset += n_records[i] * record_sizes[i];
+    }
+    return 0;
+}
+
+/* Returns the first record of 'type' in the update of 'shm' in progress,
+ * where the caller writes as many records as it passed to
+ * stats_shm_begin(). */
+void *
+stats_shm_records(struct stats_shm *shm, enum stats_shm_type type)
+{
+    return (uint8_t *) shm->header + shm->header->sections[type].offset;
+}
+
+/* Completes the update of 'shm' in progress, making it visible to
+ * readers. */
+void
+stats_shm_commit(struct stats_shm *shm, uint64_t datapath_id,
+                 unsigned int interval)
+{
+    struct stats_shm_header *h = shm->header;
+
+    h->datapath_id = datapath_id;
+    h->interval = interval;
+    h->time = time_wall_msec();
+    __atomic_store_n(&h->seq, h->seq + 1, __ATOMIC_RELEASE);
+}
+
+struct stats_shm_reader {
+    int fd;
+    const struct stats_shm_header *header; /* Mapping of the file. */
+    size_t size;                /* Bytes mapped. */
+    uint8_t *copy;              /* Copy of the file being read. */
+    size_t copy_size;           /* Bytes allocated for 'copy'. */
+};
+
+/* Maps the whole file of 'r', if it has grown since it was last mapped. */
+static int
+stats_shm_remap(struct stats_shm_reader *r)
+{
+    struct stat s;
+    void *map;
+
+    if (fstat(r->fd, &s) < 0) {
+        return errno;
+    }
+    if (s.st_size < sizeof *r->header) {
+        /* The writer is still creating the file. */
+        return EAGAIN;
+    }
+    if (s.st_size > r->size) {
+        map = mmap(NULL, s.st_size, PROT_READ, MAP_SHARED, r->fd, 0);
+        if (map == MAP_FAILED) {
+            return errno;
+        }
+        if (r->header) {
+            munmap((void *) r->header, r->size);
+        }
+        r->header = map;
+        r->size = s.st_size;
+    }
+    return 0;
+}
+
+/* Opens the statistics file named 'path' for reading and stores a reader for
+ * it in '*rp'.  Returns 0 if successful, otherwise a positive errno value and
+ * stores a null pointer in '*rp'. */
+int
+stats_shm_open(const char *path, struct stats_shm_reader **rp)
+{
+    struct stats_shm_reader *r;
+    int error;
+    int fd;
+
+    *rp = NULL;
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return errno;
+    }
+
+    r = xmalloc(sizeof *r);
+    r->fd = fd;
+    r->header = NULL;
+    r->size = 0;
+    r->copy = NULL;
+    r->copy_size = 0;
+    error = stats_shm_remap(r);
+    if (error) {
+        stats_shm_close(r);
+        return error;
+    }
+    *rp = r;
+    return 0;
+}
+
+void
+stats_shm_close(struct stats_shm_reader *r)
+{
+    if (r) {
+        if (r->header) {
+            munmap((void *) r->header, r->size);
+        }
+        close(r->fd);
+        free(r->copy);
+        free(r);
+    }
+}
+
+/* Returns a newly allocated array of the 's->n_records' records of 'size'
+ * bytes in 'copy', each converted from 's->record_size' bytes. */
+static void *
+copy_records(const uint8_t *copy, const struct stats_shm_section *s,
+             size_t size, size_t *n)
+{
+    uint8_t *records;
+    size_t i;
+
+    *n = s->n_records;
+    if (!s->n_records) {
+        return NULL;
+    }
+    records = xcalloc(s->n_records, size);
+    for (i = 0; i < s->n_records; i++) {
+        memcpy(records + i * size, copy + s->offset + i * s->record_size,
+               MIN(size, s->record_size));
+    }
+    return records;
+}
+
+/* Reads a consistent copy of the statistics from 'r' into 'snap', which the
+ * caller must free with stats_shm_snapshot_destroy().  Returns 0 if
+ * successful, otherwise a positive errno value:
+ *
+ *   - EAGAIN if the writer has not published any statistics yet, or kept
+ *     updating them during every attempt to copy them.
+ *
+ *   - EPROTO if the file is not a statistics file or is corrupt.
+ *
+ *   - EPROTONOSUPPORT if its layout is of a different version. */
+int
+stats_shm_read(struct stats_shm_reader *r, struct stats_shm_snapshot *snap)
+{
+    const struct stats_shm_header *h;
+    size_t size;
+    uint32_t seq;
+    int tries;
+    int i;
+
+    memset(snap, 0, sizeof *snap);
+    for (tries = 0; ; tries++) {
+        if (tries >= STATS_SHM_MAX_TRIES) {
+            return EAGAIN;
+        }
+
+        h = r->header;
+        switch (__atomic_load_n(&h->magic, __ATOMIC_ACQUIRE)) {
+        case STATS_SHM_MAGIC:
+            break;
+        case 0:
+            return EAGAIN;
+        default:
+            return EPROTO;
+        }
+        if (h->version != STATS_SHM_VERSION) {
+            return EPROTONOSUPPORT;
+        }
+
+        seq = __atomic_load_n(&h->seq, __ATOMIC_ACQUIRE);
+        if (!seq) {
+            return EAGAIN;
+        } else if (seq & 1) {
+            /* Let the writer finish, in case it shares our CPU. */
+            sched_yield();
+            continue;
+        }
+        size = __atomic_load_n(&h->size, __ATOMIC_RELAXED);
+        if (size > r->size) {
+            int error = stats_shm_remap(r);
+            if (error) {
+                return error;
+            }
+            continue;
+        }
+
+        if (size > r->copy_size) {
+            free(r->copy);
+            r->copy = xmalloc(size);
+            r->copy_size = size;
+        }
+        memcpy(r->copy, h, size);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&h->seq, __ATOMIC_RELAXED) == seq) {
+            break;
+        }
+    }
+
+    h = (const struct stats_shm_header *) r->copy;
+    for (i = 0; i < STATS_SHM_N_TYPES; i++) {
+        const struct stats_shm_section *s = &h->sections[i];
+
+        if (s->offset < sizeof *h || s->offset > size
+            || (s->n_records
+                && (!s->record_size
+                    || (size - s->offset) / s->record_size < s->n_records))) {
+            return EPROTO;
+        }
+    }
+
+    snap->datapath_id = h->datapath_id;
+    snap->time = h->time;
+    snap->interval = h->interval;
+    snap->seq = seq;
+    snap->ports = copy_records(r->copy, &h->sections[STATS_SHM_PORTS],
+                               sizeof *snap->ports, &snap->n_ports);
+    snap->queues = copy_records(r->copy, &h->sections[STATS_SHM_QUEUES],
+                                sizeof *snap->queues, &snap->n_queues);
+    snap->tables = copy_records(r->copy, &h->sections[STATS_SHM_TABLES],
+                                sizeof *snap->tables, &snap->n_tables);
+    snap->groups = copy_records(r->copy, &h->sections[STATS_SHM_GROUPS],
+                                sizeof *snap->groups, &snap->n_groups);
+    snap->meters = copy_records(r->copy, &h->sections[STATS_SHM_METERS],
+                                sizeof *snap->meters, &snap->n_meters);
+    snap->cookies = copy_records(r->copy, &h->sections[STATS_SHM_COOKIES],
+                                 sizeof *snap->cookies, &snap->n_cookies);
+    return 0;
+}
+
+void
+stats_shm_snapshot_destroy(struct stats_shm_snapshot *snap)
+{
+    if (snap) {
+        free(snap->ports);
+        free(snap->queues);
+        free(snap->tables);
+        free(snap->groups);
+        free(snap->meters);
+        free(snap->cookies);
+    }
+}
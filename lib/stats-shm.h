@@ -0,0 +1,188 @@
+/* Copyright (c) 2008, 2009 The Board of Trustees of The Leland Stanford
+ * Junior University
+ *
+ * We are making the OpenFlow specification and associated documentation
+ * (Software) available for public use and benefit with the expectation
+ * that others will use, modify and enhance the Software and contribute
+ * those enhancements back to the community. However, since we would
+ * like to make the Software available for broadest use, with as few
+ * restrictions as possible permission is hereby granted, free of
+ * charge, to any person obtaining a copy of this Software to deal in
+ * the Software under the copyrights without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * The name and trademarks of copyright holder(s) may NOT be used in
+ * advertising or publicity pertaining to the Software or any
+ * derivatives without specific, written prior permission.
+ */
+
+#ifndef STATS_SHM_H
+#define STATS_SHM_H 1
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Statistics exported through a memory-mapped file.
+ *
+ * A datapath writes its counters into a file, normally in /dev/shm, at a
+ * fixed interval.  Monitoring processes map the file and copy the counters
+ * out without sending the datapath a single message.
+ *
+ * The file starts with a struct stats_shm_header, followed by one array of
+ * records per enum stats_shm_type.  'seq' in the header makes a sequence
+ * lock: the writer makes it odd before changing anything and even again
+ * when done, so a reader that sees the same even 'seq' before and after
+ * copying has a consistent copy.
+ *
+ * The file only grows while the writer has it open, so readers never fault
+ * on a mapping that turns out to be too long.  A new writer replaces the
+ * file instead of reusing it.
+ *
+ * Records are only ever extended at the end.  Each section gives its record
+ * size, and readers ignore trailing fields they do not know and zero the
+ * fields a shorter record lacks.  Any other change of layout increments
+ * STATS_SHM_VERSION. */
+
+#define STATS_SHM_MAGIC 0x4f465353  /* "OFSS". */
+#define STATS_SHM_VERSION 1
+
+enum stats_shm_type {
+    STATS_SHM_PORTS,            /* struct stats_shm_port. */
+    STATS_SHM_QUEUES,           /* struct stats_shm_queue. */
+    STATS_SHM_TABLES,           /* struct stats_shm_table. */
+    STATS_SHM_GROUPS,           /* struct stats_shm_group. */
+    STATS_SHM_METERS,           /* struct stats_shm_meter. */
+    STATS_SHM_COOKIES,          /* struct stats_shm_cookie. */
+    STATS_SHM_N_TYPES
+};
+
+struct stats_shm_section {
+    uint64_t offset;            /* Offset of the first record in the file. */
+    uint32_t n_records;
+    uint32_t record_size;
+};
+
+struct stats_shm_header {
+    uint32_t magic;             /* STATS_SHM_MAGIC. */
+    uint32_t version;           /* STATS_SHM_VERSION. */
+    uint64_t size;              /* Bytes in the file. */
+    uint32_t seq;               /* Odd while the writer updates the file. */
+    uint32_t interval;          /* Milliseconds between updates. */
+    uint64_t datapath_id;
+    int64_t time;               /* Wall clock of the last update, in ms. */
+    struct stats_shm_section sections[STATS_SHM_N_TYPES];
+};
+
+struct stats_shm_port {
+    uint32_t port_no;
+    uint32_t duration_sec;
+    uint64_t rx_packets;
+    uint64_t tx_packets;
+    uint64_t rx_bytes;
+    uint64_t tx_bytes;
+    uint64_t rx_dropped;
+    uint64_t tx_dropped;
+    uint64_t rx_errors;
+    uint64_t tx_errors;
+    uint64_t rx_frame_err;
+    uint64_t rx_over_err;
+    uint64_t rx_crc_err;
+    uint64_t collisions;
+};
+
+struct stats_shm_queue {
+    uint32_t port_no;
+    uint32_t queue_id;
+    uint64_t tx_bytes;
+    uint64_t tx_packets;
+    uint64_t tx_errors;
+};
+
+struct stats_shm_table {
+    uint8_t table_id;
+    uint8_t pad[3];
+    uint32_t active_count;
+    uint64_t lookup_count;
+    uint64_t matched_count;
+};
+
+struct stats_shm_group {
+    uint32_t group_id;
+    uint32_t ref_count;
+    uint64_t packet_count;
+    uint64_t byte_count;
+};
+
+struct stats_shm_meter {
+    uint32_t meter_id;
+    uint32_t flow_count;
+    uint64_t packet_in_count;
+    uint64_t byte_in_count;
+};
+
+/* Totals of the flows installed with a given cookie.  Flows that are
+ * removed take their counts with them, so these may decrease. */
+struct stats_shm_cookie {
+    uint64_t cookie;
+    uint64_t n_flows;
+    uint64_t packet_count;
+    uint64_t byte_count;
+};
+
+/* Writer. */
+struct stats_shm;
+
+int stats_shm_create(const char *path, struct stats_shm **);
+void stats_shm_destroy(struct stats_shm *);
+int stats_shm_begin(struct stats_shm *,
+                    const size_t n_records[STATS_SHM_N_TYPES]);
+void *stats_shm_records(struct stats_shm *, enum stats_shm_type);
+void stats_shm_commit(struct stats_shm *, uint64_t datapath_id,
+                      unsigned int interval);
+
+/* Reader. */
+struct stats_shm_reader;
+
+/* A consistent copy of the statistics in a file. */
+struct stats_shm_snapshot {
+    uint64_t datapath_id;
+    long long int time;         /* Wall clock of the update, in ms. */
+    unsigned int interval;      /* Milliseconds between updates. */
+    uint32_t seq;               /* Changes with every update. */
+
+    struct stats_shm_port *ports;
+    size_t n_ports;
+    struct stats_shm_queue *queues;
+    size_t n_queues;
+    struct stats_shm_table *tables;
+    size_t n_tables;
+    struct stats_shm_group *groups;
+    size_t n_groups;
+    struct stats_shm_meter *meters;
+    size_t n_meters;
+    struct stats_shm_cookie *cookies;
+    size_t n_cookies;
+};
+
+int stats_shm_open(const char *path, struct stats_shm_reader **);
+void stats_shm_close(struct stats_shm_reader *);
+int stats_shm_read(struct stats_shm_reader *, struct stats_shm_snapshot *);
+void stats_shm_snapshot_destroy(struct stats_shm_snapshot *);
+
+#endif /* stats-shm.h */
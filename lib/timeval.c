@@ -39,84 +39,107 @@
 #include <signal.h>
 #include <string.h>
 #include <sys/time.h>
+#include <unistd.h>
 #include "fatal-signal.h"
 #include "util.h"
 
 /* Initialized? */
 static bool inited;
 
-/* Has a timer tick occurred? */
-static volatile sig_atomic_t tick;
-
-/* The current time, as of the last refresh. */
-static struct timeval now;
-
-/* Time at which to die with SIGALRM (if not TIME_MIN). */
-static time_t deadline = TIME_MIN;
+/* Clock read by time_now() and time_msec(): CLOCK_MONOTONIC_COARSE where the
+ * kernel provides it, since it is read from the vDSO without a system call
+ * and its resolution (a few ms) is much finer than callers need. */
+static clockid_t monotonic_clock = CLOCK_MONOTONIC;
 
 static void sigalrm_handler(int);
-static void refresh_if_ticked(void);
-static time_t time_add(time_t, time_t);
-static void block_sigalrm(sigset_t *);
-static void unblock_sigalrm(const sigset_t *);
 
 /* Initializes the timetracking module. */
 void
 time_init(void)
 {
-    struct sigaction sa;
-    struct itimerval itimer;
+    struct timespec ts;
 
     if (inited) {
         return;
     }
 
     inited = true;
-    gettimeofday(&now, NULL);
-    tick = false;
-
-    /* Set up signal handler. */
-    memset(&sa, 0, sizeof sa);
-    sa.sa_handler = sigalrm_handler;
-    sigemptyset(&sa.sa_mask);
-    sa.sa_flags = SA_RESTART;
-    if (sigaction(SIGALRM, &sa, NULL)) {
-        ofp_fatal(errno, "sigaction(SIGALRM) failed");
+#ifdef CLOCK_MONOTONIC_COARSE
+    if (!clock_gettime(CLOCK_MONOTONIC_COARSE, &ts)) {
+        monotonic_clock = CLOCK_MONOTONIC_COARSE;
     }
-
-    /* Set up periodic timer. */
-    itimer.it_interval.tv_sec = 0;
-    itimer.it_interval.tv_usec = TIME_UPDATE_INTERVAL * 1000;
-    itimer.it_value = itimer.it_interval;
-    if (setitimer(ITIMER_REAL, &itimer, NULL)) {
-        ofp_fatal(errno, "setitimer failed");
+#endif
+    if (clock_gettime(monotonic_clock, &ts)) {
+        ofp_fatal(errno, "clock_gettime failed");
     }
 }
 
-/* Forces a refresh of the current time from the kernel.  It is not usually
- * necessary to call this function, since the time will be refreshed
- * automatically at least every TIME_UPDATE_INTERVAL milliseconds. */
+/* Formerly refreshed the cached current time.  The time is now read from the
+ * clock on each call, so this does nothing; it is kept for existing
+ * callers. */
 void
 time_refresh(void)
 {
-    gettimeofday(&now, NULL);
-    tick = false;
 }
 
-/* Returns the current time, in seconds. */
+static void
+monotonic_time(struct timespec *ts)
+{
+    assert(inited);
+    clock_gettime(monotonic_clock, ts);
+}
+
+/* Returns the time elapsed since an arbitrary point in the past, in seconds.
+ * The time is monotonic: it does not jump when the system clock is set, so
+ * it is only suitable for measuring intervals.  Use time_wall() for the time
+ * of day. */
 time_t
 time_now(void)
 {
-    refresh_if_ticked();
-    return now.tv_sec;
+    struct timespec ts;
+
+    monotonic_time(&ts);
+    return ts.tv_sec;
 }
 
-/* Returns the current time, in ms (within TIME_UPDATE_INTERVAL ms). */
+/* Returns the time elapsed since an arbitrary point in the past, in ms.  Like
+ * time_now(), the time is monotonic. */
 long long int
 time_msec(void)
 {
-    refresh_if_ticked();
-    return (long long int) now.tv_sec * 1000 + now.tv_usec / 1000;
+    struct timespec ts;
+
+    monotonic_time(&ts);
+    return (long long int) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* Returns the time elapsed since an arbitrary point in the past, in us.
+ * Unlike time_msec(), the time is read from a fine-grained clock, so it is
+ * suitable for measuring short intervals. */
+long long int
+time_usec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long int) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* Returns the wall-clock time, in seconds since the epoch. */
+time_t
+time_wall(void)
+{
+    return time(NULL);
+}
+
+/* Returns the wall-clock time, in ms since the epoch. */
+long long int
+time_wall_msec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (long long int) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
 }
 
 /* Configures the program to die with SIGALRM 'secs' seconds from now, if
@@ -124,12 +147,19 @@ time_msec(void)
 void
 time_alarm(unsigned int secs)
 {
-    sigset_t oldsigs;
+    struct sigaction sa;
 
     time_init();
-    block_sigalrm(&oldsigs);
-    deadline = secs ? time_add(time_now(), secs) : TIME_MIN;
-    unblock_sigalrm(&oldsigs);
+    if (secs) {
+        memset(&sa, 0, sizeof sa);
+        sa.sa_handler = sigalrm_handler;
+        sigemptyset(&sa.sa_mask);
+        sa.sa_flags = SA_RESTART;
+        if (sigaction(SIGALRM, &sa, NULL)) {
+            ofp_fatal(errno, "sigaction(SIGALRM) failed");
+        }
+    }
+    alarm(secs);
 }
 
 /* Like poll(), except:
@@ -139,20 +169,14 @@ time_alarm(unsigned int secs)
  *      - If interrupted by a signal, retries automatically until the original
  *        'timeout' expires.  (Because of this property, this function will
  *        never return -EINTR.)
- *
- *      - As a side effect, refreshes the current time (like time_refresh()).
  */
 int
 time_poll(struct pollfd *pollfds, int n_pollfds, int timeout)
 {
     long long int start;
-    sigset_t oldsigs;
-    bool blocked;
     int retval;
 
-    time_refresh();
     start = time_msec();
-    blocked = false;
     for (;;) {
         int time_left;
         if (timeout > 0) {
@@ -169,61 +193,12 @@ time_poll(struct pollfd *pollfds, int n_pollfds, int timeout)
         if (retval != -EINTR) {
             break;
         }
-
-        if (!blocked && deadline == TIME_MIN) {
-            block_sigalrm(&oldsigs);
-            blocked = true;
-        }
-        time_refresh();
-    }
-    if (blocked) {
-        unblock_sigalrm(&oldsigs);
     }
     return retval;
 }
 
-/* Returns the sum of 'a' and 'b', with saturation on overflow or underflow. */
-static time_t
-time_add(time_t a, time_t b)
-{
-    return (a >= 0
-            ? (b > TIME_MAX - a ? TIME_MAX : a + b)
-            : (b < TIME_MIN - a ? TIME_MIN : a + b));
-}
-
 static void
 sigalrm_handler(int sig_nr)
 {
-    tick = true;
-    if (deadline != TIME_MIN && time(0) > deadline) {
-        fatal_signal_handler(sig_nr);
-    }
-}
-
-static void
-refresh_if_ticked(void)
-{
-    assert(inited);
-    if (tick) {
-        time_refresh();
-    }
-}
-
-static void
-block_sigalrm(sigset_t *oldsigs)
-{
-    sigset_t sigalrm;
-    sigemptyset(&sigalrm);
-    sigaddset(&sigalrm, SIGALRM);
-    if (sigprocmask(SIG_BLOCK, &sigalrm, oldsigs)) {
-        ofp_fatal(errno, "sigprocmask");
-    }
-}
-
-static void
-unblock_sigalrm(const sigset_t *oldsigs)
-{
-    if (sigprocmask(SIG_SETMASK, oldsigs, NULL)) {
-        ofp_fatal(errno, "sigprocmask");
-    }
+    fatal_signal_handler(sig_nr);
 }
@@ -50,16 +50,16 @@ BUILD_ASSERT_DECL(TYPE_IS_SIGNED(time_t));
 #define TIME_MAX TYPE_MAXIMUM(time_t)
 #define TIME_MIN TYPE_MINIMUM(time_t)
 
-/* Interval between updates to the time reported by time_gettimeofday(), in ms.
- * This should not be adjusted much below 10 ms or so with the current
- * implementation, or too much time will be wasted in signal handlers and calls
- * to time(0). */
+/* Upper bound on the granularity of time_now() and time_msec(), in ms. */
 #define TIME_UPDATE_INTERVAL 100
 
 void time_init(void);
 void time_refresh(void);
 time_t time_now(void);
 long long int time_msec(void);
+long long int time_usec(void);
+time_t time_wall(void);
+long long int time_wall_msec(void);
 void time_alarm(unsigned int secs);
 int time_poll(struct pollfd *, int n_pollfds, int timeout);
 
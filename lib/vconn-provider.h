@@ -103,7 +103,7 @@ struct vconn_class {
      * stores the received message into '*msgp' and returns 0.  The caller is
      * responsible for destroying the message with ofpbuf_delete().  On
      * failure, returns a positive errno value and stores a null pointer into
-     * '*msgp'.
+     * '*msgp'.  The message should have VCONN_RX_HEADROOM bytes of headroom.
      *
      * If the connection has been closed in the normal fashion, returns EOF.
      *
@@ -33,7 +33,6 @@
 
 #include <config.h>
 #include "vconn-ssl.h"
-#include "dhparams.h"
 #include <assert.h>
 #include <ctype.h>
 #include <errno.h>
@@ -43,6 +42,9 @@
 #include <openssl/err.h>
 #include <openssl/ssl.h>
 #include <openssl/x509v3.h>
+#if OPENSSL_VERSION_NUMBER < 0x30000000L
+#include "dhparams.h"
+#endif
 #include <poll.h>
 #include <sys/fcntl.h>
 #include <sys/stat.h>
@@ -53,14 +55,14 @@
 #include "openflow/openflow.h"
 #include "packets.h"
 #include "poll-loop.h"
-#include "socket-util.h"
+#include "shash.h"
 #include "socket-util.h"
 #include "util.h"
 #include "vconn-provider.h"
 #include "vconn.h"
 
 #include "vlog.h"
-#define THIS_MODULE VLM_vconn_ssl
+#define LOG_MODULE VLM_vconn_ssl
 
 /* Active SSL. */
 
@@ -85,6 +87,7 @@ struct ssl_vconn
     struct ofpbuf *rxbuf;
     struct ofpbuf *txbuf;
     struct poll_waiter *tx_waiter;
+    int tx_error;               /* Error of a deferred write, if any. */
 
     /* rx_want and tx_want record the result of the last call to SSL_read()
      * and SSL_write(), respectively:
@@ -148,6 +151,24 @@ struct ssl_vconn
 /* SSL context created by ssl_init(). */
 static SSL_CTX *ctx;
 
+/* Messages sent in one iteration of the main loop are coalesced in 'txbuf'
+ * and written by a single SSL_write() from the tx poll callback.  This
+ * produces one TLS record (and system call) per 'tx_coalesce' bytes instead
+ * of one per message.  With 'tx_coalesce' at 0, each message is written as
+ * soon as it is sent. */
+static size_t tx_coalesce = VCONN_SSL_TX_COALESCE;
+
+/* Cipher suites, in order of preference.  ECDHE comes first; DHE remains for
+ * peers with DSA certificates. */
+#define SSL_CIPHERS \
+    "ECDHE+AESGCM:ECDHE+CHACHA20:ECDHE:DHE+AESGCM:DHE:" \
+    "!aNULL:!eNULL:!MD5:!RC4:!3DES"
+
+/* Sessions of client connections, indexed by vconn name, so that reconnects
+ * to the same peer can resume the session instead of doing a full handshake.
+ * Each value is an SSL_SESSION. */
+static struct shash client_sessions = SHASH_INITIALIZER(&client_sessions);
+
 /* Required configuration. */
 static bool has_private_key, has_certificate, has_ca_cert;
 
@@ -172,10 +193,15 @@ static int do_ssl_init(void);
 static bool ssl_wants_io(int ssl_error);
 static void ssl_close(struct vconn *);
 static void ssl_clear_txbuf(struct ssl_vconn *);
+static int ssl_do_tx(struct vconn *);
 static int interpret_ssl_error(const char *function, int ret, int error,
                                int *want);
 static void ssl_tx_poll_callback(int fd, short int revents, void *vconn_);
+static int new_session_callback(SSL *ssl, SSL_SESSION *session);
+static void forget_client_session(const char *name);
+#if OPENSSL_VERSION_NUMBER < 0x30000000L
 static DH *tmp_dh_callback(SSL *ssl, int is_export UNUSED, int keylength);
+#endif
 static void log_ca_cert(const char *file_name, X509 *cert);
 
 static short int
@@ -208,19 +234,19 @@ new_ssl_vconn(const char *name, int fd, enum session_type type,
 
     /* Check for all the needful configuration. */
     if (!has_private_key) {
-        VLOG_ERR("Private key must be configured to use SSL");
+        VLOG_ERR(LOG_MODULE, "Private key must be configured to use SSL");
         goto error;
     }
     if (!has_certificate) {
-        VLOG_ERR("Certificate must be configured to use SSL");
+        VLOG_ERR(LOG_MODULE, "Certificate must be configured to use SSL");
         goto error;
     }
     if (!has_ca_cert && !bootstrap_ca_cert) {
-        VLOG_ERR("CA certificate must be configured to use SSL");
+        VLOG_ERR(LOG_MODULE, "CA certificate must be configured to use SSL");
         goto error;
     }
     if (!SSL_CTX_check_private_key(ctx)) {
-        VLOG_ERR("Private key does not match certificate public key: %s",
+        VLOG_ERR(LOG_MODULE, "Private key does not match certificate public key: %s",
                  ERR_error_string(ERR_get_error(), NULL));
         goto error;
     }
@@ -228,7 +254,7 @@ new_ssl_vconn(const char *name, int fd, enum session_type type,
     /* Disable Nagle. */
     retval = setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof on);
     if (retval) {
-        VLOG_ERR("%s: setsockopt(TCP_NODELAY): %s", name, strerror(errno));
+        VLOG_ERR(LOG_MODULE, "%s: setsockopt(TCP_NODELAY): %s", name, strerror(errno));
         close(fd);
         return errno;
     }
@@ -236,12 +262,12 @@ new_ssl_vconn(const char *name, int fd, enum session_type type,
     /* Create and configure OpenSSL stream. */
     ssl = SSL_new(ctx);
     if (ssl == NULL) {
-        VLOG_ERR("SSL_new: %s", ERR_error_string(ERR_get_error(), NULL));
+        VLOG_ERR(LOG_MODULE, "SSL_new: %s", ERR_error_string(ERR_get_error(), NULL));
         close(fd);
         return ENOPROTOOPT;
     }
     if (SSL_set_fd(ssl, fd) == 0) {
-        VLOG_ERR("SSL_set_fd: %s", ERR_error_string(ERR_get_error(), NULL));
+        VLOG_ERR(LOG_MODULE, "SSL_set_fd: %s", ERR_error_string(ERR_get_error(), NULL));
         goto error;
     }
     if (bootstrap_ca_cert && type == CLIENT) {
@@ -259,7 +285,15 @@ new_ssl_vconn(const char *name, int fd, enum session_type type,
     sslv->rxbuf = NULL;
     sslv->txbuf = NULL;
     sslv->tx_waiter = NULL;
+    sslv->tx_error = 0;
     sslv->rx_want = sslv->tx_want = SSL_NOTHING;
+    SSL_set_app_data(ssl, sslv);
+    if (type == CLIENT) {
+        SSL_SESSION *session = shash_find_data(&client_sessions, name);
+        if (session) {
+            SSL_set_session(ssl, session);
+        }
+    }
     *vconnp = &sslv->vconn;
     return 0;
 
@@ -313,7 +347,7 @@ ssl_open(const char *name, char *suffix, struct vconn **vconnp)
     /* Create socket. */
     fd = socket(AF_INET, SOCK_STREAM, 0);
     if (fd < 0) {
-        VLOG_ERR("%s: socket: %s", name, strerror(errno));
+        VLOG_ERR(LOG_MODULE, "%s: socket: %s", name, strerror(errno));
         return errno;
     }
     retval = set_nonblocking(fd);
@@ -330,7 +364,7 @@ ssl_open(const char *name, char *suffix, struct vconn **vconnp)
                                  &sin, vconnp);
         } else {
             int error = errno;
-            VLOG_ERR("%s: connect: %s", name, strerror(error));
+            VLOG_ERR(LOG_MODULE, "%s: connect: %s", name, strerror(error));
             close(fd);
             return error;
         }
@@ -352,7 +386,7 @@ do_ca_cert_bootstrap(struct vconn *vconn)
 
     chain = SSL_get_peer_cert_chain(sslv->ssl);
     if (!chain || !sk_X509_num(chain)) {
-        VLOG_ERR("could not bootstrap CA cert: no certificate presented by "
+        VLOG_ERR(LOG_MODULE, "could not bootstrap CA cert: no certificate presented by "
                  "peer");
         return EPROTO;
     }
@@ -362,11 +396,11 @@ do_ca_cert_bootstrap(struct vconn *vconn)
      * certificate and we should not attempt to use it as one. */
     error = X509_check_issued(ca_cert, ca_cert);
     if (error) {
-        VLOG_ERR("could not bootstrap CA cert: obtained certificate is "
+        VLOG_ERR(LOG_MODULE, "could not bootstrap CA cert: obtained certificate is "
                  "not self-signed (%s)",
                  X509_verify_cert_error_string(error));
         if (sk_X509_num(chain) < 2) {
-            VLOG_ERR("only one certificate was received, so probably the peer "
+            VLOG_ERR(LOG_MODULE, "only one certificate was received, so probably the peer "
                      "is not configured to send its CA certificate");
         }
         return EPROTO;
@@ -374,7 +408,7 @@ do_ca_cert_bootstrap(struct vconn *vconn)
 
     fd = open(ca_cert_file, O_CREAT | O_EXCL | O_WRONLY, 0444);
     if (fd < 0) {
-        VLOG_ERR("could not bootstrap CA cert: creating %s failed: %s",
+        VLOG_ERR(LOG_MODULE, "could not bootstrap CA cert: creating %s failed: %s",
                  ca_cert_file, strerror(errno));
         return errno;
     }
@@ -382,14 +416,14 @@ do_ca_cert_bootstrap(struct vconn *vconn)
     file = fdopen(fd, "w");
     if (!file) {
         int error = errno;
-        VLOG_ERR("could not bootstrap CA cert: fdopen failed: %s",
+        VLOG_ERR(LOG_MODULE, "could not bootstrap CA cert: fdopen failed: %s",
                  strerror(error));
         unlink(ca_cert_file);
         return error;
     }
 
     if (!PEM_write_X509(file, ca_cert)) {
-        VLOG_ERR("could not bootstrap CA cert: PEM_write_X509 to %s failed: "
+        VLOG_ERR(LOG_MODULE, "could not bootstrap CA cert: PEM_write_X509 to %s failed: "
                  "%s", ca_cert_file, ERR_error_string(ERR_get_error(), NULL));
         fclose(file);
         unlink(ca_cert_file);
@@ -398,13 +432,13 @@ do_ca_cert_bootstrap(struct vconn *vconn)
 
     if (fclose(file)) {
         int error = errno;
-        VLOG_ERR("could not bootstrap CA cert: writing %s failed: %s",
+        VLOG_ERR(LOG_MODULE, "could not bootstrap CA cert: writing %s failed: %s",
                  ca_cert_file, strerror(error));
         unlink(ca_cert_file);
         return error;
     }
 
-    VLOG_INFO("successfully bootstrapped CA cert to %s", ca_cert_file);
+    VLOG_INFO(LOG_MODULE, "successfully bootstrapped CA cert to %s", ca_cert_file);
     log_ca_cert(ca_cert_file, ca_cert);
     bootstrap_ca_cert = false;
     has_ca_cert = true;
@@ -419,11 +453,11 @@ do_ca_cert_bootstrap(struct vconn *vconn)
         out_of_memory();
     }
     if (SSL_CTX_load_verify_locations(ctx, ca_cert_file, NULL) != 1) {
-        VLOG_ERR("SSL_CTX_load_verify_locations: %s",
+        VLOG_ERR(LOG_MODULE, "SSL_CTX_load_verify_locations: %s",
                  ERR_error_string(ERR_get_error(), NULL));
         return EPROTO;
     }
-    VLOG_INFO("killing successful connection to retry using CA cert");
+    VLOG_INFO(LOG_MODULE, "killing successful connection to retry using CA cert");
     return EPROTO;
 }
 
@@ -453,10 +487,19 @@ ssl_connect(struct vconn *vconn)
                 int unused;
                 interpret_ssl_error((sslv->type == CLIENT ? "SSL_connect"
                                      : "SSL_accept"), retval, error, &unused);
+                if (sslv->type == CLIENT) {
+                    forget_client_session(vconn_get_name(vconn));
+                }
                 shutdown(sslv->fd, SHUT_RDWR);
                 return EPROTO;
             }
-        } else if (bootstrap_ca_cert) {
+        }
+
+        if (sslv->type == CLIENT) {
+            VLOG_DBG(LOG_MODULE, "%s: %s TLS session", vconn_get_name(vconn),
+                     SSL_session_reused(sslv->ssl) ? "resumed" : "new");
+        }
+        if (bootstrap_ca_cert) {
             return do_ca_cert_bootstrap(vconn);
         } else if ((SSL_get_verify_mode(sslv->ssl)
                     & (SSL_VERIFY_NONE | SSL_VERIFY_PEER))
@@ -469,7 +512,7 @@ ssl_connect(struct vconn *vconn)
              * certificate, but that's more trouble than it's worth.  These
              * connections will succeed the next time they retry, assuming that
              * they have a certificate against the correct CA.) */
-            VLOG_ERR("rejecting SSL connection during bootstrap race window");
+            VLOG_ERR(LOG_MODULE, "rejecting SSL connection during bootstrap race window");
             return EPROTO;
         } else {
             return 0;
@@ -484,8 +527,15 @@ ssl_close(struct vconn *vconn)
 {
     struct ssl_vconn *sslv = ssl_vconn_cast(vconn);
     poll_cancel(sslv->tx_waiter);
+    if (sslv->txbuf && !sslv->tx_error) {
+        /* Make an attempt to send the messages still being coalesced. */
+        ssl_do_tx(vconn);
+    }
     ssl_clear_txbuf(sslv);
     ofpbuf_delete(sslv->rxbuf);
+    /* OpenSSL does not resume a session whose connection was freed without
+     * sending a close_notify alert. */
+    SSL_shutdown(sslv->ssl);
     SSL_free(sslv->ssl);
     close(sslv->fd);
     free(sslv);
@@ -499,11 +549,11 @@ interpret_ssl_error(const char *function, int ret, int error,
 
     switch (error) {
     case SSL_ERROR_NONE:
-        VLOG_ERR_RL(&rl, "%s: unexpected SSL_ERROR_NONE", function);
+        VLOG_ERR_RL(LOG_MODULE, &rl, "%s: unexpected SSL_ERROR_NONE", function);
         break;
 
     case SSL_ERROR_ZERO_RETURN:
-        VLOG_ERR_RL(&rl, "%s: unexpected SSL_ERROR_ZERO_RETURN", function);
+        VLOG_ERR_RL(LOG_MODULE, &rl, "%s: unexpected SSL_ERROR_ZERO_RETURN", function);
         break;
 
     case SSL_ERROR_WANT_READ:
@@ -515,15 +565,15 @@ interpret_ssl_error(const char *function, int ret, int error,
         return EAGAIN;
 
     case SSL_ERROR_WANT_CONNECT:
-        VLOG_ERR_RL(&rl, "%s: unexpected SSL_ERROR_WANT_CONNECT", function);
+        VLOG_ERR_RL(LOG_MODULE, &rl, "%s: unexpected SSL_ERROR_WANT_CONNECT", function);
         break;
 
     case SSL_ERROR_WANT_ACCEPT:
-        VLOG_ERR_RL(&rl, "%s: unexpected SSL_ERROR_WANT_ACCEPT", function);
+        VLOG_ERR_RL(LOG_MODULE, &rl, "%s: unexpected SSL_ERROR_WANT_ACCEPT", function);
         break;
 
     case SSL_ERROR_WANT_X509_LOOKUP:
-        VLOG_ERR_RL(&rl, "%s: unexpected SSL_ERROR_WANT_X509_LOOKUP",
+        VLOG_ERR_RL(LOG_MODULE, &rl, "%s: unexpected SSL_ERROR_WANT_X509_LOOKUP",
                     function);
         break;
 
@@ -532,16 +582,16 @@ interpret_ssl_error(const char *function, int ret, int error,
         if (queued_error == 0) {
             if (ret < 0) {
                 int status = errno;
-                VLOG_WARN_RL(&rl, "%s: system error (%s)",
+                VLOG_WARN_RL(LOG_MODULE, &rl, "%s: system error (%s)",
                              function, strerror(status));
                 return status;
             } else {
-                VLOG_WARN_RL(&rl, "%s: unexpected SSL connection close",
+                VLOG_WARN_RL(LOG_MODULE, &rl, "%s: unexpected SSL connection close",
                              function);
                 return EPROTO;
             }
         } else {
-            VLOG_WARN_RL(&rl, "%s: %s",
+            VLOG_WARN_RL(LOG_MODULE, &rl, "%s: %s",
                          function, ERR_error_string(queued_error, NULL));
             break;
         }
@@ -550,17 +600,17 @@ interpret_ssl_error(const char *function, int ret, int error,
     case SSL_ERROR_SSL: {
         int queued_error = ERR_get_error();
         if (queued_error != 0) {
-            VLOG_WARN_RL(&rl, "%s: %s",
+            VLOG_WARN_RL(LOG_MODULE, &rl, "%s: %s",
                          function, ERR_error_string(queued_error, NULL));
         } else {
-            VLOG_ERR_RL(&rl, "%s: SSL_ERROR_SSL without queued error",
+            VLOG_ERR_RL(LOG_MODULE, &rl, "%s: SSL_ERROR_SSL without queued error",
                         function);
         }
         break;
     }
 
     default:
-        VLOG_ERR_RL(&rl, "%s: bad SSL error code %d", function, error);
+        VLOG_ERR_RL(LOG_MODULE, &rl, "%s: bad SSL error code %d", function, error);
         break;
     }
     return EIO;
@@ -576,7 +626,7 @@ ssl_recv(struct vconn *vconn, struct ofpbuf **bufferp)
     ssize_t ret;
 
     if (sslv->rxbuf == NULL) {
-        sslv->rxbuf = ofpbuf_new(1564);
+        sslv->rxbuf = ofpbuf_new_with_headroom(1564, VCONN_RX_HEADROOM);
     }
     rx = sslv->rxbuf;
 
@@ -587,7 +637,7 @@ again:
         struct ofp_header *oh = rx->data;
         size_t length = ntohs(oh->length);
         if (length < sizeof(struct ofp_header)) {
-            VLOG_ERR_RL(&rl, "received too-short ofp_header (%zu bytes)",
+            VLOG_ERR_RL(LOG_MODULE, &rl, "received too-short ofp_header (%zu bytes)",
                         length);
             return EPROTO;
         }
@@ -631,7 +681,7 @@ again:
         if (error == SSL_ERROR_ZERO_RETURN) {
             /* Connection closed (EOF). */
             if (rx->size) {
-                VLOG_WARN_RL(&rl, "SSL_read: unexpected connection close");
+                VLOG_WARN_RL(LOG_MODULE, &rl, "SSL_read: unexpected connection close");
                 return EPROTO;
             } else {
                 return EOF;
@@ -679,7 +729,7 @@ ssl_do_tx(struct vconn *vconn)
         } else {
             int ssl_error = SSL_get_error(sslv->ssl, ret);
             if (ssl_error == SSL_ERROR_ZERO_RETURN) {
-                VLOG_WARN_RL(&rl, "SSL_write: connection closed");
+                VLOG_WARN_RL(LOG_MODULE, &rl, "SSL_write: connection closed");
                 return EPIPE;
             } else {
                 return interpret_ssl_error("SSL_write", ret, ssl_error,
@@ -696,6 +746,8 @@ ssl_tx_poll_callback(int fd UNUSED, short int revents UNUSED, void *vconn_)
     struct ssl_vconn *sslv = ssl_vconn_cast(vconn);
     int error = ssl_do_tx(vconn);
     if (error != EAGAIN) {
+        /* The error is reported by the next ssl_send(). */
+        sslv->tx_error = error;
         ssl_clear_txbuf(sslv);
     } else {
         ssl_register_tx_waiter(vconn);
@@ -707,26 +759,31 @@ ssl_send(struct vconn *vconn, struct ofpbuf *buffer)
 {
     struct ssl_vconn *sslv = ssl_vconn_cast(vconn);
 
-    if (sslv->txbuf) {
+    if (sslv->tx_error) {
+        return sslv->tx_error;
+    } else if (sslv->txbuf && sslv->txbuf->size >= tx_coalesce) {
         return EAGAIN;
-    } else {
-        int error;
+    }
 
+    if (!sslv->txbuf) {
+        leak_checker_claim(buffer);
         sslv->txbuf = buffer;
-        error = ssl_do_tx(vconn);
-        switch (error) {
-        case 0:
-            ssl_clear_txbuf(sslv);
-            return 0;
-        case EAGAIN:
-            leak_checker_claim(buffer);
-            ssl_register_tx_waiter(vconn);
-            return 0;
-        default:
-            sslv->txbuf = NULL;
-            return error;
-        }
+    } else {
+        /* SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER allows the buffer to move, and
+         * a retried SSL_write() may pass more data than the original one. */
+        ofpbuf_put(sslv->txbuf, buffer->data, buffer->size);
+        ofpbuf_delete(buffer);
     }
+
+    if (sslv->tx_waiter) {
+        /* The pending write will send the appended message as well. */
+    } else if (sslv->txbuf->size >= tx_coalesce) {
+        ssl_tx_poll_callback(sslv->fd, POLLOUT, vconn);
+    } else {
+        sslv->tx_waiter = poll_fd_callback(sslv->fd, POLLOUT,
+                                           ssl_tx_poll_callback, vconn);
+    }
+    return 0;
 }
 
 static void
@@ -766,7 +823,7 @@ ssl_wait(struct vconn *vconn, enum vconn_wait_type wait)
         break;
 
     case WAIT_SEND:
-        if (!sslv->txbuf) {
+        if (!sslv->txbuf || sslv->txbuf->size < tx_coalesce) {
             /* We have room in our tx queue. */
             poll_immediate_wake();
         } else {
@@ -824,13 +881,13 @@ pssl_open(const char *name, char *suffix, struct pvconn **pvconnp)
     fd = socket(AF_INET, SOCK_STREAM, 0);
     if (fd < 0) {
         int error = errno;
-        VLOG_ERR("%s: socket: %s", name, strerror(error));
+        VLOG_ERR(LOG_MODULE, "%s: socket: %s", name, strerror(error));
         return error;
     }
 
     if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof yes) < 0) {
         int error = errno;
-        VLOG_ERR("%s: setsockopt(SO_REUSEADDR): %s", name, strerror(errno));
+        VLOG_ERR(LOG_MODULE, "%s: setsockopt(SO_REUSEADDR): %s", name, strerror(errno));
         return error;
     }
 
@@ -841,7 +898,7 @@ pssl_open(const char *name, char *suffix, struct pvconn **pvconnp)
     retval = bind(fd, (struct sockaddr *) &sin, sizeof sin);
     if (retval < 0) {
         int error = errno;
-        VLOG_ERR("%s: bind: %s", name, strerror(error));
+        VLOG_ERR(LOG_MODULE, "%s: bind: %s", name, strerror(error));
         close(fd);
         return error;
     }
@@ -849,7 +906,7 @@ pssl_open(const char *name, char *suffix, struct pvconn **pvconnp)
     retval = listen(fd, 10);
     if (retval < 0) {
         int error = errno;
-        VLOG_ERR("%s: listen: %s", name, strerror(error));
+        VLOG_ERR(LOG_MODULE, "%s: listen: %s", name, strerror(error));
         close(fd);
         return error;
     }
@@ -889,7 +946,7 @@ pssl_accept(struct pvconn *pvconn, struct vconn **new_vconnp)
     if (new_fd < 0) {
         int error = errno;
         if (error != EAGAIN) {
-            VLOG_DBG_RL(&rl, "accept: %s", strerror(error));
+            VLOG_DBG_RL(LOG_MODULE, &rl, "accept: %s", strerror(error));
         }
         return error;
     }
@@ -949,24 +1006,47 @@ ssl_init(void)
 static int
 do_ssl_init(void)
 {
-    SSL_METHOD *method;
+    const SSL_METHOD *method;
 
     SSL_library_init();
     SSL_load_error_strings();
 
-    method = TLSv1_method();
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+    method = TLS_method();
+#else
+    method = SSLv23_method();
+#endif
     if (method == NULL) {
-        VLOG_ERR("TLSv1_method: %s", ERR_error_string(ERR_get_error(), NULL));
+        VLOG_ERR(LOG_MODULE, "TLS_method: %s", ERR_error_string(ERR_get_error(), NULL));
         return ENOPROTOOPT;
     }
 
     ctx = SSL_CTX_new(method);
     if (ctx == NULL) {
-        VLOG_ERR("SSL_CTX_new: %s", ERR_error_string(ERR_get_error(), NULL));
+        VLOG_ERR(LOG_MODULE, "SSL_CTX_new: %s", ERR_error_string(ERR_get_error(), NULL));
         return ENOPROTOOPT;
     }
-    SSL_CTX_set_options(ctx, SSL_OP_NO_SSLv2 | SSL_OP_NO_SSLv3);
+    SSL_CTX_set_options(ctx, SSL_OP_NO_SSLv2 | SSL_OP_NO_SSLv3
+                             | SSL_OP_CIPHER_SERVER_PREFERENCE);
+    if (SSL_CTX_set_cipher_list(ctx, SSL_CIPHERS) != 1) {
+        VLOG_ERR(LOG_MODULE, "SSL_CTX_set_cipher_list: %s",
+                 ERR_error_string(ERR_get_error(), NULL));
+        return ENOPROTOOPT;
+    }
+#if OPENSSL_VERSION_NUMBER >= 0x10002000L && OPENSSL_VERSION_NUMBER < 0x10100000L
+    /* Later versions enable ECDHE by default. */
+    SSL_CTX_set_ecdh_auto(ctx, 1);
+#endif
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    /* Use the built-in RFC 7919 groups for DHE. */
+    SSL_CTX_set_dh_auto(ctx, 1);
+#else
     SSL_CTX_set_tmp_dh_callback(ctx, tmp_dh_callback);
+#endif
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_BOTH);
+    SSL_CTX_set_session_id_context(ctx, (const unsigned char *) "openflow",
+                                   strlen("openflow"));
+    SSL_CTX_sess_set_new_cb(ctx, new_session_callback);
     SSL_CTX_set_mode(ctx, SSL_MODE_ENABLE_PARTIAL_WRITE);
     SSL_CTX_set_mode(ctx, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
     SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT,
@@ -975,6 +1055,45 @@ do_ssl_init(void)
     return 0;
 }
 
+/* Called by OpenSSL when a new session is established.  On client
+ * connections, saves the session for resuming the next connection to the
+ * same peer.  (With TLS 1.3, this happens after the handshake, when the
+ * server sends a session ticket.) */
+static int
+new_session_callback(SSL *ssl, SSL_SESSION *session)
+{
+    struct ssl_vconn *sslv = SSL_get_app_data(ssl);
+    const char *name;
+    struct shash_node *node;
+
+    if (sslv == NULL || sslv->type != CLIENT) {
+        return 0;
+    }
+
+    name = vconn_get_name(&sslv->vconn);
+    node = shash_find(&client_sessions, name);
+    if (node) {
+        SSL_SESSION_free(node->data);
+        node->data = session;
+    } else {
+        shash_add(&client_sessions, name, session);
+    }
+    return 1;
+}
+
+/* Discards the saved session for the peer 'name', e.g. because resuming it
+ * failed. */
+static void
+forget_client_session(const char *name)
+{
+    struct shash_node *node = shash_find(&client_sessions, name);
+    if (node) {
+        SSL_SESSION_free(node->data);
+        shash_delete(&client_sessions, node);
+    }
+}
+
+#if OPENSSL_VERSION_NUMBER < 0x30000000L
 static DH *
 tmp_dh_callback(SSL *ssl UNUSED, int is_export UNUSED, int keylength)
 {
@@ -1004,10 +1123,11 @@ tmp_dh_callback(SSL *ssl UNUSED, int is_export UNUSED, int keylength)
             return dh->dh;
         }
     }
-    VLOG_ERR_RL(&rl, "no Diffie-Hellman parameters for key length %d",
+    VLOG_ERR_RL(LOG_MODULE, &rl, "no Diffie-Hellman parameters for key length %d",
                 keylength);
     return NULL;
 }
+#endif
 
 /* Returns true if SSL is at least partially configured. */
 bool
@@ -1023,7 +1143,7 @@ vconn_ssl_set_private_key_file(const char *file_name)
         return;
     }
     if (SSL_CTX_use_PrivateKey_file(ctx, file_name, SSL_FILETYPE_PEM) != 1) {
-        VLOG_ERR("SSL_use_PrivateKey_file: %s",
+        VLOG_ERR(LOG_MODULE, "SSL_use_PrivateKey_file: %s",
                  ERR_error_string(ERR_get_error(), NULL));
         return;
     }
@@ -1037,7 +1157,7 @@ vconn_ssl_set_certificate_file(const char *file_name)
         return;
     }
     if (SSL_CTX_use_certificate_chain_file(ctx, file_name) != 1) {
-        VLOG_ERR("SSL_use_certificate_file: %s",
+        VLOG_ERR(LOG_MODULE, "SSL_use_certificate_file: %s",
                  ERR_error_string(ERR_get_error(), NULL));
         return;
     }
@@ -1062,7 +1182,7 @@ read_cert_file(const char *file_name, X509 ***certs, size_t *n_certs)
 
     file = fopen(file_name, "r");
     if (!file) {
-        VLOG_ERR("failed to open %s for reading: %s",
+        VLOG_ERR(LOG_MODULE, "failed to open %s for reading: %s",
                  file_name, strerror(errno));
         return errno;
     }
@@ -1076,7 +1196,7 @@ read_cert_file(const char *file_name, X509 ***certs, size_t *n_certs)
         if (!certificate) {
             size_t i;
 
-            VLOG_ERR("PEM_read_X509 failed reading %s: %s",
+            VLOG_ERR(LOG_MODULE, "PEM_read_X509 failed reading %s: %s",
                      file_name, ERR_error_string(ERR_get_error(), NULL));
             for (i = 0; i < *n_certs; i++) {
                 X509_free((*certs)[i]);
@@ -1125,7 +1245,7 @@ vconn_ssl_set_peer_ca_cert_file(const char *file_name)
     if (!read_cert_file(file_name, &certs, &n_certs)) {
         for (i = 0; i < n_certs; i++) {
             if (SSL_CTX_add_extra_chain_cert(ctx, certs[i]) != 1) {
-                VLOG_ERR("SSL_CTX_add_extra_chain_cert: %s",
+                VLOG_ERR(LOG_MODULE, "SSL_CTX_add_extra_chain_cert: %s",
                          ERR_error_string(ERR_get_error(), NULL));
             }
         }
@@ -1155,7 +1275,7 @@ log_ca_cert(const char *file_name, X509 *cert)
         }
     }
     subject = X509_NAME_oneline(X509_get_subject_name(cert), NULL, 0);
-    VLOG_INFO("Trusting CA cert from %s (%s) (fingerprint %s)", file_name,
+    VLOG_INFO(LOG_MODULE, "Trusting CA cert from %s (%s) (fingerprint %s)", file_name,
               subject ? subject : "<out of memory>", ds_cstr(&fp));
     free(subject);
     ds_destroy(&fp);
@@ -1187,7 +1307,7 @@ vconn_ssl_set_ca_cert_file(const char *file_name, bool bootstrap)
         for (i = 0; i < n_certs; i++) {
             /* SSL_CTX_add_client_CA makes a copy of the relevant data. */
             if (SSL_CTX_add_client_CA(ctx, certs[i]) != 1) {
-                VLOG_ERR("failed to add client certificate %d from %s: %s",
+                VLOG_ERR(LOG_MODULE, "failed to add client certificate %zu from %s: %s",
                          i, file_name,
                          ERR_error_string(ERR_get_error(), NULL));
             } else {
@@ -1199,7 +1319,7 @@ vconn_ssl_set_ca_cert_file(const char *file_name, bool bootstrap)
         /* Set up CAs for OpenSSL to trust in verifying the peer's
          * certificate. */
         if (SSL_CTX_load_verify_locations(ctx, file_name, NULL) != 1) {
-            VLOG_ERR("SSL_CTX_load_verify_locations: %s",
+            VLOG_ERR(LOG_MODULE, "SSL_CTX_load_verify_locations: %s",
                      ERR_error_string(ERR_get_error(), NULL));
             return;
         }
@@ -1207,3 +1327,26 @@ vconn_ssl_set_ca_cert_file(const char *file_name, bool bootstrap)
         has_ca_cert = true;
     }
 }
+
+/* Sets the number of bytes of messages that a connection coalesces before
+ * writing them, 0 to write each message on its own.  The default is
+ * VCONN_SSL_TX_COALESCE. */
+void
+vconn_ssl_set_tx_coalesce(size_t n_bytes)
+{
+    tx_coalesce = n_bytes;
+}
+
+/* Discards the sessions saved for resuming client connections, so that the
+ * next connection to each peer does a full handshake. */
+void
+vconn_ssl_forget_sessions(void)
+{
+    struct shash_node *node, *next;
+
+    HMAP_FOR_EACH_SAFE (node, next, struct shash_node, node,
+                        &client_sessions.map) {
+        SSL_SESSION_free(node->data);
+        shash_delete(&client_sessions, node);
+    }
+}
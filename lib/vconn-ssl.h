@@ -34,13 +34,19 @@
 #define VCONN_SSL_H 1
 
 #include <stdbool.h>
+#include <stddef.h>
 
 #ifdef HAVE_OPENSSL
+/* Default number of bytes of messages coalesced into one TLS record. */
+#define VCONN_SSL_TX_COALESCE 16384
+
 bool vconn_ssl_is_configured(void);
 void vconn_ssl_set_private_key_file(const char *file_name);
 void vconn_ssl_set_certificate_file(const char *file_name);
 void vconn_ssl_set_ca_cert_file(const char *file_name, bool bootstrap);
 void vconn_ssl_set_peer_ca_cert_file(const char *file_name);
+void vconn_ssl_set_tx_coalesce(size_t n_bytes);
+void vconn_ssl_forget_sessions(void);
 
 #define VCONN_SSL_LONG_OPTIONS                      \
         {"private-key", required_argument, 0, 'p'}, \
@@ -120,7 +120,7 @@ stream_recv(struct vconn *vconn, struct ofpbuf **bufferp)
     ssize_t retval;
 
     if (s->rxbuf == NULL) {
-        s->rxbuf = ofpbuf_new(1564);
+        s->rxbuf = ofpbuf_new_with_headroom(1564, VCONN_RX_HEADROOM);
     }
     rx = s->rxbuf;
 
@@ -47,6 +47,11 @@ struct vconn;
 
 void vconn_usage(bool active, bool passive, bool bootstrap);
 
+/* Bytes of headroom that stream and SSL vconns leave before each message they
+ * receive, so that headers can be pushed onto a packet carried in the message
+ * without moving it. */
+#define VCONN_RX_HEADROOM 64
+
 /* Active vconns: virtual connections to OpenFlow devices. */
 int vconn_open(const char *name, int min_version, struct vconn **);
 void vconn_close(struct vconn *);
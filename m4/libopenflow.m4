@@ -76,7 +76,7 @@ AC_DEFUN([OFP_CHECK_OPENSSL],
    if test "$ssl" = true; then
    dnl Make sure that pkg-config is installed.
    m4_pattern_forbid([PKG_CHECK_MODULES])
-   PKG_CHECK_MODULES([SSL], [libssl], 
+   PKG_CHECK_MODULES([SSL], [libssl libcrypto], 
      [HAVE_OPENSSL=yes],
      [HAVE_OPENSSL=no
       AC_MSG_WARN([Cannot find libssl:
@@ -8,6 +8,7 @@ noinst_LIBRARIES += nbee_link/libnbee_link.a
 #	lib/hmap.o 	
 
 nbee_link_libnbee_link_a_SOURCES = nbee_link/nbee_link.cpp \
+			nbee_link/nbee_link_l2.c \
 			nbee_link/nbee_link.h
 
 MAINTAINERCLEANFILES = Makefile.in aclocal.m4 config.guess config.sub config.h.in configure depcomp install-sh missing ltmain.sh *~ *.tar.*
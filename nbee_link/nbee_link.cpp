@@ -265,14 +265,14 @@ int nblink_extract_proto_fields(struct ofpbuf * pktin, _nbPDMLField * field, str
             ofl_structs_match_put32(pktout, header, m_value);
         }
         else if (header == OXM_OF_MPLS_TC){
-            uint8_t m_value;
-            sscanf(field->Value, "%hhx", &m_value);
+            uint32_t m_value;
+            sscanf(field->Value, "%x", &m_value);
             m_value = (m_value & MPLS_TC_MASK) >> MPLS_TC_SHIFT;
             ofl_structs_match_put32(pktout, header, m_value);
         }
         else if (header == OXM_OF_MPLS_BOS){
-            uint8_t m_value;
-            sscanf(field->Value, "%hhx", &m_value);
+            uint32_t m_value;
+            sscanf(field->Value, "%x", &m_value);
             m_value = (m_value & MPLS_S_MASK) >> MPLS_S_SHIFT;
             ofl_structs_match_put8(pktout, header, m_value);
         }
@@ -348,8 +348,11 @@ int nblink_extract_proto_fields(struct ofpbuf * pktin, _nbPDMLField * field, str
 }
 
 
-extern "C" int nblink_packet_parse(struct ofpbuf * pktin,  struct ofl_match * pktout, struct protocols_std * pkt_proto)
+extern "C" int nblink_packet_parse(struct ofpbuf * pktin,  struct ofl_match * pktout, struct protocols_std * pkt_proto, int depth)
 {
+    if (depth == NBLINK_PARSE_L2)
+        return nblink_packet_parse_l2(pktin, pktout, pkt_proto);
+
     protocol_reset(pkt_proto);
     pkhdr->caplen = pktin->size; //need this information
     pkhdr->len = pktin->size; //need this information
@@ -431,6 +434,8 @@ extern "C" int nblink_packet_parse(struct ofpbuf * pktin,  struct ofl_match * pk
             else if (protocol_Name.compare("arp") == 0 && pkt_proto->arp == NULL)
             {
                 pkt_proto->arp = (struct arp_eth_header *) ((uint8_t*) pktin->data + proto->Position);
+                if (depth < NBLINK_PARSE_L3)
+                    goto next_proto;
                 PDMLReader->GetPDMLField(proto->Name, (char*) "op", proto->FirstField, &field);
                 nblink_extract_proto_fields(pktin, field, pktout, OXM_OF_ARP_OP);
                 PDMLReader->GetPDMLField(proto->Name, (char*) "sHwAddr", proto->FirstField, &field);
@@ -454,6 +459,8 @@ extern "C" int nblink_packet_parse(struct ofpbuf * pktin,  struct ofl_match * pk
             if (protocol_Name.compare("ip") == 0 && pkt_proto->ipv4 == NULL)
             {
                 pkt_proto->ipv4 = (struct ip_header *) ((uint8_t*) pktin->data + proto->Position);
+                if (depth < NBLINK_PARSE_L3)
+                    goto next_proto;
                 PDMLReader->GetPDMLField(proto->Name, (char*) "ip dscp", proto->FirstField, &field);
                 nblink_extract_proto_fields(pktin, field, pktout, OXM_OF_IP_DSCP);
                 PDMLReader->GetPDMLField(proto->Name, (char*) "ip ecn", proto->FirstField, &field);
@@ -468,21 +475,29 @@ extern "C" int nblink_packet_parse(struct ofpbuf * pktin,  struct ofl_match * pk
             else if (protocol_Name.compare("ipv6") == 0 && pkt_proto->ipv6 == NULL)
             {
                 pkt_proto->ipv6 = (struct ipv6_header *) ((uint8_t*) pktin->data + proto->Position);
+                if (depth < NBLINK_PARSE_L3)
+                    goto next_proto;
                 PDMLReader->GetPDMLField(proto->Name, (char*) "flabel", proto->FirstField, &field);
                 nblink_extract_proto_fields(pktin, field, pktout, OXM_OF_IPV6_FLABEL);
                 PDMLReader->GetPDMLField(proto->Name, (char*) "nexthdr", proto->FirstField, &field);
+                nblink_extract_proto_fields(pktin, field, pktout, OXM_OF_IP_PROTO);
+                char *pEnd;
+                uint16_t next_header = strtol(field->Value, &pEnd,16);
+                PDMLReader->GetPDMLField(proto->Name, (char*) "src", proto->FirstField, &field);
+                nblink_extract_proto_fields(pktin, field, pktout, OXM_OF_IPV6_SRC);
+                PDMLReader->GetPDMLField(proto->Name, (char*) "dst", proto->FirstField, &field);
+                nblink_extract_proto_fields(pktin, field, pktout, OXM_OF_IPV6_DST);
+                if (depth < NBLINK_PARSE_L4)
+                    goto next_proto;
+
                 /*Initialize extension header OXM */
                 struct ofl_match_tlv * EH_field;
-                uint16_t bit_field = OFPIEH_NONEXT;
-                uint8_t i;
                 EH_field = (struct ofl_match_tlv *) malloc(sizeof(struct ofl_match_tlv));
                 EH_field->value = (uint8_t*) malloc(OXM_LENGTH(OXM_OF_IPV6_EXTHDR));
                 EH_field->header = OXM_OF_IPV6_EXTHDR;
                 /*Set everything to zero */
                 memset(EH_field->value,0x0, sizeof(uint16_t));
 
-                char *pEnd;
-                uint16_t next_header = strtol(field->Value, &pEnd,16);
                 /*Set OFPIEH_NONEXT */
                 if (next_header == IPV6_NO_NEXT_HEADER)
                 {
@@ -493,18 +508,9 @@ extern "C" int nblink_packet_parse(struct ofpbuf * pktin,  struct ofl_match * pk
                     *ext_hdrs = *ext_hdrs;
                 }
 
-
-
                 hmap_insert_fast(&pktout->match_fields, &EH_field->hmap_node,
                             hash_int(EH_field->header, 0));
 
-                nblink_extract_proto_fields(pktin, field, pktout, OXM_OF_IP_PROTO);
-                PDMLReader->GetPDMLField(proto->Name, (char*) "src", proto->FirstField, &field);
-                nblink_extract_proto_fields(pktin, field, pktout, OXM_OF_IPV6_SRC);
-                PDMLReader->GetPDMLField(proto->Name, (char*) "dst", proto->FirstField, &field);
-                nblink_extract_proto_fields(pktin, field, pktout, OXM_OF_IPV6_DST);
-
-
                 if (PDMLReader->GetPDMLField(proto->Name, (char*) "HBH", proto->FirstField, &field) == nbSUCCESS)
                     nblink_extract_exthdr_fields(pktin, pktout, OFPIEH_HOP, field, &destination_num);
                 if(PDMLReader->GetPDMLField(proto->Name, (char*) "FH", proto->FirstField, &field) == nbSUCCESS)
@@ -522,6 +528,8 @@ extern "C" int nblink_packet_parse(struct ofpbuf * pktin,  struct ofl_match * pk
             if (protocol_Name.compare("tcp") == 0 && pkt_proto->tcp == NULL)
             {
                 pkt_proto->tcp = (struct tcp_header *) ((uint8_t*) pktin->data + proto->Position);
+                if (depth < NBLINK_PARSE_L4)
+                    goto next_proto;
                 PDMLReader->GetPDMLField(proto->Name, (char*) "sport", proto->FirstField, &field);
                 nblink_extract_proto_fields(pktin, field, pktout, OXM_OF_TCP_SRC);
                 PDMLReader->GetPDMLField(proto->Name, (char*) "dport", proto->FirstField, &field);
@@ -530,6 +538,8 @@ extern "C" int nblink_packet_parse(struct ofpbuf * pktin,  struct ofl_match * pk
             else if (protocol_Name.compare("udp") == 0 && pkt_proto->udp == NULL)
             {
                 pkt_proto->udp = (struct udp_header *) ((uint8_t*) pktin->data + proto->Position);
+                if (depth < NBLINK_PARSE_L4)
+                    goto next_proto;
                 PDMLReader->GetPDMLField(proto->Name, (char*) "sport", proto->FirstField, &field);
                 nblink_extract_proto_fields(pktin, field, pktout, OXM_OF_UDP_SRC);
                 PDMLReader->GetPDMLField(proto->Name, (char*) "dport", proto->FirstField, &field);
@@ -542,6 +552,8 @@ extern "C" int nblink_packet_parse(struct ofpbuf * pktin,  struct ofl_match * pk
 
             if (protocol_Name.compare("icmp") == 0 && pkt_proto->icmp == NULL){
                 pkt_proto->icmp = (struct icmp_header *) ((uint8_t*) pktin->data + proto->Position);
+                if (depth < NBLINK_PARSE_L4)
+                    goto next_proto;
 
                 PDMLReader->GetPDMLField(proto->Name, (char*) "type", proto->FirstField, &field);
                 nblink_extract_proto_fields(pktin, field, pktout, OXM_OF_ICMPV4_TYPE);
@@ -550,6 +562,8 @@ extern "C" int nblink_packet_parse(struct ofpbuf * pktin,  struct ofl_match * pk
             }
             else if (protocol_Name.compare("icmp6") == 0 && pkt_proto->icmp == NULL){
                 pkt_proto->icmp = (struct icmp_header *) ((uint8_t*) pktin->data + proto->Position);
+                if (depth < NBLINK_PARSE_L4)
+                    goto next_proto;
 
                 PDMLReader->GetPDMLField(proto->Name, (char*) "type", proto->FirstField, &field);
                 nblink_extract_proto_fields(pktin, field, pktout, OXM_OF_ICMPV6_TYPE);
@@ -567,6 +581,7 @@ extern "C" int nblink_packet_parse(struct ofpbuf * pktin,  struct ofl_match * pk
                     nblink_extract_proto_fields(pktin, field, pktout, OXM_OF_IPV6_ND_TLL);
                 }
             }
+next_proto:
             while (!field->isField)
             {
             // This is necessary for Protocols with a Block as a first "field" on NetBee,
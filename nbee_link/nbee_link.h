@@ -51,10 +51,27 @@ extern "C"
 #endif
 int nblink_initialize(void);
 
+/* How deep nblink_packet_parse() extracts match fields.  The protocol
+ * pointers in struct protocols_std are set at every depth. */
+enum nblink_parse_depth {
+    NBLINK_PARSE_L2,   /* Ethernet, VLAN, PBB and MPLS fields. */
+    NBLINK_PARSE_L3,   /* Also ARP, IPv4 and IPv6 header fields. */
+    NBLINK_PARSE_L4    /* Also IPv6 extension headers, TCP, UDP, ICMP and ND. */
+};
+#define NBLINK_PARSE_N (NBLINK_PARSE_L4 + 1)
+
+#ifdef __cplusplus
+extern "C"
+#endif
+int nblink_packet_parse(struct ofpbuf * pktin, struct ofl_match * pktout, struct protocols_std * pkt_proto, int depth);
+
+/* Native parser behind nblink_packet_parse() at NBLINK_PARSE_L2: the
+ * link layer fields are at fixed offsets, so the frame is not run through
+ * the NetBee decoder at all. */
 #ifdef __cplusplus
 extern "C"
 #endif
-int nblink_packet_parse(struct ofpbuf * pktin, struct ofl_match * pktout, struct protocols_std * pkt_proto);
+int nblink_packet_parse_l2(struct ofpbuf * pktin, struct ofl_match * pktout, struct protocols_std * pkt_proto);
 
 
 
@@ -0,0 +1,206 @@
+/*
+ * nbee_link_l2.c
+ *
+ * Link layer parser used by nblink_packet_parse() at NBLINK_PARSE_L2
+ * depth.  It extracts the same match fields NetBee does at that depth and
+ * sets the same protocol pointers, without decoding the frame into PDML.
+ */
+
+#include <config.h>
+#include <string.h>
+#include <netinet/in.h>
+
+#include "oflib/ofl-structs.h"
+#include "oflib/oxm-match.h"
+#include "nbee_link.h"
+
+/* Returns the header of 'len' bytes at 'ofs' in 'pktin', or NULL if the
+ * frame is too short to hold it. */
+static void *
+l2_header_at(struct ofpbuf *pktin, size_t ofs, size_t len)
+{
+    return ofs + len <= pktin->size ? (uint8_t *) pktin->data + ofs : NULL;
+}
+
+static bool
+l2_is_vlan_type(uint16_t type)
+{
+    return type == ETH_TYPE_VLAN || type == ETH_TYPE_SVLAN
+           || type == ETH_TYPE_VLAN_QinQ || type == ETH_TYPE_VLAN_PBB_B;
+}
+
+/* Sets the ICMP, TCP or UDP pointer for an IP payload of 'proto' at
+ * 'ofs'. */
+static void
+l2_set_l4(struct ofpbuf *pktin, struct protocols_std *pkt_proto,
+          uint8_t proto, size_t ofs)
+{
+    if (proto == IP_TYPE_TCP) {
+        pkt_proto->tcp = l2_header_at(pktin, ofs, TCP_HEADER_LEN);
+    } else if (proto == IP_TYPE_UDP) {
+        pkt_proto->udp = l2_header_at(pktin, ofs, UDP_HEADER_LEN);
+    } else if (proto == IP_TYPE_ICMP || proto == IPV6_TYPE_ICMPV6) {
+        pkt_proto->icmp = l2_header_at(pktin, ofs, ICMP_HEADER_LEN);
+    }
+}
+
+static void
+l2_parse_ipv4(struct ofpbuf *pktin, struct protocols_std *pkt_proto,
+              size_t ofs)
+{
+    struct ip_header *ip = l2_header_at(pktin, ofs, IP_HEADER_LEN);
+    size_t ihl;
+
+    if (ip == NULL) {
+        return;
+    }
+    ihl = IP_IHL(ip->ip_ihl_ver) * 4;
+    if (ihl < IP_HEADER_LEN || ofs + ihl > pktin->size) {
+        return;
+    }
+    pkt_proto->ipv4 = ip;
+    /* Like the NetPDL description, only the first fragment carries the
+     * transport header. */
+    if (!(ip->ip_frag_off & htons(IP_FRAG_OFF_MASK))) {
+        l2_set_l4(pktin, pkt_proto, ip->ip_proto, ofs + ihl);
+    }
+}
+
+static void
+l2_parse_ipv6(struct ofpbuf *pktin, struct protocols_std *pkt_proto,
+              size_t ofs)
+{
+    struct ipv6_header *ipv6 = l2_header_at(pktin, ofs, IPV6_HEADER_LEN);
+    uint8_t next;
+
+    if (ipv6 == NULL) {
+        return;
+    }
+    pkt_proto->ipv6 = ipv6;
+    next = ipv6->ipv6_next_hd;
+    ofs += IPV6_HEADER_LEN;
+
+    for (;;) {
+        uint8_t *eh = l2_header_at(pktin, ofs, 8);
+        size_t len;
+
+        if (next == IPV6_TYPE_HBH || next == IPV6_TYPE_DOH
+            || next == IPV6_TYPE_RH) {
+            len = eh ? (eh[1] + 1) * 8 : 0;
+        } else if (next == IPV6_TYPE_FH) {
+            len = 8;
+        } else if (next == IPV6_TYPE_AH) {
+            len = eh ? (eh[1] + 2) * 4 : 0;
+        } else {
+            break;
+        }
+        if (eh == NULL || ofs + len > pktin->size) {
+            return;
+        }
+        if (next == IPV6_TYPE_FH
+            && (ntohs(*(uint16_t *) (eh + 2)) & 0xfff8)) {
+            /* Not the first fragment. */
+            return;
+        }
+        next = eh[0];
+        ofs += len;
+    }
+    l2_set_l4(pktin, pkt_proto, next, ofs);
+}
+
+int
+nblink_packet_parse_l2(struct ofpbuf *pktin, struct ofl_match *pktout,
+                       struct protocols_std *pkt_proto)
+{
+    struct eth_header *eth;
+    uint16_t type;
+    size_t ofs;
+
+    protocol_reset(pkt_proto);
+    eth = l2_header_at(pktin, 0, ETH_HEADER_LEN);
+    if (eth == NULL) {
+        return -1;
+    }
+    pkt_proto->eth = eth;
+    ofl_structs_match_put_eth(pktout, OXM_OF_ETH_DST, eth->eth_dst);
+    ofl_structs_match_put_eth(pktout, OXM_OF_ETH_SRC, eth->eth_src);
+
+    type = ntohs(eth->eth_type);
+    ofs = ETH_HEADER_LEN;
+    while (l2_is_vlan_type(type)) {
+        struct vlan_header *vlan = l2_header_at(pktin, ofs,
+                                                VLAN_HEADER_LEN);
+        if (vlan == NULL) {
+            break;
+        }
+        if (pkt_proto->vlan == NULL) {
+            uint16_t tci = ntohs(vlan->vlan_tci);
+
+            pkt_proto->vlan = vlan;
+            ofl_structs_match_put16(pktout, OXM_OF_VLAN_PCP,
+                    (tci & VLAN_PCP_MASK) >> VLAN_PCP_SHIFT);
+            ofl_structs_match_put16(pktout, OXM_OF_VLAN_VID,
+                                    tci & VLAN_VID_MASK);
+        }
+        pkt_proto->vlan_last = vlan;
+        type = ntohs(vlan->vlan_next_type);
+        ofs += VLAN_HEADER_LEN;
+    }
+    /* The outermost non-VLAN Ethertype is the one matched on. */
+    if (!l2_is_vlan_type(type)) {
+        ofl_structs_match_put16(pktout, OXM_OF_ETH_TYPE, type);
+    }
+
+    if (type == ETH_TYPE_MPLS || type == ETH_TYPE_MPLS_MCAST) {
+        struct mpls_header *mpls;
+        uint32_t fields = 0;
+        uint32_t label;
+        uint8_t version;
+
+        while ((mpls = l2_header_at(pktin, ofs, MPLS_HEADER_LEN)) != NULL) {
+            fields = ntohl(mpls->fields);
+            if (pkt_proto->mpls == NULL) {
+                pkt_proto->mpls = mpls;
+                ofl_structs_match_put32(pktout, OXM_OF_MPLS_LABEL,
+                        (fields & MPLS_LABEL_MASK) >> MPLS_LABEL_SHIFT);
+                ofl_structs_match_put32(pktout, OXM_OF_MPLS_TC,
+                        (fields & MPLS_TC_MASK) >> MPLS_TC_SHIFT);
+                ofl_structs_match_put8(pktout, OXM_OF_MPLS_BOS,
+                        (fields & MPLS_S_MASK) >> MPLS_S_SHIFT);
+            }
+            ofs += MPLS_HEADER_LEN;
+            if (fields & MPLS_S_MASK) {
+                break;
+            }
+        }
+        if (mpls == NULL || ofs >= pktin->size) {
+            return 1;
+        }
+        /* Labels 0 and 2 are the IPv4 and IPv6 explicit nulls; otherwise
+         * go by the version nibble. */
+        label = (fields & MPLS_LABEL_MASK) >> MPLS_LABEL_SHIFT;
+        version = ((uint8_t *) pktin->data)[ofs] >> 4;
+        if (label == 2 || (label != 0 && version == 6)) {
+            l2_parse_ipv6(pktin, pkt_proto, ofs);
+        } else if (label == 0 || version == 4) {
+            l2_parse_ipv4(pktin, pkt_proto, ofs);
+        }
+    } else if (type == ETH_TYPE_IP) {
+        l2_parse_ipv4(pktin, pkt_proto, ofs);
+    } else if (type == ETH_TYPE_IPV6) {
+        l2_parse_ipv6(pktin, pkt_proto, ofs);
+    } else if (type == ETH_TYPE_ARP) {
+        pkt_proto->arp = l2_header_at(pktin, ofs, ARP_ETH_HEADER_LEN);
+    } else if (type == ETH_TYPE_VLAN_PBB_S) {
+        /* The customer frame behind the I-TAG is not parsed, as its fields
+         * cannot be matched on with an Ethertype of 0x88e7. */
+        struct pbb_header *pbb = l2_header_at(pktin, ofs, PBB_HEADER_LEN);
+
+        if (pbb != NULL) {
+            pkt_proto->pbb = pbb;
+            ofl_structs_match_put32(pktout, OXM_OF_PBB_ISID,
+                                    ntohl(pbb->id) & PBB_ISID_MASK);
+        }
+    }
+    return 1;
+}
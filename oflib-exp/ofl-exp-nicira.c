@@ -29,8 +29,10 @@
  * Author: Zoltán Lajos Kis <zoltan.lajos.kis@ericsson.com>
  */
 
+#include <inttypes.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <netinet/in.h>
 
 #include "openflow/openflow.h"
@@ -38,11 +40,387 @@
 #include "ofl-exp-nicira.h"
 #include "../oflib/ofl-print.h"
 #include "../oflib/ofl-log.h"
+#include "../oflib/ofl-utils.h"
+#include "../oflib/oxm-match.h"
 
 #define LOG_MODULE ofl_exp_nx
 OFL_LOG_INIT(LOG_MODULE)
 
 
+/* The elements of a learn action are only 16-bit aligned. */
+
+static uint8_t *
+put_be16(uint8_t *p, uint16_t value) {
+    value = htons(value);
+    memcpy(p, &value, sizeof value);
+    return p + sizeof value;
+}
+
+static uint8_t *
+put_be32(uint8_t *p, uint32_t value) {
+    value = htonl(value);
+    memcpy(p, &value, sizeof value);
+    return p + sizeof value;
+}
+
+static uint16_t
+get_be16(uint8_t **p) {
+    uint16_t value;
+    memcpy(&value, *p, sizeof value);
+    *p += sizeof value;
+    return ntohs(value);
+}
+
+static uint32_t
+get_be32(uint8_t **p) {
+    uint32_t value;
+    memcpy(&value, *p, sizeof value);
+    *p += sizeof value;
+    return ntohl(value);
+}
+
+static size_t
+learn_spec_ofp_len(struct ofl_exp_nicira_learn_spec *spec) {
+    size_t len = sizeof(uint16_t);
+
+    if (spec->src == NX_LEARN_SRC_FIELD) {
+        len += sizeof(uint32_t) + sizeof(uint16_t);
+    } else {
+        len += NX_LEARN_IMMEDIATE_LEN(spec->n_bits);
+    }
+    if (spec->dst == NX_LEARN_DST_MATCH || spec->dst == NX_LEARN_DST_LOAD) {
+        len += sizeof(uint32_t) + sizeof(uint16_t);
+    }
+    return len;
+}
+
+static size_t
+learn_ofp_len(struct ofl_exp_nicira_act_learn *learn) {
+    size_t len = sizeof(struct nx_action_learn);
+    size_t i;
+
+    for (i = 0; i < learn->specs_num; i++) {
+        len += learn_spec_ofp_len(&learn->specs[i]);
+    }
+    return ROUND_UP(len, 8);
+}
+
+/* Unpacks the flow_mod_spec elements of a learn action, from 'p' to 'end',
+ * into 'learn'. */
+static ofl_err
+learn_unpack_specs(uint8_t *p, uint8_t *end, struct ofl_exp_nicira_act_learn *learn) {
+    while (end - p >= (ptrdiff_t)sizeof(uint16_t)) {
+        struct ofl_exp_nicira_learn_spec *spec;
+        uint16_t header = get_be16(&p);
+
+        if (header == 0) {
+            /* Padding. */
+            break;
+        }
+        if ((header & ~(NX_LEARN_N_BITS_MASK | NX_LEARN_SRC_MASK | NX_LEARN_DST_MASK)) != 0 ||
+            (header & NX_LEARN_DST_MASK) == NX_LEARN_DST_RESERVED ||
+            (header & NX_LEARN_N_BITS_MASK) == 0) {
+            OFL_LOG_WARN(LOG_MODULE, "Received NXAST_LEARN action has invalid spec (0x%04"PRIx16").", header);
+            return ofl_error(OFPET_BAD_ACTION, OFPBAC_BAD_ARGUMENT);
+        }
+
+        learn->specs = (struct ofl_exp_nicira_learn_spec *)realloc(learn->specs,
+                           (learn->specs_num + 1) * sizeof(struct ofl_exp_nicira_learn_spec));
+        spec = &learn->specs[learn->specs_num++];
+        memset(spec, 0x00, sizeof(struct ofl_exp_nicira_learn_spec));
+        spec->src    = header & NX_LEARN_SRC_MASK;
+        spec->dst    = header & NX_LEARN_DST_MASK;
+        spec->n_bits = header & NX_LEARN_N_BITS_MASK;
+
+        if (spec->src == NX_LEARN_SRC_FIELD) {
+            if (end - p < (ptrdiff_t)(sizeof(uint32_t) + sizeof(uint16_t))) {
+                OFL_LOG_WARN(LOG_MODULE, "Received NXAST_LEARN action has truncated spec.");
+                return ofl_error(OFPET_BAD_ACTION, OFPBAC_BAD_LEN);
+            }
+            spec->src_field = get_be32(&p);
+            spec->src_ofs   = get_be16(&p);
+        } else {
+            size_t imm_len = NX_LEARN_IMMEDIATE_LEN(spec->n_bits);
+
+            if (end - p < (ptrdiff_t)imm_len) {
+                OFL_LOG_WARN(LOG_MODULE, "Received NXAST_LEARN action has truncated spec.");
+                return ofl_error(OFPET_BAD_ACTION, OFPBAC_BAD_LEN);
+            }
+            spec->src_value = (uint8_t *)memcpy(malloc(imm_len), p, imm_len);
+            p += imm_len;
+        }
+
+        if (spec->dst == NX_LEARN_DST_MATCH || spec->dst == NX_LEARN_DST_LOAD) {
+            if (end - p < (ptrdiff_t)(sizeof(uint32_t) + sizeof(uint16_t))) {
+                OFL_LOG_WARN(LOG_MODULE, "Received NXAST_LEARN action has truncated spec.");
+                return ofl_error(OFPET_BAD_ACTION, OFPBAC_BAD_LEN);
+            }
+            spec->dst_field = get_be32(&p);
+            spec->dst_ofs   = get_be16(&p);
+        }
+    }
+    return 0;
+}
+
+static void
+learn_field_print(FILE *stream, uint32_t field, uint16_t ofs, uint16_t n_bits) {
+    ofl_oxm_type_print(stream, field);
+    if (ofs != 0 || n_bits != oxm_field_bits(field)) {
+        fprintf(stream, "[%u..%u]", ofs, ofs + n_bits - 1);
+    }
+}
+
+static void
+learn_spec_print(FILE *stream, struct ofl_exp_nicira_learn_spec *spec) {
+    switch (spec->dst) {
+        case (NX_LEARN_DST_MATCH): {
+            learn_field_print(stream, spec->dst_field, spec->dst_ofs, spec->n_bits);
+            fprintf(stream, "=");
+            break;
+        }
+        case (NX_LEARN_DST_LOAD): {
+            fprintf(stream, "load:");
+            learn_field_print(stream, spec->dst_field, spec->dst_ofs, spec->n_bits);
+            fprintf(stream, "=");
+            break;
+        }
+        default: {
+            fprintf(stream, "output=");
+            break;
+        }
+    }
+    if (spec->src == NX_LEARN_SRC_FIELD) {
+        learn_field_print(stream, spec->src_field, spec->src_ofs, spec->n_bits);
+    } else {
+        size_t i;
+
+        fprintf(stream, "0x");
+        for (i = 0; i < NX_LEARN_IMMEDIATE_LEN(spec->n_bits); i++) {
+            fprintf(stream, "%02"PRIx8, spec->src_value[i]);
+        }
+    }
+}
+
+int
+ofl_exp_nicira_act_pack(struct ofl_action_header *src, struct ofp_action_header *dst) {
+    struct ofl_action_experimenter *exp = (struct ofl_action_experimenter *)src;
+
+    if (exp->experimenter_id == NX_VENDOR_ID) {
+        struct ofl_exp_nicira_act_header *nx = (struct ofl_exp_nicira_act_header *)exp;
+        switch (nx->subtype) {
+            case (NXAST_LEARN): {
+                struct ofl_exp_nicira_act_learn *l = (struct ofl_exp_nicira_act_learn *)nx;
+                struct nx_action_learn *ofp = (struct nx_action_learn *)dst;
+                size_t len = learn_ofp_len(l);
+                uint8_t *p;
+                size_t i;
+
+                ofp->type             = htons(OFPAT_EXPERIMENTER);
+                ofp->len              = htons(len);
+                ofp->vendor           = htonl(NX_VENDOR_ID);
+                ofp->subtype          = htons(NXAST_LEARN);
+                ofp->idle_timeout     = htons(l->idle_timeout);
+                ofp->hard_timeout     = htons(l->hard_timeout);
+                ofp->priority         = htons(l->priority);
+                ofp->cookie           = hton64(l->cookie);
+                ofp->flags            = htons(l->flags);
+                ofp->table_id         = l->table_id;
+                ofp->pad              = 0;
+                ofp->fin_idle_timeout = htons(l->fin_idle_timeout);
+                ofp->fin_hard_timeout = htons(l->fin_hard_timeout);
+
+                p = (uint8_t *)dst + sizeof(struct nx_action_learn);
+                for (i = 0; i < l->specs_num; i++) {
+                    struct ofl_exp_nicira_learn_spec *spec = &l->specs[i];
+
+                    p = put_be16(p, spec->src | spec->dst | spec->n_bits);
+                    if (spec->src == NX_LEARN_SRC_FIELD) {
+                        p = put_be32(p, spec->src_field);
+                        p = put_be16(p, spec->src_ofs);
+                    } else {
+                        memcpy(p, spec->src_value, NX_LEARN_IMMEDIATE_LEN(spec->n_bits));
+                        p += NX_LEARN_IMMEDIATE_LEN(spec->n_bits);
+                    }
+                    if (spec->dst == NX_LEARN_DST_MATCH || spec->dst == NX_LEARN_DST_LOAD) {
+                        p = put_be32(p, spec->dst_field);
+                        p = put_be16(p, spec->dst_ofs);
+                    }
+                }
+                memset(p, 0x00, (uint8_t *)dst + len - p);
+
+                return len;
+            }
+            default: {
+                OFL_LOG_WARN(LOG_MODULE, "Trying to pack unknown Nicira Experimenter action.");
+                return 0;
+            }
+        }
+    } else {
+        OFL_LOG_WARN(LOG_MODULE, "Trying to pack non-Nicira Experimenter action.");
+        return 0;
+    }
+}
+
+ofl_err
+ofl_exp_nicira_act_unpack(struct ofp_action_header *src, size_t *len, struct ofl_action_header **dst) {
+    struct ofp_action_experimenter_header *exp = (struct ofp_action_experimenter_header *)src;
+    struct nx_action_header *nx;
+
+    if (ntohl(exp->experimenter) != NX_VENDOR_ID) {
+        OFL_LOG_WARN(LOG_MODULE, "Trying to unpack non-Nicira Experimenter action.");
+        return ofl_error(OFPET_BAD_ACTION, OFPBAC_BAD_EXPERIMENTER);
+    }
+    if (*len < sizeof(struct nx_action_header) ||
+        ntohs(src->len) < sizeof(struct nx_action_header)) {
+        OFL_LOG_WARN(LOG_MODULE, "Received Nicira action has invalid length (%zu).", *len);
+        return ofl_error(OFPET_BAD_ACTION, OFPBAC_BAD_LEN);
+    }
+
+    nx = (struct nx_action_header *)src;
+    switch (ntohs(nx->subtype)) {
+        case (NXAST_LEARN): {
+            struct nx_action_learn *sa = (struct nx_action_learn *)src;
+            struct ofl_exp_nicira_act_learn *da;
+            size_t act_len = ntohs(src->len);
+            ofl_err error;
+
+            if (act_len < sizeof(struct nx_action_learn)) {
+                OFL_LOG_WARN(LOG_MODULE, "Received NXAST_LEARN action has invalid length (%zu).", act_len);
+                return ofl_error(OFPET_BAD_ACTION, OFPBAC_BAD_LEN);
+            }
+            if (sa->pad != 0) {
+                OFL_LOG_WARN(LOG_MODULE, "Received NXAST_LEARN action has nonzero padding.");
+                return ofl_error(OFPET_BAD_ACTION, OFPBAC_BAD_ARGUMENT);
+            }
+
+            da = (struct ofl_exp_nicira_act_learn *)malloc(sizeof(struct ofl_exp_nicira_act_learn));
+            da->header.header.experimenter_id = NX_VENDOR_ID;
+            da->header.subtype                = NXAST_LEARN;
+            da->idle_timeout     = ntohs(sa->idle_timeout);
+            da->hard_timeout     = ntohs(sa->hard_timeout);
+            da->priority         = ntohs(sa->priority);
+            da->cookie           = ntoh64(sa->cookie);
+            da->flags            = ntohs(sa->flags);
+            da->table_id         = sa->table_id;
+            da->fin_idle_timeout = ntohs(sa->fin_idle_timeout);
+            da->fin_hard_timeout = ntohs(sa->fin_hard_timeout);
+            da->specs_num        = 0;
+            da->specs            = NULL;
+
+            error = learn_unpack_specs((uint8_t *)src + sizeof(struct nx_action_learn),
+                                       (uint8_t *)src + act_len, da);
+            if (error) {
+                ofl_exp_nicira_act_free((struct ofl_action_header *)da);
+                return error;
+            }
+
+            *len -= act_len;
+            *dst = (struct ofl_action_header *)da;
+            return 0;
+        }
+        default: {
+            OFL_LOG_WARN(LOG_MODULE, "Trying to unpack unknown Nicira Experimenter action (%u).", ntohs(nx->subtype));
+            return ofl_error(OFPET_BAD_ACTION, OFPBAC_BAD_EXP_TYPE);
+        }
+    }
+}
+
+int
+ofl_exp_nicira_act_free(struct ofl_action_header *act) {
+    struct ofl_action_experimenter *exp = (struct ofl_action_experimenter *)act;
+
+    if (exp->experimenter_id == NX_VENDOR_ID) {
+        struct ofl_exp_nicira_act_header *nx = (struct ofl_exp_nicira_act_header *)exp;
+        switch (nx->subtype) {
+            case (NXAST_LEARN): {
+                struct ofl_exp_nicira_act_learn *l = (struct ofl_exp_nicira_act_learn *)nx;
+                size_t i;
+
+                for (i = 0; i < l->specs_num; i++) {
+                    free(l->specs[i].src_value);
+                }
+                free(l->specs);
+                break;
+            }
+            default: {
+                OFL_LOG_WARN(LOG_MODULE, "Trying to free unknown Nicira Experimenter action.");
+            }
+        }
+    } else {
+        OFL_LOG_WARN(LOG_MODULE, "Trying to free non-Nicira Experimenter action.");
+    }
+    free(act);
+    return 0;
+}
+
+size_t
+ofl_exp_nicira_act_ofp_len(struct ofl_action_header *act) {
+    struct ofl_action_experimenter *exp = (struct ofl_action_experimenter *)act;
+
+    if (exp->experimenter_id == NX_VENDOR_ID) {
+        struct ofl_exp_nicira_act_header *nx = (struct ofl_exp_nicira_act_header *)exp;
+        switch (nx->subtype) {
+            case (NXAST_LEARN): {
+                return learn_ofp_len((struct ofl_exp_nicira_act_learn *)nx);
+            }
+            default: {
+                OFL_LOG_WARN(LOG_MODULE, "Trying to get length of unknown Nicira Experimenter action.");
+                return 0;
+            }
+        }
+    } else {
+        OFL_LOG_WARN(LOG_MODULE, "Trying to get length of non-Nicira Experimenter action.");
+        return 0;
+    }
+}
+
+char *
+ofl_exp_nicira_act_to_string(struct ofl_action_header *act) {
+    struct ofl_action_experimenter *exp = (struct ofl_action_experimenter *)act;
+    char *str;
+    size_t str_size;
+    FILE *stream = open_memstream(&str, &str_size);
+
+    if (exp->experimenter_id == NX_VENDOR_ID) {
+        struct ofl_exp_nicira_act_header *nx = (struct ofl_exp_nicira_act_header *)exp;
+        switch (nx->subtype) {
+            case (NXAST_LEARN): {
+                struct ofl_exp_nicira_act_learn *l = (struct ofl_exp_nicira_act_learn *)nx;
+                size_t i;
+
+                fprintf(stream, "{nx=\"learn\", table=\"");
+                ofl_table_print(stream, l->table_id);
+                fprintf(stream, "\", idle=\"%u\", hard=\"%u\", prio=\"%u\", "
+                                "cookie=\"0x%"PRIx64"\", flags=\"0x%"PRIx16"\", ",
+                        l->idle_timeout, l->hard_timeout, l->priority,
+                        l->cookie, l->flags);
+                if (l->fin_idle_timeout != 0 || l->fin_hard_timeout != 0) {
+                    fprintf(stream, "fin_idle=\"%u\", fin_hard=\"%u\", ",
+                            l->fin_idle_timeout, l->fin_hard_timeout);
+                }
+                fprintf(stream, "specs=[");
+                for (i = 0; i < l->specs_num; i++) {
+                    learn_spec_print(stream, &l->specs[i]);
+                    if (i < l->specs_num - 1) { fprintf(stream, ", "); }
+                }
+                fprintf(stream, "]}");
+                break;
+            }
+            default: {
+                OFL_LOG_WARN(LOG_MODULE, "Trying to print unknown Nicira Experimenter action.");
+                fprintf(stream, "{nx=\"%u\"}", nx->subtype);
+            }
+        }
+    } else {
+        OFL_LOG_WARN(LOG_MODULE, "Trying to print non-Nicira Experimenter action.");
+        fprintf(stream, "{id=\"0x%"PRIx32"\"}", exp->experimenter_id);
+    }
+
+    fclose(stream);
+    return str;
+}
+
+
 int
 ofl_exp_nicira_msg_pack(struct ofl_msg_experimenter *msg, uint8_t **buf, size_t *buf_len) {
     if (msg->experimenter_id == NX_VENDOR_ID) {
@@ -33,6 +33,7 @@
 #define OFL_EXP_NICIRA_H 1
 
 
+#include "../oflib/ofl-actions.h"
 #include "../oflib/ofl-structs.h"
 #include "../oflib/ofl-messages.h"
 
@@ -50,6 +51,63 @@ struct ofl_exp_nicira_msg_role {
 };
 
 
+struct ofl_exp_nicira_act_header {
+    struct ofl_action_experimenter   header; /* NX_VENDOR_ID */
+
+    uint16_t   subtype;
+};
+
+/* A flow_mod_spec of NXAST_LEARN. */
+struct ofl_exp_nicira_learn_spec {
+    uint16_t   src;          /* NX_LEARN_SRC_*. */
+    uint16_t   dst;          /* NX_LEARN_DST_*. */
+    uint16_t   n_bits;
+
+    uint32_t   src_field;    /* NX_LEARN_SRC_FIELD: OXM header. */
+    uint16_t   src_ofs;
+    uint8_t   *src_value;    /* NX_LEARN_SRC_IMMEDIATE: the value, in network
+                              * byte order, padded to a multiple of 16 bits. */
+
+    uint32_t   dst_field;    /* NX_LEARN_DST_MATCH|LOAD: OXM header. */
+    uint16_t   dst_ofs;
+};
+
+struct ofl_exp_nicira_act_learn {
+    struct ofl_exp_nicira_act_header   header; /* NXAST_LEARN */
+
+    uint16_t   idle_timeout;
+    uint16_t   hard_timeout;
+    uint16_t   priority;
+    uint64_t   cookie;
+    uint16_t   flags;
+    uint8_t    table_id;
+    uint16_t   fin_idle_timeout;
+    uint16_t   fin_hard_timeout;
+
+    size_t                             specs_num;
+    struct ofl_exp_nicira_learn_spec  *specs;
+};
+
+/* Returns the size of the immediate value of a learn spec copying 'n_bits'
+ * bits. */
+#define NX_LEARN_IMMEDIATE_LEN(N_BITS) (2 * (((N_BITS) + 15) / 16))
+
+
+int
+ofl_exp_nicira_act_pack(struct ofl_action_header *src, struct ofp_action_header *dst);
+
+ofl_err
+ofl_exp_nicira_act_unpack(struct ofp_action_header *src, size_t *len, struct ofl_action_header **dst);
+
+int
+ofl_exp_nicira_act_free(struct ofl_action_header *act);
+
+size_t
+ofl_exp_nicira_act_ofp_len(struct ofl_action_header *act);
+
+char *
+ofl_exp_nicira_act_to_string(struct ofl_action_header *act);
+
 
 int
 ofl_exp_nicira_msg_pack(struct ofl_msg_experimenter *msg, uint8_t **buf, size_t *buf_len);
@@ -33,18 +33,158 @@
 #include <stdio.h>
 #include <string.h>
 #include <netinet/in.h>
+#include <arpa/inet.h>
 #include "openflow/openflow.h"
 #include "openflow/openflow-ext.h"
 #include "ofl-exp-openflow.h"
+#include "../oflib/ofl-actions.h"
 #include "../oflib/ofl-log.h"
 #include "../oflib/ofl-print.h"
+#include "../oflib/ofl-utils.h"
 
 #define LOG_MODULE ofl_exp_of
 OFL_LOG_INIT(LOG_MODULE)
 
+/* Actions in packet_out batches are handled with the experimenter callbacks
+ * 'ofl_exp' the message callbacks are given. */
+
+static size_t
+packet_out_entry_ofp_len(struct ofl_exp_openflow_packet_out_entry *e,
+                         struct ofl_exp *ofl_exp) {
+    return ROUND_UP(sizeof(struct openflow_ext_packet_out_entry) +
+                    ofl_actions_ofp_total_len(e->actions, e->actions_num, ofl_exp) +
+                    e->data_length, 8);
+}
+
+static void
+packet_out_batch_free_entries(struct ofl_exp_openflow_packet_out_entry *entries,
+                              size_t entries_num, bool with_data,
+                              struct ofl_exp *ofl_exp) {
+    size_t i;
+
+    for (i = 0; i < entries_num; i++) {
+        if (i == 0 || entries[i].actions != entries[i - 1].actions) {
+            OFL_UTILS_FREE_ARR_FUN2(entries[i].actions, entries[i].actions_num,
+                                    ofl_actions_free, ofl_exp);
+        }
+        if (with_data) {
+            free(entries[i].data);
+        }
+    }
+    free(entries);
+}
+
+/* Unpacks the entries of a packet_out batch; 'len' is the length of the
+ * entries.  An entry with the same actions as the previous one shares its
+ * action array, so that they are only validated once.  The data of the
+ * entries is copied, unless 'dst->data_in_place' is set. */
+static ofl_err
+packet_out_batch_unpack_entries(uint8_t *src, size_t len,
+                                struct ofl_exp_openflow_msg_packet_out_batch *dst,
+                                struct ofl_exp *ofl_exp) {
+    struct openflow_ext_packet_out_entry *prev = NULL;
+    size_t n = 0;
+    size_t i;
+
+    for (i = 0; i < len; i += ntohs(((struct openflow_ext_packet_out_entry *)(src + i))->len)) {
+        struct openflow_ext_packet_out_entry *e;
+        size_t e_len;
+
+        if (len - i < sizeof(struct openflow_ext_packet_out_entry)) {
+            OFL_LOG_WARN(LOG_MODULE, "Received EXT_PACKET_OUT_BATCH entry has invalid length (%zu).", len - i);
+            return ofl_error(OFPET_BAD_REQUEST, OFPBRC_BAD_LEN);
+        }
+        e = (struct openflow_ext_packet_out_entry *)(src + i);
+        e_len = ntohs(e->len);
+        if (e_len > len - i || e_len % 8 != 0 ||
+            e_len < ROUND_UP(sizeof(struct openflow_ext_packet_out_entry) +
+                             ntohs(e->actions_len) + ntohs(e->data_len), 8)) {
+            OFL_LOG_WARN(LOG_MODULE, "Received EXT_PACKET_OUT_BATCH entry has invalid length (%zu).", e_len);
+            return ofl_error(OFPET_BAD_REQUEST, OFPBRC_BAD_LEN);
+        }
+        if (ntohl(e->buffer_id) != 0xffffffff && e->data_len != 0) {
+            OFL_LOG_WARN(LOG_MODULE, "Received EXT_PACKET_OUT_BATCH entry with data and buffer_id.");
+            return ofl_error(OFPET_BAD_REQUEST, OFPBRC_BAD_LEN);
+        }
+        n++;
+    }
+
+    dst->entries_num = n;
+    dst->entries = (struct ofl_exp_openflow_packet_out_entry *)malloc(n * sizeof(struct ofl_exp_openflow_packet_out_entry));
+
+    for (n = 0; n < dst->entries_num; n++) {
+        struct openflow_ext_packet_out_entry *e = (struct openflow_ext_packet_out_entry *)src;
+        struct ofl_exp_openflow_packet_out_entry *d = &dst->entries[n];
+        size_t actions_len = ntohs(e->actions_len);
+        size_t data_len = ntohs(e->data_len);
+        uint8_t *data = (uint8_t *)e->actions + actions_len;
+
+        d->buffer_id   = ntohl(e->buffer_id);
+        d->in_port     = ntohl(e->in_port);
+        d->data_length = data_len;
+        if (data_len == 0) {
+            d->data = NULL;
+        } else if (dst->data_in_place) {
+            d->data = data;
+        } else {
+            d->data = (uint8_t *)memcpy(malloc(data_len), data, data_len);
+        }
+
+        if (prev != NULL && prev->actions_len == e->actions_len &&
+            memcmp(prev->actions, e->actions, actions_len) == 0) {
+            d->actions_num = dst->entries[n - 1].actions_num;
+            d->actions     = dst->entries[n - 1].actions;
+        } else {
+            struct ofp_action_header *act;
+            ofl_err error;
+
+            error = ofl_utils_count_ofp_actions(e->actions, actions_len, &d->actions_num);
+            if (error) {
+                d->actions_num = 0;
+                d->actions = NULL;
+                packet_out_batch_free_entries(dst->entries, n + 1,
+                                              !dst->data_in_place, ofl_exp);
+                return error;
+            }
+            d->actions = (struct ofl_action_header **)malloc(d->actions_num * sizeof(struct ofl_action_header *));
+
+            act = e->actions;
+            for (i = 0; i < d->actions_num; i++) {
+                error = ofl_actions_unpack(act, &actions_len, &(d->actions[i]), ofl_exp);
+                if (error) {
+                    d->actions_num = i;
+                    packet_out_batch_free_entries(dst->entries, n + 1,
+                                                  !dst->data_in_place, ofl_exp);
+                    return error;
+                }
+                act = (struct ofp_action_header *)((uint8_t *)act + ntohs(act->len));
+            }
+        }
+        prev = e;
+        src += ntohs(e->len);
+    }
+    return 0;
+}
+
+static void
+responder_entry_print(FILE *stream, struct ofl_exp_openflow_responder_entry *e) {
+    char addr_str[INET6_ADDRSTRLEN];
+
+    fprintf(stream, "{vlan=\"");
+    if (e->vlan_vid == OFPVID_NONE) {
+        fprintf(stream, "none");
+    } else {
+        fprintf(stream, "%u", e->vlan_vid & ~OFPVID_PRESENT);
+    }
+    inet_ntop(AF_INET6, e->ip_addr, addr_str, INET6_ADDRSTRLEN);
+    fprintf(stream, "\", ip=\"%s\", eth=\"%02"PRIx8":%02"PRIx8":%02"PRIx8":%02"PRIx8":%02"PRIx8":%02"PRIx8"\"}",
+            addr_str, e->eth_addr[0], e->eth_addr[1], e->eth_addr[2],
+            e->eth_addr[3], e->eth_addr[4], e->eth_addr[5]);
+}
+
 
 int
-ofl_exp_openflow_msg_pack(struct ofl_msg_experimenter *msg, uint8_t **buf, size_t *buf_len) {
+ofl_exp_openflow_msg_pack(struct ofl_msg_experimenter *msg, uint8_t **buf, size_t *buf_len, struct ofl_exp *ofl_exp) {
     if (msg->experimenter_id == OPENFLOW_VENDOR_ID) {
         struct ofl_exp_openflow_msg_header *exp = (struct ofl_exp_openflow_msg_header *)msg;
         switch (exp->type) {
@@ -78,6 +218,121 @@ ofl_exp_openflow_msg_pack(struct ofl_msg_experimenter *msg, uint8_t **buf, size_
 
                 return 0;
             }
+            case (OFP_EXT_RX_STATS_REQUEST): {
+                struct ofl_exp_openflow_msg_rx_stats_request *r = (struct ofl_exp_openflow_msg_rx_stats_request *)exp;
+                struct openflow_ext_rx_stats_request *ofp;
+
+                *buf_len  = sizeof(struct openflow_ext_rx_stats_request);
+                *buf     = (uint8_t *)malloc(*buf_len);
+
+                ofp = (struct openflow_ext_rx_stats_request *)(*buf);
+                ofp->header.vendor  = htonl(exp->header.experimenter_id);
+                ofp->header.subtype = htonl(exp->type);
+                ofp->port_no = htonl(r->port_no);
+                memset(ofp->pad, 0x00, sizeof(ofp->pad));
+
+                return 0;
+            }
+            case (OFP_EXT_RX_STATS_REPLY): {
+                struct ofl_exp_openflow_msg_rx_stats_reply *r = (struct ofl_exp_openflow_msg_rx_stats_reply *)exp;
+                struct openflow_ext_rx_stats_reply *ofp;
+                size_t i;
+
+                *buf_len  = sizeof(struct openflow_ext_rx_stats_reply) +
+                            r->stats_num * sizeof(struct openflow_ext_port_rx_stats);
+                *buf     = (uint8_t *)malloc(*buf_len);
+
+                ofp = (struct openflow_ext_rx_stats_reply *)(*buf);
+                ofp->header.vendor  = htonl(exp->header.experimenter_id);
+                ofp->header.subtype = htonl(exp->type);
+                ofp->polls      = hton64(r->polls);
+                ofp->busy_polls = hton64(r->busy_polls);
+                ofp->pktmem_buffers   = hton64(r->pktmem_buffers);
+                ofp->pktmem_free      = hton64(r->pktmem_free);
+                ofp->pktmem_exhausted = hton64(r->pktmem_exhausted);
+                ofp->pktmem_oversize  = hton64(r->pktmem_oversize);
+                ofp->pin_suppressed   = hton64(r->pin_suppressed);
+                ofp->pin_released     = hton64(r->pin_released);
+                ofp->pin_dropped      = hton64(r->pin_dropped);
+                ofp->conn_dropped     = hton64(r->conn_dropped);
+                ofp->aux_dropped      = hton64(r->aux_dropped);
+                ofp->aux_failover     = hton64(r->aux_failover);
+                ofp->hw_dropped       = hton64(r->hw_dropped);
+                for (i = 0; i < r->stats_num; i++) {
+                    ofp->ports[i].port_no      = htonl(r->stats[i].port_no);
+                    memset(ofp->ports[i].pad, 0x00, sizeof(ofp->ports[i].pad));
+                    ofp->ports[i].kernel_drops = hton64(r->stats[i].kernel_drops);
+                    ofp->ports[i].full_bursts  = hton64(r->stats[i].full_bursts);
+                }
+
+                return 0;
+            }
+            case (OFP_EXT_PACKET_OUT_BATCH): {
+                struct ofl_exp_openflow_msg_packet_out_batch *b = (struct ofl_exp_openflow_msg_packet_out_batch *)exp;
+                struct openflow_ext_packet_out_batch *ofp;
+                uint8_t *ptr;
+                size_t i, j;
+
+                *buf_len = sizeof(struct openflow_ext_packet_out_batch);
+                for (i = 0; i < b->entries_num; i++) {
+                    *buf_len += packet_out_entry_ofp_len(&b->entries[i], ofl_exp);
+                }
+                *buf     = (uint8_t *)malloc(*buf_len);
+
+                ofp = (struct openflow_ext_packet_out_batch *)(*buf);
+                ofp->header.vendor  = htonl(exp->header.experimenter_id);
+                ofp->header.subtype = htonl(exp->type);
+
+                ptr = ofp->entries;
+                for (i = 0; i < b->entries_num; i++) {
+                    struct ofl_exp_openflow_packet_out_entry *e = &b->entries[i];
+                    struct openflow_ext_packet_out_entry *ofe = (struct openflow_ext_packet_out_entry *)ptr;
+                    size_t e_len = packet_out_entry_ofp_len(e, ofl_exp);
+                    uint8_t *p;
+
+                    ofe->len         = htons(e_len);
+                    ofe->actions_len = htons(ofl_actions_ofp_total_len(e->actions, e->actions_num, ofl_exp));
+                    ofe->data_len    = htons(e->data_length);
+                    memset(ofe->pad, 0x00, sizeof(ofe->pad));
+                    ofe->buffer_id   = htonl(e->buffer_id);
+                    ofe->in_port     = htonl(e->in_port);
+
+                    p = (uint8_t *)ofe->actions;
+                    for (j = 0; j < e->actions_num; j++) {
+                        p += ofl_actions_pack(e->actions[j], (struct ofp_action_header *)p, *buf, ofl_exp);
+                    }
+                    if (e->data_length > 0) {
+                        memcpy(p, e->data, e->data_length);
+                        p += e->data_length;
+                    }
+                    memset(p, 0x00, ptr + e_len - p);
+                    ptr += e_len;
+                }
+
+                return 0;
+            }
+            case (OFP_EXT_RESPONDER_MOD): {
+                struct ofl_exp_openflow_msg_responder_mod *r = (struct ofl_exp_openflow_msg_responder_mod *)exp;
+                struct openflow_ext_responder_mod *ofp;
+                size_t i;
+
+                *buf_len  = sizeof(struct openflow_ext_responder_mod) +
+                            r->entries_num * sizeof(struct openflow_ext_responder_entry);
+                *buf     = (uint8_t *)malloc(*buf_len);
+
+                ofp = (struct openflow_ext_responder_mod *)(*buf);
+                ofp->header.vendor  = htonl(exp->header.experimenter_id);
+                ofp->header.subtype = htonl(exp->type);
+                ofp->command = htons(r->command);
+                memset(ofp->pad, 0x00, sizeof(ofp->pad));
+                for (i = 0; i < r->entries_num; i++) {
+                    ofp->entries[i].vlan_vid = htons(r->entries[i].vlan_vid);
+                    memcpy(ofp->entries[i].eth_addr, r->entries[i].eth_addr, OFP_ETH_ALEN);
+                    memcpy(ofp->entries[i].ip_addr, r->entries[i].ip_addr, 16);
+                }
+
+                return 0;
+            }
             default: {
                 OFL_LOG_WARN(LOG_MODULE, "Trying to print unknown Openflow Experimenter message.");
                 return -1;
@@ -89,8 +344,8 @@ ofl_exp_openflow_msg_pack(struct ofl_msg_experimenter *msg, uint8_t **buf, size_
     }
 }
 
-ofl_err
-ofl_exp_openflow_msg_unpack(struct ofp_header *oh, size_t *len, struct ofl_msg_experimenter **msg) {
+static ofl_err
+ofl_exp_openflow_msg_unpack__(struct ofp_header *oh, size_t *len, struct ofl_msg_experimenter **msg, struct ofl_exp *ofl_exp, bool in_place) {
     struct ofp_extension_header *exp;
 
     if (*len < sizeof(struct ofp_extension_header)) {
@@ -152,6 +407,144 @@ ofl_exp_openflow_msg_unpack(struct ofp_header *oh, size_t *len, struct ofl_msg_e
                 (*msg) = (struct ofl_msg_experimenter *)dst;
                 return 0;
             }
+            case (OFP_EXT_RX_STATS_REQUEST): {
+                struct openflow_ext_rx_stats_request *src;
+                struct ofl_exp_openflow_msg_rx_stats_request *dst;
+
+                if (*len < sizeof(struct openflow_ext_rx_stats_request)) {
+                    OFL_LOG_WARN(LOG_MODULE, "Received EXT_RX_STATS_REQUEST message has invalid length (%zu).", *len);
+                    return ofl_error(OFPET_BAD_REQUEST, OFPBRC_BAD_LEN);
+                }
+                *len -= sizeof(struct openflow_ext_rx_stats_request);
+
+                src = (struct openflow_ext_rx_stats_request *)exp;
+
+                dst = (struct ofl_exp_openflow_msg_rx_stats_request *)malloc(sizeof(struct ofl_exp_openflow_msg_rx_stats_request));
+                dst->header.header.experimenter_id = ntohl(exp->vendor);
+                dst->header.type                   = ntohl(exp->subtype);
+                dst->port_no                       = ntohl(src->port_no);
+
+                (*msg) = (struct ofl_msg_experimenter *)dst;
+                return 0;
+            }
+            case (OFP_EXT_RX_STATS_REPLY): {
+                struct openflow_ext_rx_stats_reply *src;
+                struct ofl_exp_openflow_msg_rx_stats_reply *dst;
+                size_t i;
+
+                if (*len < sizeof(struct openflow_ext_rx_stats_reply) ||
+                    (*len - sizeof(struct openflow_ext_rx_stats_reply))
+                                % sizeof(struct openflow_ext_port_rx_stats) != 0) {
+                    OFL_LOG_WARN(LOG_MODULE, "Received EXT_RX_STATS_REPLY message has invalid length (%zu).", *len);
+                    return ofl_error(OFPET_BAD_REQUEST, OFPBRC_BAD_LEN);
+                }
+                *len -= sizeof(struct openflow_ext_rx_stats_reply);
+
+                src = (struct openflow_ext_rx_stats_reply *)exp;
+
+                dst = (struct ofl_exp_openflow_msg_rx_stats_reply *)malloc(sizeof(struct ofl_exp_openflow_msg_rx_stats_reply));
+                dst->header.header.experimenter_id = ntohl(exp->vendor);
+                dst->header.type                   = ntohl(exp->subtype);
+                dst->polls                         = ntoh64(src->polls);
+                dst->busy_polls                    = ntoh64(src->busy_polls);
+                dst->pktmem_buffers                = ntoh64(src->pktmem_buffers);
+                dst->pktmem_free                   = ntoh64(src->pktmem_free);
+                dst->pktmem_exhausted              = ntoh64(src->pktmem_exhausted);
+                dst->pktmem_oversize               = ntoh64(src->pktmem_oversize);
+                dst->pin_suppressed                = ntoh64(src->pin_suppressed);
+                dst->pin_released                  = ntoh64(src->pin_released);
+                dst->pin_dropped                   = ntoh64(src->pin_dropped);
+                dst->conn_dropped                  = ntoh64(src->conn_dropped);
+                dst->aux_dropped                   = ntoh64(src->aux_dropped);
+                dst->aux_failover                  = ntoh64(src->aux_failover);
+                dst->hw_dropped                    = ntoh64(src->hw_dropped);
+                dst->stats_num = *len / sizeof(struct openflow_ext_port_rx_stats);
+                dst->stats = (struct ofl_exp_openflow_port_rx_stats *)malloc(dst->stats_num * sizeof(struct ofl_exp_openflow_port_rx_stats));
+                for (i = 0; i < dst->stats_num; i++) {
+                    dst->stats[i].port_no      = ntohl(src->ports[i].port_no);
+                    dst->stats[i].kernel_drops = ntoh64(src->ports[i].kernel_drops);
+                    dst->stats[i].full_bursts  = ntoh64(src->ports[i].full_bursts);
+                }
+                *len = 0;
+
+                (*msg) = (struct ofl_msg_experimenter *)dst;
+                return 0;
+            }
+            case (OFP_EXT_PACKET_OUT_BATCH): {
+                struct openflow_ext_packet_out_batch *src;
+                struct ofl_exp_openflow_msg_packet_out_batch *dst;
+                ofl_err error;
+
+                if (*len < sizeof(struct openflow_ext_packet_out_batch)) {
+                    OFL_LOG_WARN(LOG_MODULE, "Received EXT_PACKET_OUT_BATCH message has invalid length (%zu).", *len);
+                    return ofl_error(OFPET_BAD_REQUEST, OFPBRC_BAD_LEN);
+                }
+                *len -= sizeof(struct openflow_ext_packet_out_batch);
+
+                src = (struct openflow_ext_packet_out_batch *)exp;
+
+                dst = (struct ofl_exp_openflow_msg_packet_out_batch *)malloc(sizeof(struct ofl_exp_openflow_msg_packet_out_batch));
+                dst->header.header.experimenter_id = ntohl(exp->vendor);
+                dst->header.type                   = ntohl(exp->subtype);
+                dst->data_in_place                 = in_place;
+
+                error = packet_out_batch_unpack_entries(src->entries, *len, dst, ofl_exp);
+                if (error) {
+                    free(dst);
+                    return error;
+                }
+                *len = 0;
+
+                (*msg) = (struct ofl_msg_experimenter *)dst;
+                return 0;
+            }
+            case (OFP_EXT_RESPONDER_MOD): {
+                struct openflow_ext_responder_mod *src;
+                struct ofl_exp_openflow_msg_responder_mod *dst;
+                size_t i;
+
+                if (*len < sizeof(struct openflow_ext_responder_mod) ||
+                    (*len - sizeof(struct openflow_ext_responder_mod))
+                                % sizeof(struct openflow_ext_responder_entry) != 0) {
+                    OFL_LOG_WARN(LOG_MODULE, "Received EXT_RESPONDER_MOD message has invalid length (%zu).", *len);
+                    return ofl_error(OFPET_BAD_REQUEST, OFPBRC_BAD_LEN);
+                }
+                *len -= sizeof(struct openflow_ext_responder_mod);
+
+                src = (struct openflow_ext_responder_mod *)exp;
+
+                if (ntohs(src->command) > OFP_EXT_RESPONDER_REPLACE) {
+                    OFL_LOG_WARN(LOG_MODULE, "Received EXT_RESPONDER_MOD message has invalid command (%u).", ntohs(src->command));
+                    return ofl_error(OFPET_BAD_REQUEST, OFPBRC_BAD_EXP_TYPE);
+                }
+
+                /* An entry is for untagged packets, or for the VLAN id
+                 * after OFPVID_PRESENT, which must be a 12-bit id. */
+                for (i = 0; i < *len / sizeof(struct openflow_ext_responder_entry); i++) {
+                    uint16_t vid = ntohs(src->entries[i].vlan_vid);
+
+                    if (vid != OFPVID_NONE && (vid & ~VLAN_VID_MASK) != OFPVID_PRESENT) {
+                        OFL_LOG_WARN(LOG_MODULE, "Received EXT_RESPONDER_MOD entry has invalid vlan_vid (0x%04"PRIx16").", vid);
+                        return ofl_error(OFPET_BAD_REQUEST, OFPBRC_EPERM);
+                    }
+                }
+
+                dst = (struct ofl_exp_openflow_msg_responder_mod *)malloc(sizeof(struct ofl_exp_openflow_msg_responder_mod));
+                dst->header.header.experimenter_id = ntohl(exp->vendor);
+                dst->header.type                   = ntohl(exp->subtype);
+                dst->command                       = ntohs(src->command);
+                dst->entries_num = *len / sizeof(struct openflow_ext_responder_entry);
+                dst->entries = (struct ofl_exp_openflow_responder_entry *)malloc(dst->entries_num * sizeof(struct ofl_exp_openflow_responder_entry));
+                for (i = 0; i < dst->entries_num; i++) {
+                    dst->entries[i].vlan_vid = ntohs(src->entries[i].vlan_vid);
+                    memcpy(dst->entries[i].eth_addr, src->entries[i].eth_addr, OFP_ETH_ALEN);
+                    memcpy(dst->entries[i].ip_addr, src->entries[i].ip_addr, 16);
+                }
+                *len = 0;
+
+                (*msg) = (struct ofl_msg_experimenter *)dst;
+                return 0;
+            }
             default: {
                 OFL_LOG_WARN(LOG_MODULE, "Trying to unpack unknown Openflow Experimenter message.");
                 return ofl_error(OFPET_BAD_REQUEST, OFPBRC_BAD_EXPERIMENTER);
@@ -165,8 +558,18 @@ ofl_exp_openflow_msg_unpack(struct ofp_header *oh, size_t *len, struct ofl_msg_e
     return 0;
 }
 
+ofl_err
+ofl_exp_openflow_msg_unpack(struct ofp_header *oh, size_t *len, struct ofl_msg_experimenter **msg, struct ofl_exp *ofl_exp) {
+    return ofl_exp_openflow_msg_unpack__(oh, len, msg, ofl_exp, false);
+}
+
+ofl_err
+ofl_exp_openflow_msg_unpack_in_place(struct ofp_header *oh, size_t *len, struct ofl_msg_experimenter **msg, struct ofl_exp *ofl_exp) {
+    return ofl_exp_openflow_msg_unpack__(oh, len, msg, ofl_exp, true);
+}
+
 int
-ofl_exp_openflow_msg_free(struct ofl_msg_experimenter *msg) {
+ofl_exp_openflow_msg_free(struct ofl_msg_experimenter *msg, struct ofl_exp *ofl_exp) {
     if (msg->experimenter_id == OPENFLOW_VENDOR_ID) {
         struct ofl_exp_openflow_msg_header *exp = (struct ofl_exp_openflow_msg_header *)msg;
         switch (exp->type) {
@@ -181,6 +584,25 @@ ofl_exp_openflow_msg_free(struct ofl_msg_experimenter *msg) {
                 free(s->dp_desc);
                 break;
             }
+            case (OFP_EXT_RX_STATS_REQUEST): {
+                break;
+            }
+            case (OFP_EXT_RX_STATS_REPLY): {
+                struct ofl_exp_openflow_msg_rx_stats_reply *r = (struct ofl_exp_openflow_msg_rx_stats_reply *)exp;
+                free(r->stats);
+                break;
+            }
+            case (OFP_EXT_PACKET_OUT_BATCH): {
+                struct ofl_exp_openflow_msg_packet_out_batch *b = (struct ofl_exp_openflow_msg_packet_out_batch *)exp;
+                packet_out_batch_free_entries(b->entries, b->entries_num,
+                                              !b->data_in_place, ofl_exp);
+                break;
+            }
+            case (OFP_EXT_RESPONDER_MOD): {
+                struct ofl_exp_openflow_msg_responder_mod *r = (struct ofl_exp_openflow_msg_responder_mod *)exp;
+                free(r->entries);
+                break;
+            }
             default: {
                 OFL_LOG_WARN(LOG_MODULE, "Trying to free unknown Openflow Experimenter message.");
             }
@@ -193,7 +615,7 @@ ofl_exp_openflow_msg_free(struct ofl_msg_experimenter *msg) {
 }
 
 char *
-ofl_exp_openflow_msg_to_string(struct ofl_msg_experimenter *msg) {
+ofl_exp_openflow_msg_to_string(struct ofl_msg_experimenter *msg, struct ofl_exp *ofl_exp) {
     char *str;
     size_t str_size;
     FILE *stream = open_memstream(&str, &str_size);
@@ -216,6 +638,82 @@ ofl_exp_openflow_msg_to_string(struct ofl_msg_experimenter *msg) {
                 fprintf(stream, "setdesc{desc=\"%s\"}", s->dp_desc);
                 break;
             }
+            case (OFP_EXT_RX_STATS_REQUEST): {
+                struct ofl_exp_openflow_msg_rx_stats_request *r = (struct ofl_exp_openflow_msg_rx_stats_request *)exp;
+                fprintf(stream, "rxstats-req{port=\"");
+                ofl_port_print(stream, r->port_no);
+                fprintf(stream, "\"}");
+                break;
+            }
+            case (OFP_EXT_RX_STATS_REPLY): {
+                struct ofl_exp_openflow_msg_rx_stats_reply *r = (struct ofl_exp_openflow_msg_rx_stats_reply *)exp;
+                size_t i;
+
+                fprintf(stream, "rxstats-repl{polls=\"%"PRIu64"\", busy_polls=\"%"PRIu64"\", ",
+                        r->polls, r->busy_polls);
+                if (r->pktmem_buffers != 0) {
+                    fprintf(stream, "pktmem={buffers=\"%"PRIu64"\", free=\"%"PRIu64"\", "
+                                    "exhausted=\"%"PRIu64"\", oversize=\"%"PRIu64"\"}, ",
+                            r->pktmem_buffers, r->pktmem_free,
+                            r->pktmem_exhausted, r->pktmem_oversize);
+                }
+                fprintf(stream, "pin={suppressed=\"%"PRIu64"\", released=\"%"PRIu64"\", "
+                                "dropped=\"%"PRIu64"\"}, ",
+                        r->pin_suppressed, r->pin_released, r->pin_dropped);
+                fprintf(stream, "conn={dropped=\"%"PRIu64"\", aux_dropped=\"%"PRIu64"\", "
+                                "aux_failover=\"%"PRIu64"\"}, ",
+                        r->conn_dropped, r->aux_dropped, r->aux_failover);
+                if (r->hw_dropped != 0) {
+                    fprintf(stream, "hw={dropped=\"%"PRIu64"\"}, ", r->hw_dropped);
+                }
+                fprintf(stream, "stats=[");
+                for (i = 0; i < r->stats_num; i++) {
+                    fprintf(stream, "{port=\"");
+                    ofl_port_print(stream, r->stats[i].port_no);
+                    fprintf(stream, "\", kernel_drops=\"%"PRIu64"\", full_bursts=\"%"PRIu64"\"}",
+                            r->stats[i].kernel_drops, r->stats[i].full_bursts);
+                    if (i < r->stats_num - 1) { fprintf(stream, ", "); };
+                }
+                fprintf(stream, "]}");
+                break;
+            }
+            case (OFP_EXT_PACKET_OUT_BATCH): {
+                struct ofl_exp_openflow_msg_packet_out_batch *b = (struct ofl_exp_openflow_msg_packet_out_batch *)exp;
+                size_t i, j;
+
+                fprintf(stream, "pktout-batch{entries=[");
+                for (i = 0; i < b->entries_num; i++) {
+                    struct ofl_exp_openflow_packet_out_entry *e = &b->entries[i];
+
+                    fprintf(stream, "{buffer=\"");
+                    ofl_buffer_print(stream, e->buffer_id);
+                    fprintf(stream, "\", port=\"");
+                    ofl_port_print(stream, e->in_port);
+                    fprintf(stream, "\", actions=[");
+                    for (j = 0; j < e->actions_num; j++) {
+                        ofl_action_print(stream, e->actions[j], ofl_exp);
+                        if (j < e->actions_num - 1) { fprintf(stream, ", "); }
+                    }
+                    fprintf(stream, "], data_len=\"%zu\"}", e->data_length);
+                    if (i < b->entries_num - 1) { fprintf(stream, ", "); };
+                }
+                fprintf(stream, "]}");
+                break;
+            }
+            case (OFP_EXT_RESPONDER_MOD): {
+                struct ofl_exp_openflow_msg_responder_mod *r = (struct ofl_exp_openflow_msg_responder_mod *)exp;
+                size_t i;
+
+                fprintf(stream, "respondermod{cmd=\"%s\", entries=[",
+                        r->command == OFP_EXT_RESPONDER_ADD    ? "add" :
+                        r->command == OFP_EXT_RESPONDER_DELETE ? "del" : "replace");
+                for (i = 0; i < r->entries_num; i++) {
+                    responder_entry_print(stream, &r->entries[i]);
+                    if (i < r->entries_num - 1) { fprintf(stream, ", "); };
+                }
+                fprintf(stream, "]}");
+                break;
+            }
             default: {
                 OFL_LOG_WARN(LOG_MODULE, "Trying to print unknown Openflow Experimenter message.");
                 fprintf(stream, "ofexp{type=\"%u\"}", exp->type);
@@ -229,3 +727,141 @@ ofl_exp_openflow_msg_to_string(struct ofl_msg_experimenter *msg) {
     fclose(stream);
     return str;
 }
+
+int
+ofl_exp_openflow_act_pack(struct ofl_action_header *src, struct ofp_action_header *dst) {
+    struct ofl_action_experimenter *exp = (struct ofl_action_experimenter *)src;
+
+    if (exp->experimenter_id == OPENFLOW_VENDOR_ID) {
+        struct ofl_exp_openflow_act_header *ext = (struct ofl_exp_openflow_act_header *)exp;
+        switch (ext->subtype) {
+            case (OFP_EXT_ACT_RESPOND): {
+                struct ofl_exp_openflow_act_respond *r = (struct ofl_exp_openflow_act_respond *)ext;
+                struct openflow_ext_action_respond *ofp = (struct openflow_ext_action_respond *)dst;
+
+                ofp->type      = htons(OFPAT_EXPERIMENTER);
+                ofp->len       = htons(sizeof(struct openflow_ext_action_respond));
+                ofp->vendor    = htonl(OPENFLOW_VENDOR_ID);
+                ofp->subtype   = htons(OFP_EXT_ACT_RESPOND);
+                ofp->max_len   = htons(r->max_len);
+                ofp->miss_port = htonl(r->miss_port);
+
+                return sizeof(struct openflow_ext_action_respond);
+            }
+            default: {
+                OFL_LOG_WARN(LOG_MODULE, "Trying to pack unknown Openflow Experimenter action.");
+                return 0;
+            }
+        }
+    } else {
+        OFL_LOG_WARN(LOG_MODULE, "Trying to pack non-Openflow Experimenter action.");
+        return 0;
+    }
+}
+
+ofl_err
+ofl_exp_openflow_act_unpack(struct ofp_action_header *src, size_t *len, struct ofl_action_header **dst) {
+    struct ofp_action_experimenter_header *exp = (struct ofp_action_experimenter_header *)src;
+    uint16_t subtype;
+
+    if (ntohl(exp->experimenter) != OPENFLOW_VENDOR_ID) {
+        OFL_LOG_WARN(LOG_MODULE, "Trying to unpack non-Openflow Experimenter action.");
+        return ofl_error(OFPET_BAD_ACTION, OFPBAC_BAD_EXPERIMENTER);
+    }
+    if (*len < sizeof(struct ofp_action_experimenter_header) + sizeof(uint16_t) ||
+        ntohs(src->len) < sizeof(struct ofp_action_experimenter_header) + sizeof(uint16_t)) {
+        OFL_LOG_WARN(LOG_MODULE, "Received Openflow action has invalid length (%zu).", *len);
+        return ofl_error(OFPET_BAD_ACTION, OFPBAC_BAD_LEN);
+    }
+
+    subtype = ntohs(*(uint16_t *)((uint8_t *)src + sizeof(struct ofp_action_experimenter_header)));
+    switch (subtype) {
+        case (OFP_EXT_ACT_RESPOND): {
+            struct openflow_ext_action_respond *sa = (struct openflow_ext_action_respond *)src;
+            struct ofl_exp_openflow_act_respond *da;
+
+            if (*len < sizeof(struct openflow_ext_action_respond) ||
+                ntohs(src->len) != sizeof(struct openflow_ext_action_respond)) {
+                OFL_LOG_WARN(LOG_MODULE, "Received EXT_ACT_RESPOND action has invalid length (%u).", ntohs(src->len));
+                return ofl_error(OFPET_BAD_ACTION, OFPBAC_BAD_LEN);
+            }
+
+            da = (struct ofl_exp_openflow_act_respond *)malloc(sizeof(struct ofl_exp_openflow_act_respond));
+            da->header.header.experimenter_id = OPENFLOW_VENDOR_ID;
+            da->header.subtype                = OFP_EXT_ACT_RESPOND;
+            da->max_len                       = ntohs(sa->max_len);
+            da->miss_port                     = ntohl(sa->miss_port);
+
+            *len -= sizeof(struct openflow_ext_action_respond);
+            *dst = (struct ofl_action_header *)da;
+            return 0;
+        }
+        default: {
+            OFL_LOG_WARN(LOG_MODULE, "Trying to unpack unknown Openflow Experimenter action (%u).", subtype);
+            return ofl_error(OFPET_BAD_ACTION, OFPBAC_BAD_EXP_TYPE);
+        }
+    }
+}
+
+int
+ofl_exp_openflow_act_free(struct ofl_action_header *act) {
+    free(act);
+    return 0;
+}
+
+size_t
+ofl_exp_openflow_act_ofp_len(struct ofl_action_header *act) {
+    struct ofl_action_experimenter *exp = (struct ofl_action_experimenter *)act;
+
+    if (exp->experimenter_id == OPENFLOW_VENDOR_ID) {
+        struct ofl_exp_openflow_act_header *ext = (struct ofl_exp_openflow_act_header *)exp;
+        switch (ext->subtype) {
+            case (OFP_EXT_ACT_RESPOND): {
+                return sizeof(struct openflow_ext_action_respond);
+            }
+            default: {
+                OFL_LOG_WARN(LOG_MODULE, "Trying to get length of unknown Openflow Experimenter action.");
+                return 0;
+            }
+        }
+    } else {
+        OFL_LOG_WARN(LOG_MODULE, "Trying to get length of non-Openflow Experimenter action.");
+        return 0;
+    }
+}
+
+char *
+ofl_exp_openflow_act_to_string(struct ofl_action_header *act) {
+    struct ofl_action_experimenter *exp = (struct ofl_action_experimenter *)act;
+    char *str;
+    size_t str_size;
+    FILE *stream = open_memstream(&str, &str_size);
+
+    if (exp->experimenter_id == OPENFLOW_VENDOR_ID) {
+        struct ofl_exp_openflow_act_header *ext = (struct ofl_exp_openflow_act_header *)exp;
+        switch (ext->subtype) {
+            case (OFP_EXT_ACT_RESPOND): {
+                struct ofl_exp_openflow_act_respond *r = (struct ofl_exp_openflow_act_respond *)ext;
+
+                fprintf(stream, "{ext=\"respond\", miss=\"");
+                ofl_port_print(stream, r->miss_port);
+                if (r->miss_port == OFPP_CONTROLLER) {
+                    fprintf(stream, "\", mlen=\"%u\"}", r->max_len);
+                } else {
+                    fprintf(stream, "\"}");
+                }
+                break;
+            }
+            default: {
+                OFL_LOG_WARN(LOG_MODULE, "Trying to print unknown Openflow Experimenter action.");
+                fprintf(stream, "{ext=\"%u\"}", ext->subtype);
+            }
+        }
+    } else {
+        OFL_LOG_WARN(LOG_MODULE, "Trying to print non-Openflow Experimenter action.");
+        fprintf(stream, "{id=\"0x%"PRIx32"\"}", exp->experimenter_id);
+    }
+
+    fclose(stream);
+    return str;
+}
@@ -35,6 +35,7 @@
 
 #include "../oflib/ofl-structs.h"
 #include "../oflib/ofl-messages.h"
+#include "../oflib/ofl-actions.h"
 
 
 struct ofl_exp_openflow_msg_header {
@@ -58,18 +59,122 @@ struct ofl_exp_openflow_msg_set_dp_desc {
 };
 
 
+struct ofl_exp_openflow_msg_rx_stats_request {
+    struct ofl_exp_openflow_msg_header   header; /* OFP_EXT_RX_STATS_REQUEST */
+
+    uint32_t  port_no;
+};
+
+struct ofl_exp_openflow_port_rx_stats {
+    uint32_t  port_no;
+    uint64_t  kernel_drops;
+    uint64_t  full_bursts;
+};
+
+struct ofl_exp_openflow_msg_rx_stats_reply {
+    struct ofl_exp_openflow_msg_header   header; /* OFP_EXT_RX_STATS_REPLY */
+
+    uint64_t                                polls;
+    uint64_t                                busy_polls;
+    uint64_t                                pktmem_buffers;
+    uint64_t                                pktmem_free;
+    uint64_t                                pktmem_exhausted;
+    uint64_t                                pktmem_oversize;
+    uint64_t                                pin_suppressed;
+    uint64_t                                pin_released;
+    uint64_t                                pin_dropped;
+    uint64_t                                conn_dropped;
+    uint64_t                                aux_dropped;
+    uint64_t                                aux_failover;
+    uint64_t                                hw_dropped;
+    size_t                                  stats_num;
+    struct ofl_exp_openflow_port_rx_stats  *stats;
+};
+
+struct ofl_exp_openflow_packet_out_entry {
+    uint32_t                    buffer_id;
+    uint32_t                    in_port;
+    /* Entries with the same actions as the previous entry share its
+     * array. */
+    size_t                      actions_num;
+    struct ofl_action_header  **actions;
+    size_t                      data_length;
+    uint8_t                    *data;
+};
+
+struct ofl_exp_openflow_msg_packet_out_batch {
+    struct ofl_exp_openflow_msg_header   header; /* OFP_EXT_PACKET_OUT_BATCH */
+
+    size_t                                    entries_num;
+    struct ofl_exp_openflow_packet_out_entry *entries;
+    bool                                      data_in_place; /* If true, the
+                                         data of the entries points into the
+                                         buffer the message was unpacked
+                                         from and is not freed with the
+                                         message. */
+};
+
+struct ofl_exp_openflow_responder_entry {
+    uint16_t   vlan_vid;
+    uint8_t    eth_addr[OFP_ETH_ALEN];
+    uint8_t    ip_addr[16];
+};
+
+struct ofl_exp_openflow_msg_responder_mod {
+    struct ofl_exp_openflow_msg_header   header; /* OFP_EXT_RESPONDER_MOD */
+
+    uint16_t                                  command;
+    size_t                                    entries_num;
+    struct ofl_exp_openflow_responder_entry  *entries;
+};
+
+
+struct ofl_exp_openflow_act_header {
+    struct ofl_action_experimenter   header; /* OPENFLOW_VENDOR_ID */
+
+    uint16_t   subtype;
+};
+
+struct ofl_exp_openflow_act_respond {
+    struct ofl_exp_openflow_act_header   header; /* OFP_EXT_ACT_RESPOND */
+
+    uint16_t   max_len;
+    uint32_t   miss_port;
+};
+
+
+int
+ofl_exp_openflow_msg_pack(struct ofl_msg_experimenter *msg, uint8_t **buf, size_t *buf_len, struct ofl_exp *ofl_exp);
+
+ofl_err
+ofl_exp_openflow_msg_unpack(struct ofp_header *oh, size_t *len, struct ofl_msg_experimenter **msg, struct ofl_exp *ofl_exp);
+
+/* Like ofl_exp_openflow_msg_unpack(), but the entries of a packet_out batch
+ * point to their data in 'oh', which must outlive the message. */
+ofl_err
+ofl_exp_openflow_msg_unpack_in_place(struct ofp_header *oh, size_t *len, struct ofl_msg_experimenter **msg, struct ofl_exp *ofl_exp);
 
 int
-ofl_exp_openflow_msg_pack(struct ofl_msg_experimenter *msg, uint8_t **buf, size_t *buf_len);
+ofl_exp_openflow_msg_free(struct ofl_msg_experimenter *msg, struct ofl_exp *ofl_exp);
+
+char *
+ofl_exp_openflow_msg_to_string(struct ofl_msg_experimenter *msg, struct ofl_exp *ofl_exp);
+
+
+int
+ofl_exp_openflow_act_pack(struct ofl_action_header *src, struct ofp_action_header *dst);
 
 ofl_err
-ofl_exp_openflow_msg_unpack(struct ofp_header *oh, size_t *len, struct ofl_msg_experimenter **msg);
+ofl_exp_openflow_act_unpack(struct ofp_action_header *src, size_t *len, struct ofl_action_header **dst);
 
 int
-ofl_exp_openflow_msg_free(struct ofl_msg_experimenter *msg);
+ofl_exp_openflow_act_free(struct ofl_action_header *act);
+
+size_t
+ofl_exp_openflow_act_ofp_len(struct ofl_action_header *act);
 
 char *
-ofl_exp_openflow_msg_to_string(struct ofl_msg_experimenter *msg);
+ofl_exp_openflow_act_to_string(struct ofl_action_header *act);
 
 
 #endif /* OFL_EXP_OPENFLOW_H */
@@ -48,10 +48,10 @@ OFL_LOG_INIT(LOG_MODULE)
 
 
 int
-ofl_exp_msg_pack(struct ofl_msg_experimenter *msg, uint8_t **buf, size_t *buf_len) {
+ofl_exp_msg_pack(struct ofl_msg_experimenter *msg, uint8_t **buf, size_t *buf_len, struct ofl_exp *ofl_exp) {
     switch (msg->experimenter_id) {
         case (OPENFLOW_VENDOR_ID): {
-            return ofl_exp_openflow_msg_pack(msg, buf, buf_len);
+            return ofl_exp_openflow_msg_pack(msg, buf, buf_len, ofl_exp);
         }
         case (NX_VENDOR_ID): {
             return ofl_exp_nicira_msg_pack(msg, buf, buf_len);
@@ -63,8 +63,8 @@ ofl_exp_msg_pack(struct ofl_msg_experimenter *msg, uint8_t **buf, size_t *buf_le
     }
 }
 
-ofl_err
-ofl_exp_msg_unpack(struct ofp_header *oh, size_t *len, struct ofl_msg_experimenter **msg) {
+static ofl_err
+ofl_exp_msg_unpack__(struct ofp_header *oh, size_t *len, struct ofl_msg_experimenter **msg, struct ofl_exp *ofl_exp, bool in_place) {
     struct ofp_experimenter_header *exp;
 
     if (*len < sizeof(struct ofp_experimenter_header)) {
@@ -76,7 +76,8 @@ ofl_exp_msg_unpack(struct ofp_header *oh, size_t *len, struct ofl_msg_experiment
 
     switch (htonl(exp->experimenter)) {
         case (OPENFLOW_VENDOR_ID): {
-            return ofl_exp_openflow_msg_unpack(oh, len, msg);
+            return in_place ? ofl_exp_openflow_msg_unpack_in_place(oh, len, msg, ofl_exp)
+                            : ofl_exp_openflow_msg_unpack(oh, len, msg, ofl_exp);
         }
         case (NX_VENDOR_ID): {
             return ofl_exp_nicira_msg_unpack(oh, len, msg);
@@ -88,11 +89,21 @@ ofl_exp_msg_unpack(struct ofp_header *oh, size_t *len, struct ofl_msg_experiment
     }
 }
 
+ofl_err
+ofl_exp_msg_unpack(struct ofp_header *oh, size_t *len, struct ofl_msg_experimenter **msg, struct ofl_exp *ofl_exp) {
+    return ofl_exp_msg_unpack__(oh, len, msg, ofl_exp, false);
+}
+
+ofl_err
+ofl_exp_msg_unpack_in_place(struct ofp_header *oh, size_t *len, struct ofl_msg_experimenter **msg, struct ofl_exp *ofl_exp) {
+    return ofl_exp_msg_unpack__(oh, len, msg, ofl_exp, true);
+}
+
 int
-ofl_exp_msg_free(struct ofl_msg_experimenter *msg) {
+ofl_exp_msg_free(struct ofl_msg_experimenter *msg, struct ofl_exp *ofl_exp) {
     switch (msg->experimenter_id) {
         case (OPENFLOW_VENDOR_ID): {
-            return ofl_exp_openflow_msg_free(msg);
+            return ofl_exp_openflow_msg_free(msg, ofl_exp);
         }
         case (NX_VENDOR_ID): {
             return ofl_exp_nicira_msg_free(msg);
@@ -106,10 +117,10 @@ ofl_exp_msg_free(struct ofl_msg_experimenter *msg) {
 }
 
 char *
-ofl_exp_msg_to_string(struct ofl_msg_experimenter *msg) {
+ofl_exp_msg_to_string(struct ofl_msg_experimenter *msg, struct ofl_exp *ofl_exp) {
     switch (msg->experimenter_id) {
         case (OPENFLOW_VENDOR_ID): {
-            return ofl_exp_openflow_msg_to_string(msg);
+            return ofl_exp_openflow_msg_to_string(msg, ofl_exp);
         }
         case (NX_VENDOR_ID): {
             return ofl_exp_nicira_msg_to_string(msg);
@@ -125,3 +136,107 @@ ofl_exp_msg_to_string(struct ofl_msg_experimenter *msg) {
         }
     }
 }
+
+
+int
+ofl_exp_act_pack(struct ofl_action_header *src, struct ofp_action_header *dst) {
+    struct ofl_action_experimenter *exp = (struct ofl_action_experimenter *)src;
+
+    switch (exp->experimenter_id) {
+        case (OPENFLOW_VENDOR_ID): {
+            return ofl_exp_openflow_act_pack(src, dst);
+        }
+        case (NX_VENDOR_ID): {
+            return ofl_exp_nicira_act_pack(src, dst);
+        }
+        default: {
+            OFL_LOG_WARN(LOG_MODULE, "Trying to pack unknown EXPERIMENTER action (%u).", exp->experimenter_id);
+            return -1;
+        }
+    }
+}
+
+ofl_err
+ofl_exp_act_unpack(struct ofp_action_header *src, size_t *len, struct ofl_action_header **dst) {
+    struct ofp_action_experimenter_header *exp;
+
+    if (*len < sizeof(struct ofp_action_experimenter_header)) {
+        OFL_LOG_WARN(LOG_MODULE, "Received EXPERIMENTER action is shorter than ofp_action_experimenter_header.");
+        return ofl_error(OFPET_BAD_ACTION, OFPBAC_BAD_LEN);
+    }
+
+    exp = (struct ofp_action_experimenter_header *)src;
+
+    switch (ntohl(exp->experimenter)) {
+        case (OPENFLOW_VENDOR_ID): {
+            return ofl_exp_openflow_act_unpack(src, len, dst);
+        }
+        case (NX_VENDOR_ID): {
+            return ofl_exp_nicira_act_unpack(src, len, dst);
+        }
+        default: {
+            OFL_LOG_WARN(LOG_MODULE, "Trying to unpack unknown EXPERIMENTER action (%u).", ntohl(exp->experimenter));
+            return ofl_error(OFPET_BAD_ACTION, OFPBAC_BAD_EXPERIMENTER);
+        }
+    }
+}
+
+int
+ofl_exp_act_free(struct ofl_action_header *act) {
+    struct ofl_action_experimenter *exp = (struct ofl_action_experimenter *)act;
+
+    switch (exp->experimenter_id) {
+        case (OPENFLOW_VENDOR_ID): {
+            return ofl_exp_openflow_act_free(act);
+        }
+        case (NX_VENDOR_ID): {
+            return ofl_exp_nicira_act_free(act);
+        }
+        default: {
+            OFL_LOG_WARN(LOG_MODULE, "Trying to free unknown EXPERIMENTER action (%u).", exp->experimenter_id);
+            free(act);
+            return -1;
+        }
+    }
+}
+
+size_t
+ofl_exp_act_ofp_len(struct ofl_action_header *act) {
+    struct ofl_action_experimenter *exp = (struct ofl_action_experimenter *)act;
+
+    switch (exp->experimenter_id) {
+        case (OPENFLOW_VENDOR_ID): {
+            return ofl_exp_openflow_act_ofp_len(act);
+        }
+        case (NX_VENDOR_ID): {
+            return ofl_exp_nicira_act_ofp_len(act);
+        }
+        default: {
+            OFL_LOG_WARN(LOG_MODULE, "Trying to get length of unknown EXPERIMENTER action (%u).", exp->experimenter_id);
+            return 0;
+        }
+    }
+}
+
+char *
+ofl_exp_act_to_string(struct ofl_action_header *act) {
+    struct ofl_action_experimenter *exp = (struct ofl_action_experimenter *)act;
+
+    switch (exp->experimenter_id) {
+        case (OPENFLOW_VENDOR_ID): {
+            return ofl_exp_openflow_act_to_string(act);
+        }
+        case (NX_VENDOR_ID): {
+            return ofl_exp_nicira_act_to_string(act);
+        }
+        default: {
+            char *str;
+            size_t str_size;
+            FILE *stream = open_memstream(&str, &str_size);
+            OFL_LOG_WARN(LOG_MODULE, "Trying to convert to string unknown EXPERIMENTER action (%u).", exp->experimenter_id);
+            fprintf(stream, "{id=\"0x%"PRIx32"\"}", exp->experimenter_id);
+            fclose(stream);
+            return str;
+        }
+    }
+}
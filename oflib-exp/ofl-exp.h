@@ -32,21 +32,41 @@
 #ifndef OFL_EXP_H
 #define OFL_EXP_H 1
 
+#include "../oflib/ofl-actions.h"
 #include "../oflib/ofl-messages.h"
 #include "openflow/openflow.h"
 
 
 int
-ofl_exp_msg_pack(struct ofl_msg_experimenter *msg, uint8_t **buf, size_t *buf_len);
+ofl_exp_msg_pack(struct ofl_msg_experimenter *msg, uint8_t **buf, size_t *buf_len, struct ofl_exp *ofl_exp);
 
 ofl_err
-ofl_exp_msg_unpack(struct ofp_header *oh, size_t *len, struct ofl_msg_experimenter **msg);
+ofl_exp_msg_unpack(struct ofp_header *oh, size_t *len, struct ofl_msg_experimenter **msg, struct ofl_exp *ofl_exp);
+
+ofl_err
+ofl_exp_msg_unpack_in_place(struct ofp_header *oh, size_t *len, struct ofl_msg_experimenter **msg, struct ofl_exp *ofl_exp);
+
+int
+ofl_exp_msg_free(struct ofl_msg_experimenter *msg, struct ofl_exp *ofl_exp);
+
+char *
+ofl_exp_msg_to_string(struct ofl_msg_experimenter *msg, struct ofl_exp *ofl_exp);
+
+
+int
+ofl_exp_act_pack(struct ofl_action_header *src, struct ofp_action_header *dst);
+
+ofl_err
+ofl_exp_act_unpack(struct ofp_action_header *src, size_t *len, struct ofl_action_header **dst);
 
 int
-ofl_exp_msg_free(struct ofl_msg_experimenter *msg);
+ofl_exp_act_free(struct ofl_action_header *act);
+
+size_t
+ofl_exp_act_ofp_len(struct ofl_action_header *act);
 
 char *
-ofl_exp_msg_to_string(struct ofl_msg_experimenter *msg);
+ofl_exp_act_to_string(struct ofl_action_header *act);
 
 
 #endif /* OFL_EXP_H */
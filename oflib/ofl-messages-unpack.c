@@ -345,7 +345,7 @@ ofl_msg_unpack_port_status(struct ofp_header *src, size_t *len, struct ofl_msg_h
 }
 
 static ofl_err
-ofl_msg_unpack_packet_out(struct ofp_header *src, size_t *len, struct ofl_msg_header **msg, struct ofl_exp *exp) {
+ofl_msg_unpack_packet_out(struct ofp_header *src, size_t *len, struct ofl_msg_header **msg, struct ofl_exp *exp, bool in_place) {
     struct ofp_packet_out *sp;
     struct ofl_msg_packet_out *dp;
     struct ofp_action_header *act;
@@ -413,7 +413,16 @@ ofl_msg_unpack_packet_out(struct ofp_header *src, size_t *len, struct ofl_msg_he
 
     data = ((uint8_t *)sp->actions) + ntohs(sp->actions_len);
     dp->data_length = *len;
-    dp->data = *len > 0 ? (uint8_t *)memcpy(malloc(*len), data, *len) : NULL;
+    if (*len == 0) {
+        dp->data = NULL;
+        dp->data_in_place = false;
+    } else if (in_place) {
+        dp->data = data;
+        dp->data_in_place = true;
+    } else {
+        dp->data = (uint8_t *)memcpy(malloc(*len), data, *len);
+        dp->data_in_place = false;
+    }
     *len = 0;
 
     *msg = (struct ofl_msg_header *)dp;
@@ -1562,8 +1571,8 @@ ofl_msg_unpack_empty(struct ofp_header *src UNUSED, size_t *len, struct ofl_msg_
 }
 
 
-ofl_err
-ofl_msg_unpack(uint8_t *buf, size_t buf_len, struct ofl_msg_header **msg, uint32_t *xid, struct ofl_exp *exp) {
+static ofl_err
+ofl_msg_unpack__(uint8_t *buf, size_t buf_len, struct ofl_msg_header **msg, uint32_t *xid, struct ofl_exp *exp, bool in_place) {
     struct ofp_header *oh;
     size_t len = buf_len;
     ofl_err error = 0;
@@ -1606,8 +1615,10 @@ ofl_msg_unpack(uint8_t *buf, size_t buf_len, struct ofl_msg_header **msg, uint32
             if (exp == NULL || exp->msg == NULL || exp->msg->unpack == NULL) {
                 OFL_LOG_WARN(LOG_MODULE, "Received EXPERIMENTER message, but no callback was given.");
                 error = ofl_error(OFPET_BAD_REQUEST, OFPBRC_BAD_EXPERIMENTER);
+            } else if (in_place && exp->msg->unpack_in_place != NULL) {
+                error = exp->msg->unpack_in_place(oh, &len, (struct ofl_msg_experimenter **)msg, exp);
             } else {
-                error = exp->msg->unpack(oh, &len, (struct ofl_msg_experimenter **)msg);
+                error = exp->msg->unpack(oh, &len, (struct ofl_msg_experimenter **)msg, exp);
             }
             break;
 
@@ -1649,7 +1660,7 @@ ofl_msg_unpack(uint8_t *buf, size_t buf_len, struct ofl_msg_header **msg, uint32
             break;
         }
         case OFPT_PACKET_OUT:
-            error = ofl_msg_unpack_packet_out(oh, &len, msg, exp);
+            error = ofl_msg_unpack_packet_out(oh, &len, msg, exp, in_place);
             break;
         case OFPT_FLOW_MOD:
             error = ofl_msg_unpack_flow_mod(oh,buf, &len, msg, exp);
@@ -1728,3 +1739,13 @@ ofl_msg_unpack(uint8_t *buf, size_t buf_len, struct ofl_msg_header **msg, uint32
 
     return 0;
 }
+
+ofl_err
+ofl_msg_unpack(uint8_t *buf, size_t buf_len, struct ofl_msg_header **msg, uint32_t *xid, struct ofl_exp *exp) {
+    return ofl_msg_unpack__(buf, buf_len, msg, xid, exp, false);
+}
+
+ofl_err
+ofl_msg_unpack_in_place(uint8_t *buf, size_t buf_len, struct ofl_msg_header **msg, uint32_t *xid, struct ofl_exp *exp) {
+    return ofl_msg_unpack__(buf, buf_len, msg, xid, exp, true);
+}
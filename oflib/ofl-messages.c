@@ -217,7 +217,7 @@ ofl_msg_free(struct ofl_msg_header *msg, struct ofl_exp *exp) {
                 OFL_LOG_WARN(LOG_MODULE, "Trying to free EXPERIMENTER message, but no callback was given");
                 break;
             }
-            exp->msg->free((struct ofl_msg_experimenter *)msg);
+            exp->msg->free((struct ofl_msg_experimenter *)msg, exp);
             return 0;
         }
         case OFPT_FEATURES_REQUEST: {
@@ -311,7 +311,7 @@ ofl_msg_free_meter_mod(struct ofl_msg_meter_mod * msg, bool with_bands){
 
 int
 ofl_msg_free_packet_out(struct ofl_msg_packet_out *msg, bool with_data, struct ofl_exp *exp) {
-    if (with_data) {
+    if (with_data && !msg->data_in_place) {
         free(msg->data);
     }
     OFL_UTILS_FREE_ARR_FUN2(msg->actions, msg->actions_num,
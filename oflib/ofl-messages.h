@@ -181,6 +181,10 @@ struct ofl_msg_packet_out {
     size_t                     data_length;
     uint8_t                   *data;        /* Packet data. (Only meaningful
                                               if buffer_id is 0xffffffff.) */
+    bool                       data_in_place; /* If true, data points into
+                                              the buffer the message was
+                                              unpacked from and is not freed
+                                              with the message. */
 };
 
 struct ofl_msg_flow_mod {
@@ -493,6 +497,13 @@ ofl_err
 ofl_msg_unpack(uint8_t *buf, size_t buf_len,
                struct ofl_msg_header **msg, uint32_t *xid, struct ofl_exp *exp);
 
+/* Like ofl_msg_unpack, but the packet data of a packet out message is not
+ * copied: the message points to it in buf, which must outlive the message. */
+ofl_err
+ofl_msg_unpack_in_place(uint8_t *buf, size_t buf_len,
+                        struct ofl_msg_header **msg, uint32_t *xid,
+                        struct ofl_exp *exp);
+
 
 
 
@@ -36,6 +36,7 @@
 
 #include "../include/openflow/openflow.h"
 
+struct ofl_exp;
 struct ofl_msg_experimenter;
 struct ofl_msg_multipart_request_header;
 struct ofl_msg_multipart_reply_header;
@@ -121,10 +122,15 @@ struct ofl_exp_stats {
 
 /* Callback functions for handling experimenter messages. */
 struct ofl_exp_msg {
-    int     (*pack)             (struct ofl_msg_experimenter *msg, uint8_t **buf, size_t *buf_len);
-    ofl_err (*unpack)           (struct ofp_header *oh, size_t *len, struct ofl_msg_experimenter **msg);
-    int     (*free)             (struct ofl_msg_experimenter *msg);
-    char   *(*to_string)        (struct ofl_msg_experimenter *msg);
+    /* 'exp' is the structure the callbacks were found in, for messages that
+     * carry actions or other experimenter structures. */
+    int     (*pack)             (struct ofl_msg_experimenter *msg, uint8_t **buf, size_t *buf_len, struct ofl_exp *exp);
+    ofl_err (*unpack)           (struct ofp_header *oh, size_t *len, struct ofl_msg_experimenter **msg, struct ofl_exp *exp);
+    /* Optional: like 'unpack', but packet data may be left in 'oh', for
+     * ofl_msg_unpack_in_place(). */
+    ofl_err (*unpack_in_place)  (struct ofp_header *oh, size_t *len, struct ofl_msg_experimenter **msg, struct ofl_exp *exp);
+    int     (*free)             (struct ofl_msg_experimenter *msg, struct ofl_exp *exp);
+    char   *(*to_string)        (struct ofl_msg_experimenter *msg, struct ofl_exp *exp);
 };
 
 /* Convenience structure for passing all callback groups at once. */
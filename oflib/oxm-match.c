@@ -59,6 +59,7 @@
 #include "oflib/ofl-utils.h"
 #include "oflib/ofl-print.h"
 #include "unaligned.h"
+#include "util.h"
 #include "byte-order.h"
 #include "../include/openflow/openflow.h"
 
@@ -79,50 +80,39 @@ static const uint8_t eth_mcast_0[ETH_ADDR_LEN]
 
 struct oxm_field all_fields[NUM_OXM_FIELDS] = {
 #define DEFINE_FIELD(HEADER, DL_TYPES, NW_PROTO, MASKABLE)     \
-    { HMAP_NODE_NULL_INITIALIZER, OFI_OXM_##HEADER, OXM_##HEADER, \
+    { OFI_OXM_##HEADER, OXM_##HEADER, \
         DL_CONVERT DL_TYPES, NW_PROTO, MASKABLE },
 #define DL_CONVERT(T1, T2) { CONSTANT_HTONS(T1), CONSTANT_HTONS(T2) }
 #include "oxm-match.def"
 };
 
-/* Hash table of 'oxm_fields'. */
-static struct hmap all_oxm_fields = HMAP_INITIALIZER(&all_oxm_fields);
+/* Direct lookup table of 'all_fields', indexed by the field id and hasmask
+ * bit of an OXM header.  Only OpenFlow basic class fields are listed in
+ * oxm-match.def, so the vendor and length are checked against the entry. */
+#define OXM_SLOT(HEADER) ((OXM_FIELD(HEADER) << 1) | OXM_HASMASK(HEADER))
+#define OXM_N_SLOTS 256
 
-static void
-oxm_init(void)
-{
-    if (hmap_is_empty(&all_oxm_fields)) {
-        int i;
-
-        for (i = 0; i < NUM_OXM_FIELDS; i++) {
-            struct oxm_field *f = &all_fields[i];
-            hmap_insert(&all_oxm_fields, &f->hmap_node,
-                        hash_int(f->header, 0));
-        }
-
-        /* Verify that the header values are unique (duplicate "case" values
-         * cause a compile error). */
-        switch (0) {
-#define DEFINE_FIELD(HEADER, DL_TYPE, NW_PROTO, MASKABLE)  \
-        case OXM_##HEADER: break;
+static struct oxm_field *const oxm_fields_by_slot[OXM_N_SLOTS] = {
+#define DEFINE_FIELD(HEADER, DL_TYPES, NW_PROTO, MASKABLE)  \
+    [OXM_SLOT(OXM_##HEADER)] = &all_fields[OFI_OXM_##HEADER],
 #include "oxm-match.def"
-        }
-    }
-}
+};
 
 struct oxm_field *
 oxm_field_lookup(uint32_t header)
 {
     struct oxm_field *f;
 
-    oxm_init();
-    HMAP_FOR_EACH_WITH_HASH(f, struct oxm_field, hmap_node, hash_int(header, 0),
-                            &all_oxm_fields) {
-        if (f->header == header) {
-            return f;
-        }
+    /* Verify that the header values are unique (duplicate "case" values
+     * cause a compile error). */
+    switch (0) {
+#define DEFINE_FIELD(HEADER, DL_TYPE, NW_PROTO, MASKABLE)  \
+    case OXM_##HEADER: break;
+#include "oxm-match.def"
     }
-    return NULL;
+
+    f = oxm_fields_by_slot[OXM_SLOT(header)];
+    return f != NULL && f->header == header ? f : NULL;
 }
 
 
@@ -141,19 +131,6 @@ oxm_match_lookup(uint32_t header, const struct ofl_match *omt)
 }
 
 
-static bool
-check_present_prereq(const struct ofl_match *match, uint32_t header){
-
-    struct ofl_match_tlv *omt;
-
-    /* Check for header */
-    HMAP_FOR_EACH_WITH_HASH (omt, struct ofl_match_tlv, hmap_node, hash_int(header, 0),
-          &match->match_fields) {
-         return true;
-    }
-    return false;
-}
-
 bool
 oxm_prereqs_ok(const struct oxm_field *field, const struct ofl_match *rule)
 {
@@ -221,31 +198,93 @@ oxm_prereqs_ok(const struct oxm_field *field, const struct ofl_match *rule)
     return false;
 }
 
+/* Decoder state of oxm_pull_match(): which fields have been pulled so far
+ * and the values the prerequisites of later fields depend on, so that neither
+ * needs a lookup into the match being built. */
+struct oxm_pull_state {
+    uint64_t present;        /* Bit OFI_* set for each field pulled. */
+    uint16_t eth_type;       /* OXM_OF_ETH_TYPE, network byte order. */
+    uint16_t vlan_vid;       /* OXM_OF_VLAN_VID, host byte order. */
+    uint8_t ip_proto;        /* OXM_OF_IP_PROTO. */
+    uint8_t icmpv6_type;     /* OXM_OF_ICMPV6_TYPE. */
+};
+
+BUILD_ASSERT_DECL(NUM_OXM_FIELDS <= 64);
+#define OXM_BIT(INDEX) (UINT64_C(1) << (INDEX))
+
+static inline bool
+oxm_pull_present(const struct oxm_pull_state *s, enum oxm_field_index index)
+{
+    return (s->present & OXM_BIT(index)) != 0;
+}
+
+/* The checks of oxm_prereqs_ok(), against the pull state.  The ND target
+ * may follow either a neighbor solicitation or an advertisement. */
 static bool
-check_oxm_dup(struct ofl_match *match,const struct oxm_field *om){
+oxm_pull_prereqs_ok(const struct oxm_field *f, const struct oxm_pull_state *s)
+{
+    if (f->index == OFI_OXM_OF_IPV6_ND_TARGET
+        || f->index == OFI_OXM_OF_IPV6_ND_SLL
+        || f->index == OFI_OXM_OF_IPV6_ND_TLL) {
+        if (!oxm_pull_present(s, OFI_OXM_OF_ICMPV6_TYPE)) {
+            return false;
+        }
+        if (f->index != OFI_OXM_OF_IPV6_ND_TLL
+            && s->icmpv6_type == ICMPV6_NEIGHSOL) {
+            /* Solicitation: target and source link-layer address. */
+        } else if (f->index != OFI_OXM_OF_IPV6_ND_SLL
+                   && s->icmpv6_type == ICMPV6_NEIGHADV) {
+            /* Advertisement: target and target link-layer address. */
+        } else {
+            return false;
+        }
+    }
 
-    struct ofl_match_tlv *t;
-    HMAP_FOR_EACH_WITH_HASH(t, struct ofl_match_tlv, hmap_node ,hash_int(om->header, 0),
-                             &match->match_fields) {
-        return true;
+    if (f->nw_proto && (!oxm_pull_present(s, OFI_OXM_OF_IP_PROTO)
+                        || s->ip_proto != f->nw_proto)) {
+        return false;
     }
-    return false;
 
+    if (!f->dl_type[0]) {
+        return true;
+    }
+    return oxm_pull_present(s, OFI_OXM_OF_ETH_TYPE)
+           && (s->eth_type == f->dl_type[0]
+               || (f->dl_type[1] && s->eth_type == f->dl_type[1]));
 }
 
-static uint8_t* get_oxm_value(struct ofl_match *m, uint32_t header){
+/* A field may appear once, either exact or wildcarded. */
+static bool
+oxm_pull_dup(const struct oxm_field *f, const struct oxm_pull_state *s)
+{
+    const struct oxm_field *other;
 
-     struct ofl_match_tlv *t;
-     HMAP_FOR_EACH_WITH_HASH (t, struct ofl_match_tlv, hmap_node, hash_int(header, 0),
-          &m->match_fields) {
-         return t->value;
-     }
+    if (oxm_pull_present(s, f->index)) {
+        return true;
+    }
+    other = oxm_fields_by_slot[OXM_SLOT(f->header) ^ 1];
+    return other != NULL && oxm_pull_present(s, other->index);
+}
 
-     return NULL;
+static void
+oxm_pull_record(struct oxm_pull_state *s, const struct oxm_field *f,
+                const uint8_t *value)
+{
+    s->present |= OXM_BIT(f->index);
+    if (f->index == OFI_OXM_OF_ETH_TYPE) {
+        memcpy(&s->eth_type, value, sizeof s->eth_type);
+    } else if (f->index == OFI_OXM_OF_VLAN_VID) {
+        s->vlan_vid = ntohs(get_unaligned_u16((const uint16_t *) value));
+    } else if (f->index == OFI_OXM_OF_IP_PROTO) {
+        s->ip_proto = *value;
+    } else if (f->index == OFI_OXM_OF_ICMPV6_TYPE) {
+        s->icmpv6_type = *value;
+    }
 }
 
 static int
 parse_oxm_entry(struct ofl_match *match, const struct oxm_field *f,
+                const struct oxm_pull_state *s,
                 const void *value, const void *mask){
 
     switch (f->index) {
@@ -256,8 +295,10 @@ parse_oxm_entry(struct ofl_match *match, const struct oxm_field *f,
         }
         case OFI_OXM_OF_IN_PHY_PORT:{
             /* Check for inport presence */
-            if (check_present_prereq(match,OXM_OF_IN_PORT))
+            if (oxm_pull_present(s, OFI_OXM_OF_IN_PORT)) {
                 ofl_structs_match_put32(match, f->header, ntohl(*((uint32_t*) value)));
+                return 0;
+            }
             else return ofp_mkerr(OFPET_BAD_MATCH, OFPBMC_BAD_PREREQ);
 
         }
@@ -309,9 +350,8 @@ parse_oxm_entry(struct ofl_match *match, const struct oxm_field *f,
 
         case OFI_OXM_OF_VLAN_PCP:{
             /* Check for VLAN_VID presence */
-            if (check_present_prereq(match,OXM_OF_VLAN_VID)){
-                uint8_t *p = get_oxm_value(match,OXM_OF_VLAN_VID);
-                if (*(uint16_t*) p != OFPVID_NONE ){
+            if (oxm_pull_present(s, OFI_OXM_OF_VLAN_VID)){
+                if (s->vlan_vid != OFPVID_NONE ){
                     uint8_t *v = (uint8_t*) value;
                     ofl_structs_match_put8(match, f->header, *v);
                 }
@@ -465,6 +505,7 @@ int
 oxm_pull_match(struct ofpbuf *buf, struct ofl_match * match_dst, int match_len)
 {
 
+    struct oxm_pull_state state;
     uint32_t header;
     uint8_t *p;
     p = ofpbuf_try_pull(buf, match_len);
@@ -479,6 +520,7 @@ oxm_pull_match(struct ofpbuf *buf, struct ofl_match * match_dst, int match_len)
 
     /* Initialize the match hashmap */
     ofl_structs_match_init(match_dst);
+    memset(&state, 0, sizeof state);
 
     while ((header = oxm_entry_ok(p, match_len)) != 0) {
 
@@ -493,17 +535,21 @@ oxm_pull_match(struct ofpbuf *buf, struct ofl_match * match_dst, int match_len)
         else if (OXM_HASMASK(header) && !f->maskable){
             error = ofp_mkerr(OFPET_BAD_MATCH, OFPBMC_BAD_MASK);
         }
-        else if (!oxm_prereqs_ok(f, match_dst)) {
+        else if (!oxm_pull_prereqs_ok(f, &state)) {
             error = ofp_mkerr(OFPET_BAD_MATCH, OFPBMC_BAD_PREREQ);
         }
-        else if (check_oxm_dup(match_dst,f)){
+        else if (oxm_pull_dup(f, &state)){
             error = ofp_mkerr(OFPET_BAD_MATCH, OFPBMC_DUP_FIELD);
         }
         else {
             /* 'hasmask' and 'length' are known to be correct at this point
              * because they are included in 'header' and oxm_field_lookup()
              * checked them already. */
-            error = parse_oxm_entry(match_dst, f, p + 4, p + 4 + length / 2);
+            error = parse_oxm_entry(match_dst, f, &state,
+                                    p + 4, p + 4 + length / 2);
+            if (!error) {
+                oxm_pull_record(&state, f, p + 4);
+            }
         }
         if (error) {
             VLOG_DBG_RL(LOG_MODULE,&rl, "bad oxm_entry with vendor=%"PRIu32", "
@@ -841,5 +887,26 @@ int oxm_put_match(struct ofpbuf *buf, struct ofl_match *omt){
     return match_len;
 }
 
+int
+oxm_field_bytes(uint32_t header) {
+    unsigned int length = OXM_LENGTH(header);
+    return OXM_HASMASK(header) ? length / 2 : length;
+}
 
-
+int
+oxm_field_bits(uint32_t header) {
+    switch (OXM_HEADER(OXM_VENDOR(header), OXM_FIELD(header),
+                       oxm_field_bytes(header))) {
+        case OXM_OF_VLAN_VID:       return 13;
+        case OXM_OF_VLAN_PCP:       return 3;
+        case OXM_OF_IP_DSCP:        return 6;
+        case OXM_OF_IP_ECN:         return 2;
+        case OXM_OF_IPV6_FLABEL:    return 20;
+        case OXM_OF_MPLS_LABEL:     return 20;
+        case OXM_OF_MPLS_TC:        return 3;
+        case OXM_OF_MPLS_BOS:       return 1;
+        case OXM_OF_PBB_ISID:       return 24;
+        case OXM_OF_IPV6_EXTHDR:    return 9;
+        default:                    return oxm_field_bytes(header) * 8;
+    }
+}
@@ -55,7 +55,7 @@
 #include "../oflib/ofl-structs.h"
 
 #define OXM_HEADER__(VENDOR, FIELD, HASMASK, LENGTH) \
-    (((VENDOR) << 16) | ((FIELD) << 9) | ((HASMASK) << 8) | (LENGTH))
+    (((uint32_t) (VENDOR) << 16) | ((FIELD) << 9) | ((HASMASK) << 8) | (LENGTH))
 #define OXM_HEADER(VENDOR, FIELD, LENGTH) \
     OXM_HEADER__(VENDOR, FIELD, 0, LENGTH)
 #define OXM_HEADER_W(VENDOR, FIELD, LENGTH) \
@@ -288,7 +288,6 @@ enum oxm_field_index {
 };
 
 struct oxm_field {
-    struct hmap_node hmap_node;
     enum oxm_field_index index;       /* OFI_* value. */
     uint32_t header;                  /* OXM_* value. */
     uint16_t dl_type[N_OXM_DL_TYPES]; /* dl_type prerequisites. */
@@ -315,9 +314,11 @@ oxm_match_lookup(uint32_t header, const struct ofl_match *omt);
 
 uint32_t oxm_entry_ok(const void *, unsigned int );
 
+/* Returns the size of the value of field 'header', without its mask. */
 int
 oxm_field_bytes(uint32_t header);
 
+/* Returns the number of significant bits of the value of field 'header'. */
 int
 oxm_field_bits(uint32_t header);
 
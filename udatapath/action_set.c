@@ -203,6 +203,11 @@ action_set_clear_actions(struct action_set *set) {
     }
 }
 
+bool
+action_set_is_empty(struct action_set *set) {
+    return list_is_empty(&set->actions);
+}
+
 void
 action_set_execute(struct action_set *set, struct packet *pkt, uint64_t cookie) {
     struct action_set_entry *entry, *next;
@@ -231,7 +236,8 @@ action_set_execute(struct action_set *set, struct packet *pkt, uint64_t cookie)
             pkt->out_queue = 0;
 
             action_set_clear_actions(pkt->action_set);
-            dp_actions_output_port(pkt, port_id, queue_id, max_len, cookie);
+            dp_actions_output_port(pkt, port_id, queue_id, max_len, cookie,
+                                   true);
             return;
         }
     }
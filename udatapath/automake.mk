@@ -20,8 +20,18 @@ udatapath_ofdatapath_SOURCES = \
 	udatapath/dp_control.h \
 	udatapath/dp_exp.c \
 	udatapath/dp_exp.h \
+	udatapath/dp_learn.c \
+	udatapath/dp_learn.h \
+	udatapath/dp_pending.c \
+	udatapath/dp_pending.h \
 	udatapath/dp_ports.c \
 	udatapath/dp_ports.h \
+	udatapath/dp_responder.c \
+	udatapath/dp_responder.h \
+	udatapath/dp_sflow.c \
+	udatapath/dp_sflow.h \
+	udatapath/dp_stats_shm.c \
+	udatapath/dp_stats_shm.h \
 	udatapath/flow_table.c \
 	udatapath/flow_table.h \
 	udatapath/flow_entry.c \
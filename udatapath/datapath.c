@@ -41,26 +41,35 @@
 #include <assert.h>
 #include <errno.h>
 #include <inttypes.h>
+#include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include "csum.h"
 #include "dp_buffers.h"
 #include "dp_control.h"
+#include "dp_learn.h"
+#include "dp_pending.h"
+#include "dp_responder.h"
+#include "dp_sflow.h"
+#include "dp_stats_shm.h"
 #include "ofp.h"
 #include "ofpbuf.h"
 #include "group_table.h"
+#include "hash.h"
 #include "meter_table.h"
 #include "oflib/ofl.h"
 #include "oflib-exp/ofl-exp.h"
 #include "oflib-exp/ofl-exp-nicira.h"
 #include "oflib/ofl-messages.h"
 #include "oflib/ofl-log.h"
+#include "oflib/oxm-match.h"
 #include "openflow/openflow.h"
 #include "openflow/nicira-ext.h"
 #include "openflow/private-ext.h"
 #include "openflow/openflow-ext.h"
 #include "pipeline.h"
+#include "pkt-queue.h"
 #include "poll-loop.h"
 #include "rconn.h"
 #include "stp.h"
@@ -71,9 +80,11 @@
 static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(60, 60);
 
 
-static struct remote *remote_create(struct datapath *dp, struct rconn *rconn, struct rconn *rconn_aux);
+static struct remote *remote_create(struct datapath *dp, struct rconn *rconn, struct pvconn *listener);
+static void remote_attach_aux(struct datapath *, struct aux_listener *, struct rconn *);
 static void remote_run(struct datapath *, struct remote *);
 static void remote_rconn_run(struct datapath *, struct remote *, uint8_t);
+static void remote_backlog_clear(struct remote_backlog *);
 static void remote_wait(struct remote *);
 static void remote_destroy(struct remote *);
 
@@ -84,19 +95,36 @@ static void remote_destroy(struct remote *);
 #define DP_DESC      "OpenFlow 1.3 Reference Userspace Switch Datapath"
 #define SERIAL_NUM   "1"
 
-#define MAIN_CONNECTION 0
-#define PTIN_CONNECTION 1
+/* Remotes are served in deficit round robin order. In each round a remote is
+ * credited REMOTE_QUANTUM bytes, and processes messages until its credit runs
+ * out or its batch is complete. The batch size adapts to the measured cost of
+ * a message, so that serving a remote takes about REMOTE_TIME_BUDGET us. */
+#define REMOTE_QUANTUM      (64 * 1024)
+#define REMOTE_TIME_BUDGET  2000
+#define REMOTE_MIN_BATCH    8
+#define REMOTE_MAX_BATCH    512
+#define REMOTE_INIT_COST    10000  /* Initial cost of a message, in ns. */
+#define REMOTE_MAX_BACKLOG  64     /* Requests read ahead per connection. */
 
 
 /* Callbacks for processing experimenter messages in OFLib. */
 static struct ofl_exp_msg dp_exp_msg =
-        {.pack      = ofl_exp_msg_pack,
-         .unpack    = ofl_exp_msg_unpack,
-         .free      = ofl_exp_msg_free,
-         .to_string = ofl_exp_msg_to_string};
+        {.pack            = ofl_exp_msg_pack,
+         .unpack          = ofl_exp_msg_unpack,
+         .unpack_in_place = ofl_exp_msg_unpack_in_place,
+         .free            = ofl_exp_msg_free,
+         .to_string       = ofl_exp_msg_to_string};
+
+/* Callbacks for processing experimenter actions in OFLib. */
+static struct ofl_exp_act dp_exp_act =
+        {.pack      = ofl_exp_act_pack,
+         .unpack    = ofl_exp_act_unpack,
+         .free      = ofl_exp_act_free,
+         .ofp_len   = ofl_exp_act_ofp_len,
+         .to_string = ofl_exp_act_to_string};
 
 static struct ofl_exp dp_exp =
-        {.act   = NULL,
+        {.act   = &dp_exp_act,
          .inst  = NULL,
          .match = NULL,
          .stats = NULL,
@@ -138,17 +166,37 @@ dp_new(void) {
     dp->n_listeners = 0;
     dp->listeners_aux = NULL;
     dp->n_listeners_aux = 0;
-
-    memset(dp->ports, 0x00, sizeof (dp->ports));
+    dp->n_aux_conns = 0;
+
+    dp->ports = NULL;
+    dp->ports_size = 0;
+    dp->flood_ports = NULL;
+    dp->n_flood_ports = 0;
+    dp->all_ports = NULL;
+    dp->n_all_ports = 0;
     dp->local_port = NULL;
+    netdev_monitor_create(&dp->port_monitor);
+    dp->rx_polls = 0;
+    dp->rx_busy_polls = 0;
+    dp->stats_shm = NULL;
+    dp->sflow = NULL;
+    dp->pktmem = NULL;
 
     dp->buffers = dp_buffers_create(dp);
+    dp->parse_depth = NBLINK_PARSE_L2;
+    memset(dp->parse_refs, 0x00, sizeof (dp->parse_refs));
     dp->pipeline = pipeline_create(dp);
     dp->groups = group_table_create(dp);
     dp->meters = meter_table_create(dp);
+    dp->learn = dp_learn_create(dp);
+    dp->pending = dp_pending_create(dp);
+    dp->responder = dp_responder_create(dp);
 
     list_init(&dp->port_list);
     dp->ports_num = 0;
+    dp->tx_batching = false;
+    list_init(&dp->tx_ports);
+    dp->rx_burst = DP_PORTS_BURST;
     dp->max_queues = NETDEV_MAX_QUEUES;
 
     dp->exp = &dp_exp;
@@ -173,14 +221,29 @@ dp_new(void) {
 
 
 void
-dp_add_pvconn(struct datapath *dp, struct pvconn *pvconn, struct pvconn *pvconn_aux) {
+dp_add_pvconn(struct datapath *dp, struct pvconn *pvconn,
+              struct pvconn **pvconn_aux, size_t n_aux) {
+    size_t i;
+
     dp->listeners = xrealloc(dp->listeners,
                              sizeof *dp->listeners * (dp->n_listeners + 1));
     dp->listeners[dp->n_listeners++] = pvconn;
 
-    dp->listeners_aux = xrealloc(dp->listeners_aux,
+    n_aux = MIN(n_aux, DP_MAX_AUX_CONNS);
+    for (i = 0; i < n_aux; i++) {
+        struct aux_listener *l;
+
+        if (pvconn_aux[i] == NULL) {
+            continue;
+        }
+        dp->listeners_aux = xrealloc(dp->listeners_aux,
                              sizeof *dp->listeners_aux * (dp->n_listeners_aux + 1));
-    dp->listeners_aux[dp->n_listeners_aux++] = pvconn_aux;
+        l = &dp->listeners_aux[dp->n_listeners_aux++];
+        l->pvconn = pvconn_aux[i];
+        l->main   = pvconn;
+        l->aux_id = i + 1;
+    }
+    dp->n_aux_conns = MAX(dp->n_aux_conns, n_aux);
 }
 
 void
@@ -202,6 +265,11 @@ dp_run(struct datapath *dp) {
     LIST_FOR_EACH_SAFE (r, rn, struct remote, node, &dp->remotes) {
         remote_run(dp, r);
     }
+    /* Rotate the remotes, so that the same remote is not always served
+     * first. */
+    if (!list_is_empty(&dp->remotes)) {
+        list_push_back(&dp->remotes, list_pop_front(&dp->remotes));
+    }
 
     for (i = 0; i < dp->n_listeners; ) {
         struct pvconn *pvconn = dp->listeners[i];
@@ -209,31 +277,48 @@ dp_run(struct datapath *dp) {
 
         int retval = pvconn_accept(pvconn, OFP_VERSION, &new_vconn);
         if (!retval) {
-            struct rconn * rconn_aux = NULL;
-            if (dp->n_listeners_aux && dp->listeners_aux[i] != NULL) {
-                struct pvconn *pvconn_aux = dp->listeners_aux[i];
-                struct vconn *new_vconn_aux;
-                int retval_aux = pvconn_accept(pvconn_aux, OFP_VERSION, &new_vconn_aux);
-                if (!retval_aux)
-                    rconn_aux = rconn_new_from_vconn("passive_aux", new_vconn_aux);
-            }
-            remote_create(dp, rconn_new_from_vconn("passive", new_vconn), rconn_aux);
+            remote_create(dp, rconn_new_from_vconn("passive", new_vconn), pvconn);
         }
         else if (retval != EAGAIN) {
             VLOG_WARN_RL(LOG_MODULE, &rl, "accept failed (%s)", strerror(retval));
             dp->listeners[i] = dp->listeners[--dp->n_listeners];
-            if (dp->n_listeners_aux) {
-                dp->listeners_aux[i] = dp->listeners_aux[--dp->n_listeners_aux];
-            }
             continue;
         }
         i++;
     }
+
+    /* Auxiliary connections are accepted independently of the main ones, as
+     * the controller opens them only after the main connection is up. */
+    for (i = 0; i < dp->n_listeners_aux; ) {
+        struct aux_listener *l = &dp->listeners_aux[i];
+        struct vconn *new_vconn;
+
+        int retval = pvconn_accept(l->pvconn, OFP_VERSION, &new_vconn);
+        if (!retval) {
+            remote_attach_aux(dp, l, rconn_new_from_vconn("passive_aux", new_vconn));
+        }
+        else if (retval != EAGAIN) {
+            VLOG_WARN_RL(LOG_MODULE, &rl, "auxiliary accept failed (%s)", strerror(retval));
+            dp->listeners_aux[i] = dp->listeners_aux[--dp->n_listeners_aux];
+            continue;
+        }
+        i++;
+    }
+
+    dp_pending_run(dp);
+    dp_sflow_run(dp);
+    dp_stats_shm_run(dp);
 }
 
 static void
 remote_run(struct datapath *dp, struct remote *r)
 {
+    size_t i;
+
+    /* Credit the remote for this round. An idle remote does not build up
+     * credit beyond a single quantum. */
+    r->deficit = MIN(r->deficit + REMOTE_QUANTUM, REMOTE_QUANTUM);
+
     remote_rconn_run(dp, r, MAIN_CONNECTION);
 
     if (!rconn_is_alive(r->rconn)) {
@@ -241,62 +326,202 @@ remote_run(struct datapath *dp, struct remote *r)
         return;
     }
 
-    if (r->rconn_aux == NULL || !rconn_is_alive(r->rconn_aux))
-        return;
+    for (i = 0; i < DP_MAX_AUX_CONNS; i++) {
+        struct remote_aux *aux = &r->aux[i];
+
+        if (aux->rconn == NULL) {
+            continue;
+        }
+        if (!rconn_is_alive(aux->rconn)) {
+            /* Messages for this connection fail over to the main one. */
+            VLOG_WARN_RL(LOG_MODULE, &rl, "%s: auxiliary connection %zu lost.",
+                         rconn_get_name(r->rconn), i + 1);
+            remote_backlog_clear(&aux->backlog);
+            rconn_destroy(aux->rconn);
+            aux->rconn = NULL;
+            continue;
+        }
+        remote_rconn_run(dp, r, i + 1);
+    }
+}
+
+/* Returns true if messages of 'type' are not charged to the budget of the
+ * remote and bypass the limit of its tx queue. This does not reorder them:
+ * barriers and role requests must stay in order with the requests around
+ * them, and are only handled when the requests before them are. Only echo
+ * requests and replies are answered ahead of a backlog, see
+ * remote_read_ahead(). */
+static bool
+is_priority_msg(uint8_t type) {
+    switch (type) {
+        case OFPT_ECHO_REQUEST:
+        case OFPT_ECHO_REPLY:
+        case OFPT_BARRIER_REQUEST:
+        case OFPT_BARRIER_REPLY:
+        case OFPT_ROLE_REQUEST:
+        case OFPT_ROLE_REPLY:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static struct remote_backlog *
+remote_get_backlog(struct remote *r, uint8_t conn_id) {
+    return (conn_id == MAIN_CONNECTION ? &r->backlog
+                                       : &r->aux[conn_id - 1].backlog);
+}
+
+static void
+remote_backlog_push(struct remote_backlog *b, struct ofpbuf *buffer) {
+    buffer->next = NULL;
+    if (b->tail != NULL) {
+        b->tail->next = buffer;
+    } else {
+        b->head = buffer;
+    }
+    b->tail = buffer;
+    b->n++;
+}
 
-    remote_rconn_run(dp, r, PTIN_CONNECTION);
+static struct ofpbuf *
+remote_backlog_pop(struct remote_backlog *b) {
+    struct ofpbuf *buffer = b->head;
+
+    if (buffer != NULL) {
+        b->head = buffer->next;
+        if (b->head == NULL) {
+            b->tail = NULL;
+        }
+        buffer->next = NULL;
+        b->n--;
+    }
+    return buffer;
+}
+
+static void
+remote_backlog_clear(struct remote_backlog *b) {
+    struct ofpbuf *buffer;
+
+    while ((buffer = remote_backlog_pop(b)) != NULL) {
+        ofpbuf_delete(buffer);
+    }
+}
+
+/* Handles the request in 'buffer', received on connection 'conn_id' of 'r',
+ * and frees 'buffer'. */
+static void
+remote_handle_msg(struct datapath *dp, struct remote *r, uint8_t conn_id,
+                  struct ofpbuf *buffer) {
+    struct ofl_msg_header *msg;
+    struct sender sender = {.remote = r, .conn_id = conn_id,
+                            .buffer = &buffer};
+    ofl_err error;
+
+    error = ofl_msg_unpack_in_place(buffer->data, buffer->size,
+                                    &msg, &(sender.xid), dp->exp);
+
+    if (!error) {
+        error = handle_control_msg(dp, msg, &sender);
+
+        if (error) {
+            ofl_msg_free(msg, dp->exp);
+        }
+    }
+
+    if (error) {
+        struct ofl_msg_error err =
+                {{.type = OFPT_ERROR},
+                 .type = ofl_error_type(error),
+                 .code = ofl_error_code(error),
+                 .data_length = buffer->size,
+                 .data        = buffer->data};
+        dp_send_message(dp, (struct ofl_msg_header *)&err, &sender);
+    }
+
+    ofpbuf_delete(buffer);
+}
+
+/* Called when connection 'conn_id' of 'r' is left with unserved requests.
+ * Reads up to REMOTE_MAX_BACKLOG of them into the backlog of the connection,
+ * answering the echo requests among them right away, so that the controller
+ * does not time out the connection while the switch is loaded. The backlog
+ * is served in order before anything else is read from the connection. */
+static void
+remote_read_ahead(struct datapath *dp, struct remote *r, uint8_t conn_id,
+                  struct rconn *rconn) {
+    struct remote_backlog *b = remote_get_backlog(r, conn_id);
+
+    while (b->n < REMOTE_MAX_BACKLOG) {
+        struct ofpbuf *buffer = rconn_recv(rconn);
+        struct ofp_header *oh;
+
+        if (buffer == NULL) {
+            break;
+        }
+        oh = buffer->data;
+        if (oh->type == OFPT_ECHO_REQUEST || oh->type == OFPT_ECHO_REPLY) {
+            remote_handle_msg(dp, r, conn_id, buffer);
+        } else {
+            remote_backlog_push(b, buffer);
+        }
+    }
+}
+
+/* Returns the number of messages queued for tx on the connection that
+ * messages for connection 'conn_id' of 'r' are sent on, see
+ * send_openflow_buffer_to_remote(). */
+static int
+remote_n_txq(const struct remote *r, uint8_t conn_id) {
+    if (conn_id != MAIN_CONNECTION) {
+        const struct remote_aux *aux = &r->aux[conn_id - 1];
+
+        if (aux->rconn != NULL && rconn_is_connected(aux->rconn)) {
+            return aux->n_txq;
+        }
+    }
+    return r->n_txq;
 }
 
 static void
 remote_rconn_run(struct datapath *dp, struct remote *r, uint8_t conn_id) {
+    struct remote_backlog *backlog = remote_get_backlog(r, conn_id);
     struct rconn *rconn;
-    ofl_err error;
+    long long int start;
+    size_t batch;
     size_t i;
 
     if (conn_id == MAIN_CONNECTION)
         rconn = r->rconn;
-    else if (conn_id == PTIN_CONNECTION)
-        rconn = r->rconn_aux;
+    else
+        rconn = r->aux[conn_id - 1].rconn;
 
     rconn_run(rconn);
-    /* Do some remote processing, but cap it at a reasonable amount so that
-     * other processing doesn't starve. */
-    for (i = 0; i < 50; i++) {
+    /* Do some remote processing, but cap it so that other remotes and packet
+     * forwarding don't starve. */
+    batch = REMOTE_TIME_BUDGET * 1000 / MAX(r->msg_cost, 1);
+    batch = MAX(REMOTE_MIN_BATCH, MIN(batch, REMOTE_MAX_BATCH));
+    start = time_usec();
+    for (i = 0; i < batch && r->deficit > 0; i++) {
         if (!r->cb_dump) {
             struct ofpbuf *buffer;
 
-            buffer = rconn_recv(rconn);
+            buffer = remote_backlog_pop(backlog);
+            if (buffer == NULL) {
+                buffer = rconn_recv(rconn);
+            }
             if (buffer == NULL) {
                 break;
             } else {
-                struct ofl_msg_header *msg;
-
-                struct sender sender = {.remote = r, .conn_id = conn_id};
-
-                error = ofl_msg_unpack(buffer->data, buffer->size, &msg, &(sender.xid), dp->exp);
+                struct ofp_header *oh = buffer->data;
 
-                if (!error) {
-                    error = handle_control_msg(dp, msg, &sender);
-
-                    if (error) {
-                        ofl_msg_free(msg, dp->exp);
-                    }
+                if (!is_priority_msg(oh->type)) {
+                    r->deficit -= buffer->size;
                 }
-
-                if (error) {
-                    struct ofl_msg_error err =
-                            {{.type = OFPT_ERROR},
-                             .type = ofl_error_type(error),
-                             .code = ofl_error_code(error),
-                             .data_length = buffer->size,
-                             .data        = buffer->data};
-                    dp_send_message(dp, (struct ofl_msg_header *)&err, &sender);
-                }
-
-                ofpbuf_delete(buffer);
+                remote_handle_msg(dp, r, conn_id, buffer);
             }
         } else {
-            if (r->n_txq < TXQ_LIMIT) {
+            if (remote_n_txq(r, r->cb_conn_id) < TXQ_LIMIT) {
                 int error = r->cb_dump(dp, r->cb_aux);
                 if (error <= 0) {
                     if (error) {
@@ -311,17 +536,36 @@ remote_rconn_run(struct datapath *dp, struct remote *r, uint8_t conn_id) {
             }
         }
     }
+
+    if (i > 0) {
+        long long int cost = (time_usec() - start) * 1000 / i;
+        r->msg_cost = (3 * r->msg_cost + cost) / 4;
+    }
+    if (i == batch || r->deficit <= 0 || r->cb_dump) {
+        /* Requests are left unserved: answer the echo requests among them
+         * now, and serve the others in order in the next rounds. */
+        remote_read_ahead(dp, r, conn_id, rconn);
+    }
+    if (i == batch || r->deficit <= 0
+        || (backlog->n > 0 && !r->cb_dump)) {
+        /* There may be messages left, serve them in the next round. */
+        poll_immediate_wake();
+    }
 }
 
 static void
 remote_wait(struct remote *r)
 {
+    size_t i;
+
     rconn_run_wait(r->rconn);
     rconn_recv_wait(r->rconn);
 
-    if (r->rconn_aux) {
-        rconn_run_wait(r->rconn_aux);
-        rconn_recv_wait(r->rconn_aux);
+    for (i = 0; i < DP_MAX_AUX_CONNS; i++) {
+        if (r->aux[i].rconn != NULL) {
+            rconn_run_wait(r->aux[i].rconn);
+            rconn_recv_wait(r->aux[i].rconn);
+        }
     }
 }
 
@@ -329,12 +573,18 @@ static void
 remote_destroy(struct remote *r)
 {
     if (r) {
+        size_t i;
+
         if (r->cb_dump && r->cb_done) {
              r->cb_done(r->cb_aux);
         }
         list_remove(&r->node);
-        if (r->rconn_aux != NULL) {
-            rconn_destroy(r->rconn_aux);
+        remote_backlog_clear(&r->backlog);
+        for (i = 0; i < DP_MAX_AUX_CONNS; i++) {
+            remote_backlog_clear(&r->aux[i].backlog);
+            if (r->aux[i].rconn != NULL) {
+                rconn_destroy(r->aux[i].rconn);
+            }
         }
         rconn_destroy(r->rconn);
         free(r);
@@ -342,15 +592,22 @@ remote_destroy(struct remote *r)
 }
 
 static struct remote *
-remote_create(struct datapath *dp, struct rconn *rconn, struct rconn *rconn_aux)
+remote_create(struct datapath *dp, struct rconn *rconn, struct pvconn *listener)
 {
     size_t i;
     struct remote *remote = xmalloc(sizeof *remote);
     list_push_back(&dp->remotes, &remote->node);
     remote->rconn = rconn;
-    remote->rconn_aux = rconn_aux;
+    remote->listener = listener;
+    memset(remote->aux, 0x00, sizeof remote->aux);
+    memset(&remote->backlog, 0x00, sizeof remote->backlog);
     remote->cb_dump = NULL;
+    remote->cb_conn_id = MAIN_CONNECTION;
     remote->n_txq = 0;
+    remote->n_dropped = 0;
+    remote->n_aux_failover = 0;
+    remote->deficit = 0;
+    remote->msg_cost = REMOTE_INIT_COST;
     remote->role = OFPCR_ROLE_EQUAL;
     /* Set the remote configuration to receive any asynchronous message*/
     for(i = 0; i < 2; i++){
@@ -361,6 +618,32 @@ remote_create(struct datapath *dp, struct rconn *rconn, struct rconn *rconn_aux)
     return remote;
 }
 
+/* Attaches the auxiliary connection 'rconn', accepted on 'l', to the first
+ * remote of the same peer and listener which has no connection with that
+ * auxiliary id yet. The connection is dropped if there is no such remote. */
+static void
+remote_attach_aux(struct datapath *dp, struct aux_listener *l, struct rconn *rconn)
+{
+    uint32_t ip = rconn_get_ip(rconn);
+    struct remote *r;
+
+    LIST_FOR_EACH (r, struct remote, node, &dp->remotes) {
+        struct remote_aux *aux = &r->aux[l->aux_id - 1];
+
+        if (r->listener == l->main && aux->rconn == NULL
+            && rconn_get_ip(r->rconn) == ip) {
+            VLOG_INFO(LOG_MODULE, "%s: auxiliary connection %u established.",
+                      rconn_get_name(r->rconn), l->aux_id);
+            aux->rconn = rconn;
+            aux->n_dropped = 0;
+            return;
+        }
+    }
+    VLOG_WARN_RL(LOG_MODULE, &rl, "No main connection for auxiliary connection %u, dropping.",
+                 l->aux_id);
+    rconn_destroy(rconn);
+}
+
 
 void
 dp_wait(struct datapath *dp)
@@ -375,12 +658,23 @@ dp_wait(struct datapath *dp)
         }
         netdev_recv_wait(p->netdev);
     }
+    if (dp->port_monitor) {
+        netdev_monitor_wait(dp->port_monitor);
+    }
+#if defined(OF_HW_PLAT) && !defined(USE_NETDEV)
+    if (dp->hw_pkt_q) {
+        pkt_queue_wait(dp->hw_pkt_q);
+    }
+#endif
     LIST_FOR_EACH (r, struct remote, node, &dp->remotes) {
         remote_wait(r);
     }
     for (i = 0; i < dp->n_listeners; i++) {
         pvconn_wait(dp->listeners[i]);
     }
+    dp_pending_wait(dp);
+    dp_sflow_wait(dp);
+    dp_stats_shm_wait(dp);
 }
 
 void
@@ -423,21 +717,52 @@ dp_set_max_queues(struct datapath *dp, uint32_t max_queues) {
     dp->max_queues = max_queues;
 }
 
+void
+dp_update_parse_depth(struct datapath *dp, uint8_t depth, int delta) {
+    int i;
+
+    dp->parse_refs[depth] += delta;
+    for (i = NBLINK_PARSE_N - 1; i > NBLINK_PARSE_L2; i--) {
+        if (dp->parse_refs[i] > 0) {
+            break;
+        }
+    }
+    if (dp->parse_depth != i) {
+        VLOG_DBG(LOG_MODULE, "Packet parse depth changed from %u to %d.",
+                 dp->parse_depth, i);
+        dp->parse_depth = i;
+    }
+}
+
 
 static int
 send_openflow_buffer_to_remote(struct ofpbuf *buffer, struct remote *remote) {
     struct rconn* rconn = remote->rconn;
+    int *n_txq = &remote->n_txq;
+    unsigned int *n_dropped = &remote->n_dropped;
+    struct ofp_header *oh = buffer->data;
     int retval;
-    if (buffer->conn_id == PTIN_CONNECTION &&
-        remote->rconn != NULL &&
-        remote->rconn_aux != NULL &&
-        rconn_is_connected(remote->rconn) &&
-        rconn_is_connected(remote->rconn_aux)) {
-            rconn = remote->rconn_aux;
+
+    /* Each connection has its own tx queue, so a backlog of packet-ins on an
+     * auxiliary connection does not hold back replies on the main one. If the
+     * auxiliary connection is down, the main connection is used instead. */
+    if (buffer->conn_id != MAIN_CONNECTION) {
+        struct remote_aux *aux = &remote->aux[buffer->conn_id - 1];
+
+        if (aux->rconn != NULL && rconn_is_connected(aux->rconn)) {
+            rconn     = aux->rconn;
+            n_txq     = &aux->n_txq;
+            n_dropped = &aux->n_dropped;
+        } else {
+            remote->n_aux_failover++;
+        }
     }
-    retval = rconn_send_with_limit(rconn, buffer, &remote->n_txq,
-                                      TXQ_LIMIT);
+    retval = rconn_send_with_limit(rconn, buffer, n_txq,
+                      is_priority_msg(oh->type) ? INT_MAX : TXQ_LIMIT);
 
+    if (retval == EAGAIN) {
+        (*n_dropped)++;
+    }
     if (retval) {
         VLOG_WARN_RL(LOG_MODULE, &rl, "send to %s failed: %s",
                      rconn_get_name(rconn), strerror(retval));
@@ -530,9 +855,30 @@ send_openflow_buffer(struct datapath *dp, struct ofpbuf *buffer,
     }
 }
 
-int
-dp_send_message(struct datapath *dp, struct ofl_msg_header *msg,
-                     const struct sender *sender) {
+/* Returns a hash of the ingress port and flow key of a packet-in, so that all
+ * packet-ins of a flow are sent on the same auxiliary connection. */
+static uint32_t
+packet_in_hash(struct ofl_msg_packet_in *msg) {
+    struct ofl_match *m = (struct ofl_match *)msg->match;
+    struct ofl_match_tlv *f;
+    uint32_t hash = 0;
+
+    if (m == NULL || m->header.type != OFPMT_OXM) {
+        return 0;
+    }
+    /* Fields are combined commutatively, as the hmap order is not defined. */
+    HMAP_FOR_EACH (f, struct ofl_match_tlv, hmap_node, &m->match_fields) {
+        hash += hash_bytes(f->value, OXM_LENGTH(f->header), f->header);
+    }
+    return hash;
+}
+
+/* Packs 'msg' for the connection it is sent on, see dp_send_message().
+ * Returns 0 and stores the packed message in '*bufferp' if successful,
+ * otherwise a positive errno value. */
+static int
+dp_pack_message(struct datapath *dp, struct ofl_msg_header *msg,
+                const struct sender *sender, struct ofpbuf **bufferp) {
     struct ofpbuf *ofpbuf;
     uint8_t *buf;
     size_t buf_size;
@@ -557,24 +903,105 @@ dp_send_message(struct datapath *dp, struct ofl_msg_header *msg,
        1) By default, we send it to the main connection
        2) If there's an associated sender, send the response to the same
           connection the request came from
-       3) If it's a packet in, use the auxiliary connection
+       3) If it's a packet in, use the auxiliary connection selected by
+          the hash of its flow, so that packet-ins of a flow stay in order
     */
     ofpbuf->conn_id = MAIN_CONNECTION;
     if (sender != NULL)
         ofpbuf->conn_id = sender->conn_id;
-    if (msg->type == OFPT_PACKET_IN)
-        ofpbuf->conn_id = PTIN_CONNECTION;
+    if (msg->type == OFPT_PACKET_IN && dp->n_aux_conns > 0)
+        ofpbuf->conn_id = 1 + packet_in_hash((struct ofl_msg_packet_in *)msg)
+                                                  % dp->n_aux_conns;
 
+    *bufferp = ofpbuf;
+    return 0;
+}
+
+int
+dp_send_message(struct datapath *dp, struct ofl_msg_header *msg,
+                     const struct sender *sender) {
+    struct ofpbuf *ofpbuf;
+    int error;
+
+    error = dp_pack_message(dp, msg, sender, &ofpbuf);
+    if (error) {
+        return error;
+    }
     error = send_openflow_buffer(dp, ofpbuf, sender);
     if (error) {
+        /* The buffer has already been freed by rconn_send_with_limit(). */
         VLOG_WARN_RL(LOG_MODULE, &rl, "There was an error sending the message!");
-        /* TODO Zoltan: is delete needed? */
-        ofpbuf_delete(ofpbuf);
         return error;
     }
     return 0;
 }
 
+int
+dp_pack_reply(struct datapath *dp, struct ofl_msg_header *msg,
+              const struct sender *sender, struct remote_backlog *replies) {
+    struct ofpbuf *ofpbuf;
+    int error;
+
+    error = dp_pack_message(dp, msg, sender, &ofpbuf);
+    if (!error) {
+        remote_backlog_push(replies, ofpbuf);
+    }
+    return error;
+}
+
+/* The replies left of a multipart reply, see dp_send_replies(). */
+struct reply_dump {
+    struct sender sender;
+    struct remote_backlog replies;
+};
+
+static int
+reply_dump_cb(struct datapath *dp, void *aux) {
+    struct reply_dump *d = aux;
+    struct ofpbuf *buffer = remote_backlog_pop(&d->replies);
+
+    if (buffer != NULL) {
+        send_openflow_buffer(dp, buffer, &d->sender);
+    }
+    return d->replies.n > 0;
+}
+
+static void
+reply_dump_done(void *aux) {
+    struct reply_dump *d = aux;
+
+    remote_backlog_clear(&d->replies);
+    free(d);
+}
+
+void
+dp_send_replies(struct datapath *dp, struct remote_backlog *replies,
+                const struct sender *sender) {
+    struct remote *r = sender->remote;
+    struct reply_dump *d;
+
+    if (r->cb_dump != NULL) {
+        /* Not expected, as the remote's requests are not read while a dump
+         * is in progress, but then there is no choice but to queue them all
+         * at once. */
+        struct ofpbuf *buffer;
+
+        while ((buffer = remote_backlog_pop(replies)) != NULL) {
+            send_openflow_buffer(dp, buffer, sender);
+        }
+        return;
+    }
+    d = xmalloc(sizeof *d);
+    d->sender = *sender;
+    d->sender.buffer = NULL;
+    d->replies = *replies;
+    memset(replies, 0, sizeof *replies);
+    r->cb_dump = reply_dump_cb;
+    r->cb_done = reply_dump_done;
+    r->cb_aux = d;
+    r->cb_conn_id = sender->conn_id;
+}
+
 ofl_err
 dp_handle_set_desc(struct datapath *dp, struct ofl_exp_openflow_msg_set_dp_desc *msg,
                                             const struct sender *sender UNUSED) {
@@ -53,8 +53,10 @@
 #include "group_table.h"
 #include "timeval.h"
 #include "list.h"
+#include "nbee_link/nbee_link.h"
 
 
+struct pkt_queue;
 struct rconn;
 struct pvconn;
 struct sender;
@@ -82,8 +84,9 @@ struct datapath {
     /* Listeners. */
     struct pvconn **listeners;
     size_t n_listeners;
-    struct pvconn **listeners_aux;
+    struct aux_listener *listeners_aux;
     size_t n_listeners_aux;
+    uint8_t n_aux_conns;        /* Auxiliary connections per remote. */
     
     time_t last_timeout;
 
@@ -95,15 +98,55 @@ struct datapath {
 
     struct meter_table *meters; /* Meter tables */
 
+    /* Depth packets are parsed to for flow table lookups: the deepest layer
+     * referenced by an installed match.  'parse_refs' counts the flow entries
+     * needing each enum nblink_parse_depth. */
+    uint8_t          parse_depth;
+    unsigned int     parse_refs[NBLINK_PARSE_N];
+
     struct ofl_config config; /* Configuration, set from controller. */
 
     /* Switch ports. */
     /* NOTE: ports are numbered starting at 1 in OF 1.1 */
     uint32_t         max_queues; /* used when creating ports */
-    struct sw_port   ports[DP_MAX_PORTS + 1];
+    struct sw_port **ports;       /* Indexed by port number, NULL if unused. */
+    size_t           ports_size;  /* Number of elements in 'ports'. */
     struct sw_port  *local_port;  /* OFPP_LOCAL port, if any. */
     struct list      port_list; /* All ports, including local_port. */
     size_t           ports_num;
+    /* Ports OFPP_FLOOD and OFPP_ALL output to (before excluding the input
+     * port), rebuilt by dp_ports_update_output() when a port is added or its
+     * configuration changes. */
+    struct sw_port **flood_ports;
+    size_t           n_flood_ports;
+    struct sw_port **all_ports;
+    size_t           n_all_ports;
+    bool             tx_batching; /* Output is queued for dp_ports_flush_tx(). */
+    struct list      tx_ports;    /* Ports with output queued that way. */
+    unsigned int     rx_burst;    /* Packets received from a port per
+                                   * dp_ports_run() call. */
+    uint64_t         rx_polls;      /* Calls to dp_ports_run(). */
+    uint64_t         rx_busy_polls; /* Those that filled a port's burst. */
+    /* rtnetlink monitor of the ports' link state, null if unavailable. */
+    struct netdev_monitor *port_monitor;
+
+    /* Statistics exported through shared memory, null if not exported. */
+    struct dp_stats_shm *stats_shm;
+
+    /* sFlow exporter, null if sFlow is disabled. */
+    struct dp_sflow *sflow;
+
+    /* Memory for packet buffers, null to malloc() them. */
+    struct pktmem *pktmem;
+
+    /* Flows learned by the packet going through the pipeline. */
+    struct dp_learn *learn;
+
+    /* Flows whose table misses await a flow entry from the controller. */
+    struct dp_pending *pending;
+
+    /* Addresses answered for in ARP and neighbor discovery. */
+    struct dp_responder *responder;
 
     /* Experimenter handling. */
     struct ofl_exp  *exp;
@@ -114,34 +157,82 @@ struct datapath {
      * in the driver structure
      */
     of_hw_driver_t *hw_drv;
-    struct hw_pkt_q_entry *hw_pkt_list_head, *hw_pkt_list_tail;
+    struct pkt_queue *hw_pkt_q; /* Packets received by the driver's thread. */
+    uint64_t hw_pkt_q_dropped;  /* Drops on 'hw_pkt_q' logged so far. */
 #endif
 };
 
+/* A listener for auxiliary connections. Connections accepted on it are
+ * attached to a remote accepted on 'main', from the same peer. */
+struct aux_listener {
+    struct pvconn *pvconn;
+    struct pvconn *main;        /* Listener of the main connections. */
+    uint8_t aux_id;             /* Auxiliary id of accepted connections. */
+};
+
 /* The origin of a received OpenFlow message, to enable sending a reply. */
 struct sender {
     struct remote *remote;      /* The device that sent the message. */
     uint8_t conn_id;            /* The connection that sent the message */
     uint32_t xid;               /* The OpenFlow transaction ID. */
+    struct ofpbuf **buffer;     /* The received message, whose packet data
+                                 * the message refers to in place.  A handler
+                                 * that keeps the data sets '*buffer' to
+                                 * null.  Null for internal messages. */
+};
+
+#define MAIN_CONNECTION 0
+#define DP_MAX_AUX_CONNS 8      /* Max auxiliary connections per remote. */
+
+/* Requests read from a connection ahead of its remote's budget, so that echo
+ * requests behind them can be answered, or the messages of a multipart reply
+ * waiting to be sent. Linked through ofpbuf 'next'. */
+struct remote_backlog {
+    struct ofpbuf *head;
+    struct ofpbuf *tail;
+    size_t n;
+};
+
+/* An auxiliary connection of a remote, identified by its position in the
+ * remote's 'aux' array (auxiliary_id - 1). */
+struct remote_aux {
+    struct rconn *rconn;        /* NULL if not connected. */
+    int n_txq;                  /* Number of packets queued for tx on rconn. */
+    unsigned int n_dropped;     /* Messages dropped on a full tx queue. */
+    struct remote_backlog backlog;
 };
 
 /* A connection to a secure channel. */
 struct remote {
     struct list node;
     struct rconn *rconn;
-    struct rconn *rconn_aux;
-    
+    struct pvconn *listener;    /* Listener the main connection came from. */
+    struct remote_aux aux[DP_MAX_AUX_CONNS];
+    struct remote_backlog backlog; /* Backlog of the main connection. */
+
 #define TXQ_LIMIT 128           /* Max number of packets to queue for tx. */
     int n_txq;                  /* Number of packets queued for tx on rconn. */
+    /* The remote gets these, and its auxiliary connections' n_dropped, in
+     * the rx-stats experimenter reply. */
+    unsigned int n_dropped;     /* Messages dropped on a full tx queue. */
+    unsigned int n_aux_failover; /* Packet-ins sent on the main connection
+                                    because their auxiliary one was down. */
+
+    int deficit;                /* Bytes of requests left to process in
+                                   this scheduling round. */
+    long long int msg_cost;     /* Average cost of a request, in ns. */
 
     /* Support for reliable, multi-message replies to requests.
      *
      * If an incoming request needs to have a reliable reply that might
-     * require multiple messages, it can use remote_start_dump() to set up
-     * a callback that will be called as buffer space for replies. */
+     * require multiple messages, it can use dp_send_replies() to set up
+     * a callback that will be called as buffer space for replies becomes
+     * available on connection 'cb_conn_id'.  The remote's requests are not
+     * read until the callback is done. */
     int (*cb_dump)(struct datapath *, void *aux);
     void (*cb_done)(void *aux);
     void *cb_aux;
+    uint8_t cb_conn_id;
 
     uint32_t role; /*OpenFlow controller role.*/
     struct ofl_async_config config;  /* Asynchronous messages configuration, 
@@ -152,8 +243,12 @@ struct remote {
 struct datapath *
 dp_new(void);
 
+/* Adds a listener for main connections, and 'n_aux' listeners for their
+ * auxiliary connections. The i'th auxiliary listener accepts connections
+ * with auxiliary_id i+1; any of them may be NULL. */
 void
-dp_add_pvconn(struct datapath *dp, struct pvconn *pvconn, struct pvconn *pvconn_aux);
+dp_add_pvconn(struct datapath *dp, struct pvconn *pvconn,
+              struct pvconn **pvconn_aux, size_t n_aux);
 
 /* Executes the datapath. The datapath works if this function is run
  * repeatedly. */
@@ -189,6 +284,11 @@ dp_set_serial_num(struct datapath *dp, char *serial_num);
 void
 dp_set_max_queues(struct datapath *dp, uint32_t max_queues);
 
+/* Adds 'delta' flow entries needing packets parsed to 'depth', and updates
+ * the datapath's parse depth accordingly. */
+void
+dp_update_parse_depth(struct datapath *dp, uint8_t depth, int delta);
+
 
 /* Sends the given OFLib message to the connection represented by sender,
  * or to all open connections, if sender is null. */
@@ -196,6 +296,19 @@ int
 dp_send_message(struct datapath *dp, struct ofl_msg_header *msg,
                      const struct sender *sender);
 
+/* Packs 'msg', one message of a multipart reply to 'sender', and appends it
+ * to 'replies', to be sent by dp_send_replies(). */
+int
+dp_pack_reply(struct datapath *dp, struct ofl_msg_header *msg,
+              const struct sender *sender, struct remote_backlog *replies);
+
+/* Sends 'replies' to 'sender' one at a time, as the tx queue of its
+ * connection drains, so that none of them is dropped on a full queue.
+ * Empties 'replies'. */
+void
+dp_send_replies(struct datapath *dp, struct remote_backlog *replies,
+                const struct sender *sender);
+
 
 
 /* Handles a set description (openflow experimenter) message */
@@ -36,7 +36,10 @@
 #include "dp_exp.h"
 #include "dp_actions.h"
 #include "dp_buffers.h"
+#include "dp_pending.h"
+#include "dp_sflow.h"
 #include "datapath.h"
+#include "gso.h"
 #include "oflib/ofl.h"
 #include "oflib/ofl-actions.h"
 #include "oflib/ofl-log.h"
@@ -68,6 +71,56 @@ output(struct packet *pkt, struct ofl_action_output *action) {
     }
 }
 
+/* Returns transport checksum 'csum' of 'pkt' updated for a change from 'old'
+ * to 'new' in an address covered by the pseudo-header.  A partial checksum
+ * holds the uncomplemented pseudo-header sum, so it is updated inversely. */
+static uint16_t
+l4_csum_addr32(const struct packet *pkt, uint16_t csum, uint32_t old,
+               uint32_t new)
+{
+    if (pkt->buffer->offload.flags & OFPBUF_CSUM_PARTIAL) {
+        return ~recalc_csum32(~csum, old, new);
+    }
+    return recalc_csum32(csum, old, new);
+}
+
+/* Returns transport checksum 'csum' of 'pkt' updated for a change from 'old'
+ * to 'new' in a transport header field.  A partial checksum does not cover
+ * the header yet, so it is left alone. */
+static uint16_t
+l4_csum_field16(const struct packet *pkt, uint16_t csum, uint16_t old,
+                uint16_t new)
+{
+    if (pkt->buffer->offload.flags & OFPBUF_CSUM_PARTIAL) {
+        return csum;
+    }
+    return recalc_csum16(csum, old, new);
+}
+
+/* Updates the TCP or UDP checksum of 'pkt' for a change of an IPv6 address
+ * from 'old' to 'new'. */
+static void
+l4_csum_addr128(struct packet *pkt, const void *old, const void *new)
+{
+    uint16_t *csum;
+    size_t i;
+
+    if (pkt->handle_std->proto->tcp != NULL) {
+        csum = &pkt->handle_std->proto->tcp->tcp_csum;
+    } else if (pkt->handle_std->proto->udp != NULL) {
+        csum = &pkt->handle_std->proto->udp->udp_csum;
+    } else {
+        return;
+    }
+    for (i = 0; i < 4; i++) {
+        uint32_t old_u32, new_u32;
+
+        memcpy(&old_u32, (const uint8_t *) old + i * 4, 4);
+        memcpy(&new_u32, (const uint8_t *) new + i * 4, 4);
+        *csum = l4_csum_addr32(pkt, *csum, old_u32, new_u32);
+    }
+}
+
 /* Executes a set field action.
 TODO: if we use the the index structure to the packet fields
 revalidation is not needed  */
@@ -141,11 +194,11 @@ set_field(struct packet *pkt, struct ofl_action_set_field *act )
                 /*Reconstruct TCP or UDP checksum*/
                 if (pkt->handle_std->proto->tcp != NULL) {
                     struct tcp_header *tcp = pkt->handle_std->proto->tcp;
-                    tcp->tcp_csum = recalc_csum32(tcp->tcp_csum,
+                    tcp->tcp_csum = l4_csum_addr32(pkt, tcp->tcp_csum,
                         ipv4->ip_src, *((uint32_t*) act->field->value));
                 } else if (pkt->handle_std->proto->udp != NULL) {
                     struct udp_header *udp = pkt->handle_std->proto->udp;
-                    udp->udp_csum = recalc_csum32(udp->udp_csum,
+                    udp->udp_csum = l4_csum_addr32(pkt, udp->udp_csum,
                         ipv4->ip_src, *((uint32_t*) act->field->value));
                 }
 
@@ -161,11 +214,11 @@ set_field(struct packet *pkt, struct ofl_action_set_field *act )
                 /*Reconstruct TCP or UDP checksum*/
                 if (pkt->handle_std->proto->tcp != NULL) {
                     struct tcp_header *tcp = pkt->handle_std->proto->tcp;
-                    tcp->tcp_csum = recalc_csum32(tcp->tcp_csum,
+                    tcp->tcp_csum = l4_csum_addr32(pkt, tcp->tcp_csum,
                         ipv4->ip_dst, *((uint32_t*) act->field->value));
                 } else if (pkt->handle_std->proto->udp != NULL) {
                     struct udp_header *udp = pkt->handle_std->proto->udp;
-                    udp->udp_csum = recalc_csum32(udp->udp_csum,
+                    udp->udp_csum = l4_csum_addr32(pkt, udp->udp_csum,
                         ipv4->ip_dst, *((uint32_t*) act->field->value));
                 }
 
@@ -179,7 +232,8 @@ set_field(struct packet *pkt, struct ofl_action_set_field *act )
                 struct tcp_header *tcp = pkt->handle_std->proto->tcp;
                 uint16_t *v = (uint16_t*) act->field->value;
                 *v = htons(*v);
-                tcp->tcp_csum = recalc_csum16(tcp->tcp_csum, tcp->tcp_src,*v);
+                tcp->tcp_csum = l4_csum_field16(pkt, tcp->tcp_csum,
+                                                tcp->tcp_src, *v);
                 memcpy(&tcp->tcp_src, v, OXM_LENGTH(act->field->header));
 
                 break;
@@ -188,7 +242,8 @@ set_field(struct packet *pkt, struct ofl_action_set_field *act )
                 struct tcp_header *tcp = pkt->handle_std->proto->tcp;
                 uint16_t *v = (uint16_t*) act->field->value;
                 *v = htons(*v);
-                tcp->tcp_csum = recalc_csum16(tcp->tcp_csum, tcp->tcp_dst,*v);
+                tcp->tcp_csum = l4_csum_field16(pkt, tcp->tcp_csum,
+                                                tcp->tcp_dst, *v);
                 memcpy(&tcp->tcp_dst, v, OXM_LENGTH(act->field->header));
 
                 break;
@@ -197,7 +252,8 @@ set_field(struct packet *pkt, struct ofl_action_set_field *act )
                 struct udp_header *udp = pkt->handle_std->proto->udp;
                 uint16_t *v = (uint16_t*) act->field->value;
                 *v = htons(*v);
-                udp->udp_csum = recalc_csum16(udp->udp_csum, udp->udp_dst, *v);
+                udp->udp_csum = l4_csum_field16(pkt, udp->udp_csum,
+                                                udp->udp_src, *v);
                 memcpy(&udp->udp_src, v, OXM_LENGTH(act->field->header));
                 break;
             }
@@ -205,7 +261,8 @@ set_field(struct packet *pkt, struct ofl_action_set_field *act )
                 struct udp_header *udp = pkt->handle_std->proto->udp;
                 uint16_t *v = (uint16_t*) act->field->value;
                 *v = htons(*v);
-                udp->udp_csum = recalc_csum16(udp->udp_csum, udp->udp_dst, *v);
+                udp->udp_csum = l4_csum_field16(pkt, udp->udp_csum,
+                                                udp->udp_dst, *v);
                 memcpy(&udp->udp_dst, v, OXM_LENGTH(act->field->header));
                 break;
             }
@@ -255,11 +312,15 @@ set_field(struct packet *pkt, struct ofl_action_set_field *act )
                         break;
             }
             case OXM_OF_IPV6_SRC:{
+                l4_csum_addr128(pkt, &pkt->handle_std->proto->ipv6->ipv6_src,
+                                act->field->value);
                 memcpy(&pkt->handle_std->proto->ipv6->ipv6_src,
                         act->field->value, OXM_LENGTH(act->field->header));
                         break;
             }
             case OXM_OF_IPV6_DST:{
+                l4_csum_addr128(pkt, &pkt->handle_std->proto->ipv6->ipv6_dst,
+                                act->field->value);
                 memcpy(&pkt->handle_std->proto->ipv6->ipv6_dst,
                         act->field->value, OXM_LENGTH(act->field->header));
                         break;
@@ -909,7 +970,8 @@ dp_execute_action(struct packet *pkt,
 
 void
 dp_execute_action_list(struct packet *pkt,
-                size_t actions_num, struct ofl_action_header **actions, uint64_t cookie) {
+                size_t actions_num, struct ofl_action_header **actions, uint64_t cookie,
+                bool last) {
     size_t i;
 
     VLOG_DBG_RL(LOG_MODULE, &rl, "Executing action list.");
@@ -931,40 +993,64 @@ dp_execute_action_list(struct packet *pkt,
             pkt->out_port_max_len = 0;
             pkt->out_queue = 0;
             VLOG_DBG_RL(LOG_MODULE, &rl, "Port action; sending to port (%u).", port);
-            dp_actions_output_port(pkt, port, queue, max_len, cookie);
+            dp_actions_output_port(pkt, port, queue, max_len, cookie,
+                                   last && i + 1 == actions_num);
         }
 
     }
 }
 
 
+/* Outputs the packet on a single port.  The last use of the buffer of a
+ * packet not saved for the controller hands it over to the port. */
+static void
+dp_actions_output(struct packet *pkt, uint32_t port, uint32_t queue,
+                  bool last) {
+    if (last && pkt->buffer_id == NO_BUFFER) {
+        dp_ports_output_take(pkt->dp, pkt->buffer, port, queue);
+        pkt->buffer = NULL;
+    } else {
+        dp_ports_output(pkt->dp, pkt->buffer, port, queue);
+    }
+}
+
 void
-dp_actions_output_port(struct packet *pkt, uint32_t out_port, uint32_t out_queue, uint16_t max_len, uint64_t cookie) {
+dp_actions_output_port(struct packet *pkt, uint32_t out_port, uint32_t out_queue, uint16_t max_len, uint64_t cookie,
+                       bool last) {
 
+    if (pkt->sflow != NULL) {
+        dp_sflow_sample_output(pkt->sflow, out_port);
+    }
     switch (out_port) {
         case (OFPP_TABLE): {
             if (pkt->packet_out) {
                 // NOTE: hackish; makes sure packet cannot be resubmit to pipeline again.
                 pkt->packet_out = false;
-                pipeline_process_packet(pkt->dp->pipeline, pkt);
+                /* The pipeline consumes the packet it is given, and the
+                 * caller still destroys 'pkt'. */
+                pipeline_process_packet(pkt->dp->pipeline, packet_clone(pkt));
             } else {
                 VLOG_WARN_RL(LOG_MODULE, &rl, "Trying to resubmit packet to pipeline.");
             }
             break;
         }
         case (OFPP_IN_PORT): {
-            dp_ports_output(pkt->dp, pkt->buffer, pkt->in_port, 0);
+            dp_actions_output(pkt, pkt->in_port, 0, last);
             break;
         }
         case (OFPP_CONTROLLER): {
             struct ofl_msg_packet_in msg;
             msg.header.type = OFPT_PACKET_IN;
-            msg.total_len   = pkt->buffer->size;
             msg.reason = pkt->handle_std->table_miss? OFPR_NO_MATCH:OFPR_ACTION;
             msg.table_id = pkt->table_id;
             msg.data        = pkt->buffer->data;
             msg.cookie = cookie;
 
+            /* The controller is still setting up the flow of the packet. */
+            if (msg.reason == OFPR_NO_MATCH && dp_pending_hold(pkt->dp, pkt)) {
+                break;
+            }
+
             if (pkt->dp->config.miss_send_len != OFPCML_NO_BUFFER){
                 dp_buffers_save(pkt->dp->buffers, pkt);
                 msg.buffer_id = pkt->buffer_id;
@@ -975,14 +1061,14 @@ dp_actions_output_port(struct packet *pkt, uint32_t out_port, uint32_t out_queue
                 msg.data_length =  pkt->buffer->size;
             }
 
-            if (!pkt->handle_std->valid){
-                packet_handle_std_validate(pkt->handle_std);
-            }
+            /* The controller gets every field, however shallow the
+               installed flows let the packet be parsed. */
+            packet_handle_std_validate_full(pkt->handle_std);
             /* In this implementation the fields in_port and in_phy_port
                 always will be the same, because we are not considering logical
                 ports*/
             msg.match = (struct ofl_match_header*) &pkt->handle_std->match;
-            dp_send_message(pkt->dp, (struct ofl_msg_header *)&msg, NULL);
+            dp_actions_send_packet_in(pkt, &msg);
             break;
         }
         case (OFPP_FLOOD):
@@ -998,12 +1084,36 @@ dp_actions_output_port(struct packet *pkt, uint32_t out_port, uint32_t out_queue
                 VLOG_WARN_RL(LOG_MODULE, &rl, "can't directly forward to input port.");
             } else {
                 VLOG_DBG_RL(LOG_MODULE, &rl, "Outputting packet on port %u.", out_port);
-                dp_ports_output(pkt->dp, pkt->buffer, out_port, out_queue);
+                dp_actions_output(pkt, out_port, out_queue, last);
             }
         }
     }
 }
 
+void
+dp_actions_send_packet_in(struct packet *pkt, struct ofl_msg_packet_in *msg)
+{
+    struct ofpbuf *seg, *next;
+
+    if (msg->buffer_id != OFP_NO_BUFFER
+        || pkt->buffer->offload.gso_type == OFPBUF_GSO_NONE) {
+        gso_complete_csum(pkt->buffer);
+        msg->total_len = MIN(pkt->buffer->size, UINT16_MAX);
+        dp_send_message(pkt->dp, (struct ofl_msg_header *) msg, NULL);
+        return;
+    }
+
+    /* A whole super-frame would not fit in one message. */
+    for (seg = gso_segment(pkt->buffer); seg != NULL; seg = next) {
+        next = seg->next;
+        msg->total_len = seg->size;
+        msg->data_length = seg->size;
+        msg->data = seg->data;
+        dp_send_message(pkt->dp, (struct ofl_msg_header *) msg, NULL);
+        ofpbuf_delete(seg);
+    }
+}
+
 bool
 dp_actions_list_has_out_port(size_t actions_num, struct ofl_action_header **actions, uint32_t port) {
     size_t i;
@@ -1019,6 +1129,19 @@ dp_actions_list_has_out_port(size_t actions_num, struct ofl_action_header **acti
     return false;
 }
 
+bool
+dp_actions_list_is_output_only(size_t actions_num, struct ofl_action_header **actions) {
+    size_t i;
+
+    for (i=0; i < actions_num; i++) {
+        if (actions[i]->type != OFPAT_OUTPUT
+            || ((struct ofl_action_output *)actions[i])->port == OFPP_TABLE) {
+            return false;
+        }
+    }
+    return true;
+}
+
 bool
 dp_actions_list_has_out_group(size_t actions_num, struct ofl_action_header **actions, uint32_t group) {
     size_t i;
@@ -1055,6 +1178,14 @@ dp_actions_validate(struct datapath *dp, size_t actions_num, struct ofl_action_h
                 return ofl_error(OFPET_BAD_ACTION, OFPBAC_BAD_OUT_GROUP);
             }
         }
+        if (actions[i]->type == OFPAT_EXPERIMENTER) {
+            ofl_err error;
+
+            error = dp_exp_action_validate(dp, (struct ofl_action_experimenter *)actions[i]);
+            if (error) {
+                return error;
+            }
+        }
     }
 
     return 0;
@@ -48,19 +48,37 @@ dp_execute_action(struct packet *pkt,
                   struct ofl_action_header *action);
 
 
-/* Executes the list of action on the given packet. */
+/* Executes the list of action on the given packet.  If 'last' is true, the
+ * packet is destroyed right after the list, so an output by the last action
+ * may take its buffer. */
 void
 dp_execute_action_list(struct packet *pkt,
-                size_t actions_num, struct ofl_action_header **actions, uint64_t cookie);
+                size_t actions_num, struct ofl_action_header **actions, uint64_t cookie,
+                bool last);
 
-/* Outputs the packet on the given port and queue. */
+/* Outputs the packet on the given port and queue.  If 'last' is true, the
+ * packet is destroyed right after the output, which then hands the packet's
+ * buffer to the port instead of a copy of it. */
 void
-dp_actions_output_port(struct packet *pkt, uint32_t out_port, uint32_t out_queue, uint16_t max_len, uint64_t cookie);
+dp_actions_output_port(struct packet *pkt, uint32_t out_port, uint32_t out_queue, uint16_t max_len, uint64_t cookie,
+                       bool last);
+
+/* Sends 'msg', a packet_in for the packet filled in but for its total length,
+ * to the controllers, with the packet as it would appear on the wire: with a
+ * complete checksum, and if it is an unbuffered TCP super-frame, as one
+ * packet_in per segment. */
+void
+dp_actions_send_packet_in(struct packet *pkt, struct ofl_msg_packet_in *msg);
 
 /* Returns true if the given list of actions has an output action to the port. */
 bool
 dp_actions_list_has_out_port(size_t actions_num, struct ofl_action_header **actions, uint32_t port);
 
+/* Returns true if the given list of actions only outputs the packet, to ports
+ * other than OFPP_TABLE, so that no action looks at the packet's fields. */
+bool
+dp_actions_list_is_output_only(size_t actions_num, struct ofl_action_header **actions);
+
 /* Returns true if the given list of actions has an group action to the group. */
 bool
 dp_actions_list_has_out_group(size_t actions_num, struct ofl_action_header **actions, uint32_t group);
@@ -34,15 +34,19 @@
 #include "dp_control.h"
 #include "dp_actions.h"
 #include "dp_buffers.h"
+#include "dp_learn.h"
 #include "dp_ports.h"
 #include "group_table.h"
 #include "meter_table.h"
 #include "packets.h"
 #include "pipeline.h"
+#include "pktmem.h"
 #include "oflib/ofl.h"
 #include "oflib/ofl-messages.h"
 #include "oflib/ofl-log.h"
+#include "oflib-exp/ofl-exp-openflow.h"
 #include "openflow/openflow.h"
+#include "openflow/openflow-ext.h"
 
 #include "vlog.h"
 #define LOG_MODULE VLM_dp_ctrl
@@ -121,6 +125,18 @@ handle_control_set_config(struct datapath *dp, struct ofl_msg_set_config *msg,
 }
 
 /* Handles packet out messages. */
+/* Creates the packet of a packet_out from 'buf', to be executed with
+ * 'actions'. */
+static struct packet *
+packet_out_create(struct datapath *dp, uint32_t in_port, struct ofpbuf *buf,
+                  size_t actions_num, struct ofl_action_header **actions) {
+    /* Nothing looks at the fields of a packet that is only output. */
+    if (dp_actions_list_is_output_only(actions_num, actions)) {
+        return packet_create_unparsed(dp, in_port, buf, true, time_msec());
+    }
+    return packet_create(dp, in_port, buf, true, time_msec());
+}
+
 static ofl_err
 handle_control_packet_out(struct datapath *dp, struct ofl_msg_packet_out *msg,
                                                 const struct sender *sender) {
@@ -137,14 +153,39 @@ handle_control_packet_out(struct datapath *dp, struct ofl_msg_packet_out *msg,
 
     if (msg->buffer_id == NO_BUFFER) {
         struct ofpbuf *buf;
-        /* NOTE: the created packet will take the ownership of data in msg. */
-        buf = ofpbuf_new(0);
-        ofpbuf_use(buf, msg->data, msg->data_length);
-        ofpbuf_put_uninit(buf, msg->data_length);
-        pkt = packet_create(dp, msg->in_port, buf, true);
+        if (msg->data_in_place && sender->buffer != NULL) {
+            /* Take over the received message and leave the data where it
+             * is.  The packet_out header and actions before the data, and
+             * the vconn's headroom, become headroom for the headers that
+             * actions push. */
+            buf = *sender->buffer;
+            *sender->buffer = NULL;
+            buf->data = msg->data;
+            buf->size = msg->data_length;
+        } else if (msg->data_in_place || dp->pktmem != NULL) {
+            /* Copy the data, into packet memory if there is any, with the
+             * headroom of a received packet. */
+            buf = pktmem_ofpbuf_clone_data(dp->pktmem, msg->data,
+                                           msg->data_length,
+                                           DP_PORTS_HEADROOM);
+            if (!msg->data_in_place) {
+                free(msg->data);
+            }
+        } else {
+            /* NOTE: the created packet will take the ownership of data in
+             * msg. */
+            buf = ofpbuf_new(0);
+            ofpbuf_use(buf, msg->data, msg->data_length);
+            ofpbuf_put_uninit(buf, msg->data_length);
+        }
+        pkt = packet_out_create(dp, msg->in_port, buf,
+                                msg->actions_num, msg->actions);
     } else {
         /* NOTE: in this case packet should not have data */
         pkt = dp_buffers_retrieve(dp->buffers, msg->buffer_id);
+        if (pkt != NULL) {
+            pkt->timestamp = time_msec();
+        }
     }
 
     if (pkt == NULL) {
@@ -152,13 +193,132 @@ handle_control_packet_out(struct datapath *dp, struct ofl_msg_packet_out *msg,
         return ofl_error(OFPET_BAD_REQUEST, OFPBRC_BUFFER_EMPTY);
     }
     
-    dp_execute_action_list(pkt, msg->actions_num, msg->actions, 0xffffffffffffffff);
+    dp_execute_action_list(pkt, msg->actions_num, msg->actions, 0xffffffffffffffff,
+                           true);
+    dp_learn_flush(dp);
 
     packet_destroy(pkt);
     ofl_msg_free_packet_out(msg, false, dp->exp);
     return 0;
 }
 
+/* Sends the error of entry 'entry' of a packet_out batch. */
+static void
+send_packet_out_batch_error(struct datapath *dp, ofl_err error, size_t entry,
+                            const struct sender *sender) {
+    struct openflow_ext_packet_out_batch_error data;
+    struct ofl_msg_error err =
+            {{.type = OFPT_ERROR},
+             .type = ofl_error_type(error),
+             .code = ofl_error_code(error),
+             .data_length = sizeof(data),
+             .data        = (uint8_t *)&data};
+
+    if (sender->buffer != NULL && *sender->buffer != NULL) {
+        memcpy(&data.header, (*sender->buffer)->data, sizeof(data.header));
+    } else {
+        data.header.header.version = OFP_VERSION;
+        data.header.header.type    = OFPT_EXPERIMENTER;
+        data.header.header.length  = htons(sizeof(struct openflow_ext_packet_out_batch));
+        data.header.header.xid     = htonl(sender->xid);
+        data.header.vendor         = htonl(OPENFLOW_VENDOR_ID);
+        data.header.subtype        = htonl(OFP_EXT_PACKET_OUT_BATCH);
+    }
+    data.entry = htonl(entry);
+    memset(data.pad, 0x00, sizeof(data.pad));
+
+    dp_send_message(dp, (struct ofl_msg_header *)&err, sender);
+}
+
+ofl_err
+handle_control_packet_out_batch(struct datapath *dp,
+                                struct ofl_exp_openflow_msg_packet_out_batch *msg,
+                                const struct sender *sender) {
+    ofl_err *errors;
+    ofl_err error = 0;
+    size_t i;
+
+    if (sender->remote->role == OFPCR_ROLE_SLAVE)
+        return ofl_error(OFPET_BAD_REQUEST, OFPBRC_IS_SLAVE);
+
+    /* Validate all the entries before executing any; entries sharing the
+     * action list of the previous one share its result. */
+    errors = xmalloc(msg->entries_num * sizeof *errors);
+    for (i = 0; i < msg->entries_num; i++) {
+        struct ofl_exp_openflow_packet_out_entry *e = &msg->entries[i];
+
+        if (i == 0 || e->actions != msg->entries[i - 1].actions) {
+            error = dp_actions_validate(dp, e->actions_num, e->actions);
+        }
+        errors[i] = error;
+    }
+
+    /* Execute them in one pass, sending the output of all of them
+     * together. */
+    dp->tx_batching = true;
+    for (i = 0; i < msg->entries_num; i++) {
+        struct ofl_exp_openflow_packet_out_entry *e = &msg->entries[i];
+        struct packet *pkt;
+
+        if (errors[i]) {
+            continue;
+        }
+
+        if (e->buffer_id == NO_BUFFER) {
+            struct ofpbuf *buf;
+
+            if (msg->data_in_place && sender->buffer != NULL
+                && i == msg->entries_num - 1) {
+                /* The last entry takes over the received message, as
+                 * handle_control_packet_out() does; the entries before it
+                 * are done with their data. */
+                buf = *sender->buffer;
+                *sender->buffer = NULL;
+                buf->data = e->data;
+                buf->size = e->data_length;
+            } else if (msg->data_in_place || dp->pktmem != NULL) {
+                /* Copy the data, into packet memory if there is any. */
+                buf = pktmem_ofpbuf_clone_data(dp->pktmem, e->data,
+                                               e->data_length,
+                                               DP_PORTS_HEADROOM);
+            } else {
+                /* The packet takes the ownership of the data. */
+                buf = ofpbuf_new(0);
+                ofpbuf_use(buf, e->data, e->data_length);
+                ofpbuf_put_uninit(buf, e->data_length);
+                e->data = NULL;
+            }
+            pkt = packet_out_create(dp, e->in_port, buf,
+                                    e->actions_num, e->actions);
+        } else {
+            pkt = dp_buffers_retrieve(dp->buffers, e->buffer_id);
+            if (pkt == NULL) {
+                errors[i] = ofl_error(OFPET_BAD_REQUEST, OFPBRC_BUFFER_EMPTY);
+                continue;
+            }
+            pkt->timestamp = time_msec();
+        }
+
+        dp_execute_action_list(pkt, e->actions_num, e->actions, 0xffffffffffffffff,
+                               true);
+        packet_destroy(pkt);
+    }
+    dp_learn_flush(dp);
+    dp->tx_batching = false;
+    dp_ports_flush_tx(dp);
+
+    for (i = 0; i < msg->entries_num; i++) {
+        if (errors[i]) {
+            VLOG_DBG_RL(LOG_MODULE, &rl, "packet_out batch entry %zu failed.", i);
+            send_packet_out_batch_error(dp, errors[i], i, sender);
+        }
+    }
+    free(errors);
+
+    ofl_msg_free((struct ofl_msg_header *)msg, dp->exp);
+    return 0;
+}
+
 
 /* Handles desc stats request messages. */
 static ofl_err
@@ -35,6 +35,7 @@
 #include "datapath.h"
 #include "oflib/ofl.h"
 #include "oflib/ofl-messages.h"
+#include "oflib-exp/ofl-exp-openflow.h"
 
 
 /****************************************************************************
@@ -49,5 +50,12 @@ ofl_err
 handle_control_msg(struct datapath *dp, struct ofl_msg_header *msg,
                    const struct sender *sender);
 
+/* Handles a batch of packet_outs (openflow experimenter message), sending an
+ * error for each entry that fails. */
+ofl_err
+handle_control_packet_out_batch(struct datapath *dp,
+                                struct ofl_exp_openflow_msg_packet_out_batch *msg,
+                                const struct sender *sender);
+
 
 #endif /* DP_CONTROL_H */
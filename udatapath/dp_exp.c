@@ -32,7 +32,10 @@
 #include <stdlib.h>
 #include <string.h>
 #include "datapath.h"
+#include "dp_control.h"
 #include "dp_exp.h"
+#include "dp_learn.h"
+#include "dp_responder.h"
 #include "packet.h"
 #include "oflib/ofl.h"
 #include "oflib/ofl-actions.h"
@@ -50,10 +53,66 @@
 static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(60, 60);
 
 void
-dp_exp_action(struct packet * pkt UNUSED, struct ofl_action_experimenter *act) {
+dp_exp_action(struct packet *pkt, struct ofl_action_experimenter *act) {
+    if (act->experimenter_id == NX_VENDOR_ID) {
+        struct ofl_exp_nicira_act_header *nx = (struct ofl_exp_nicira_act_header *)act;
+
+        switch (nx->subtype) {
+            case (NXAST_LEARN): {
+                dp_learn_execute(pkt, (struct ofl_exp_nicira_act_learn *)act);
+                return;
+            }
+            default: {
+                break;
+            }
+        }
+    }
+    if (act->experimenter_id == OPENFLOW_VENDOR_ID) {
+        struct ofl_exp_openflow_act_header *ext = (struct ofl_exp_openflow_act_header *)act;
+
+        switch (ext->subtype) {
+            case (OFP_EXT_ACT_RESPOND): {
+                dp_responder_execute(pkt, (struct ofl_exp_openflow_act_respond *)act);
+                return;
+            }
+            default: {
+                break;
+            }
+        }
+    }
 	VLOG_WARN_RL(LOG_MODULE, &rl, "Trying to execute unknown experimenter action (%u).", act->experimenter_id);
 }
 
+ofl_err
+dp_exp_action_validate(struct datapath *dp, struct ofl_action_experimenter *act) {
+    if (act->experimenter_id == NX_VENDOR_ID) {
+        struct ofl_exp_nicira_act_header *nx = (struct ofl_exp_nicira_act_header *)act;
+
+        switch (nx->subtype) {
+            case (NXAST_LEARN): {
+                return dp_learn_validate(dp, (struct ofl_exp_nicira_act_learn *)act);
+            }
+            default: {
+                break;
+            }
+        }
+    }
+    if (act->experimenter_id == OPENFLOW_VENDOR_ID) {
+        struct ofl_exp_openflow_act_header *ext = (struct ofl_exp_openflow_act_header *)act;
+
+        switch (ext->subtype) {
+            case (OFP_EXT_ACT_RESPOND): {
+                return dp_responder_validate(dp, (struct ofl_exp_openflow_act_respond *)act);
+            }
+            default: {
+                break;
+            }
+        }
+    }
+	VLOG_WARN_RL(LOG_MODULE, &rl, "Trying to validate unknown experimenter action (%u).", act->experimenter_id);
+    return ofl_error(OFPET_BAD_ACTION, OFPBAC_BAD_EXPERIMENTER);
+}
+
 void
 dp_exp_inst(struct packet *pkt UNUSED, struct ofl_instruction_experimenter *inst) {
 	VLOG_WARN_RL(LOG_MODULE, &rl, "Trying to execute unknown experimenter instruction (%u).", inst->experimenter_id);
@@ -87,6 +146,15 @@ dp_exp_message(struct datapath *dp,
                 case (OFP_EXT_SET_DESC): {
                     return dp_handle_set_desc(dp, (struct ofl_exp_openflow_msg_set_dp_desc *)msg, sender);
                 }
+                case (OFP_EXT_RX_STATS_REQUEST): {
+                    return dp_ports_handle_rx_stats_request(dp, (struct ofl_exp_openflow_msg_rx_stats_request *)msg, sender);
+                }
+                case (OFP_EXT_PACKET_OUT_BATCH): {
+                    return handle_control_packet_out_batch(dp, (struct ofl_exp_openflow_msg_packet_out_batch *)msg, sender);
+                }
+                case (OFP_EXT_RESPONDER_MOD): {
+                    return dp_responder_handle_mod(dp, (struct ofl_exp_openflow_msg_responder_mod *)msg, sender);
+                }
                 default: {
                 	VLOG_WARN_RL(LOG_MODULE, &rl, "Trying to handle unknown experimenter type (%u).", exp->type);
                     return ofl_error(OFPET_BAD_REQUEST, OFPBRC_BAD_EXPERIMENTER);
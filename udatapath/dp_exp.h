@@ -46,6 +46,10 @@ struct sender;
 void
 dp_exp_action(struct packet *pkt, struct ofl_action_experimenter *act);
 
+/* Checks that an experimenter action can be executed by the datapath. */
+ofl_err
+dp_exp_action_validate(struct datapath *dp, struct ofl_action_experimenter *act);
+
 /* Handles experimenter instructions. */
 void
 dp_exp_inst(struct packet *pkt, struct ofl_instruction_experimenter *inst);
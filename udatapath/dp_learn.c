@@ -0,0 +1,431 @@
+/* Copyright (c) 2008 The Board of Trustees of The Leland Stanford
+ * Junior University
+ *
+ * We are making the OpenFlow specification and associated documentation
+ * (Software) available for public use and benefit with the expectation
+ * that others will use, modify and enhance the Software and contribute
+ * those enhancements back to the community. However, since we would
+ * like to make the Software available for broadest use, with as few
+ * restrictions as possible permission is hereby granted, free of
+ * charge, to any person obtaining a copy of this Software to deal in
+ * the Software under the copyrights without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * The name and trademarks of copyright holder(s) may NOT be used in
+ * advertising or publicity pertaining to the Software or any
+ * derivatives without specific, written prior permission.
+ */
+
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dp_learn.h"
+#include "datapath.h"
+#include "flow_entry.h"
+#include "flow_table.h"
+#include "hash.h"
+#include "packet.h"
+#include "packet_handle_std.h"
+#include "pipeline.h"
+#include "oflib/ofl-actions.h"
+#include "oflib/ofl-messages.h"
+#include "oflib/ofl-structs.h"
+#include "oflib/ofl-utils.h"
+#include "oflib/oxm-match.h"
+#include "openflow/nicira-ext.h"
+#include "openflow/openflow.h"
+#include "timeval.h"
+#include "util.h"
+#include "vlog.h"
+
+#define LOG_MODULE VLM_dp_learn
+
+static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(60, 60);
+
+/* Most flow_mods queued by the packet going through the pipeline. */
+#define LEARN_MAX_PENDING 64
+
+struct dp_learn {
+    struct datapath *dp;
+    unsigned int rate;          /* Flows per second, 0 if unlimited. */
+    long long int tokens;       /* Flows that may be installed, in 1/1000. */
+    long long int last_fill;    /* Time the bucket was last refilled. */
+    size_t n_pending;
+    struct ofl_msg_flow_mod *pending[LEARN_MAX_PENDING];
+};
+
+struct dp_learn *
+dp_learn_create(struct datapath *dp) {
+    struct dp_learn *learn = xmalloc(sizeof *learn);
+
+    learn->dp = dp;
+    learn->n_pending = 0;
+    dp_learn_set_rate(learn, DP_LEARN_DEFAULT_RATE);
+    return learn;
+}
+
+void
+dp_learn_set_rate(struct dp_learn *learn, unsigned int rate) {
+    learn->rate = rate;
+    learn->tokens = (long long int)rate * 1000;
+    learn->last_fill = time_msec();
+}
+
+/* Takes a token from the bucket, refilling it first.  Returns false if the
+ * bucket is empty. */
+static bool
+learn_take_token(struct dp_learn *learn) {
+    long long int now, burst;
+
+    if (learn->rate == 0) {
+        return true;
+    }
+
+    now = time_msec();
+    burst = (long long int)learn->rate * 1000;
+    if (now > learn->last_fill) {
+        learn->tokens = MIN(burst,
+                learn->tokens + (now - learn->last_fill) * learn->rate);
+        learn->last_fill = now;
+    }
+    if (learn->tokens < 1000) {
+        return false;
+    }
+    learn->tokens -= 1000;
+    return true;
+}
+
+/* Returns true if 'header' is a field that can be copied or loaded whole by
+ * a learn action moving 'n_bits' bits. */
+static bool
+learn_field_ok(uint32_t header, uint16_t ofs, uint16_t n_bits) {
+    return (!OXM_HASMASK(header) && oxm_field_lookup(header) != NULL
+            && ofs == 0 && n_bits == oxm_field_bits(header));
+}
+
+ofl_err
+dp_learn_validate(struct datapath *dp UNUSED, struct ofl_exp_nicira_act_learn *act) {
+    size_t i, j;
+
+    if (act->table_id >= PIPELINE_TABLES) {
+        VLOG_WARN_RL(LOG_MODULE, &rl, "Learn action for invalid table (%u).", act->table_id);
+        return ofl_error(OFPET_BAD_ACTION, OFPBAC_BAD_ARGUMENT);
+    }
+    if ((act->flags & ~NX_LEARN_F_SEND_FLOW_REM) != 0
+        || act->fin_idle_timeout != 0 || act->fin_hard_timeout != 0) {
+        VLOG_WARN_RL(LOG_MODULE, &rl, "Learn action has unsupported flags or fin timeouts.");
+        return ofl_error(OFPET_BAD_ACTION, OFPBAC_BAD_ARGUMENT);
+    }
+
+    for (i = 0; i < act->specs_num; i++) {
+        struct ofl_exp_nicira_learn_spec *spec = &act->specs[i];
+
+        if (spec->src == NX_LEARN_SRC_FIELD
+            && !learn_field_ok(spec->src_field, spec->src_ofs, spec->n_bits)) {
+            VLOG_WARN_RL(LOG_MODULE, &rl, "Learn action copies part or unknown field (%x).", spec->src_field);
+            return ofl_error(OFPET_BAD_ACTION, OFPBAC_BAD_ARGUMENT);
+        }
+
+        switch (spec->dst) {
+            case (NX_LEARN_DST_MATCH):
+            case (NX_LEARN_DST_LOAD): {
+                if (!learn_field_ok(spec->dst_field, spec->dst_ofs, spec->n_bits)) {
+                    VLOG_WARN_RL(LOG_MODULE, &rl, "Learn action sets part or unknown field (%x).", spec->dst_field);
+                    return ofl_error(OFPET_BAD_ACTION, OFPBAC_BAD_ARGUMENT);
+                }
+                if (spec->dst == NX_LEARN_DST_LOAD
+                    && (spec->dst_field == OXM_OF_IN_PORT || spec->dst_field == OXM_OF_IN_PHY_PORT
+                        || spec->dst_field == OXM_OF_METADATA)) {
+                    VLOG_WARN_RL(LOG_MODULE, &rl, "Learn action loads a field set_field cannot (%x).", spec->dst_field);
+                    return ofl_error(OFPET_BAD_ACTION, OFPBAC_BAD_SET_TYPE);
+                }
+                if (spec->dst == NX_LEARN_DST_MATCH) {
+                    /* A field can only be matched once. */
+                    for (j = 0; j < i; j++) {
+                        if (act->specs[j].dst == NX_LEARN_DST_MATCH
+                            && act->specs[j].dst_field == spec->dst_field) {
+                            VLOG_WARN_RL(LOG_MODULE, &rl, "Learn action matches a field twice (%x).", spec->dst_field);
+                            return ofl_error(OFPET_BAD_ACTION, OFPBAC_BAD_ARGUMENT);
+                        }
+                    }
+                }
+                break;
+            }
+            default: {
+                if (spec->n_bits != 32) {
+                    VLOG_WARN_RL(LOG_MODULE, &rl, "Learn action outputs to a port of %u bits.", spec->n_bits);
+                    return ofl_error(OFPET_BAD_ACTION, OFPBAC_BAD_ARGUMENT);
+                }
+                break;
+            }
+        }
+    }
+    return 0;
+}
+
+/* Converts the 'value' of field 'header' between network byte order and the
+ * order OFLib keeps it in, which is the same conversion both ways. */
+static void
+learn_swap_value(uint32_t header, uint8_t *value) {
+    switch (OXM_LENGTH(header)) {
+        case 2: {
+            uint16_t v;
+            memcpy(&v, value, sizeof v);
+            v = ntohs(v);
+            memcpy(value, &v, sizeof v);
+            break;
+        }
+        case 4: {
+            uint32_t v;
+            /* IPv4 and ARP addresses are kept in network byte order. */
+            if (header != OXM_OF_IPV4_SRC && header != OXM_OF_IPV4_DST
+                && header != OXM_OF_ARP_SPA && header != OXM_OF_ARP_TPA) {
+                memcpy(&v, value, sizeof v);
+                v = ntohl(v);
+                memcpy(value, &v, sizeof v);
+            }
+            break;
+        }
+        case 8: {
+            uint64_t v;
+            memcpy(&v, value, sizeof v);
+            v = ntoh64(v);
+            memcpy(value, &v, sizeof v);
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+}
+
+/* Reads the value 'spec' moves for 'pkt' into 'value', in network byte
+ * order.  Returns false if the packet does not have the source field. */
+static bool
+learn_spec_value(struct packet *pkt, struct ofl_exp_nicira_learn_spec *spec,
+                 uint8_t *value, size_t len) {
+    if (spec->src == NX_LEARN_SRC_FIELD) {
+        struct ofl_match_tlv *f;
+
+        f = oxm_match_lookup(spec->src_field, &pkt->handle_std->match);
+        if (f == NULL) {
+            return false;
+        }
+        memcpy(value, f->value, len);
+        learn_swap_value(spec->src_field, value);
+    } else {
+        /* Immediate values are right aligned. */
+        memcpy(value, spec->src_value + NX_LEARN_IMMEDIATE_LEN(spec->n_bits) - len, len);
+    }
+    return true;
+}
+
+static void
+learn_match_put(struct ofl_match *match, uint32_t header, uint8_t *value, size_t len) {
+    struct ofl_match_tlv *m = xmalloc(sizeof(struct ofl_match_tlv));
+
+    m->header = header;
+    m->value = xmalloc(len);
+    memcpy(m->value, value, len);
+    hmap_insert(&match->match_fields, &m->hmap_node, hash_int(header, 0));
+    match->header.length += len + 4;
+}
+
+static struct ofl_action_header *
+learn_set_field(uint32_t header, uint8_t *value, size_t len) {
+    struct ofl_action_set_field *act = xmalloc(sizeof *act);
+
+    act->header.type = OFPAT_SET_FIELD;
+    act->field = xmalloc(sizeof(struct ofl_match_tlv));
+    act->field->header = header;
+    act->field->value = xmalloc(len);
+    memcpy(act->field->value, value, len);
+    return (struct ofl_action_header *)act;
+}
+
+static struct ofl_action_header *
+learn_output(uint8_t *value) {
+    struct ofl_action_output *act = xmalloc(sizeof *act);
+    uint32_t port;
+
+    memcpy(&port, value, sizeof port);
+    act->header.type = OFPAT_OUTPUT;
+    act->port = ntohl(port);
+    act->max_len = 0;
+    return (struct ofl_action_header *)act;
+}
+
+void
+dp_learn_execute(struct packet *pkt, struct ofl_exp_nicira_act_learn *act) {
+    struct dp_learn *learn = pkt->dp->learn;
+    struct ofl_msg_flow_mod *mod;
+    struct ofl_match *match;
+    struct ofl_instruction_actions *inst;
+    size_t i;
+
+    if (learn->n_pending == LEARN_MAX_PENDING) {
+        VLOG_WARN_RL(LOG_MODULE, &rl, "Too many flows learned by one packet, dropping.");
+        return;
+    }
+
+    packet_handle_std_validate_full(pkt->handle_std);
+
+    match = xmalloc(sizeof *match);
+    ofl_structs_match_init(match);
+
+    inst = xmalloc(sizeof *inst);
+    inst->header.type = OFPIT_APPLY_ACTIONS;
+    inst->actions_num = 0;
+    inst->actions = xmalloc(act->specs_num * sizeof(struct ofl_action_header *));
+
+    mod = xmalloc(sizeof *mod);
+    mod->header.type      = OFPT_FLOW_MOD;
+    mod->cookie           = act->cookie;
+    mod->cookie_mask      = 0;
+    mod->table_id         = act->table_id;
+    mod->command          = OFPFC_ADD;
+    mod->idle_timeout     = act->idle_timeout;
+    mod->hard_timeout     = act->hard_timeout;
+    mod->priority         = act->priority;
+    mod->buffer_id        = NO_BUFFER;
+    mod->out_port         = OFPP_ANY;
+    mod->out_group        = OFPG_ANY;
+    mod->flags            = (act->flags & NX_LEARN_F_SEND_FLOW_REM) ? OFPFF_SEND_FLOW_REM : 0;
+    mod->match            = (struct ofl_match_header *)match;
+    mod->instructions_num = 1;
+    mod->instructions     = xmalloc(sizeof(struct ofl_instruction_header *));
+    mod->instructions[0]  = (struct ofl_instruction_header *)inst;
+
+    for (i = 0; i < act->specs_num; i++) {
+        struct ofl_exp_nicira_learn_spec *spec = &act->specs[i];
+        uint8_t value[16];
+        size_t len;
+
+        len = (spec->dst == NX_LEARN_DST_OUTPUT) ? sizeof(uint32_t)
+                                                 : (size_t)oxm_field_bytes(spec->dst_field);
+        if (!learn_spec_value(pkt, spec, value, len)) {
+            /* A flow matching the missing field as zero would not match
+             * the packets it was learned from, so none is learned. */
+            VLOG_DBG_RL(LOG_MODULE, &rl, "Packet has no field to learn (%x).", spec->src_field);
+            ofl_msg_free_flow_mod(mod, true, true, pkt->dp->exp);
+            return;
+        }
+
+        switch (spec->dst) {
+            case (NX_LEARN_DST_MATCH): {
+                learn_swap_value(spec->dst_field, value);
+                learn_match_put(match, spec->dst_field, value, len);
+                break;
+            }
+            case (NX_LEARN_DST_LOAD): {
+                learn_swap_value(spec->dst_field, value);
+                inst->actions[inst->actions_num++] = learn_set_field(spec->dst_field, value, len);
+                break;
+            }
+            default: {
+                inst->actions[inst->actions_num++] = learn_output(value);
+                break;
+            }
+        }
+    }
+
+    learn->pending[learn->n_pending++] = mod;
+}
+
+/* Returns true if the 'a_num' instructions 'a' are the same as the 'b_num'
+ * instructions 'b'. */
+static bool
+learn_instructions_equal(struct ofl_instruction_header **a, size_t a_num,
+                         struct ofl_instruction_header **b, size_t b_num,
+                         struct ofl_exp *exp) {
+    size_t len = ofl_structs_instructions_ofp_total_len(a, a_num, exp);
+    uint8_t *buf_a, *buf_b, *p;
+    bool equal;
+    size_t i;
+
+    if (len != ofl_structs_instructions_ofp_total_len(b, b_num, exp)) {
+        return false;
+    }
+
+    buf_a = xmalloc(len);
+    buf_b = xmalloc(len);
+    for (i = 0, p = buf_a; i < a_num; i++) {
+        p += ofl_structs_instructions_pack(a[i], (struct ofp_instruction *)p, exp);
+    }
+    for (i = 0, p = buf_b; i < b_num; i++) {
+        p += ofl_structs_instructions_pack(b[i], (struct ofp_instruction *)p, exp);
+    }
+    equal = !memcmp(buf_a, buf_b, len);
+    free(buf_a);
+    free(buf_b);
+    return equal;
+}
+
+/* Returns true if 'entry' is the flow 'mod' would install. */
+static bool
+learn_entry_equal(struct flow_entry *entry, struct ofl_msg_flow_mod *mod,
+                  struct ofl_exp *exp) {
+    struct ofl_flow_stats *stats = entry->stats;
+
+    return (stats->cookie == mod->cookie
+            && stats->idle_timeout == mod->idle_timeout
+            && stats->hard_timeout == mod->hard_timeout
+            && entry->send_removed == ((mod->flags & OFPFF_SEND_FLOW_REM) != 0)
+            && learn_instructions_equal(stats->instructions, stats->instructions_num,
+                                        mod->instructions, mod->instructions_num, exp));
+}
+
+void
+dp_learn_flush(struct datapath *dp) {
+    struct dp_learn *learn = dp->learn;
+    struct ofl_msg_flow_mod *pending[LEARN_MAX_PENDING];
+    size_t n_pending = learn->n_pending;
+    size_t i;
+
+    /* Installing a flow may run packets held for it through the pipeline,
+     * which flushes the flows they learn in turn. */
+    memcpy(pending, learn->pending, n_pending * sizeof *pending);
+    learn->n_pending = 0;
+
+    for (i = 0; i < n_pending; i++) {
+        struct ofl_msg_flow_mod *mod = pending[i];
+        struct flow_entry *entry;
+        ofl_err error;
+
+        entry = flow_table_find_strict(dp->pipeline->tables[mod->table_id], mod);
+        if (entry != NULL && learn_entry_equal(entry, mod, dp->exp)) {
+            entry->last_used = time_msec();
+            ofl_msg_free_flow_mod(mod, true, true, dp->exp);
+            continue;
+        }
+
+        if (!learn_take_token(learn)) {
+            VLOG_WARN_RL(LOG_MODULE, &rl, "Learning more than %u flows/s, dropping.", learn->rate);
+            ofl_msg_free_flow_mod(mod, true, true, dp->exp);
+            continue;
+        }
+
+        error = pipeline_flow_mod(dp->pipeline, mod);
+        if (error) {
+            VLOG_WARN_RL(LOG_MODULE, &rl, "Failed to install learned flow (type %u, code %u).",
+                         ofl_error_type(error), ofl_error_code(error));
+            ofl_msg_free_flow_mod(mod, true, true, dp->exp);
+        }
+    }
+}
@@ -0,0 +1,78 @@
+/* Copyright (c) 2008 The Board of Trustees of The Leland Stanford
+ * Junior University
+ *
+ * We are making the OpenFlow specification and associated documentation
+ * (Software) available for public use and benefit with the expectation
+ * that others will use, modify and enhance the Software and contribute
+ * those enhancements back to the community. However, since we would
+ * like to make the Software available for broadest use, with as few
+ * restrictions as possible permission is hereby granted, free of
+ * charge, to any person obtaining a copy of this Software to deal in
+ * the Software under the copyrights without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * The name and trademarks of copyright holder(s) may NOT be used in
+ * advertising or publicity pertaining to the Software or any
+ * derivatives without specific, written prior permission.
+ */
+
+#ifndef DP_LEARN_H
+#define DP_LEARN_H 1
+
+#include "oflib/ofl.h"
+#include "oflib-exp/ofl-exp-nicira.h"
+
+/****************************************************************************
+ * The Nicira learn action: flow entries built from the fields of the packet
+ * executing the action, installed without a round trip to the controller.
+ *
+ * The flow_mods are queued while the packet goes through the pipeline, and
+ * installed after it, so that a learned flow never replaces the entry being
+ * executed.  Installing and replacing entries is rate limited; relearning
+ * an installed flow only refreshes its idle timeout, and is not.
+ ****************************************************************************/
+
+struct datapath;
+struct packet;
+
+/* Default limit, in learned flows installed per second. */
+#define DP_LEARN_DEFAULT_RATE 1000
+
+/* Creates the learning state of 'dp'. */
+struct dp_learn *
+dp_learn_create(struct datapath *dp);
+
+/* Limits learning to 'rate' flows installed per second, with a burst of one
+ * second; 0 disables the limit. */
+void
+dp_learn_set_rate(struct dp_learn *learn, unsigned int rate);
+
+/* Checks that the learn action 'act' can be executed by 'dp'. */
+ofl_err
+dp_learn_validate(struct datapath *dp, struct ofl_exp_nicira_act_learn *act);
+
+/* Executes the learn action 'act' on 'pkt', queueing the flow_mod it
+ * builds. */
+void
+dp_learn_execute(struct packet *pkt, struct ofl_exp_nicira_act_learn *act);
+
+/* Installs the queued flow_mods. */
+void
+dp_learn_flush(struct datapath *dp);
+
+#endif /* DP_LEARN_H */
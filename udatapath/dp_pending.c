@@ -0,0 +1,262 @@
+/* Copyright (c) 2008 The Board of Trustees of The Leland Stanford
+ * Junior University
+ *
+ * We are making the OpenFlow specification and associated documentation
+ * (Software) available for public use and benefit with the expectation
+ * that others will use, modify and enhance the Software and contribute
+ * those enhancements back to the community. However, since we would
+ * like to make the Software available for broadest use, with as few
+ * restrictions as possible permission is hereby granted, free of
+ * charge, to any person obtaining a copy of this Software to deal in
+ * the Software under the copyrights without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * The name and trademarks of copyright holder(s) may NOT be used in
+ * advertising or publicity pertaining to the Software or any
+ * derivatives without specific, written prior permission.
+ */
+
+#include <stdlib.h>
+
+#include "dp_pending.h"
+#include "datapath.h"
+#include "hash.h"
+#include "hmap.h"
+#include "list.h"
+#include "match_std.h"
+#include "packet.h"
+#include "packet_handle_std.h"
+#include "pipeline.h"
+#include "poll-loop.h"
+#include "oflib/ofl-structs.h"
+#include "oflib/oxm-match.h"
+#include "timeval.h"
+#include "util.h"
+#include "vlog.h"
+
+#define LOG_MODULE VLM_dp_pending
+
+static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(60, 60);
+
+/* Most flows awaiting a flow entry at a time; the packet_ins of others are
+ * not coalesced. */
+#define PENDING_MAX_FLOWS 1024
+
+/* A flow that missed a table, awaiting a flow entry from the controller. */
+struct pending_flow {
+    struct hmap_node node;      /* In dp_pending's 'flows'. */
+    struct list expiry_node;    /* In dp_pending's 'expiry'. */
+    uint8_t table_id;
+    struct packet *first;       /* Copy of the packet sent to the
+                                 * controller, the key of the flow. */
+    long long int expires;
+    size_t n_held;
+    struct packet **held;
+};
+
+struct dp_pending {
+    struct datapath *dp;
+    unsigned int timeout;       /* In ms, 0 if disabled. */
+    unsigned int max_held;
+    struct hmap flows;
+    struct list expiry;         /* The flows, in order of expiry. */
+    struct dp_pending_stats stats;
+};
+
+struct dp_pending *
+dp_pending_create(struct datapath *dp) {
+    struct dp_pending *pending = xmalloc(sizeof *pending);
+
+    pending->dp = dp;
+    pending->timeout = 0;
+    pending->max_held = DP_PENDING_DEFAULT_MAX_HELD;
+    hmap_init(&pending->flows);
+    list_init(&pending->expiry);
+    pending->stats.n_suppressed = 0;
+    pending->stats.n_released = 0;
+    pending->stats.n_dropped = 0;
+    return pending;
+}
+
+void
+dp_pending_set(struct dp_pending *pending, unsigned int timeout,
+               unsigned int max_held) {
+    pending->timeout = timeout;
+    pending->max_held = max_held;
+}
+
+/* Hashes the fields of 'pkt', in whatever order they were parsed. */
+static uint32_t
+pending_hash(struct packet *pkt) {
+    struct ofl_match_tlv *f;
+    uint32_t hash = 0;
+
+    HMAP_FOR_EACH (f, struct ofl_match_tlv, hmap_node,
+                   &pkt->handle_std->match.match_fields) {
+        hash += hash_bytes(f->value, OXM_LENGTH(f->header), f->header);
+    }
+    return hash_int(pkt->table_id, hash);
+}
+
+static struct pending_flow *
+pending_lookup(struct dp_pending *pending, struct packet *pkt, uint32_t hash) {
+    struct pending_flow *flow;
+
+    HMAP_FOR_EACH_WITH_HASH (flow, struct pending_flow, node, hash,
+                             &pending->flows) {
+        if (flow->table_id == pkt->table_id
+            && match_std_strict(&flow->first->handle_std->match,
+                                &pkt->handle_std->match)) {
+            return flow;
+        }
+    }
+    return NULL;
+}
+
+static void
+pending_remove(struct dp_pending *pending, struct pending_flow *flow) {
+    hmap_remove(&pending->flows, &flow->node);
+    list_remove(&flow->expiry_node);
+    packet_destroy(flow->first);
+}
+
+bool
+dp_pending_hold(struct datapath *dp, struct packet *pkt) {
+    struct dp_pending *pending = dp->pending;
+    struct pending_flow *flow;
+    uint32_t hash;
+
+    if (pending->timeout == 0) {
+        return false;
+    }
+
+    packet_handle_std_validate_full(pkt->handle_std);
+    hash = pending_hash(pkt);
+    flow = pending_lookup(pending, pkt, hash);
+
+    if (flow == NULL) {
+        if (hmap_count(&pending->flows) >= PENDING_MAX_FLOWS) {
+            return false;
+        }
+        flow = xmalloc(sizeof *flow);
+        flow->table_id = pkt->table_id;
+        flow->first = packet_clone(pkt);
+        flow->expires = time_msec() + pending->timeout;
+        flow->n_held = 0;
+        flow->held = NULL;
+        hmap_insert(&pending->flows, &flow->node, hash);
+        list_push_back(&pending->expiry, &flow->expiry_node);
+        return false;
+    }
+
+    pending->stats.n_suppressed++;
+    if (flow->n_held < pending->max_held) {
+        if (flow->held == NULL) {
+            flow->held = xmalloc(pending->max_held * sizeof *flow->held);
+        }
+        flow->held[flow->n_held++] = packet_clone(pkt);
+    } else {
+        pending->stats.n_dropped++;
+    }
+    return true;
+}
+
+void
+dp_pending_flow_added(struct datapath *dp, struct ofl_msg_flow_mod *mod) {
+    struct dp_pending *pending = dp->pending;
+    struct ofl_match *match = (struct ofl_match *)mod->match;
+    struct pending_flow *flow, *next;
+    struct list released;
+
+    if (hmap_is_empty(&pending->flows) || mod->match->type != OFPMT_OXM) {
+        return;
+    }
+    /* Packets that missed a table still miss it with a new table-miss
+     * entry. */
+    if (mod->priority == 0 && mod->match->length <= 4) {
+        return;
+    }
+
+    /* The flows are removed before their packets go through the pipeline,
+     * where they may miss a table again. */
+    list_init(&released);
+    HMAP_FOR_EACH_SAFE (flow, next, struct pending_flow, node, &pending->flows) {
+        if (flow->table_id == mod->table_id
+            && packet_handle_std_match(flow->first->handle_std, match)) {
+            pending_remove(pending, flow);
+            list_push_back(&released, &flow->expiry_node);
+        }
+    }
+
+    while (!list_is_empty(&released)) {
+        size_t i;
+
+        flow = CONTAINER_OF(list_pop_front(&released), struct pending_flow, expiry_node);
+        VLOG_DBG_RL(LOG_MODULE, &rl, "Releasing %zu packets held for table %u.",
+                    flow->n_held, flow->table_id);
+        /* The held copies already went through the earlier tables, so
+         * they pick up at the table they missed. */
+        for (i = 0; i < flow->n_held; i++) {
+            pipeline_resume_packet(dp->pipeline, flow->held[i],
+                                   flow->table_id);
+        }
+        pending->stats.n_released += flow->n_held;
+        free(flow->held);
+        free(flow);
+    }
+}
+
+void
+dp_pending_run(struct datapath *dp) {
+    struct dp_pending *pending = dp->pending;
+    long long int now = time_msec();
+
+    while (!list_is_empty(&pending->expiry)) {
+        struct pending_flow *flow;
+        size_t i;
+
+        flow = CONTAINER_OF(list_front(&pending->expiry), struct pending_flow, expiry_node);
+        if (flow->expires > now) {
+            break;
+        }
+        pending_remove(pending, flow);
+        for (i = 0; i < flow->n_held; i++) {
+            packet_destroy(flow->held[i]);
+        }
+        pending->stats.n_dropped += flow->n_held;
+        free(flow->held);
+        free(flow);
+    }
+}
+
+void
+dp_pending_wait(struct datapath *dp) {
+    struct dp_pending *pending = dp->pending;
+
+    if (!list_is_empty(&pending->expiry)) {
+        struct pending_flow *flow;
+
+        flow = CONTAINER_OF(list_front(&pending->expiry), struct pending_flow, expiry_node);
+        poll_timer_wait(MAX(0, flow->expires - time_msec()));
+    }
+}
+
+void
+dp_pending_get_stats(struct dp_pending *pending, struct dp_pending_stats *stats) {
+    *stats = pending->stats;
+}
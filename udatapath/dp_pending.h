@@ -0,0 +1,102 @@
+/* Copyright (c) 2008 The Board of Trustees of The Leland Stanford
+ * Junior University
+ *
+ * We are making the OpenFlow specification and associated documentation
+ * (Software) available for public use and benefit with the expectation
+ * that others will use, modify and enhance the Software and contribute
+ * those enhancements back to the community. However, since we would
+ * like to make the Software available for broadest use, with as few
+ * restrictions as possible permission is hereby granted, free of
+ * charge, to any person obtaining a copy of this Software to deal in
+ * the Software under the copyrights without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * The name and trademarks of copyright holder(s) may NOT be used in
+ * advertising or publicity pertaining to the Software or any
+ * derivatives without specific, written prior permission.
+ */
+
+#ifndef DP_PENDING_H
+#define DP_PENDING_H 1
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "oflib/ofl-messages.h"
+
+/****************************************************************************
+ * Coalescing of the packet_ins of table misses.
+ *
+ * After a packet of a flow missed a table and was sent to the controller,
+ * the next packets of the same flow that miss the same table are held
+ * instead of being sent too, until the controller adds a flow entry they
+ * match.  They then carry on from the table they missed, with the state
+ * the earlier tables left them, so those tables do not act on them twice.
+ * They are dropped if no such entry is added within a timeout, and
+ * the next packet of the flow is sent to the controller again.
+ ****************************************************************************/
+
+struct datapath;
+struct packet;
+
+/* Default time to wait for a flow entry, in ms, when coalescing is enabled,
+ * and number of packets of a flow held meanwhile. */
+#define DP_PENDING_DEFAULT_TIMEOUT 500
+#define DP_PENDING_DEFAULT_MAX_HELD 16
+
+struct dp_pending_stats {
+    uint64_t n_suppressed;      /* Packet_ins not sent. */
+    uint64_t n_released;        /* Packets run through the rest of the
+                                 * pipeline. */
+    uint64_t n_dropped;         /* Packets dropped, over the limit of held
+                                 * packets or on timeout. */
+};
+
+/* Creates the pending flows of 'dp', with coalescing disabled. */
+struct dp_pending *
+dp_pending_create(struct datapath *dp);
+
+/* Holds the packets of a flow for up to 'timeout' ms, and up to 'max_held'
+ * of them.  A timeout of 0 disables coalescing. */
+void
+dp_pending_set(struct dp_pending *pending, unsigned int timeout,
+               unsigned int max_held);
+
+/* Called for 'pkt', which missed its table, before sending it to the
+ * controller.  Returns true if the packet_in must not be sent, because the
+ * packet was held or dropped. */
+bool
+dp_pending_hold(struct datapath *dp, struct packet *pkt);
+
+/* Releases the packets held for the table of 'mod', an OFPFC_ADD just
+ * applied, that match the flow entry it added. */
+void
+dp_pending_flow_added(struct datapath *dp, struct ofl_msg_flow_mod *mod);
+
+/* Drops the packets held for too long. */
+void
+dp_pending_run(struct datapath *dp);
+
+/* Wakes poll_block() for the next timeout. */
+void
+dp_pending_wait(struct datapath *dp);
+
+/* Returns the counters of 'pending' in 'stats'. */
+void
+dp_pending_get_stats(struct dp_pending *pending, struct dp_pending_stats *stats);
+
+#endif /* DP_PENDING_H */
@@ -42,14 +42,20 @@
 #include <errno.h>
 #include <inttypes.h>
 #include "dp_exp.h"
+#include "dp_pending.h"
 #include "dp_ports.h"
+#include "dp_sflow.h"
 #include "datapath.h"
 #include "packets.h"
 #include "pipeline.h"
+#include "pkt-queue.h"
+#include "pktmem.h"
 #include "oflib/ofl.h"
 #include "oflib/ofl-messages.h"
 #include "oflib-exp/ofl-exp-openflow.h"
+#include "openflow/openflow-ext.h"
 #include "oflib/ofl-log.h"
+#include "svec.h"
 #include "util.h"
 
 #include "vlog.h"
@@ -59,69 +65,48 @@ static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(60, 60);
 
 #if defined(OF_HW_PLAT)
 #include <openflow/of_hw_api.h>
-#include <pthread.h>
 #endif
 
 
 #if defined(OF_HW_PLAT) && !defined(USE_NETDEV)
-/* Queue to decouple receive packet thread from rconn control thread */
-/* Could make mutex per-DP */
-static pthread_mutex_t pkt_q_mutex = PTHREAD_MUTEX_INITIALIZER;
-#define PKT_Q_LOCK pthread_mutex_lock(&pkt_q_mutex)
-#define PKT_Q_UNLOCK pthread_mutex_unlock(&pkt_q_mutex)
-
+/* Processes the packets queued by the driver's thread, at most a queue's
+ * worth at a time so that a busy driver cannot starve the rest of the
+ * datapath. */
 static void
-enqueue_pkt(struct datapath *dp, struct ofpbuf *buffer, of_port_t port_no,
-            int reason)
-{
-    struct hw_pkt_q_entry *q_entry;
-
-    if ((q_entry = xmalloc(sizeof(*q_entry))) == NULL) {
-        VLOG_WARN(LOG_MODULE, "Could not alloc q entry\n");
-        /* FIXME: Dealloc buffer */
-        return;
-    }
-    q_entry->buffer = buffer;
-    q_entry->next = NULL;
-    q_entry->port_no = port_no;
-    q_entry->reason = reason;
-    pthread_mutex_lock(&pkt_q_mutex);
-    if (dp->hw_pkt_list_head == NULL) {
-        dp->hw_pkt_list_head = q_entry;
-    } else {
-        dp->hw_pkt_list_tail->next = q_entry;
-    }
-    dp->hw_pkt_list_tail = q_entry;
-    pthread_mutex_unlock(&pkt_q_mutex);
-}
-
-/* If queue non-empty, fill out params and return 1; else return 0 */
-static int
-dequeue_pkt(struct datapath *dp, struct ofpbuf **buffer, of_port_t *port_no,
-            int *reason)
+hw_pkt_q_run(struct datapath *dp)
 {
-    struct hw_pkt_q_entry *q_entry;
-    int rv = 0;
-
-    pthread_mutex_lock(&pkt_q_mutex);
-    q_entry = dp->hw_pkt_list_head;
-    if (dp->hw_pkt_list_head != NULL) {
-        dp->hw_pkt_list_head = dp->hw_pkt_list_head->next;
-        if (dp->hw_pkt_list_head == NULL) {
-            dp->hw_pkt_list_tail = NULL;
+    struct pkt_queue *q = dp->hw_pkt_q;
+    uint64_t dropped;
+    size_t total = 0;
+
+    pkt_queue_clear_wakeup(q);
+    while (total < PKT_QUEUE_SIZE) {
+        struct pkt_queue_entry entries[DP_PORTS_BURST_MAX];
+        struct packet *pkts[DP_PORTS_BURST_MAX];
+        long long int now;
+        size_t i, n;
+
+        n = pkt_queue_dequeue(q, entries, dp->rx_burst);
+        if (n == 0) {
+            break;
         }
-    }
-    pthread_mutex_unlock(&pkt_q_mutex);
-
-    if (q_entry != NULL) {
-        rv = 1;
-        *buffer = q_entry->buffer;
-        *port_no = q_entry->port_no;
-        *reason = q_entry->reason;
-        free(q_entry);
+        total += n;
+        now = time_msec();
+        for (i = 0; i < n; i++) {
+            /* FIXME:  We're throwing away the reason that came from HW */
+            pkts[i] = packet_create(dp, entries[i].port_no,
+                                    entries[i].buffer, false, now);
+        }
+        pipeline_process_batch(dp->pipeline, pkts, n);
     }
 
-    return rv;
+    dropped = pkt_queue_get_dropped(q);
+    if (dropped != dp->hw_pkt_q_dropped) {
+        VLOG_WARN_RL(LOG_MODULE, &rl, "hardware receive queue full, "
+                     "dropped %"PRIu64" packets",
+                     dropped - dp->hw_pkt_q_dropped);
+        dp->hw_pkt_q_dropped = dropped;
+    }
 }
 #endif
 
@@ -153,7 +138,7 @@ hw_packet_in(of_port_t port_no, of_packet_t *packet, int reason,
         /* TODO increment error counter */
         return -1;
     }
-    port = &dp->ports[port_no];
+    port = dp_ports_lookup(dp, port_no);
     if (!PORT_IN_USE(port)) {
         VLOG_WARN(LOG_MODULE, "Receive port not active: %d\n", port_no);
         return -1;
@@ -177,8 +162,7 @@ hw_packet_in(of_port_t port_no, of_packet_t *packet, int reason,
         buffer->data = (char*)buffer->data + headroom;
         buffer->size = packet->length;
         memcpy(buffer->data, packet->data, packet->length);
-        enqueue_pkt(dp, buffer, port_no, reason);
-        poll_immediate_wake();
+        pkt_queue_enqueue(dp->hw_pkt_q, buffer, port_no, reason);
     }
 
     return 0;
@@ -189,8 +173,7 @@ hw_packet_in(of_port_t port_no, of_packet_t *packet, int reason,
 static int
 dp_hw_drv_init(struct datapath *dp)
 {
-    dp->hw_pkt_list_head = NULL;
-    dp->hw_pkt_list_tail = NULL;
+    dp->hw_pkt_q = NULL;
 
     dp->hw_drv = new_of_hw_driver(dp);
     if (dp->hw_drv == NULL) {
@@ -198,6 +181,9 @@ dp_hw_drv_init(struct datapath *dp)
         return -1;
     }
 #if !defined(USE_NETDEV)
+    if (pkt_queue_create(&dp->hw_pkt_q)) {
+        return -1;
+    }
     if (dp->hw_drv->packet_receive_register(dp->hw_drv,
                                             hw_packet_in, dp) < 0) {
         VLOG_ERR(LOG_MODULE, "Could not register with HW driver to receive pkts");
@@ -210,19 +196,88 @@ dp_hw_drv_init(struct datapath *dp)
 #endif
 
 
-/* Runs a datapath packet through the pipeline, if the port is not set to down. */
+/* Returns a buffer to receive a packet from 'p' into. */
+static struct ofpbuf *
+alloc_rx_buffer(struct sw_port *p) {
+    const int hard_header = VLAN_ETH_HEADER_LEN;
+    const int mtu = netdev_get_mtu(p->netdev);
+    return pktmem_ofpbuf_new(p->dp->pktmem, hard_header + mtu,
+                             DP_PORTS_HEADROOM);
+}
+
+/* Sets the OFPPS_LINK_DOWN and OFPPS_LIVE state bits of 'p' according to
+ * 'up' and, if they changed, notifies the controllers. */
+static void
+port_set_link(struct datapath *dp, struct sw_port *p, bool up)
+{
+    uint32_t state;
+
+    state = p->conf->state & ~(OFPPS_LINK_DOWN | OFPPS_LIVE);
+    state |= up ? OFPPS_LIVE : OFPPS_LINK_DOWN;
+    if (state != p->conf->state) {
+        struct ofl_msg_port_status msg =
+                {{.type = OFPT_PORT_STATUS},
+                 .reason = OFPPR_MODIFY, .desc = p->conf};
+
+        p->conf->state = state;
+        VLOG_INFO(LOG_MODULE, "port %u (%s): link %s", p->conf->port_no,
+                  p->conf->name, up ? "up" : "down");
+        dp_send_message(dp, (struct ofl_msg_header *)&msg, NULL/*sender*/);
+    }
+}
+
+/* Reads the link state of 'p' from its network device.  The link is up if
+ * the device is administratively up and has carrier. */
+static void
+port_refresh_link(struct datapath *dp, struct sw_port *p)
+{
+    enum netdev_flags flags;
+
+    if (!netdev_get_flags(p->netdev, &flags)) {
+        port_set_link(dp, p, (flags & NETDEV_UP) && (flags & NETDEV_CARRIER));
+    }
+}
+
+/* Makes 'dp->port_monitor' watch the network devices of all of the ports. */
 static void
-process_buffer(struct datapath *dp, struct sw_port *p, struct ofpbuf *buffer) {
-    struct packet *pkt;
+port_monitor_update(struct datapath *dp)
+{
+    struct sw_port *p;
+    struct svec names;
 
-    if (p->conf->config & ((OFPPC_NO_RECV | OFPPC_PORT_DOWN) != 0)) {
-        ofpbuf_delete(buffer);
+    if (dp->port_monitor == NULL) {
         return;
     }
+    svec_init(&names);
+    LIST_FOR_EACH (p, struct sw_port, node, &dp->port_list) {
+        if (!IS_HW_PORT(p)) {
+            svec_add(&names, netdev_get_name(p->netdev));
+        }
+    }
+    netdev_monitor_set_devices(dp->port_monitor, names.names, names.n);
+    svec_destroy(&names);
+}
+
+/* Applies the link changes announced over rtnetlink, so that the port state
+ * follows the link as soon as the kernel reports it rather than when the
+ * next receive happens to fail. */
+static void
+port_monitor_run(struct datapath *dp)
+{
+    const char *name;
 
-    // packet takes ownership of ofpbuf buffer
-    pkt = packet_create(dp, p->stats->port_no, buffer, false);
-    pipeline_process_packet(dp->pipeline, pkt);
+    if (dp->port_monitor == NULL) {
+        return;
+    }
+    while ((name = netdev_monitor_poll(dp->port_monitor)) != NULL) {
+        struct sw_port *p;
+
+        LIST_FOR_EACH (p, struct sw_port, node, &dp->port_list) {
+            if (!IS_HW_PORT(p) && !strcmp(netdev_get_name(p->netdev), name)) {
+                port_refresh_link(dp, p);
+            }
+        }
+    }
 }
 
 void
@@ -231,55 +286,83 @@ dp_ports_run(struct datapath *dp) {
     static struct ofpbuf *buffer = NULL;
 
     struct sw_port *p, *pn;
+    bool busy = false;
 
-#if defined(OF_HW_PLAT) && !defined(USE_NETDEV)
-    { /* Process packets received from callback thread */
-        struct ofpbuf *buffer;
-        of_port_t port_no;
-        int reason;
-        struct sw_port *p;
+    dp->rx_polls++;
+    port_monitor_run(dp);
 
-        while (dequeue_pkt(dp, &buffer, &port_no, &reason)) {
-            p = dp_ports_lookup(dp, port_no);
-            /* FIXME:  We're throwing away the reason that came from HW */
-            process_packet(dp, p, buffer);
-        }
+#if defined(OF_HW_PLAT) && !defined(USE_NETDEV)
+    if (dp->hw_pkt_q) {
+        hw_pkt_q_run(dp);
     }
 #endif
 
     LIST_FOR_EACH_SAFE (p, pn, struct sw_port, node, &dp->port_list) {
-        int error;
+        struct packet *pkts[DP_PORTS_BURST_MAX];
+        size_t n_pkts = 0;
+        size_t n_read;
+        long long int now = 0;
+        int error = 0;
 
         if (IS_HW_PORT(p)) {
             continue;
         }
-        if (buffer == NULL) {
-            /* Allocate buffer with some headroom to add headers in forwarding
-             * to the controller or adding a vlan tag, plus an extra 2 bytes to
-             * allow IP headers to be aligned on a 4-byte boundary.  */
-            const int headroom = 128 + 2;
-            const int hard_header = VLAN_ETH_HEADER_LEN;
-            const int mtu = netdev_get_mtu(p->netdev);
-            buffer = ofpbuf_new_with_headroom(hard_header + mtu, headroom);
+        /* The burst is bounded by the packets read, not those processed,
+         * so that a port that does not receive cannot hold the loop. */
+        for (n_read = 0; n_read < dp->rx_burst; n_read++) {
+            struct ofpbuf *rx;
+
+            error = netdev_recv_zerocopy(p->netdev, &rx);
+            if (error == EOPNOTSUPP) {
+                if (buffer == NULL) {
+                    buffer = alloc_rx_buffer(p);
+                }
+                error = netdev_recv(p->netdev, buffer);
+                rx = buffer;
+            }
+            if (error) {
+                break;
+            }
+            if (rx == buffer) {
+                buffer = NULL;
+            }
+            p->stats->rx_packets++;
+            p->stats->rx_bytes += rx->size;
+            if (p->conf->config & (OFPPC_NO_RECV | OFPPC_PORT_DOWN)) {
+                ofpbuf_delete(rx);
+            } else {
+                /* The clock is read once for the whole burst. */
+                if (n_pkts == 0) {
+                    now = time_msec();
+                }
+                // packet takes ownership of ofpbuf buffer
+                pkts[n_pkts++] = packet_create(dp, p->stats->port_no, rx,
+                                               false, now);
+                if (p->sflow_skip != 0 && --p->sflow_skip == 0) {
+                    dp_sflow_sample_packet(dp, p, pkts[n_pkts - 1]);
+                }
+            }
         }
-        error = netdev_recv(p->netdev, buffer);
-        if (error == ENETDOWN){
-            VLOG_ERR(LOG_MODULE, "Não tenho nada mas tô aqui...");
+        if (n_pkts > 0) {
+            pipeline_process_batch(dp->pipeline, pkts, n_pkts);
         }
         if (!error) {
-            p->stats->rx_packets++;
-            p->stats->rx_bytes += buffer->size;
-            // process_buffer takes ownership of ofpbuf buffer
-            process_buffer(dp, p, buffer);
-            buffer = NULL;
-        } else if (error != EAGAIN) {
-            if(error == ENETDOWN){
-                p->conf->state = OFPPS_LINK_DOWN;
+            /* The burst filled up, so more packets are likely waiting. */
+            p->full_bursts++;
+            busy = true;
+        }
+
+        if (error && error != EAGAIN) {
+            if (error == ENETDOWN) {
+                port_set_link(dp, p, false);
             }
             VLOG_ERR_RL(LOG_MODULE, &rl, "error receiving data from %s: %s",
                         netdev_get_name(p->netdev), strerror(error));
         }
     }
+    if (busy) {
+        dp->rx_busy_polls++;
+    }
 
 }
 
@@ -359,7 +442,7 @@ new_port(struct datapath *dp, struct sw_port *port, uint32_t port_no,
         }
     }
 
-    /* NOTE: port struct is already allocated in struct dp */
+    /* NOTE: port struct is already allocated by the caller */
     memset(port, '\0', sizeof *port);
 
     port->dp = dp;
@@ -420,11 +503,28 @@ new_port(struct datapath *dp, struct sw_port *port, uint32_t port_no,
     port->max_queues = max_queues;
     port->num_queues = 0;
     port->created = now;
+    port->n_tx_batch = 0;
+    port->kernel_drops = 0;
+    port->full_bursts = 0;
+    dp_sflow_init_port(dp, port);
 
     memset(port->queues, 0x00, sizeof(port->queues));
 
     list_push_back(&dp->port_list, &port->node);
     dp->ports_num++;
+    dp_ports_update_output(dp);
+
+    /* Start from the device's current link state; the port monitor keeps it
+     * up to date from then on. */
+    {
+        enum netdev_flags flags;
+
+        if (!netdev_get_flags(netdev, &flags)
+            && !(flags & NETDEV_CARRIER)) {
+            port->conf->state = OFPPS_LINK_DOWN;
+        }
+    }
+    port_monitor_update(dp);
 
     {
     /* Notify the controllers that this port has been added */
@@ -439,6 +539,26 @@ new_port(struct datapath *dp, struct sw_port *port, uint32_t port_no,
 }
 
 
+/* Makes sure 'dp->ports' has a slot for 'port_no', doubling its size as
+ * needed so that adding ports one by one stays cheap. */
+static void
+port_table_reserve(struct datapath *dp, uint32_t port_no)
+{
+    size_t new_size;
+
+    if (port_no < dp->ports_size) {
+        return;
+    }
+    new_size = dp->ports_size ? dp->ports_size : 64;
+    while (new_size <= port_no) {
+        new_size *= 2;
+    }
+    dp->ports = xrealloc(dp->ports, new_size * sizeof *dp->ports);
+    memset(dp->ports + dp->ports_size, 0,
+           (new_size - dp->ports_size) * sizeof *dp->ports);
+    dp->ports_size = new_size;
+}
+
 #if defined(OF_HW_PLAT) && !defined(USE_NETDEV)
 int
 dp_ports_add(struct datapath *dp, const char *port_name)
@@ -451,8 +571,8 @@ dp_ports_add(struct datapath *dp, const char *port_name)
     if (dp->hw_drv && dp->hw_drv->port_add) {
         port_no = dp->hw_drv->port_add(dp->hw_drv, -1, port_name);
         if (port_no >= 0) {
-            port = &dp->ports[port_no];
-            if (port->flags & SWP_USED) {
+            port = dp_ports_lookup(dp, port_no);
+            if (PORT_IN_USE(port)) {
                 VLOG_ERR(LOG_MODULE, "HW port %s (%d) already created\n",
                           port_name, port_no);
                 rc = -1;
@@ -460,6 +580,9 @@ dp_ports_add(struct datapath *dp, const char *port_name)
                 fprintf(stderr, "Adding HW port %s as OF port number %d\n",
                        port_name, port_no);
                 /* FIXME: Determine and record HW addr, etc */
+                port_table_reserve(dp, port_no);
+                port = xcalloc(1, sizeof *port);
+                dp->ports[port_no] = port;
                 port->flags |= SWP_USED | SWP_HW_DRV_PORT;
                 port->dp = dp;
                 port->port_no = port_no;
@@ -468,6 +591,8 @@ dp_ports_add(struct datapath *dp, const char *port_name)
                 port->num_queues = 0;
                 strncpy(port->hw_name, port_name, sizeof(port->hw_name));
                 list_push_back(&dp->port_list, &port->node);
+                dp->ports_num++;
+                dp_ports_update_output(dp);
 
                 struct ofl_msg_port_status msg =
                         {{.type = OFPT_PORT_STATUS},
@@ -492,14 +617,29 @@ dp_ports_add(struct datapath *dp, const char *port_name)
 int
 dp_ports_add(struct datapath *dp, const char *netdev)
 {
+    struct sw_port *port;
     uint32_t port_no;
-    for (port_no = 1; port_no < DP_MAX_PORTS; port_no++) {
-        struct sw_port *port = &dp->ports[port_no];
-        if (port->netdev == NULL) {
-            return new_port(dp, port, port_no, netdev, NULL, dp->max_queues);
+    int error;
+
+    /* Reuse the lowest free port number, or take the next one. */
+    for (port_no = 1; port_no < dp->ports_size; port_no++) {
+        if (dp->ports[port_no] == NULL) {
+            break;
         }
     }
-    return EXFULL;
+    if (port_no > DP_MAX_PORTS) {
+        return EXFULL;
+    }
+    port_table_reserve(dp, port_no);
+
+    port = xcalloc(1, sizeof *port);
+    dp->ports[port_no] = port;
+    error = new_port(dp, port, port_no, netdev, NULL, dp->max_queues);
+    if (error) {
+        dp->ports[port_no] = NULL;
+        free(port);
+    }
+    return error;
 }
 #endif /* OF_HW_PLAT */
 
@@ -529,18 +669,14 @@ dp_ports_add_local(struct datapath *dp, const char *netdev)
 struct sw_port *
 dp_ports_lookup(struct datapath *dp, uint32_t port_no) {
 
-    // exclude local port from ports_num
-    uint32_t ports_num = dp->local_port ? dp->ports_num -1 : dp->ports_num;
-
     if (port_no == OFPP_LOCAL) {
         return dp->local_port;
     }
-    /* Local port already checked, so dp->ports -1 */
-    if (port_no < 1 || port_no > ports_num) {
+    if (port_no < 1 || port_no >= dp->ports_size) {
         return NULL;
     }
 
-    return &dp->ports[port_no];
+    return dp->ports[port_no];
 }
 
 struct sw_queue *
@@ -559,15 +695,36 @@ dp_ports_lookup_queue(struct sw_port *p, uint32_t queue_id)
     return NULL;
 }
 
-void
-dp_ports_output(struct datapath *dp, struct ofpbuf *buffer, uint32_t out_port,
-              uint32_t queue_id)
+/* Sends the packets queued on 'p' during a pipeline batch, in the order they
+ * were output. */
+static void
+flush_port_tx(struct sw_port *p) {
+    size_t n_sent, n_bytes, i;
+
+    if (p->n_tx_batch == 0) {
+        return;
+    }
+    n_sent = netdev_send_batch(p->netdev, p->tx_batch, p->n_tx_batch, 0,
+                               &n_bytes);
+    p->stats->tx_packets += n_sent;
+    p->stats->tx_bytes += n_bytes;
+    p->stats->tx_dropped += p->n_tx_batch - n_sent;
+    for (i = 0; i < p->n_tx_batch; i++) {
+        ofpbuf_delete(p->tx_batch[i]);
+    }
+    p->n_tx_batch = 0;
+}
+
+/* Sends 'buffer' out of port 'p' (numbered 'out_port'), which may be NULL if
+ * the port does not exist.  If 'take' is true, the output queued for
+ * flush_port_tx() is 'buffer' itself rather than a copy of it.  Returns true
+ * if 'buffer' was queued that way, false if the caller still owns it. */
+static bool
+port_output(struct datapath *dp, struct sw_port *p, struct ofpbuf *buffer,
+            uint32_t out_port, uint32_t queue_id, bool take)
 {
     uint16_t class_id;
     struct sw_queue * q;
-    struct sw_port *p;
-
-    p = dp_ports_lookup(dp, out_port);
 
     /* FIXME:  Needs update for queuing */
     #if defined(OF_HW_PLAT) && !defined(USE_NETDEV)
@@ -588,13 +745,24 @@ dp_ports_output(struct datapath *dp, struct ofpbuf *buffer, uint32_t out_port,
                 }
             }
         }
-        return;
+        return false;
     }
 
     /* Fall through to software controlled ports if not HW port */
 #endif
     if (p != NULL && p->netdev != NULL) {
         if (!(p->conf->config & OFPPC_PORT_DOWN)) {
+            /* best-effort traffic of a pipeline batch is sent at its end */
+            if (queue_id == 0 && dp->tx_batching) {
+                if (p->n_tx_batch == 0) {
+                    list_push_back(&dp->tx_ports, &p->tx_node);
+                } else if (p->n_tx_batch == DP_PORTS_BURST) {
+                    flush_port_tx(p);
+                }
+                p->tx_batch[p->n_tx_batch++] = take
+                        ? buffer : pktmem_ofpbuf_clone(dp->pktmem, buffer, 0);
+                return take;
+            }
             /* avoid the queue lookup for best-effort traffic */
             if (queue_id == 0) {
                 q = NULL;
@@ -623,29 +791,82 @@ dp_ports_output(struct datapath *dp, struct ofpbuf *buffer, uint32_t out_port,
             }
         }
         /* NOTE: no need to delete buffer, it is deleted along with the packet in caller. */
-        return;
+        return false;
     }
 
  error:
      /* NOTE: no need to delete buffer, it is deleted along with the packet. */
     VLOG_DBG_RL(LOG_MODULE, &rl, "can't forward to bad port:queue(%d:%d)\n", out_port,
                 queue_id);
+    return false;
 }
 
-int
-dp_ports_output_all(struct datapath *dp, struct ofpbuf *buffer, int in_port, bool flood)
+void
+dp_ports_output(struct datapath *dp, struct ofpbuf *buffer, uint32_t out_port,
+              uint32_t queue_id)
+{
+    port_output(dp, dp_ports_lookup(dp, out_port), buffer, out_port, queue_id,
+                false);
+}
+
+void
+dp_ports_output_take(struct datapath *dp, struct ofpbuf *buffer,
+                     uint32_t out_port, uint32_t queue_id)
+{
+    if (!port_output(dp, dp_ports_lookup(dp, out_port), buffer, out_port,
+                     queue_id, true)) {
+        ofpbuf_delete(buffer);
+    }
+}
+
+void
+dp_ports_flush_tx(struct datapath *dp) {
+    /* Only the ports output to are visited, however many there are. */
+    while (!list_is_empty(&dp->tx_ports)) {
+        struct sw_port *p = CONTAINER_OF(list_pop_front(&dp->tx_ports),
+                                         struct sw_port, tx_node);
+        flush_port_tx(p);
+    }
+}
+
+void
+dp_ports_update_output(struct datapath *dp)
 {
     struct sw_port *p;
 
+    dp->flood_ports = xrealloc(dp->flood_ports,
+                               (dp->ports_num + 1) * sizeof *dp->flood_ports);
+    dp->all_ports = xrealloc(dp->all_ports,
+                             (dp->ports_num + 1) * sizeof *dp->all_ports);
+    dp->n_flood_ports = 0;
+    dp->n_all_ports = 0;
+
     LIST_FOR_EACH (p, struct sw_port, node, &dp->port_list) {
-        if (p->stats->port_no == in_port) {
+        /* Ports administratively down would drop the packet anyway. */
+        if (p->conf != NULL && p->conf->config & OFPPC_PORT_DOWN) {
             continue;
         }
-        if (flood && p->conf->config & OFPPC_NO_FWD) {
-            continue;
+        dp->all_ports[dp->n_all_ports++] = p;
+        if (p->conf == NULL || !(p->conf->config & OFPPC_NO_FWD)) {
+            dp->flood_ports[dp->n_flood_ports++] = p;
         }
+    }
+}
 
-        dp_ports_output(dp, buffer, p->stats->port_no, 0);
+int
+dp_ports_output_all(struct datapath *dp, struct ofpbuf *buffer, int in_port, bool flood)
+{
+    struct sw_port **ports = flood ? dp->flood_ports : dp->all_ports;
+    size_t n_ports = flood ? dp->n_flood_ports : dp->n_all_ports;
+    size_t i;
+
+    for (i = 0; i < n_ports; i++) {
+        struct sw_port *p = ports[i];
+
+        if (p->stats->port_no == in_port) {
+            continue;
+        }
+        port_output(dp, p, buffer, p->stats->port_no, 0, false);
     }
 
     return 0;
@@ -676,6 +897,7 @@ dp_ports_handle_port_mod(struct datapath *dp, struct ofl_msg_port_mod *msg,
     if (msg->mask) {
         p->conf->config &= ~msg->mask;
         p->conf->config |= msg->config & msg->mask;
+        dp_ports_update_output(dp);
     }
 
     /*Notify all controllers that the port status has changed*/
@@ -689,81 +911,192 @@ dp_ports_handle_port_mod(struct datapath *dp, struct ofl_msg_port_mod *msg,
     return 0;
 }
 
+/* Folds the frames the kernel dropped on their way to 'port' since the last
+ * call into its rx_dropped counter. */
 static void
+dp_port_kernel_drops_update(struct sw_port *port) {
+    uint64_t drops;
+
+    if (IS_HW_PORT(port) || port->netdev == NULL
+        || netdev_get_rx_drops(port->netdev, &drops)) {
+        return;
+    }
+    port->stats->rx_dropped += drops - port->kernel_drops;
+    port->kernel_drops = drops;
+}
+
+void
 dp_port_stats_update(struct sw_port *port) {
     port->stats->duration_sec  =  (time_msec() - port->created) / 1000;
     port->stats->duration_nsec = ((time_msec() - port->created) % 1000) * 1000;
+    dp_port_kernel_drops_update(port);
 }
 
 ofl_err
 dp_ports_handle_stats_request_port(struct datapath *dp,
                                   struct ofl_msg_multipart_request_port *msg,
-                                  const struct sender *sender UNUSED) {
+                                  const struct sender *sender) {
     struct sw_port *port;
 
-    struct ofl_msg_multipart_reply_port reply =
-            {{{.type = OFPT_MULTIPART_REPLY},
-              .type = OFPMP_PORT_STATS, .flags = 0x0000},
-             .stats_num   = 0,
-             .stats       = NULL};
+    /* A 64 kB message holds 584 ports' stats, so with more ports the reply
+     * is spread over several, all but the last flagged with
+     * OFPMPF_REPLY_MORE. */
+    const size_t max_stats = (UINT16_MAX - sizeof(struct ofp_multipart_reply))
+                             / sizeof(struct ofp_port_stats);
+    struct remote_backlog replies = {NULL, NULL, 0};
+    struct ofl_port_stats **stats;
+    size_t stats_num = 0;
+    size_t first = 0;
 
     if (msg->port_no == OFPP_ANY) {
-        size_t i = 0;
-
-        reply.stats_num = dp->ports_num;
-        reply.stats     = xmalloc(sizeof(struct ofl_port_stats *) * dp->ports_num);
+        stats = xmalloc(sizeof(struct ofl_port_stats *) * dp->ports_num);
 
         LIST_FOR_EACH(port, struct sw_port, node, &dp->port_list) {
             dp_port_stats_update(port);
-            reply.stats[i] = port->stats;
-            i++;
+            stats[stats_num++] = port->stats;
         }
 
     } else {
+        stats = xmalloc(sizeof(struct ofl_port_stats *));
         port = dp_ports_lookup(dp, msg->port_no);
 
         if (port != NULL && port->netdev != NULL) {
-            reply.stats_num = 1;
-            reply.stats = xmalloc(sizeof(struct ofl_port_stats *));
             dp_port_stats_update(port);
-            reply.stats[0] = port->stats;
+            stats[stats_num++] = port->stats;
         }
     }
 
-    dp_send_message(dp, (struct ofl_msg_header *)&reply, sender);
+    do {
+        struct ofl_msg_multipart_reply_port reply =
+                {{{.type = OFPT_MULTIPART_REPLY},
+                  .type = OFPMP_PORT_STATS, .flags = 0x0000},
+                 .stats_num   = MIN(stats_num - first, max_stats),
+                 .stats       = stats + first};
 
-    free(reply.stats);
+        first += reply.stats_num;
+        if (first < stats_num) {
+            reply.header.flags = OFPMPF_REPLY_MORE;
+        }
+        dp_pack_reply(dp, (struct ofl_msg_header *)&reply, sender, &replies);
+    } while (first < stats_num);
+    dp_send_replies(dp, &replies, sender);
+
+    free(stats);
     ofl_msg_free((struct ofl_msg_header *)msg, dp->exp);
 
     return 0;
 }
 
 ofl_err
-dp_ports_handle_port_desc_request(struct datapath *dp,
-                                  struct ofl_msg_multipart_request_header *msg UNUSED,
-                                  const struct sender *sender UNUSED){
+dp_ports_handle_rx_stats_request(struct datapath *dp,
+                                 struct ofl_exp_openflow_msg_rx_stats_request *msg,
+                                 const struct sender *sender) {
+    /* The reply is a single message, so it is limited to as many ports as
+     * fit in one; ask for ports one at a time beyond that. */
+    const size_t max_stats = (UINT16_MAX - sizeof(struct openflow_ext_rx_stats_reply))
+                             / sizeof(struct openflow_ext_port_rx_stats);
     struct sw_port *port;
-    size_t i = 0;
+    struct pktmem_stats pktmem;
+    struct dp_pending_stats pending;
+
+    struct ofl_exp_openflow_msg_rx_stats_reply reply =
+            {{{{.type = OFPT_EXPERIMENTER},
+               .experimenter_id = OPENFLOW_VENDOR_ID},
+              .type = OFP_EXT_RX_STATS_REPLY},
+             .polls      = dp->rx_polls,
+             .busy_polls = dp->rx_busy_polls,
+             .stats_num  = 0,
+             .stats      = NULL};
+
+    pktmem_get_stats(dp->pktmem, &pktmem);
+    reply.pktmem_buffers   = pktmem.n_buffers;
+    reply.pktmem_free      = pktmem.n_free;
+    reply.pktmem_exhausted = pktmem.n_exhausted;
+    reply.pktmem_oversize  = pktmem.n_oversize;
+
+    dp_pending_get_stats(dp->pending, &pending);
+    reply.pin_suppressed = pending.n_suppressed;
+    reply.pin_released   = pending.n_released;
+    reply.pin_dropped    = pending.n_dropped;
 
+#if defined(OF_HW_PLAT) && !defined(USE_NETDEV)
+    if (dp->hw_pkt_q) {
+        reply.hw_dropped = pkt_queue_get_dropped(dp->hw_pkt_q);
+    }
+#endif
 
-    struct ofl_msg_multipart_reply_port_desc reply =
-            {{{.type = OFPT_MULTIPART_REPLY},
-             .type = OFPMP_PORT_DESC, .flags = 0x0000},
-             .stats_num   = 0,
-             .stats       = NULL};
+    if (sender->remote != NULL) {
+        struct remote *remote = sender->remote;
+        size_t i;
 
-    reply.stats_num = dp->ports_num;
-    reply.stats     = xmalloc(sizeof(struct ofl_port *) * dp->ports_num);
+        reply.conn_dropped = remote->n_dropped;
+        reply.aux_failover = remote->n_aux_failover;
+        for (i = 0; i < DP_MAX_AUX_CONNS; i++) {
+            reply.aux_dropped += remote->aux[i].n_dropped;
+        }
+    }
 
+    reply.stats = xmalloc(sizeof *reply.stats * MIN(dp->ports_num, max_stats));
     LIST_FOR_EACH(port, struct sw_port, node, &dp->port_list) {
-        reply.stats[i] = port->conf;
-        i++;
+        struct ofl_exp_openflow_port_rx_stats *s;
+
+        if (reply.stats_num >= max_stats) {
+            break;
+        }
+        if (msg->port_no != OFPP_ANY && msg->port_no != port->stats->port_no) {
+            continue;
+        }
+        dp_port_kernel_drops_update(port);
+        s = &reply.stats[reply.stats_num++];
+        s->port_no      = port->stats->port_no;
+        s->kernel_drops = port->kernel_drops;
+        s->full_bursts  = port->full_bursts;
     }
 
     dp_send_message(dp, (struct ofl_msg_header *)&reply, sender);
 
     free(reply.stats);
     ofl_msg_free((struct ofl_msg_header *)msg, dp->exp);
+    return 0;
+}
+
+ofl_err
+dp_ports_handle_port_desc_request(struct datapath *dp,
+                                  struct ofl_msg_multipart_request_header *msg UNUSED,
+                                  const struct sender *sender){
+    /* Split over several replies like the port stats, at 1023 ports per
+     * message. */
+    const size_t max_stats = (UINT16_MAX - sizeof(struct ofp_multipart_reply))
+                             / sizeof(struct ofp_port);
+    struct remote_backlog replies = {NULL, NULL, 0};
+    struct sw_port *port;
+    struct ofl_port **stats;
+    size_t stats_num = 0;
+    size_t first = 0;
+
+    stats = xmalloc(sizeof(struct ofl_port *) * dp->ports_num);
+
+    LIST_FOR_EACH(port, struct sw_port, node, &dp->port_list) {
+        stats[stats_num++] = port->conf;
+    }
+
+    do {
+        struct ofl_msg_multipart_reply_port_desc reply =
+                {{{.type = OFPT_MULTIPART_REPLY},
+                 .type = OFPMP_PORT_DESC, .flags = 0x0000},
+                 .stats_num   = MIN(stats_num - first, max_stats),
+                 .stats       = stats + first};
+
+        first += reply.stats_num;
+        if (first < stats_num) {
+            reply.header.flags = OFPMPF_REPLY_MORE;
+        }
+        dp_pack_reply(dp, (struct ofl_msg_header *)&reply, sender, &replies);
+    } while (first < stats_num);
+    dp_send_replies(dp, &replies, sender);
+
+    free(stats);
+    ofl_msg_free((struct ofl_msg_header *)msg, dp->exp);
 
     return 0;
 }
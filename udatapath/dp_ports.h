@@ -84,6 +84,17 @@ enum sw_port_flags {
 
 #define PORT_IN_USE(p) (((p) != NULL) && (p)->flags & SWP_USED)
 
+/* Default and largest number of packets received from a port, and passed
+ * through the pipeline together, per dp_ports_run() call (the datapath's
+ * 'rx_burst'). */
+#define DP_PORTS_BURST 32
+#define DP_PORTS_BURST_MAX 64
+
+/* Headroom of received packet buffers, to add headers in forwarding to the
+ * controller or adding a vlan tag, plus an extra 2 bytes to allow IP headers
+ * to be aligned on a 4-byte boundary. */
+#define DP_PORTS_HEADROOM (128 + 2)
+
 struct sw_port {
     struct list node; /* Element in datapath.ports. */
 
@@ -97,19 +108,24 @@ struct sw_port {
     uint16_t num_queues;
     uint64_t created;
     struct sw_queue queues[NETDEV_MAX_QUEUES];
+    /* Best-effort packets output while a batch is in the pipeline, sent
+     * together by dp_ports_flush_tx(). */
+    struct ofpbuf *tx_batch[DP_PORTS_BURST];
+    size_t n_tx_batch;
+    struct list tx_node;        /* In datapath's 'tx_ports' while
+                                 * 'n_tx_batch' is nonzero. */
+    uint64_t kernel_drops;      /* Kernel drops included in stats->rx_dropped. */
+    uint64_t full_bursts;       /* Receive bursts that did not drain the port. */
+    /* sFlow sampling (dp_sflow.h). */
+    uint32_t sflow_rate;        /* Received packets per sample, 0 for none. */
+    uint32_t sflow_skip;        /* Packets to receive until the next sample. */
+    uint32_t sflow_flow_seq;    /* Packet samples taken. */
+    uint32_t sflow_counter_seq; /* Counter samples taken. */
 };
 
 
-#if defined(OF_HW_PLAT)
-struct hw_pkt_q_entry {
-    struct ofpbuf *buffer;
-    struct hw_pkt_q_entry *next;
-    of_port_t port_no;
-    int reason;
-};
-#endif
-
-#define DP_MAX_PORTS 255
+/* Highest port number given to a port; the port table grows on demand. */
+#define DP_MAX_PORTS 65535
 BUILD_ASSERT_DECL(DP_MAX_PORTS <= OFPP_MAX);
 
 
@@ -139,6 +155,21 @@ void
 dp_ports_output(struct datapath *dp, struct ofpbuf *buffer, uint32_t out_port,
               uint32_t queue_id);
 
+/* Like dp_ports_output(), but takes the ownership of 'buffer', so that the
+ * output queued for dp_ports_flush_tx() needs no copy of it. */
+void
+dp_ports_output_take(struct datapath *dp, struct ofpbuf *buffer,
+                     uint32_t out_port, uint32_t queue_id);
+
+/* Rebuilds the flood and all-port output lists of the datapath.  Must be
+ * called whenever a port is added or its configuration changes. */
+void
+dp_ports_update_output(struct datapath *dp);
+
+/* Sends the packets output to each port during a pipeline batch. */
+void
+dp_ports_flush_tx(struct datapath *dp);
+
 /* Outputs a datapath packet on all ports except for in_port. If flood is set,
  * packet is not sent out on ports with flooding disabled. */
 int
@@ -149,6 +180,11 @@ ofl_err
 dp_ports_handle_port_mod(struct datapath *dp, struct ofl_msg_port_mod *msg,
                                                const struct sender *sender);
 
+/* Brings the duration and kernel drop count in the statistics of 'port' up to
+ * date. */
+void
+dp_port_stats_update(struct sw_port *port);
+
 /* Handles a port stats request message. */
 ofl_err
 dp_ports_handle_stats_request_port(struct datapath *dp,
@@ -183,5 +219,11 @@ ofl_err
 dp_ports_handle_queue_delete(struct datapath *dp, struct ofl_exp_openflow_msg_queue *msg,
         const struct sender *sender);
 
+/* Handles a receive statistics request (OpenFlow experimenter) message. */
+ofl_err
+dp_ports_handle_rx_stats_request(struct datapath *dp,
+                                 struct ofl_exp_openflow_msg_rx_stats_request *msg,
+                                 const struct sender *sender);
+
 
 #endif /* DP_PORTS_H */
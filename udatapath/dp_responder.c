@@ -0,0 +1,364 @@
+/* Copyright (c) 2008 The Board of Trustees of The Leland Stanford
+ * Junior University
+ *
+ * We are making the OpenFlow specification and associated documentation
+ * (Software) available for public use and benefit with the expectation
+ * that others will use, modify and enhance the Software and contribute
+ * those enhancements back to the community. However, since we would
+ * like to make the Software available for broadest use, with as few
+ * restrictions as possible permission is hereby granted, free of
+ * charge, to any person obtaining a copy of this Software to deal in
+ * the Software under the copyrights without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * The name and trademarks of copyright holder(s) may NOT be used in
+ * advertising or publicity pertaining to the Software or any
+ * derivatives without specific, written prior permission.
+ */
+
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dp_responder.h"
+#include "csum.h"
+#include "datapath.h"
+#include "dp_ports.h"
+#include "hash.h"
+#include "hmap.h"
+#include "ofpbuf.h"
+#include "packet.h"
+#include "packet_handle_std.h"
+#include "packets.h"
+#include "pktmem.h"
+#include "openflow/openflow.h"
+#include "openflow/openflow-ext.h"
+#include "util.h"
+#include "vlog.h"
+
+#define LOG_MODULE VLM_dp_responder
+
+static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(60, 60);
+
+/* IPv4 hosts are keyed by their IPv4-mapped IPv6 address, ::ffff:a.b.c.d. */
+static const uint8_t ipv4_mapped_prefix[12] =
+        {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff};
+
+struct responder_entry {
+    struct hmap_node node;      /* In struct dp_responder's 'entries'. */
+    uint16_t vlan_vid;          /* OFPVID_PRESENT | VLAN id, or OFPVID_NONE. */
+    uint8_t ip_addr[16];
+    uint8_t eth_addr[ETH_ADDR_LEN];
+};
+
+struct dp_responder {
+    struct datapath *dp;
+    struct hmap entries;
+};
+
+/* A neighbor advertisement with a target link-layer address option, as
+ * sent in reply to a neighbor solicitation. */
+#define ND_ADVERT_LEN 72
+#define ND_ADVERT_ICMP_LEN (ND_ADVERT_LEN - IPV6_HEADER_LEN)
+struct nd_advert {
+    struct ipv6_header ip;
+    struct icmp_header icmp;
+    uint32_t flags;
+    struct in6_addr target;
+    uint8_t opt_type;           /* ND_OPT_TLL. */
+    uint8_t opt_len;            /* In units of 8 bytes. */
+    uint8_t opt_eth_addr[ETH_ADDR_LEN];
+} __attribute__((packed));
+BUILD_ASSERT_DECL(ND_ADVERT_LEN == sizeof(struct nd_advert));
+
+#define ND_ADVERT_SOLICITED 0x40000000
+#define ND_ADVERT_OVERRIDE  0x20000000
+
+struct dp_responder *
+dp_responder_create(struct datapath *dp) {
+    struct dp_responder *r = xmalloc(sizeof *r);
+
+    r->dp = dp;
+    hmap_init(&r->entries);
+    return r;
+}
+
+static uint32_t
+responder_hash(uint16_t vlan_vid, const uint8_t *ip_addr) {
+    return hash_bytes(ip_addr, 16, vlan_vid);
+}
+
+static struct responder_entry *
+responder_lookup(const struct dp_responder *r, uint16_t vlan_vid,
+                 const uint8_t *ip_addr) {
+    struct responder_entry *e;
+
+    HMAP_FOR_EACH_WITH_HASH (e, struct responder_entry, node,
+                             responder_hash(vlan_vid, ip_addr), &r->entries) {
+        if (e->vlan_vid == vlan_vid && memcmp(e->ip_addr, ip_addr, 16) == 0) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+static void
+responder_add(struct dp_responder *r,
+              const struct ofl_exp_openflow_responder_entry *src) {
+    struct responder_entry *e;
+
+    e = responder_lookup(r, src->vlan_vid, src->ip_addr);
+    if (e == NULL) {
+        e = xmalloc(sizeof *e);
+        e->vlan_vid = src->vlan_vid;
+        memcpy(e->ip_addr, src->ip_addr, 16);
+        hmap_insert(&r->entries, &e->node,
+                    responder_hash(e->vlan_vid, e->ip_addr));
+    }
+    memcpy(e->eth_addr, src->eth_addr, ETH_ADDR_LEN);
+}
+
+static void
+responder_delete(struct dp_responder *r, struct responder_entry *e) {
+    hmap_remove(&r->entries, &e->node);
+    free(e);
+}
+
+ofl_err
+dp_responder_handle_mod(struct datapath *dp,
+                        struct ofl_exp_openflow_msg_responder_mod *msg,
+                        const struct sender *sender) {
+    struct dp_responder *r = dp->responder;
+    size_t i;
+
+    if (sender->remote->role == OFPCR_ROLE_SLAVE)
+        return ofl_error(OFPET_BAD_REQUEST, OFPBRC_IS_SLAVE);
+
+    /* Make sure the entries fit before changing the table, so that the
+     * message applies as a whole or not at all. */
+    if (msg->command != OFP_EXT_RESPONDER_DELETE) {
+        size_t n = 0;
+
+        if (msg->command == OFP_EXT_RESPONDER_ADD) {
+            n = hmap_count(&r->entries);
+            for (i = 0; i < msg->entries_num; i++) {
+                if (responder_lookup(r, msg->entries[i].vlan_vid,
+                                     msg->entries[i].ip_addr) == NULL) {
+                    n++;
+                }
+            }
+        } else {
+            n = msg->entries_num;
+        }
+        if (n > DP_RESPONDER_MAX_ENTRIES) {
+            VLOG_WARN_RL(LOG_MODULE, &rl, "Responder table would have %zu entries (max %u).",
+                         n, DP_RESPONDER_MAX_ENTRIES);
+            return ofl_error(OFPET_BAD_REQUEST, OFPBRC_EPERM);
+        }
+    }
+
+    if (msg->command == OFP_EXT_RESPONDER_REPLACE) {
+        struct responder_entry *e, *next;
+
+        HMAP_FOR_EACH_SAFE (e, next, struct responder_entry, node, &r->entries) {
+            responder_delete(r, e);
+        }
+    }
+    for (i = 0; i < msg->entries_num; i++) {
+        if (msg->command == OFP_EXT_RESPONDER_DELETE) {
+            struct responder_entry *e;
+
+            e = responder_lookup(r, msg->entries[i].vlan_vid,
+                                 msg->entries[i].ip_addr);
+            if (e != NULL) {
+                responder_delete(r, e);
+            }
+        } else {
+            responder_add(r, &msg->entries[i]);
+        }
+    }
+
+    ofl_msg_free((struct ofl_msg_header *)msg, dp->exp);
+    return 0;
+}
+
+ofl_err
+dp_responder_validate(struct datapath *dp,
+                      struct ofl_exp_openflow_act_respond *act) {
+    if ((act->miss_port <= OFPP_MAX && dp_ports_lookup(dp, act->miss_port) == NULL)
+        || act->miss_port == OFPP_TABLE) {
+        VLOG_WARN_RL(LOG_MODULE, &rl, "Respond action for invalid miss port (%u).", act->miss_port);
+        return ofl_error(OFPET_BAD_ACTION, OFPBAC_BAD_OUT_PORT);
+    }
+    return 0;
+}
+
+/* Returns the VLAN the responder table entries for 'proto' are keyed by:
+ * that of its outermost tag. */
+static uint16_t
+responder_vlan_vid(const struct protocols_std *proto) {
+    if (proto->vlan == NULL) {
+        return OFPVID_NONE;
+    }
+    return OFPVID_PRESENT | (ntohs(proto->vlan->vlan_tci) & VLAN_VID_MASK);
+}
+
+/* Replies to 'pkt' if it is an ARP request for an address in 'r'.  Returns
+ * true if it did. */
+static bool
+respond_arp(struct dp_responder *r, struct packet *pkt) {
+    struct protocols_std *proto = pkt->handle_std->proto;
+    struct arp_eth_header *arp = proto->arp;
+    struct responder_entry *e;
+    struct arp_eth_header *reply;
+    struct eth_header *eth;
+    struct ofpbuf *buf;
+    uint8_t ip_addr[16];
+
+    if (arp == NULL || proto->eth == NULL
+        || proto->mpls != NULL || proto->pbb != NULL
+        || (uint8_t *)(arp + 1) > (uint8_t *)ofpbuf_tail(pkt->buffer)
+        || arp->ar_hrd != htons(ARP_HRD_ETHERNET)
+        || arp->ar_pro != htons(ARP_PRO_IP)
+        || arp->ar_hln != ETH_ADDR_LEN || arp->ar_pln != sizeof(uint32_t)
+        || arp->ar_op != htons(ARP_OP_REQUEST)
+        /* Probes and announcements are not asking for the address. */
+        || arp->ar_spa == htonl(0) || arp->ar_spa == arp->ar_tpa) {
+        return false;
+    }
+
+    memcpy(ip_addr, ipv4_mapped_prefix, sizeof ipv4_mapped_prefix);
+    memcpy(ip_addr + sizeof ipv4_mapped_prefix, &arp->ar_tpa, sizeof(uint32_t));
+    e = responder_lookup(r, responder_vlan_vid(proto), ip_addr);
+    if (e == NULL) {
+        return false;
+    }
+
+    /* The reply is the request with its addresses rewritten, tags and
+     * all. */
+    buf = pktmem_ofpbuf_clone(pkt->dp->pktmem, pkt->buffer, DP_PORTS_HEADROOM);
+    eth = (struct eth_header *)((uint8_t *)buf->data +
+                    ((uint8_t *)proto->eth - (uint8_t *)pkt->buffer->data));
+    reply = (struct arp_eth_header *)((uint8_t *)buf->data +
+                    ((uint8_t *)arp - (uint8_t *)pkt->buffer->data));
+
+    memcpy(eth->eth_dst, proto->eth->eth_src, ETH_ADDR_LEN);
+    memcpy(eth->eth_src, e->eth_addr, ETH_ADDR_LEN);
+    reply->ar_op = htons(ARP_OP_REPLY);
+    memcpy(reply->ar_sha, e->eth_addr, ETH_ADDR_LEN);
+    reply->ar_spa = arp->ar_tpa;
+    memcpy(reply->ar_tha, arp->ar_sha, ETH_ADDR_LEN);
+    reply->ar_tpa = arp->ar_spa;
+
+    dp_ports_output_take(pkt->dp, buf, pkt->in_port, 0);
+    return true;
+}
+
+/* Replies to 'pkt' if it is an IPv6 neighbor solicitation for an address in
+ * 'r'.  Returns true if it did. */
+static bool
+respond_nd(struct dp_responder *r, struct packet *pkt) {
+    struct protocols_std *proto = pkt->handle_std->proto;
+    struct ipv6_header *ipv6 = proto->ipv6;
+    struct responder_entry *e;
+    struct icmp_header *icmp;
+    struct ipv6_nd_header *ns;
+    struct nd_advert *na;
+    struct eth_header *eth;
+    struct ofpbuf *buf;
+    size_t l2_len;
+    uint32_t sum;
+
+    if (ipv6 == NULL || proto->eth == NULL
+        || proto->mpls != NULL || proto->pbb != NULL
+        || ipv6->ipv6_next_hd != IPV6_TYPE_ICMPV6
+        || ipv6->ipv6_hop_limit != 255
+        || ntohs(ipv6->ipv6_pay_len) < ICMP_HEADER_LEN + IPV6_ND_HEADER_LEN
+        || (uint8_t *)(ipv6 + 1) + ICMP_HEADER_LEN + IPV6_ND_HEADER_LEN
+                > (uint8_t *)ofpbuf_tail(pkt->buffer)) {
+        return false;
+    }
+    icmp = (struct icmp_header *)(ipv6 + 1);
+    ns = (struct ipv6_nd_header *)(icmp + 1);
+    if (icmp->icmp_type != ICMPV6_NEIGHSOL || icmp->icmp_code != 0
+        /* Duplicate address detection is left to the owner of the
+         * address. */
+        || IN6_IS_ADDR_UNSPECIFIED(&ipv6->ipv6_src)) {
+        return false;
+    }
+
+    e = responder_lookup(r, responder_vlan_vid(proto), ns->target_addr.s6_addr);
+    if (e == NULL) {
+        return false;
+    }
+
+    /* The advertisement keeps the solicitation's link-layer header. */
+    l2_len = (uint8_t *)ipv6 - (uint8_t *)proto->eth;
+    buf = pktmem_ofpbuf_new(pkt->dp->pktmem, l2_len + ND_ADVERT_LEN,
+                            DP_PORTS_HEADROOM);
+    eth = ofpbuf_put(buf, proto->eth, l2_len);
+    na = ofpbuf_put_zeros(buf, ND_ADVERT_LEN);
+
+    memcpy(eth->eth_dst, proto->eth->eth_src, ETH_ADDR_LEN);
+    memcpy(eth->eth_src, e->eth_addr, ETH_ADDR_LEN);
+
+    na->ip.ipv6_ver_tc_fl = htonl(0x60000000);
+    na->ip.ipv6_pay_len   = htons(ND_ADVERT_ICMP_LEN);
+    na->ip.ipv6_next_hd   = IPV6_TYPE_ICMPV6;
+    na->ip.ipv6_hop_limit = 255;
+    na->ip.ipv6_src       = ns->target_addr;
+    na->ip.ipv6_dst       = ipv6->ipv6_src;
+    na->icmp.icmp_type    = ICMPV6_NEIGHADV;
+    na->flags             = htonl(ND_ADVERT_SOLICITED | ND_ADVERT_OVERRIDE);
+    na->target            = ns->target_addr;
+    na->opt_type          = ND_OPT_TLL;
+    na->opt_len           = 1;
+    memcpy(na->opt_eth_addr, e->eth_addr, ETH_ADDR_LEN);
+
+    /* Checksum over the pseudo-header and the ICMPv6 message. */
+    sum = csum_continue(0, &na->ip.ipv6_src, sizeof(struct in6_addr));
+    sum = csum_continue(sum, &na->ip.ipv6_dst, sizeof(struct in6_addr));
+    sum = csum_add32(sum, htonl(ND_ADVERT_ICMP_LEN));
+    sum = csum_add32(sum, htonl(IPV6_TYPE_ICMPV6));
+    sum = csum_continue(sum, &na->icmp, ND_ADVERT_ICMP_LEN);
+    na->icmp.icmp_csum = csum_finish(sum);
+
+    dp_ports_output_take(pkt->dp, buf, pkt->in_port, 0);
+    return true;
+}
+
+void
+dp_responder_execute(struct packet *pkt,
+                     struct ofl_exp_openflow_act_respond *act) {
+    struct dp_responder *r = pkt->dp->responder;
+
+    if (!hmap_is_empty(&r->entries)) {
+        packet_handle_std_validate_full(pkt->handle_std);
+        if (respond_arp(r, pkt) || respond_nd(r, pkt)) {
+            return;
+        }
+    }
+
+    /* Anything else is output to the miss port, as by an output action. */
+    if (act->miss_port != OFPP_ANY) {
+        pkt->out_port = act->miss_port;
+        if (act->miss_port == OFPP_CONTROLLER) {
+            pkt->out_port_max_len = act->max_len;
+        }
+    }
+}
@@ -0,0 +1,75 @@
+/* Copyright (c) 2008 The Board of Trustees of The Leland Stanford
+ * Junior University
+ *
+ * We are making the OpenFlow specification and associated documentation
+ * (Software) available for public use and benefit with the expectation
+ * that others will use, modify and enhance the Software and contribute
+ * those enhancements back to the community. However, since we would
+ * like to make the Software available for broadest use, with as few
+ * restrictions as possible permission is hereby granted, free of
+ * charge, to any person obtaining a copy of this Software to deal in
+ * the Software under the copyrights without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * The name and trademarks of copyright holder(s) may NOT be used in
+ * advertising or publicity pertaining to the Software or any
+ * derivatives without specific, written prior permission.
+ */
+
+#ifndef DP_RESPONDER_H
+#define DP_RESPONDER_H 1
+
+#include "oflib/ofl.h"
+#include "oflib-exp/ofl-exp-openflow.h"
+
+/****************************************************************************
+ * The neighbor responder: ARP requests and IPv6 neighbor solicitations
+ * answered by the datapath, from a table of (VLAN, address) -> Ethernet
+ * address entries set by the controller, for flow entries applying the
+ * OFP_EXT_ACT_RESPOND action.  The replies are sent out the input port of
+ * the request.
+ ****************************************************************************/
+
+struct datapath;
+struct packet;
+struct sender;
+
+/* Most entries in the responder table. */
+#define DP_RESPONDER_MAX_ENTRIES 65536
+
+/* Creates the (empty) responder table of 'dp'. */
+struct dp_responder *
+dp_responder_create(struct datapath *dp);
+
+/* Handles an OFP_EXT_RESPONDER_MOD message. */
+ofl_err
+dp_responder_handle_mod(struct datapath *dp,
+                        struct ofl_exp_openflow_msg_responder_mod *msg,
+                        const struct sender *sender);
+
+/* Checks that the respond action 'act' can be executed by 'dp'. */
+ofl_err
+dp_responder_validate(struct datapath *dp,
+                      struct ofl_exp_openflow_act_respond *act);
+
+/* Executes the respond action 'act' on 'pkt'. */
+void
+dp_responder_execute(struct packet *pkt,
+                     struct ofl_exp_openflow_act_respond *act);
+
+#endif /* DP_RESPONDER_H */
@@ -0,0 +1,490 @@
+/* Copyright (c) 2008 The Board of Trustees of The Leland Stanford
+ * Junior University
+ *
+ * We are making the OpenFlow specification and associated documentation
+ * (Software) available for public use and benefit with the expectation
+ * that others will use, modify and enhance the Software and contribute
+ * those enhancements back to the community. However, since we would
+ * like to make the Software available for broadest use, with as few
+ * restrictions as possible permission is hereby granted, free of
+ * charge, to any person obtaining a copy of this Software to deal in
+ * the Software under the copyrights without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * The name and trademarks of copyright holder(s) may NOT be used in
+ * advertising or publicity pertaining to the Software or any
+ * derivatives without specific, written prior permission.
+ */
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <limits.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "dp_sflow.h"
+#include "datapath.h"
+#include "dp_ports.h"
+#include "ofpbuf.h"
+#include "openflow/openflow.h"
+#include "openflow/openflow-ext.h"
+#include "packet.h"
+#include "poll-loop.h"
+#include "random.h"
+#include "socket-util.h"
+#include "timeval.h"
+#include "util.h"
+#include "vlog.h"
+
+#define LOG_MODULE VLM_dp_sflow
+
+static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(60, 60);
+
+#define SFLOW_VERSION 5
+#define SFLOW_PORT 6343
+
+/* Datagrams are kept below the path MTU of most networks. */
+#define SFLOW_MAX_DATAGRAM 1400
+
+/* Longest a sample waits in a datagram that is not full, in ms. */
+#define SFLOW_MAX_DELAY 100
+
+/* Structure formats (enterprise 0). */
+#define SFLOW_FLOW_SAMPLE 1
+#define SFLOW_COUNTERS_SAMPLE 2
+#define SFLOW_RAW_HEADER 1
+#define SFLOW_GENERIC_IF_COUNTERS 1
+#define SFLOW_HEADER_PROTO_ETHERNET 1
+#define SFLOW_ADDRESS_IP_V4 1
+
+/* The OpenFlow table and cookie a sample matched have no standard record,
+ * so they go in a record of the enterprise of our OpenFlow extensions. */
+#define SFLOW_OPENFLOW_MATCH ((OPENFLOW_VENDOR_ID << 12) | 1)
+
+/* Interface values for a packet received or sent by the switch itself (the
+ * local port or the controller) and for a packet sent to multiple ports. */
+#define SFLOW_IF_INTERNAL 0x3fffffff
+#define SFLOW_IF_MULTIPLE 0x80000000
+
+/* Value of a counter that is not kept. */
+#define SFLOW_COUNTER_UNKNOWN 0xffffffff
+
+/* Port-specific sampling rate. */
+struct sflow_rate {
+    uint32_t port_no;
+    uint32_t rate;
+};
+
+struct dp_sflow {
+    int fd;                     /* UDP socket connected to the collector. */
+    struct in_addr agent;       /* Local address of 'fd'. */
+    long long int boot;         /* time_msec() when sampling started. */
+
+    uint32_t default_rate;
+    struct sflow_rate *rates;
+    size_t n_rates;
+
+    unsigned int polling;       /* Seconds between counter samples. */
+    long long int next_poll;    /* time_msec() of the next ones. */
+
+    struct ofpbuf *datagram;    /* Datagram being filled. */
+    uint32_t n_samples;         /* Samples in 'datagram'. */
+    uint32_t seq;               /* Sequence number of 'datagram'. */
+    long long int flush_at;     /* time_msec() by which to send 'datagram'. */
+};
+
+static uint32_t
+sflow_interface(uint32_t port_no) {
+    return port_no < OFPP_MAX ? port_no : SFLOW_IF_INTERNAL;
+}
+
+static void
+put_u32(struct ofpbuf *b, uint32_t x) {
+    uint32_t be = htonl(x);
+    ofpbuf_put(b, &be, sizeof be);
+}
+
+static void
+put_u64(struct ofpbuf *b, uint64_t x) {
+    put_u32(b, x >> 32);
+    put_u32(b, x);
+}
+
+static void
+sflow_start_datagram(struct dp_sflow *sf) {
+    struct ofpbuf *b = sf->datagram;
+
+    ofpbuf_clear(b);
+    put_u32(b, SFLOW_VERSION);
+    put_u32(b, SFLOW_ADDRESS_IP_V4);
+    ofpbuf_put(b, &sf->agent, sizeof sf->agent);
+    put_u32(b, 0);              /* Sub-agent ID. */
+    put_u32(b, 0);              /* Sequence number, uptime and number of */
+    put_u32(b, 0);              /* samples, filled in by sflow_flush(). */
+    put_u32(b, 0);
+    sf->n_samples = 0;
+}
+
+static void
+sflow_flush(struct dp_sflow *sf) {
+    uint32_t *tail;
+
+    if (!sf->n_samples) {
+        return;
+    }
+    tail = ofpbuf_at_assert(sf->datagram, 16, 3 * sizeof *tail);
+    tail[0] = htonl(++sf->seq);
+    tail[1] = htonl(time_msec() - sf->boot);
+    tail[2] = htonl(sf->n_samples);
+    if (send(sf->fd, sf->datagram->data, sf->datagram->size, 0) < 0) {
+        VLOG_WARN_RL(LOG_MODULE, &rl, "failed to send sFlow datagram (%s)",
+                     strerror(errno));
+    }
+    sflow_start_datagram(sf);
+}
+
+/* Makes room for a sample of 'len' bytes in the datagram of 'sf', sending
+ * the datagram first if it is too full. */
+static void
+sflow_add_sample(struct dp_sflow *sf, size_t len) {
+    if (sf->n_samples && sf->datagram->size + len > SFLOW_MAX_DATAGRAM) {
+        sflow_flush(sf);
+    }
+    if (!sf->n_samples) {
+        sf->flush_at = time_msec() + SFLOW_MAX_DELAY;
+    }
+    sf->n_samples++;
+}
+
+static uint32_t
+sflow_port_rate(const struct dp_sflow *sf, uint32_t port_no) {
+    size_t i;
+
+    for (i = 0; i < sf->n_rates; i++) {
+        if (sf->rates[i].port_no == port_no) {
+            return sf->rates[i].rate;
+        }
+    }
+    return sf->default_rate;
+}
+
+/* Returns the number of packets to let pass before the next sample, chosen
+ * at random so that one in 'rate' packets is sampled on average. */
+static uint32_t
+sflow_skip(uint32_t rate) {
+    return rate > 1 ? 1 + random_range(2 * rate - 1) : rate;
+}
+
+static int
+sflow_parse_rates(struct dp_sflow *sf, const char *rates_) {
+    char *rates = xstrdup(rates_);
+    char *token, *save_ptr = NULL;
+    int error = 0;
+
+    for (token = strtok_r(rates, ",", &save_ptr); token;
+         token = strtok_r(NULL, ",", &save_ptr)) {
+        char *equals = strchr(token, '=');
+        char *tail;
+        unsigned long int rate;
+
+        rate = strtoul(equals ? equals + 1 : token, &tail, 10);
+        if (*tail != '\0' || rate > INT32_MAX / 2) {
+            error = EINVAL;
+            break;
+        }
+        if (equals) {
+            struct sflow_rate *r;
+
+            *equals = '\0';
+            sf->rates = xrealloc(sf->rates, (sf->n_rates + 1) * sizeof *r);
+            r = &sf->rates[sf->n_rates++];
+            r->port_no = strtoul(token, &tail, 10);
+            r->rate = rate;
+            if (*tail != '\0') {
+                error = EINVAL;
+                break;
+            }
+        } else {
+            sf->default_rate = rate;
+        }
+    }
+    free(rates);
+    return error;
+}
+
+static int
+sflow_open_socket(struct dp_sflow *sf, const char *target_) {
+    char *target = xstrdup(target_);
+    char *colon = strrchr(target, ':');
+    struct sockaddr_in sin;
+    socklen_t sin_len;
+    int error;
+
+    memset(&sin, 0, sizeof sin);
+    sin.sin_family = AF_INET;
+    sin.sin_port = htons(SFLOW_PORT);
+    if (colon) {
+        *colon = '\0';
+        sin.sin_port = htons(atoi(colon + 1));
+    }
+    error = lookup_ip(target, &sin.sin_addr);
+    free(target);
+    if (error) {
+        return error;
+    }
+
+    sf->fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sf->fd < 0) {
+        return errno;
+    }
+    sin_len = sizeof sin;
+    if (connect(sf->fd, (struct sockaddr *) &sin, sizeof sin) < 0
+        || getsockname(sf->fd, (struct sockaddr *) &sin, &sin_len) < 0) {
+        error = errno;
+        close(sf->fd);
+        return error;
+    }
+    sf->agent = sin.sin_addr;
+    error = set_nonblocking(sf->fd);
+    if (error) {
+        close(sf->fd);
+    }
+    return error;
+}
+
+int
+dp_sflow_enable(struct datapath *dp, const char *target, const char *rates,
+                unsigned int polling) {
+    struct dp_sflow *sf;
+    struct sw_port *port;
+    int error;
+
+    sf = xmalloc(sizeof *sf);
+    sf->default_rate = DP_SFLOW_DEFAULT_RATE;
+    sf->rates = NULL;
+    sf->n_rates = 0;
+    error = rates ? sflow_parse_rates(sf, rates) : 0;
+    if (!error) {
+        error = sflow_open_socket(sf, target);
+    }
+    if (error) {
+        free(sf->rates);
+        free(sf);
+        return error;
+    }
+
+    sf->boot = time_msec();
+    sf->polling = polling;
+    sf->next_poll = sf->boot + polling * 1000LL;
+    sf->datagram = ofpbuf_new(SFLOW_MAX_DATAGRAM);
+    sf->seq = 0;
+    sflow_start_datagram(sf);
+    dp->sflow = sf;
+
+    LIST_FOR_EACH (port, struct sw_port, node, &dp->port_list) {
+        dp_sflow_init_port(dp, port);
+    }
+    return 0;
+}
+
+void
+dp_sflow_init_port(struct datapath *dp, struct sw_port *port) {
+    port->sflow_flow_seq = 0;
+    port->sflow_counter_seq = 0;
+    if (dp->sflow != NULL) {
+        port->sflow_rate = sflow_port_rate(dp->sflow, port->stats->port_no);
+        port->sflow_skip = sflow_skip(port->sflow_rate);
+    } else {
+        port->sflow_rate = 0;
+        port->sflow_skip = 0;
+    }
+}
+
+void
+dp_sflow_sample_packet(struct datapath *dp UNUSED, struct sw_port *port,
+                       struct packet *pkt) {
+    struct dp_sflow_sample *s = xmalloc(sizeof *s);
+
+    s->source = port->stats->port_no;
+    s->input = sflow_interface(port->stats->port_no);
+    s->output = 0;
+    s->rate = port->sflow_rate;
+    s->pool = port->stats->rx_packets;
+    s->seq = ++port->sflow_flow_seq;
+    s->matched = false;
+    s->frame_len = pkt->buffer->size;
+    s->header_len = MIN(pkt->buffer->size, DP_SFLOW_HEADER_LEN);
+    memcpy(s->header, pkt->buffer->data, s->header_len);
+    pkt->sflow = s;
+
+    port->sflow_skip = sflow_skip(port->sflow_rate);
+}
+
+void
+dp_sflow_sample_match(struct dp_sflow_sample *s, uint8_t table_id,
+                      uint64_t cookie) {
+    s->matched = true;
+    s->table_id = table_id;
+    s->cookie = cookie;
+}
+
+void
+dp_sflow_sample_output(struct dp_sflow_sample *s, uint32_t port_no) {
+    uint32_t output;
+
+    switch (port_no) {
+    case OFPP_TABLE:
+        return;
+    case OFPP_IN_PORT:
+        output = s->input;
+        break;
+    case OFPP_FLOOD:
+    case OFPP_ALL:
+        output = SFLOW_IF_MULTIPLE;
+        break;
+    default:
+        output = sflow_interface(port_no);
+        break;
+    }
+    s->output = s->output && s->output != output ? SFLOW_IF_MULTIPLE : output;
+}
+
+void
+dp_sflow_sample_done(struct datapath *dp, struct dp_sflow_sample *s) {
+    struct dp_sflow *sf = dp->sflow;
+    struct ofpbuf *b = sf->datagram;
+    size_t header_pad = ROUND_UP(s->header_len, 4);
+    size_t raw_len = 16 + header_pad;
+    size_t match_len = s->matched ? 12 : 0;
+    size_t len = 32 + 8 + raw_len + (match_len ? 8 + match_len : 0);
+
+    sflow_add_sample(sf, 8 + len);
+    put_u32(b, SFLOW_FLOW_SAMPLE);
+    put_u32(b, len);
+    put_u32(b, s->seq);
+    put_u32(b, s->source & 0xffffff);
+    put_u32(b, s->rate);
+    put_u32(b, s->pool);
+    put_u32(b, 0);              /* Drops. */
+    put_u32(b, s->input);
+    put_u32(b, s->output);
+    put_u32(b, match_len ? 2 : 1);
+
+    put_u32(b, SFLOW_RAW_HEADER);
+    put_u32(b, raw_len);
+    put_u32(b, SFLOW_HEADER_PROTO_ETHERNET);
+    put_u32(b, s->frame_len + 4); /* With the FCS... */
+    put_u32(b, 4);                /* ...which the header lacks. */
+    put_u32(b, s->header_len);
+    ofpbuf_put(b, s->header, s->header_len);
+    ofpbuf_put_zeros(b, header_pad - s->header_len);
+
+    if (match_len) {
+        put_u32(b, SFLOW_OPENFLOW_MATCH);
+        put_u32(b, match_len);
+        put_u32(b, s->table_id);
+        put_u64(b, s->cookie);
+    }
+    free(s);
+}
+
+static void
+sflow_sample_counters(struct dp_sflow *sf, struct sw_port *port) {
+    const struct ofl_port_stats *ps = port->stats;
+    struct ofpbuf *b = sf->datagram;
+    uint32_t status = 0;
+
+    dp_port_stats_update(port);
+    if (!(port->conf->config & OFPPC_PORT_DOWN)) {
+        status |= 1;            /* ifAdminStatus up. */
+        if (!(port->conf->state & OFPPS_LINK_DOWN)) {
+            status |= 2;        /* ifOperStatus up. */
+        }
+    }
+
+    sflow_add_sample(sf, 8 + 12 + 8 + 88);
+    put_u32(b, SFLOW_COUNTERS_SAMPLE);
+    put_u32(b, 12 + 8 + 88);
+    put_u32(b, ++port->sflow_counter_seq);
+    put_u32(b, ps->port_no & 0xffffff);
+    put_u32(b, 1);
+
+    put_u32(b, SFLOW_GENERIC_IF_COUNTERS);
+    put_u32(b, 88);
+    put_u32(b, ps->port_no & 0xffffff); /* ifIndex. */
+    put_u32(b, 6);                      /* ifType: ethernetCsmacd. */
+    put_u64(b, (uint64_t) port->conf->curr_speed * 1000);
+    put_u32(b, 1);                      /* ifDirection: full duplex. */
+    put_u32(b, status);
+    put_u64(b, ps->rx_bytes);
+    put_u32(b, ps->rx_packets);
+    put_u32(b, SFLOW_COUNTER_UNKNOWN);  /* ifInMulticastPkts. */
+    put_u32(b, SFLOW_COUNTER_UNKNOWN);  /* ifInBroadcastPkts. */
+    put_u32(b, ps->rx_dropped);
+    put_u32(b, ps->rx_errors);
+    put_u32(b, SFLOW_COUNTER_UNKNOWN);  /* ifInUnknownProtos. */
+    put_u64(b, ps->tx_bytes);
+    put_u32(b, ps->tx_packets);
+    put_u32(b, SFLOW_COUNTER_UNKNOWN);  /* ifOutMulticastPkts. */
+    put_u32(b, SFLOW_COUNTER_UNKNOWN);  /* ifOutBroadcastPkts. */
+    put_u32(b, ps->tx_dropped);
+    put_u32(b, ps->tx_errors);
+    put_u32(b, 0);                      /* ifPromiscuousMode. */
+}
+
+void
+dp_sflow_run(struct datapath *dp) {
+    struct dp_sflow *sf = dp->sflow;
+    long long int now;
+
+    if (sf == NULL) {
+        return;
+    }
+    now = time_msec();
+    if (sf->polling && now >= sf->next_poll) {
+        struct sw_port *port;
+
+        LIST_FOR_EACH (port, struct sw_port, node, &dp->port_list) {
+            sflow_sample_counters(sf, port);
+        }
+        sf->next_poll = now + sf->polling * 1000LL;
+    }
+    if (sf->n_samples && now >= sf->flush_at) {
+        sflow_flush(sf);
+    }
+}
+
+void
+dp_sflow_wait(struct datapath *dp) {
+    struct dp_sflow *sf = dp->sflow;
+    long long int next;
+
+    if (sf == NULL) {
+        return;
+    }
+    next = sf->polling ? sf->next_poll : LLONG_MAX;
+    if (sf->n_samples) {
+        next = MIN(next, sf->flush_at);
+    }
+    if (next != LLONG_MAX) {
+        poll_timer_wait(MAX(0, next - time_msec()));
+    }
+}
@@ -0,0 +1,117 @@
+/* Copyright (c) 2008 The Board of Trustees of The Leland Stanford
+ * Junior University
+ *
+ * We are making the OpenFlow specification and associated documentation
+ * (Software) available for public use and benefit with the expectation
+ * that others will use, modify and enhance the Software and contribute
+ * those enhancements back to the community. However, since we would
+ * like to make the Software available for broadest use, with as few
+ * restrictions as possible permission is hereby granted, free of
+ * charge, to any person obtaining a copy of this Software to deal in
+ * the Software under the copyrights without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * The name and trademarks of copyright holder(s) may NOT be used in
+ * advertising or publicity pertaining to the Software or any
+ * derivatives without specific, written prior permission.
+ */
+
+#ifndef DP_SFLOW_H
+#define DP_SFLOW_H 1
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/****************************************************************************
+ * sFlow version 5 export: 1-in-N random sampling of the packets received on
+ * each port, and periodic counter samples of every port, sent over UDP to a
+ * collector.
+ ****************************************************************************/
+
+struct datapath;
+struct packet;
+struct sw_port;
+
+/* Default rate, in received packets per sample, and counter polling
+ * interval, in seconds. */
+#define DP_SFLOW_DEFAULT_RATE 400
+#define DP_SFLOW_DEFAULT_POLLING 20
+
+/* Bytes of the packet headers copied into a sample. */
+#define DP_SFLOW_HEADER_LEN 128
+
+/* A packet sample, from its arrival to the end of its trip through the
+ * pipeline. */
+struct dp_sflow_sample {
+    uint32_t input;             /* sFlow interface of the ingress port. */
+    uint32_t output;            /* sFlow interface of the egress port(s). */
+    uint32_t source;            /* Port number of the ingress port. */
+    uint32_t rate;              /* Sampling rate of the ingress port. */
+    uint32_t pool;              /* Packets the ingress port received. */
+    uint32_t seq;               /* Sample sequence number of the port. */
+    bool matched;               /* Whether a flow entry matched. */
+    uint8_t table_id;           /* Table and cookie of the last one. */
+    uint64_t cookie;
+    uint32_t frame_len;
+    uint32_t header_len;
+    uint8_t header[DP_SFLOW_HEADER_LEN];
+};
+
+/* Starts sampling to the collector at 'target', "HOST[:PORT]".  'rates' is
+ * a comma-separated list of rates, each either plain, for the ports not
+ * listed, or "PORT=RATE"; a rate of 0 disables sampling; null selects
+ * DP_SFLOW_DEFAULT_RATE for all ports.  Counters are sent every 'polling'
+ * seconds, if nonzero.  Returns 0 if successful, otherwise a positive errno
+ * value. */
+int
+dp_sflow_enable(struct datapath *dp, const char *target, const char *rates,
+                unsigned int polling);
+
+/* Sets up sampling of a newly added port. */
+void
+dp_sflow_init_port(struct datapath *dp, struct sw_port *port);
+
+/* Takes a sample of 'pkt', just received on 'port'. */
+void
+dp_sflow_sample_packet(struct datapath *dp, struct sw_port *port,
+                       struct packet *pkt);
+
+/* Records that the sampled packet matched a flow entry of 'table_id' with
+ * 'cookie'. */
+void
+dp_sflow_sample_match(struct dp_sflow_sample *sample, uint8_t table_id,
+                      uint64_t cookie);
+
+/* Records that the sampled packet was output to 'port_no'. */
+void
+dp_sflow_sample_output(struct dp_sflow_sample *sample, uint32_t port_no);
+
+/* Queues 'sample', whose packet finished its trip, for export and frees
+ * it. */
+void
+dp_sflow_sample_done(struct datapath *dp, struct dp_sflow_sample *sample);
+
+/* Sends counter samples and queued packet samples that are due. */
+void
+dp_sflow_run(struct datapath *dp);
+
+/* Wakes poll_block() for the next sending. */
+void
+dp_sflow_wait(struct datapath *dp);
+
+#endif /* DP_SFLOW_H */
@@ -0,0 +1,309 @@
+/* Copyright (c) 2008 The Board of Trustees of The Leland Stanford
+ * Junior University
+ *
+ * We are making the OpenFlow specification and associated documentation
+ * (Software) available for public use and benefit with the expectation
+ * that others will use, modify and enhance the Software and contribute
+ * those enhancements back to the community. However, since we would
+ * like to make the Software available for broadest use, with as few
+ * restrictions as possible permission is hereby granted, free of
+ * charge, to any person obtaining a copy of this Software to deal in
+ * the Software under the copyrights without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * The name and trademarks of copyright holder(s) may NOT be used in
+ * advertising or publicity pertaining to the Software or any
+ * derivatives without specific, written prior permission.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "dp_stats_shm.h"
+#include "datapath.h"
+#include "dp_ports.h"
+#include "flow_entry.h"
+#include "flow_table.h"
+#include "group_entry.h"
+#include "group_table.h"
+#include "meter_entry.h"
+#include "meter_table.h"
+#include "pipeline.h"
+#include "poll-loop.h"
+#include "stats-shm.h"
+#include "timeval.h"
+#include "util.h"
+#include "vlog.h"
+
+#define LOG_MODULE VLM_dp_stats_shm
+
+static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(60, 60);
+
+struct dp_stats_shm {
+    struct stats_shm *shm;
+    unsigned int interval;      /* Milliseconds between updates. */
+    long long int next;         /* time_msec() of the next update. */
+
+    /* Totals by cookie, if exported.  Walking every flow is too costly for
+     * every update, so they are collected every 'cookie_interval' ms only,
+     * and exported again as they are by the updates in between. */
+    unsigned int cookie_interval; /* 0 if cookies are not exported. */
+    long long int next_cookies; /* time_msec() of the next collection. */
+    struct stats_shm_cookie *flows;
+    size_t allocated_flows;
+    size_t n_cookies;           /* Cookies in 'flows' at the last collection. */
+};
+
+int
+dp_stats_shm_enable(struct datapath *dp, const char *path,
+                    unsigned int interval, unsigned int cookie_interval) {
+    struct dp_stats_shm *s;
+    struct stats_shm *shm;
+    int error;
+
+    error = stats_shm_create(path, &shm);
+    if (error) {
+        return error;
+    }
+
+    s = xmalloc(sizeof *s);
+    s->shm = shm;
+    s->interval = MAX(interval, 1);
+    s->next = time_msec();
+    s->cookie_interval = cookie_interval;
+    s->next_cookies = s->next;
+    s->flows = NULL;
+    s->allocated_flows = 0;
+    s->n_cookies = 0;
+    dp->stats_shm = s;
+    return 0;
+}
+
+static int
+compare_cookies(const void *a_, const void *b_) {
+    const struct stats_shm_cookie *a = a_;
+    const struct stats_shm_cookie *b = b_;
+
+    return a->cookie < b->cookie ? -1 : a->cookie > b->cookie;
+}
+
+/* Sums up the counters of the flows of 'dp' by cookie into 's->flows', and
+ * returns the number of distinct cookies, in increasing order. */
+static size_t
+collect_cookies(struct datapath *dp, struct dp_stats_shm *s) {
+    size_t n_flows = 0, n_cookies = 0;
+    size_t i;
+
+    for (i = 0; i < PIPELINE_TABLES; i++) {
+        struct flow_table *table = dp->pipeline->tables[i];
+        struct flow_entry *entry;
+
+        LIST_FOR_EACH (entry, struct flow_entry, match_node,
+                       &table->match_entries) {
+            struct stats_shm_cookie *c;
+
+            if (n_flows >= s->allocated_flows) {
+                s->flows = x2nrealloc(s->flows, &s->allocated_flows,
+                                      sizeof *s->flows);
+            }
+            c = &s->flows[n_flows++];
+            c->cookie = entry->stats->cookie;
+            c->n_flows = 1;
+            c->packet_count = entry->no_pkt_count ? 0
+                                                  : entry->stats->packet_count;
+            c->byte_count = entry->no_byt_count ? 0 : entry->stats->byte_count;
+        }
+    }
+
+    qsort(s->flows, n_flows, sizeof *s->flows, compare_cookies);
+    for (i = 0; i < n_flows; i++) {
+        struct stats_shm_cookie *c = &s->flows[i];
+
+        if (n_cookies && s->flows[n_cookies - 1].cookie == c->cookie) {
+            struct stats_shm_cookie *total = &s->flows[n_cookies - 1];
+
+            total->n_flows++;
+            total->packet_count += c->packet_count;
+            total->byte_count += c->byte_count;
+        } else {
+            s->flows[n_cookies++] = *c;
+        }
+    }
+    return n_cookies;
+}
+
+static void
+export_ports(struct datapath *dp, struct stats_shm_port *records) {
+    struct sw_port *port;
+
+    LIST_FOR_EACH (port, struct sw_port, node, &dp->port_list) {
+        const struct ofl_port_stats *ps = port->stats;
+        struct stats_shm_port *r = records++;
+
+        dp_port_stats_update(port);
+        r->port_no = ps->port_no;
+        r->duration_sec = ps->duration_sec;
+        r->rx_packets = ps->rx_packets;
+        r->tx_packets = ps->tx_packets;
+        r->rx_bytes = ps->rx_bytes;
+        r->tx_bytes = ps->tx_bytes;
+        r->rx_dropped = ps->rx_dropped;
+        r->tx_dropped = ps->tx_dropped;
+        r->rx_errors = ps->rx_errors;
+        r->tx_errors = ps->tx_errors;
+        r->rx_frame_err = ps->rx_frame_err;
+        r->rx_over_err = ps->rx_over_err;
+        r->rx_crc_err = ps->rx_crc_err;
+        r->collisions = ps->collisions;
+    }
+}
+
+static void
+export_queues(struct datapath *dp, struct stats_shm_queue *records) {
+    struct sw_port *port;
+
+    LIST_FOR_EACH (port, struct sw_port, node, &dp->port_list) {
+        size_t i;
+
+        for (i = 0; i < port->max_queues; i++) {
+            const struct ofl_queue_stats *qs = port->queues[i].stats;
+            struct stats_shm_queue *r;
+
+            if (port->queues[i].port == NULL) {
+                continue;
+            }
+            r = records++;
+            r->port_no = qs->port_no;
+            r->queue_id = qs->queue_id;
+            r->tx_bytes = qs->tx_bytes;
+            r->tx_packets = qs->tx_packets;
+            r->tx_errors = qs->tx_errors;
+        }
+    }
+}
+
+static void
+export_tables(struct datapath *dp, struct stats_shm_table *records) {
+    size_t i;
+
+    for (i = 0; i < PIPELINE_TABLES; i++) {
+        const struct ofl_table_stats *ts = dp->pipeline->tables[i]->stats;
+        struct stats_shm_table *r = &records[i];
+
+        r->table_id = ts->table_id;
+        memset(r->pad, 0, sizeof r->pad);
+        r->active_count = ts->active_count;
+        r->lookup_count = ts->lookup_count;
+        r->matched_count = ts->matched_count;
+    }
+}
+
+static void
+export_groups(struct datapath *dp, struct stats_shm_group *records) {
+    struct group_entry *entry;
+
+    HMAP_FOR_EACH (entry, struct group_entry, node, &dp->groups->entries) {
+        struct stats_shm_group *r = records++;
+
+        r->group_id = entry->stats->group_id;
+        r->ref_count = entry->stats->ref_count;
+        r->packet_count = entry->stats->packet_count;
+        r->byte_count = entry->stats->byte_count;
+    }
+}
+
+static void
+export_meters(struct datapath *dp, struct stats_shm_meter *records) {
+    struct meter_entry *entry;
+
+    HMAP_FOR_EACH (entry, struct meter_entry, node,
+                   &dp->meters->meter_entries) {
+        struct stats_shm_meter *r = records++;
+
+        r->meter_id = entry->stats->meter_id;
+        r->flow_count = entry->stats->flow_count;
+        r->packet_in_count = entry->stats->packet_in_count;
+        r->byte_in_count = entry->stats->byte_in_count;
+    }
+}
+
+static void
+dp_stats_shm_update(struct datapath *dp, struct dp_stats_shm *s) {
+    size_t n[STATS_SHM_N_TYPES];
+    struct sw_port *port;
+    int error;
+
+    n[STATS_SHM_PORTS] = dp->ports_num;
+    n[STATS_SHM_QUEUES] = 0;
+    LIST_FOR_EACH (port, struct sw_port, node, &dp->port_list) {
+        size_t i;
+
+        for (i = 0; i < port->max_queues; i++) {
+            n[STATS_SHM_QUEUES] += port->queues[i].port != NULL;
+        }
+    }
+    n[STATS_SHM_TABLES] = PIPELINE_TABLES;
+    n[STATS_SHM_GROUPS] = dp->groups->entries_num;
+    n[STATS_SHM_METERS] = dp->meters->entries_num;
+    if (s->cookie_interval && time_msec() >= s->next_cookies) {
+        s->n_cookies = collect_cookies(dp, s);
+        s->next_cookies = time_msec() + s->cookie_interval;
+    }
+    n[STATS_SHM_COOKIES] = s->n_cookies;
+
+    error = stats_shm_begin(s->shm, n);
+    if (error) {
+        VLOG_WARN_RL(LOG_MODULE, &rl, "failed to update statistics in shared "
+                     "memory (%s)", strerror(error));
+        return;
+    }
+    export_ports(dp, stats_shm_records(s->shm, STATS_SHM_PORTS));
+    export_queues(dp, stats_shm_records(s->shm, STATS_SHM_QUEUES));
+    export_tables(dp, stats_shm_records(s->shm, STATS_SHM_TABLES));
+    export_groups(dp, stats_shm_records(s->shm, STATS_SHM_GROUPS));
+    export_meters(dp, stats_shm_records(s->shm, STATS_SHM_METERS));
+    if (n[STATS_SHM_COOKIES]) {
+        memcpy(stats_shm_records(s->shm, STATS_SHM_COOKIES), s->flows,
+               n[STATS_SHM_COOKIES] * sizeof *s->flows);
+    }
+    stats_shm_commit(s->shm, dp->id, s->interval);
+}
+
+void
+dp_stats_shm_run(struct datapath *dp) {
+    struct dp_stats_shm *s = dp->stats_shm;
+    long long int now;
+
+    if (s == NULL) {
+        return;
+    }
+    now = time_msec();
+    if (now >= s->next) {
+        dp_stats_shm_update(dp, s);
+        s->next = now + s->interval;
+    }
+}
+
+void
+dp_stats_shm_wait(struct datapath *dp) {
+    struct dp_stats_shm *s = dp->stats_shm;
+
+    if (s != NULL) {
+        poll_timer_wait(MAX(0, s->next - time_msec()));
+    }
+}
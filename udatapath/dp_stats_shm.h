@@ -0,0 +1,66 @@
+/* Copyright (c) 2008 The Board of Trustees of The Leland Stanford
+ * Junior University
+ *
+ * We are making the OpenFlow specification and associated documentation
+ * (Software) available for public use and benefit with the expectation
+ * that others will use, modify and enhance the Software and contribute
+ * those enhancements back to the community. However, since we would
+ * like to make the Software available for broadest use, with as few
+ * restrictions as possible permission is hereby granted, free of
+ * charge, to any person obtaining a copy of this Software to deal in
+ * the Software under the copyrights without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * The name and trademarks of copyright holder(s) may NOT be used in
+ * advertising or publicity pertaining to the Software or any
+ * derivatives without specific, written prior permission.
+ */
+
+#ifndef DP_STATS_SHM_H
+#define DP_STATS_SHM_H 1
+
+
+/****************************************************************************
+ * Export of the datapath's statistics through shared memory (stats-shm.h),
+ * for local monitoring that must not cost the datapath a request each time.
+ ****************************************************************************/
+
+struct datapath;
+
+/* Default interval between collections of the totals by cookie, in ms. */
+#define DP_STATS_SHM_DEFAULT_COOKIE_INTERVAL 1000
+
+/* Starts exporting the statistics of the ports, queues, tables, groups and
+ * meters of 'dp' to the file 'path', every 'interval' ms.  If
+ * 'cookie_interval' is nonzero, the totals of the flows by cookie are
+ * exported as well, collected by a walk through every flow every
+ * 'cookie_interval' ms, but no more often than the updates.  Returns 0 if
+ * successful, otherwise a positive errno value. */
+int
+dp_stats_shm_enable(struct datapath *dp, const char *path,
+                    unsigned int interval, unsigned int cookie_interval);
+
+/* Updates the exported statistics, if the interval has passed. */
+void
+dp_stats_shm_run(struct datapath *dp);
+
+/* Wakes poll_block() for the next update. */
+void
+dp_stats_shm_wait(struct datapath *dp);
+
+#endif /* DP_STATS_SHM_H */
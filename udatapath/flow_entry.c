@@ -38,6 +38,7 @@
 #include "group_entry.h"
 #include "meter_table.h"
 #include "meter_entry.h"
+#include "match_std.h"
 #include "oflib/ofl-messages.h"
 #include "oflib/ofl-structs.h"
 #include "oflib/ofl-actions.h"
@@ -364,6 +365,11 @@ flow_entry_create(struct datapath *dp, struct flow_table *table, struct ofl_msg_
     list_init(&entry->meter_refs);
     init_meter_refs(entry);
 
+    entry->parse_depth = entry->match->type == OFPMT_OXM
+                         ? match_std_parse_depth((struct ofl_match *)entry->match)
+                         : NBLINK_PARSE_L4;
+    dp_update_parse_depth(dp, entry->parse_depth, 1);
+
     return entry;
 }
 
@@ -373,6 +379,7 @@ flow_entry_destroy(struct flow_entry *entry) {
     //       flow; but it won't be a problem.
     del_group_refs(entry);
     del_meter_refs(entry);
+    dp_update_parse_depth(entry->dp, entry->parse_depth, -1);
     ofl_structs_free_flow_stats(entry->stats, entry->dp->exp);
     // assumes it is a standard match
     //free(entry->match);
@@ -66,6 +66,7 @@ struct flow_entry {
     bool                     no_byt_count; /* true if doesn't keep track of flow matched bytes*/
     struct list              group_refs;  /* list of groups referencing the flow. */
     struct list              meter_refs;  /* list of meters referencing the flow. */
+    uint8_t                  parse_depth; /* packet parse depth the match needs. */
 };
 
 struct packet;
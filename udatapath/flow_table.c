@@ -197,6 +197,21 @@ flow_table_flow_mod(struct flow_table *table, struct ofl_msg_flow_mod *mod, bool
 }
 
 
+struct flow_entry *
+flow_table_find_strict(struct flow_table *table, struct ofl_msg_flow_mod *mod) {
+    struct flow_entry *entry;
+
+    LIST_FOR_EACH (entry, struct flow_entry, match_node, &table->match_entries) {
+        if (flow_entry_matches(entry, mod, true/*strict*/, false/*check_cookie*/)) {
+            return entry;
+        }
+        if (mod->priority > entry->stats->priority) {
+            break;
+        }
+    }
+    return NULL;
+}
+
 struct flow_entry *
 flow_table_lookup(struct flow_table *table, struct packet *pkt) {
     struct flow_entry *entry;
@@ -217,7 +232,7 @@ flow_table_lookup(struct flow_table *table, struct packet *pkt) {
                         entry->stats->byte_count += pkt->buffer->size;
                     if (!entry->no_pkt_count)
                         entry->stats->packet_count++;
-                    entry->last_used = time_msec();
+                    entry->last_used = pkt->timestamp;
 
                     table->stats->matched_count++;
 
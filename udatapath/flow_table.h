@@ -73,6 +73,10 @@ extern struct ofl_action_header actions[];
 ofl_err
 flow_table_flow_mod(struct flow_table *table, struct ofl_msg_flow_mod *mod, bool *match_kept, bool *insts_kept);
 
+/* Finds the flow entry with the same match and priority as 'mod'. */
+struct flow_entry *
+flow_table_find_strict(struct flow_table *table, struct ofl_msg_flow_mod *mod);
+
 /* Finds the flow entry with the highest priority, which matches the packet. */
 struct flow_entry *
 flow_table_lookup(struct flow_table *table, struct packet *pkt);
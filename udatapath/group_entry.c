@@ -372,7 +372,6 @@ bucket_is_alive(struct ofl_bucket *bucket, struct datapath *dp) {
         (p->conf->state & OFPPS_LINK_DOWN)){
         return false;
     }
-    // TODO Zoltan: Implement link up/down detection
     return true;
 }
 
@@ -33,6 +33,7 @@
 #include "lib/hash.h"
 #include "oflib/oxm-match.h"
 #include "match_std.h"
+#include "nbee_link/nbee_link.h"
 
 
 /* Two matches overlap, if there exists a packet,
@@ -670,3 +671,29 @@ match_std_nonstrict(struct ofl_match *a, struct ofl_match *b) {
 
 }
 
+uint8_t
+match_std_parse_depth(struct ofl_match *match){
+    struct ofl_match_tlv *f;
+    uint8_t depth = NBLINK_PARSE_L2;
+
+    /* The fields of an empty match are not initialized when unpacked. */
+    if (match->header.length == 0) {
+        return depth;
+    }
+
+    HMAP_FOR_EACH(f, struct ofl_match_tlv, hmap_node, &match->match_fields){
+        struct oxm_field *field = oxm_field_lookup(f->header);
+
+        if (field == NULL || field->nw_proto
+            || field->index == OFI_OXM_OF_IPV6_EXTHDR
+            || field->index == OFI_OXM_OF_IPV6_EXTHDR_W) {
+            return NBLINK_PARSE_L4;
+        }
+        if (field->dl_type[0] == htons(ETH_TYPE_IP)
+            || field->dl_type[0] == htons(ETH_TYPE_IPV6)
+            || field->dl_type[0] == htons(ETH_TYPE_ARP)) {
+            depth = NBLINK_PARSE_L3;
+        }
+    }
+    return depth;
+}
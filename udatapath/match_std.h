@@ -33,6 +33,7 @@
 #define MATCH_EXT_H 1
 
 #include <stdbool.h>
+#include <stdint.h>
 #include "oflib/ofl-structs.h"
 
 /****************************************************************************
@@ -53,6 +54,11 @@ match_std_strict(struct ofl_match *a, struct ofl_match *b);
 bool
 match_std_nonstrict(struct ofl_match *a, struct ofl_match *b);
 
+/* Returns the enum nblink_parse_depth a packet must be parsed to for its
+ * match fields to be compared against 'match'. */
+uint8_t
+match_std_parse_depth(struct ofl_match *match);
+
 
 
 #endif /* MATCH_STD_H */
@@ -289,9 +289,9 @@ void
 refill_bucket(struct meter_entry *entry)
 {
 	size_t i;
+    long long int now = time_msec();
 
     for(i = 0; i < entry->config->meter_bands_num; i++) {
-    	long long int now = time_msec();
         long long int tokens = !(entry->config->flags & OFPMF_PKTPS) ? 
                         (now - entry->stats->band_stats[i]->last_fill) * 
     						entry->config->bands[i]->rate  + entry->stats->band_stats[i]->tokens
@@ -34,18 +34,21 @@
 #include <sys/types.h>
 #include "datapath.h"
 #include "dp_buffers.h"
+#include "dp_ports.h"
+#include "dp_sflow.h"
 #include "packet.h"
 #include "packets.h"
 #include "action_set.h"
 #include "ofpbuf.h"
+#include "pktmem.h"
 #include "oflib/ofl-structs.h"
 #include "oflib/ofl-print.h"
 #include "util.h"
 
 
-struct packet *
-packet_create(struct datapath *dp, uint32_t in_port,
-    struct ofpbuf *buf, bool packet_out) {
+static struct packet *
+packet_create__(struct datapath *dp, uint32_t in_port,
+    struct ofpbuf *buf, bool packet_out, long long int now, bool parse) {
     struct packet *pkt;
 
     pkt = xmalloc(sizeof(struct packet));
@@ -62,18 +65,33 @@ packet_create(struct datapath *dp, uint32_t in_port,
     pkt->out_queue        = 0;
     pkt->buffer_id        = NO_BUFFER;
     pkt->table_id         = 0;
+    pkt->timestamp        = now;
+    pkt->sflow            = NULL;
 
-    pkt->handle_std = packet_handle_std_create(pkt);
+    pkt->handle_std = packet_handle_std_create(pkt, parse);
     return pkt;
 }
 
+struct packet *
+packet_create(struct datapath *dp, uint32_t in_port,
+    struct ofpbuf *buf, bool packet_out, long long int now) {
+    return packet_create__(dp, in_port, buf, packet_out, now, true);
+}
+
+struct packet *
+packet_create_unparsed(struct datapath *dp, uint32_t in_port,
+    struct ofpbuf *buf, bool packet_out, long long int now) {
+    return packet_create__(dp, in_port, buf, packet_out, now, false);
+}
+
 struct packet *
 packet_clone(struct packet *pkt) {
     struct packet *clone;
 
     clone = xmalloc(sizeof(struct packet));
     clone->dp         = pkt->dp;
-    clone->buffer     = ofpbuf_clone(pkt->buffer);
+    clone->buffer     = pktmem_ofpbuf_clone(pkt->dp->pktmem, pkt->buffer,
+                                            DP_PORTS_HEADROOM);
     clone->in_port    = pkt->in_port;
     clone->action_set = action_set_clone(pkt->action_set);
 
@@ -86,6 +104,8 @@ packet_clone(struct packet *pkt) {
                                          // but this buffer is a copy of that,
                                          // and might be altered later
     clone->table_id         = pkt->table_id;
+    clone->timestamp        = pkt->timestamp;
+    clone->sflow            = NULL; // the original reports the sample
 
     clone->handle_std = packet_handle_std_clone(clone, pkt->handle_std);
 
@@ -105,6 +125,9 @@ packet_destroy(struct packet *pkt) {
         }
     }
 
+    if (pkt->sflow != NULL) {
+        dp_sflow_sample_done(pkt->dp, pkt->sflow);
+    }
     action_set_destroy(pkt->action_set);
     ofpbuf_delete(pkt->buffer);
     packet_handle_std_destroy(pkt->handle_std);
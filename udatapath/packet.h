@@ -62,13 +62,24 @@ struct packet {
     uint8_t             table_id; /* table in which is processed */
     uint32_t            buffer_id; /* if packet is stored in buffer, buffer_id;
                                       otherwise 0xffffffff */
+    long long int       timestamp; /* time_msec() when the packet entered the
+                                      pipeline; one sample per received burst */
 
     struct packet_handle_std  *handle_std; /* handler for standard match structure */
+    struct dp_sflow_sample    *sflow; /* sFlow sample of the packet, if any */
 };
 
-/* Creates a packet. */
+/* Creates a packet, received at time 'now' (as returned by time_msec()). */
 struct packet *
-packet_create(struct datapath *dp, uint32_t in_port, struct ofpbuf *buf, bool packet_out);
+packet_create(struct datapath *dp, uint32_t in_port, struct ofpbuf *buf,
+              bool packet_out, long long int now);
+
+/* Like packet_create(), but does not parse the packet until an action needs
+ * its fields.  Only for packets that are not looked up in the flow tables. */
+struct packet *
+packet_create_unparsed(struct datapath *dp, uint32_t in_port,
+                       struct ofpbuf *buf, bool packet_out,
+                       long long int now);
 
 /* Converts the packet to a string representation. */
 char *
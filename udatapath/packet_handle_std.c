@@ -39,42 +39,57 @@
 #include "oflib/ofl-structs.h"
 #include "openflow/openflow.h"
 #include "compiler.h"
+#include "util.h"
 
 #include "lib/hash.h"
 #include "oflib/oxm-match.h"
 
 #include "nbee_link/nbee_link.h"
 
-/* Resets all protocol fields to NULL */
-
-void
-packet_handle_std_validate(struct packet_handle_std *handle) {
-
-    if(handle->valid)
-        return;
+/* Reparses the packet, extracting match fields down to 'depth'. */
+static void
+packet_handle_std_parse(struct packet_handle_std *handle, uint8_t depth) {
     struct ofl_match_tlv * iter, *next;
+
     HMAP_FOR_EACH_SAFE(iter, next, struct ofl_match_tlv, hmap_node, &handle->match.match_fields){
         free(iter->value);
         free(iter);
     }
     ofl_structs_match_init(&handle->match);
+    handle->valid = false;
 
     if (nblink_packet_parse(handle->pkt->buffer,&handle->match,
-                            handle->proto) < 0)
+                            handle->proto, depth) < 0)
         return;
 
     handle->valid = true;
+    handle->depth = depth;
 
     /* Add in_port value to the hash_map */
     ofl_structs_match_put32(&handle->match, OXM_OF_IN_PORT, handle->pkt->in_port);
     /*Add metadata value to the hash_map */
     ofl_structs_match_put64(&handle->match,  OXM_OF_METADATA, 0xffffffffffffffff);
-    return;
 }
 
+void
+packet_handle_std_validate(struct packet_handle_std *handle) {
+    uint8_t depth = handle->pkt->dp->parse_depth;
+
+    if (handle->valid && handle->depth >= depth)
+        return;
+    packet_handle_std_parse(handle, MAX(depth, handle->depth));
+}
+
+void
+packet_handle_std_validate_full(struct packet_handle_std *handle) {
+
+    if (handle->valid && handle->depth == NBLINK_PARSE_L4)
+        return;
+    packet_handle_std_parse(handle, NBLINK_PARSE_L4);
+}
 
 struct packet_handle_std *
-packet_handle_std_create(struct packet *pkt) {
+packet_handle_std_create(struct packet *pkt, bool parse) {
 	struct packet_handle_std *handle = xmalloc(sizeof(struct packet_handle_std));
 	handle->proto = xmalloc(sizeof(struct protocols_std));
 	handle->pkt = pkt;
@@ -82,19 +97,24 @@ packet_handle_std_create(struct packet *pkt) {
 	hmap_init(&handle->match.match_fields);
 
 	handle->valid = false;
-	packet_handle_std_validate(handle);
+	handle->table_miss = false;
+	handle->depth = NBLINK_PARSE_L2;
+	if (parse) {
+	    packet_handle_std_validate(handle);
+	}
 
 	return handle;
 }
 
 struct packet_handle_std *
-packet_handle_std_clone(struct packet *pkt, struct packet_handle_std *handle UNUSED) {
+packet_handle_std_clone(struct packet *pkt, struct packet_handle_std *handle) {
     struct packet_handle_std *clone = xmalloc(sizeof(struct packet_handle_std));
 
     clone->pkt = pkt;
     clone->proto = xmalloc(sizeof(struct protocols_std));
     hmap_init(&clone->match.match_fields);
     clone->valid = false;
+    clone->depth = handle->depth;
     // TODO Zoltan: if handle->valid, then match could be memcpy'd, and protocol
     //              could be offset
     packet_handle_std_validate(clone);
@@ -146,11 +166,9 @@ packet_handle_std_is_fragment(struct packet_handle_std *handle) {
 bool
 packet_handle_std_match(struct packet_handle_std *handle, struct ofl_match *match){
 
+    packet_handle_std_validate(handle);
     if (!handle->valid){
-        packet_handle_std_validate(handle);
-        if (!handle->valid){
-            return false;
-        }
+        return false;
     }
 
     return packet_match(match ,&handle->match );
@@ -188,7 +206,7 @@ packet_handle_std_to_string(struct packet_handle_std *handle) {
 
 void
 packet_handle_std_print(FILE *stream, struct packet_handle_std *handle) {
-    packet_handle_std_validate(handle);
+    packet_handle_std_validate_full(handle);
 
     fprintf(stream, "{proto=");
     proto_print(stream, handle->proto);
@@ -55,11 +55,14 @@ struct packet_handle_std {
                                            executing any methods. */
    bool						   table_miss; /*Packet was matched
    											against table miss flow*/
+   uint8_t                     depth; /* enum nblink_parse_depth the match
+                                           fields were extracted to. */
 };
 
-/* Creates a handler */
+/* Creates a handler.  The packet is parsed now if 'parse' is true, otherwise
+ * when a method or packet_handle_std_validate() first needs its fields. */
 struct packet_handle_std *
-packet_handle_std_create(struct packet *pkt);
+packet_handle_std_create(struct packet *pkt, bool parse);
 
 /* Destroys a handler */
 void
@@ -88,9 +91,14 @@ packet_handle_std_print(FILE *stream, struct packet_handle_std *handle);
 struct packet_handle_std *
 packet_handle_std_clone(struct packet *pkt, struct packet_handle_std *handle);
 
-/* Revalidates the handler data */
+/* Revalidates the handler data, extracting the match fields needed by the
+ * flows installed in the datapath. */
 void
 packet_handle_std_validate(struct packet_handle_std *handle);
 
+/* Revalidates the handler data, extracting every supported match field. */
+void
+packet_handle_std_validate_full(struct packet_handle_std *handle);
+
 
 #endif /* PACKET_HANDLE_STD_H */
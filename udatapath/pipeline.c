@@ -37,7 +37,10 @@
 #include "dp_actions.h"
 #include "dp_buffers.h"
 #include "dp_exp.h"
+#include "dp_learn.h"
+#include "dp_pending.h"
 #include "dp_ports.h"
+#include "dp_sflow.h"
 #include "datapath.h"
 #include "packet.h"
 #include "pipeline.h"
@@ -91,7 +94,6 @@ send_packet_to_controller(struct pipeline *pl, struct packet *pkt, uint8_t table
     struct ofl_msg_packet_in msg;
     struct ofl_match *m;
     msg.header.type = OFPT_PACKET_IN;
-    msg.total_len   = pkt->buffer->size;
     msg.reason      = reason;
     msg.table_id    = table_id;
     msg.cookie      = 0xffffffffffffffff;
@@ -109,17 +111,20 @@ send_packet_to_controller(struct pipeline *pl, struct packet *pkt, uint8_t table
         msg.data_length = pkt->buffer->size;
     }
 
+    packet_handle_std_validate_full(pkt->handle_std);
     m = &pkt->handle_std->match;
     /* In this implementation the fields in_port and in_phy_port
         always will be the same, because we are not considering logical
         ports                                 */
     msg.match = (struct ofl_match_header*)m;
-    dp_send_message(pl->dp, (struct ofl_msg_header *)&msg, NULL);
+    dp_actions_send_packet_in(pkt, &msg);
     ofl_structs_free_match((struct ofl_match_header* ) m, NULL);
 }
 
-void
-pipeline_process_packet(struct pipeline *pl, struct packet *pkt) {
+/* Runs 'pkt' through the pipeline from table 'first' on. */
+static void
+pipeline_process_packet__(struct pipeline *pl, struct packet *pkt,
+                          struct flow_table *first) {
     struct flow_table *table, *next_table;
 
     if (VLOG_IS_DBG_ENABLED(LOG_MODULE)) {
@@ -140,7 +145,7 @@ pipeline_process_packet(struct pipeline *pl, struct packet *pkt) {
         return;
     }
 
-    next_table = pl->tables[0];
+    next_table = first;
     while (next_table != NULL) {
         struct flow_entry *entry;
 
@@ -164,6 +169,10 @@ pipeline_process_packet(struct pipeline *pl, struct packet *pkt) {
                 free(m);
             }
             pkt->handle_std->table_miss = is_table_miss(entry);
+            if (pkt->sflow != NULL) {
+                dp_sflow_sample_match(pkt->sflow, pkt->table_id,
+                                      entry->stats->cookie);
+            }
             execute_entry(pl, entry, &next_table, &pkt);
             /* Packet could be destroyed by a meter instruction */
             if (!pkt)
@@ -188,6 +197,49 @@ pipeline_process_packet(struct pipeline *pl, struct packet *pkt) {
     VLOG_WARN_RL(LOG_MODULE, &rl, "Reached outside of pipeline processing cycle.");
 }
 
+void
+pipeline_process_packet(struct pipeline *pl, struct packet *pkt) {
+    pipeline_process_packet__(pl, pkt, pl->tables[0]);
+    /* The flows the packet learned are installed once no entry is being
+     * executed. */
+    dp_learn_flush(pl->dp);
+}
+
+void
+pipeline_resume_packet(struct pipeline *pl, struct packet *pkt,
+                       uint8_t table_id) {
+    pipeline_process_packet__(pl, pkt, pl->tables[table_id]);
+    dp_learn_flush(pl->dp);
+}
+
+void
+pipeline_process_batch(struct pipeline *pl, struct packet **pkts, size_t n) {
+    struct datapath *dp = pl->dp;
+    size_t i;
+
+    /* The packets were parsed on arrival; pull their match fields and the
+     * head of the first table into the cache before any lookup runs. */
+    PREFETCH(pl->tables[0]->match_entries.next);
+    for (i = 0; i < n; i++) {
+        PREFETCH(pkts[i]->handle_std->match.match_fields.buckets);
+    }
+
+    /* Packets still go through the tables one at a time and in arrival
+     * order, so a packet always sees the flow and meter state left by the
+     * previous one.  Their best-effort output is queued per port and sent
+     * when the whole batch is done. */
+    dp->tx_batching = true;
+    for (i = 0; i < n; i++) {
+        if (i + 1 < n) {
+            PREFETCH(pkts[i + 1]->buffer->data);
+            PREFETCH(pkts[i + 1]->handle_std->proto);
+        }
+        pipeline_process_packet(pl, pkts[i]);
+    }
+    dp->tx_batching = false;
+    dp_ports_flush_tx(dp);
+}
+
 static
 int inst_compare(const void *inst1, const void *inst2){
     struct ofl_instruction_header * i1 = *(struct ofl_instruction_header **) inst1;
@@ -202,6 +254,14 @@ int inst_compare(const void *inst1, const void *inst2){
 ofl_err
 pipeline_handle_flow_mod(struct pipeline *pl, struct ofl_msg_flow_mod *msg,
                                                 const struct sender *sender) {
+    if(sender->remote->role == OFPCR_ROLE_SLAVE)
+        return ofl_error(OFPET_BAD_REQUEST, OFPBRC_IS_SLAVE);
+
+    return pipeline_flow_mod(pl, msg);
+}
+
+ofl_err
+pipeline_flow_mod(struct pipeline *pl, struct ofl_msg_flow_mod *msg) {
     /* Note: the result of using table_id = 0xff is undefined in the spec.
      *       for now it is accepted for delete commands, meaning to delete
      *       from all tables */
@@ -209,9 +269,6 @@ pipeline_handle_flow_mod(struct pipeline *pl, struct ofl_msg_flow_mod *msg,
     size_t i;
     bool match_kept,insts_kept;
 
-    if(sender->remote->role == OFPCR_ROLE_SLAVE)
-        return ofl_error(OFPET_BAD_REQUEST, OFPBRC_IS_SLAVE);
-
     match_kept = false;
     insts_kept = false;
 
@@ -273,6 +330,9 @@ pipeline_handle_flow_mod(struct pipeline *pl, struct ofl_msg_flow_mod *msg,
                 VLOG_WARN_RL(LOG_MODULE, &rl, "The buffer flow_mod referred to was empty (%u).", msg->buffer_id);
             }
         }
+        if (msg->command == OFPFC_ADD) {
+            dp_pending_flow_added(pl->dp, msg);
+        }
 
         ofl_msg_free_flow_mod(msg, !match_kept, !insts_kept, pl->dp->exp);
         return 0;
@@ -320,15 +380,42 @@ pipeline_handle_stats_request_flow(struct pipeline *pl,
         flow_table_stats(pl->tables[msg->table_id], msg, &stats, &stats_size, &stats_num);
     }
 
+    /* An OpenFlow message is at most 64 kB long, so the stats are spread over
+     * as many replies as needed, all but the last flagged with
+     * OFPMPF_REPLY_MORE.  They are packed now, as flows may be removed
+     * before the last of them is sent. */
     {
-        struct ofl_msg_multipart_reply_flow reply =
-                {{{.type = OFPT_MULTIPART_REPLY},
-                  .type = OFPMP_FLOW, .flags = 0x0000},
-                 .stats     = stats,
-                 .stats_num = stats_num
-                };
+        const size_t max_len = UINT16_MAX - sizeof(struct ofp_multipart_reply);
+        struct remote_backlog replies = {NULL, NULL, 0};
+        size_t first = 0;
+
+        do {
+            struct ofl_msg_multipart_reply_flow reply =
+                    {{{.type = OFPT_MULTIPART_REPLY},
+                      .type = OFPMP_FLOW, .flags = 0x0000},
+                     .stats     = stats + first,
+                     .stats_num = 0
+                    };
+            size_t len = 0;
+
+            while (first + reply.stats_num < stats_num) {
+                size_t stat_len = ofl_structs_flow_stats_ofp_len(
+                                     stats[first + reply.stats_num], pl->dp->exp);
+                if (reply.stats_num > 0 && len + stat_len > max_len) {
+                    break;
+                }
+                len += stat_len;
+                reply.stats_num++;
+            }
+            first += reply.stats_num;
+            if (first < stats_num) {
+                reply.header.flags = OFPMPF_REPLY_MORE;
+            }
 
-        dp_send_message(pl->dp, (struct ofl_msg_header *)&reply, sender);
+            dp_pack_reply(pl->dp, (struct ofl_msg_header *)&reply, sender,
+                          &replies);
+        } while (first < stats_num);
+        dp_send_replies(pl->dp, &replies, sender);
     }
 
     free(stats);
@@ -515,7 +602,11 @@ execute_entry(struct pipeline *pl, struct flow_entry *entry,
             }
             case OFPIT_APPLY_ACTIONS: {
                 struct ofl_instruction_actions *ia = (struct ofl_instruction_actions *)inst;
-                dp_execute_action_list((*pkt), ia->actions_num, ia->actions, entry->stats->cookie);
+                /* With nothing after them, the actions are the last ones
+                   run on the packet. */
+                dp_execute_action_list((*pkt), ia->actions_num, ia->actions, entry->stats->cookie,
+                        i + 1 == entry->stats->instructions_num
+                        && action_set_is_empty((*pkt)->action_set));
                 break;
             }
             case OFPIT_CLEAR_ACTIONS: {
@@ -61,12 +61,28 @@ pipeline_create(struct datapath *dp);
 void
 pipeline_process_packet(struct pipeline *pl, struct packet *pkt);
 
+/* Processes a packet from table 'table_id' on, with the action set,
+ * metadata and header changes the earlier tables left it. */
+void
+pipeline_resume_packet(struct pipeline *pl, struct packet *pkt,
+                       uint8_t table_id);
+
+/* Processes a burst of packets received together, with the same result as
+ * calling pipeline_process_packet() on each of them in order. */
+void
+pipeline_process_batch(struct pipeline *pl, struct packet **pkts, size_t n);
+
 
 /* Handles a flow_mod message. */
 ofl_err
 pipeline_handle_flow_mod(struct pipeline *pl, struct ofl_msg_flow_mod *msg,
                          const struct sender *sender);
 
+/* Applies a flow_mod, from a controller or from the datapath itself.  On
+ * success the message is freed, or kept by the flow table. */
+ofl_err
+pipeline_flow_mod(struct pipeline *pl, struct ofl_msg_flow_mod *msg);
+
 /* Handles a table_mod message. */
 ofl_err
 pipeline_handle_table_mod(struct pipeline *pl,
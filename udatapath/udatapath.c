@@ -38,6 +38,7 @@
  */
 
 #include <config.h>
+#include <ctype.h>
 #include <errno.h>
 #include <getopt.h>
 #include <limits.h>
@@ -49,7 +50,13 @@
 #include "command-line.h"
 #include "daemon.h"
 #include "datapath.h"
+#include "dp_learn.h"
+#include "dp_pending.h"
+#include "dp_sflow.h"
+#include "dp_stats_shm.h"
+#include "pktmem.h"
 #include "fault.h"
+#include "netdev.h"
 #include "openflow/openflow.h"
 #include "poll-loop.h"
 #include "queue.h"
@@ -71,6 +78,8 @@
 int udatapath_cmd(int argc, char *argv[]);
 
 static void parse_options(struct datapath *dp, int argc, char *argv[]);
+static size_t parse_size(const char *);
+static unsigned int parse_uint(const char *option, const char *s);
 static void usage(void) NO_RETURN;
 
 static struct datapath *dp;
@@ -81,6 +90,24 @@ static char *local_port = "tap:";
 static void add_ports(struct datapath *dp, char *port_list);
 
 static bool use_multiple_connections = false;
+static size_t n_aux_conns = 1;
+
+/* File to export statistics to through shared memory, if any. */
+static char *stats_shm_path;
+static unsigned int stats_shm_interval = 100;
+static unsigned int stats_shm_cookie_interval = 0;
+
+/* sFlow collector to export samples to, if any. */
+static char *sflow_target;
+static char *sflow_rates;
+static unsigned int sflow_polling = DP_SFLOW_DEFAULT_POLLING;
+
+/* Size of the packet memory region, 0 to malloc() packet buffers. */
+static size_t pktmem_size;
+
+/* Coalescing of the packet_ins of table misses. */
+static unsigned int pin_hold_timeout = 0;
+static unsigned int pin_hold_max = DP_PENDING_DEFAULT_MAX_HELD;
 
 /* Need to treat this more generically */
 #if defined(UDATAPATH_AS_LIB)
@@ -123,30 +150,32 @@ udatapath_cmd(int argc, char *argv[])
           "use --help for usage");
     }
 
-    if (use_multiple_connections && (argc - optind) % 2 != 0)
-        OFP_FATAL(0, "when using multiple connections, you must specify an even number of listeners");
+    if (!use_multiple_connections)
+        n_aux_conns = 0;
+
+    if ((argc - optind) % (n_aux_conns + 1) != 0)
+        OFP_FATAL(0, "when using multiple connections, each listener must be "
+                  "followed by %zu auxiliary listener(s)", n_aux_conns);
         
     n_listeners = 0;
-    for (i = optind; i < argc; i += 2) {
+    for (i = optind; i < argc; i += n_aux_conns + 1) {
         const char *pvconn_name = argv[i];
-        const char *pvconn_name_aux = NULL;
-        if (use_multiple_connections)
-            pvconn_name_aux = argv[i + 1];
-
-        struct pvconn *pvconn, *pvconn_aux = NULL;
-        int retval, retval_aux;
+        struct pvconn *pvconn, *pvconn_aux[DP_MAX_AUX_CONNS];
+        int retval;
+        size_t j;
 
         retval = pvconn_open(pvconn_name, &pvconn);
         if (!retval || retval == EAGAIN) {
-            // Get another listener if we are using auxiliary connections
-            if (use_multiple_connections) {
-                retval_aux = pvconn_open(pvconn_name_aux, &pvconn_aux);
+            // Get the listeners for the auxiliary connections
+            for (j = 0; j < n_aux_conns; j++) {
+                const char *pvconn_name_aux = argv[i + 1 + j];
+                int retval_aux = pvconn_open(pvconn_name_aux, &pvconn_aux[j]);
                 if (retval_aux && retval_aux != EAGAIN) {
                     ofp_error(retval_aux, "opening auxiliary %s", pvconn_name_aux);
-                    pvconn_aux = NULL;
+                    pvconn_aux[j] = NULL;
                 }
             }
-            dp_add_pvconn(dp, pvconn, pvconn_aux);
+            dp_add_pvconn(dp, pvconn, pvconn_aux, n_aux_conns);
             n_listeners++;
         } else {
             ofp_error(retval, "opening %s", pvconn_name);
@@ -156,6 +185,16 @@ udatapath_cmd(int argc, char *argv[])
         OFP_FATAL(0, "could not listen for any connections");
     }
 
+    dp_pending_set(dp->pending, pin_hold_timeout, pin_hold_max);
+
+    if (pktmem_size != 0) {
+        error = pktmem_create(pktmem_size, &dp->pktmem);
+        if (error) {
+            OFP_FATAL(error, "failed to allocate packet memory");
+        }
+        netdev_use_pktmem(dp->pktmem);
+    }
+
     if (port_list != NULL) {
         add_ports(dp, port_list);
     }
@@ -172,6 +211,23 @@ udatapath_cmd(int argc, char *argv[])
     }
 
     die_if_already_running();
+
+    if (sflow_target != NULL) {
+        error = dp_sflow_enable(dp, sflow_target, sflow_rates, sflow_polling);
+        if (error) {
+            OFP_FATAL(error, "failed to enable sFlow to %s", sflow_target);
+        }
+    }
+
+    if (stats_shm_path != NULL) {
+        error = dp_stats_shm_enable(dp, stats_shm_path, stats_shm_interval,
+                                    stats_shm_cookie_interval);
+        if (error) {
+            OFP_FATAL(error, "failed to export statistics to %s",
+                      stats_shm_path);
+        }
+    }
+
     daemonize();
 
     for (;;) {
@@ -212,7 +268,18 @@ parse_options(struct datapath *dp, int argc, char *argv[])
         OPT_SERIAL_NUM,
         OPT_BOOTSTRAP_CA_CERT,
         OPT_NO_LOCAL_PORT,
-        OPT_NO_SLICING
+        OPT_NO_SLICING,
+        OPT_STATS_SHM,
+        OPT_STATS_SHM_INTERVAL,
+        OPT_STATS_SHM_COOKIES,
+        OPT_SFLOW,
+        OPT_SFLOW_SAMPLING,
+        OPT_SFLOW_POLLING,
+        OPT_PKTMEM,
+        OPT_LEARN_RATE,
+        OPT_PIN_HOLD,
+        OPT_PIN_HOLD_MAX,
+        OPT_RX_BURST
     };
 
     static struct option long_options[] = {
@@ -220,7 +287,7 @@ parse_options(struct datapath *dp, int argc, char *argv[])
         {"local-port",  required_argument, 0, 'L'},
         {"no-local-port", no_argument, 0, OPT_NO_LOCAL_PORT},
         {"datapath-id", required_argument, 0, 'd'},
-        {"multiconn",     no_argument, 0, 'm'},
+        {"multiconn",   optional_argument, 0, 'm'},
         {"verbose",     optional_argument, 0, 'v'},
         {"help",        no_argument, 0, 'h'},
         {"version",     no_argument, 0, 'V'},
@@ -230,6 +297,17 @@ parse_options(struct datapath *dp, int argc, char *argv[])
         {"sw-desc",     required_argument, 0, OPT_SW_DESC},
         {"dp_desc",  required_argument, 0, OPT_DP_DESC},
         {"serial_num",  required_argument, 0, OPT_SERIAL_NUM},
+        {"stats-shm",   required_argument, 0, OPT_STATS_SHM},
+        {"stats-shm-interval", required_argument, 0, OPT_STATS_SHM_INTERVAL},
+        {"stats-shm-cookies", optional_argument, 0, OPT_STATS_SHM_COOKIES},
+        {"sflow",       required_argument, 0, OPT_SFLOW},
+        {"sflow-sampling", required_argument, 0, OPT_SFLOW_SAMPLING},
+        {"sflow-polling", required_argument, 0, OPT_SFLOW_POLLING},
+        {"pktmem",      required_argument, 0, OPT_PKTMEM},
+        {"learn-rate",  required_argument, 0, OPT_LEARN_RATE},
+        {"packet-in-hold", optional_argument, 0, OPT_PIN_HOLD},
+        {"packet-in-hold-max", required_argument, 0, OPT_PIN_HOLD_MAX},
+        {"rx-burst",    required_argument, 0, OPT_RX_BURST},
         DAEMON_LONG_OPTIONS,
 #ifdef HAVE_OPENSSL
         VCONN_SSL_LONG_OPTIONS
@@ -267,6 +345,13 @@ parse_options(struct datapath *dp, int argc, char *argv[])
         
         case 'm': {
             use_multiple_connections = true;
+            if (optarg) {
+                n_aux_conns = atoi(optarg);
+                if (n_aux_conns < 1 || n_aux_conns > DP_MAX_AUX_CONNS) {
+                    ofp_fatal(0, "argument to -m or --multiconn must be "
+                              "between 1 and %d", DP_MAX_AUX_CONNS);
+                }
+            }
             break;
         }
         
@@ -322,6 +407,66 @@ parse_options(struct datapath *dp, int argc, char *argv[])
             dp_set_max_queues(dp, 0);
             break;
 
+        case OPT_STATS_SHM:
+            stats_shm_path = optarg;
+            break;
+
+        case OPT_STATS_SHM_INTERVAL:
+            stats_shm_interval = parse_uint("--stats-shm-interval", optarg);
+            if (stats_shm_interval < 1) {
+                ofp_fatal(0, "--stats-shm-interval must be at least 1 ms");
+            }
+            break;
+
+        case OPT_STATS_SHM_COOKIES:
+            stats_shm_cookie_interval
+                = optarg ? parse_uint("--stats-shm-cookies", optarg)
+                         : DP_STATS_SHM_DEFAULT_COOKIE_INTERVAL;
+            if (stats_shm_cookie_interval < 1) {
+                ofp_fatal(0, "--stats-shm-cookies must be at least 1 ms");
+            }
+            break;
+
+        case OPT_SFLOW:
+            sflow_target = optarg;
+            break;
+
+        case OPT_SFLOW_SAMPLING:
+            sflow_rates = optarg;
+            break;
+
+        case OPT_SFLOW_POLLING:
+            sflow_polling = parse_uint("--sflow-polling", optarg);
+            break;
+
+        case OPT_PKTMEM:
+            pktmem_size = parse_size(optarg);
+            if (pktmem_size == 0) {
+                ofp_fatal(0, "--pktmem requires a size, e.g. 64M");
+            }
+            break;
+
+        case OPT_LEARN_RATE:
+            dp_learn_set_rate(dp->learn, parse_uint("--learn-rate", optarg));
+            break;
+
+        case OPT_PIN_HOLD:
+            pin_hold_timeout = optarg ? parse_uint("--packet-in-hold", optarg)
+                                      : DP_PENDING_DEFAULT_TIMEOUT;
+            break;
+
+        case OPT_PIN_HOLD_MAX:
+            pin_hold_max = parse_uint("--packet-in-hold-max", optarg);
+            break;
+
+        case OPT_RX_BURST:
+            dp->rx_burst = parse_uint("--rx-burst", optarg);
+            if (dp->rx_burst < 1 || dp->rx_burst > DP_PORTS_BURST_MAX) {
+                ofp_fatal(0, "--rx-burst must be between 1 and %d",
+                          DP_PORTS_BURST_MAX);
+            }
+            break;
+
         DAEMON_OPTION_HANDLERS
 
 #ifdef HAVE_OPENSSL
@@ -342,6 +487,53 @@ parse_options(struct datapath *dp, int argc, char *argv[])
     free(short_options);
 }
 
+/* Parses 's', the argument of 'option', as a nonnegative decimal integer.
+ * Exits with an error message if it is not one or does not fit. */
+static unsigned int
+parse_uint(const char *option, const char *s)
+{
+    unsigned long int value;
+    char *tail;
+
+    errno = 0;
+    value = strtoul(s, &tail, 10);
+    if (!isdigit((unsigned char) *s) || *tail != '\0') {
+        ofp_fatal(0, "%s: \"%s\" is not a nonnegative integer", option, s);
+    }
+    if (errno == ERANGE || value > UINT_MAX) {
+        ofp_fatal(0, "%s: %s is too large", option, s);
+    }
+    return value;
+}
+
+/* Parses 's' as a number of bytes with an optional K, M or G suffix.
+ * Returns 0 if 's' is not of that form. */
+static size_t
+parse_size(const char *s)
+{
+    unsigned long long int size;
+    char *tail;
+
+    errno = 0;
+    size = strtoull(s, &tail, 10);
+    if (errno || tail == s) {
+        return 0;
+    }
+    switch (*tail) {
+    case 'G': case 'g':
+        size <<= 10;
+        /* fall through */
+    case 'M': case 'm':
+        size <<= 10;
+        /* fall through */
+    case 'K': case 'k':
+        size <<= 10;
+        tail++;
+        break;
+    }
+    return *tail == '\0' && size <= SIZE_MAX ? size : 0;
+}
+
 static void
 usage(void)
 {
@@ -358,9 +550,34 @@ usage(void)
            "  --no-local-port         disable local port\n"
            "  -d, --datapath-id=ID    Use ID as the OpenFlow switch ID\n"
            "                          (ID must consist of 12 hex digits)\n"
-           "  -m, --multiconn         enable multiple connections to the\n"
-           "                          same controller.\n"
+           "  -m, --multiconn[=N]     enable N (default: 1) auxiliary\n"
+           "                          connections to the same controller;\n"
+           "                          each LISTEN is followed by N LISTENs\n"
+           "                          for its auxiliary connections.\n"
            "  --no-slicing            disable slicing\n"
+           "  --stats-shm=FILE        export statistics to FILE, e.g. in\n"
+           "                          /dev/shm, for ofp-stats to read\n"
+           "  --stats-shm-interval=MS update them every MS ms (default: 100)\n"
+           "  --stats-shm-cookies[=MS]\n"
+           "                          also export flow totals by cookie,\n"
+           "                          collected every MS ms (default: %d)\n"
+           "  --sflow=HOST[:PORT]     send sFlow samples to a collector\n"
+           "  --sflow-sampling=RATE[,PORT=RATE]...\n"
+           "                          sample 1 in RATE received packets\n"
+           "                          (default: %d), or on PORT only\n"
+           "  --sflow-polling=SECS    send port counters every SECS s\n"
+           "                          (default: %d, 0 to disable)\n"
+           "  --pktmem=SIZE[K|M|G]    carve packet buffers from SIZE bytes\n"
+           "                          of hugepage memory\n"
+           "  --learn-rate=N          install at most N flows/s from learn\n"
+           "                          actions (default: %d, 0 for no limit)\n"
+           "  --packet-in-hold[=MS]   after a table miss packet_in, hold the\n"
+           "                          flow's packets up to MS (default: %d)\n"
+           "                          ms for a flow entry\n"
+           "  --packet-in-hold-max=N  hold up to N packets per flow\n"
+           "                          (default: %d)\n"
+           "  --rx-burst=N            receive up to N packets from a port\n"
+           "                          at a time, 1 to %d (default: %d)\n"
            "\nOther options:\n"
            "  -D, --detach            run in background as daemon\n"
            "  -P, --pidfile[=FILE]    create pidfile (default: %s/ofdatapath.pid)\n"
@@ -369,6 +586,10 @@ usage(void)
            "  -v, --verbose           set maximum verbosity level\n"
            "  -h, --help              display this help message\n"
            "  -V, --version           display version information\n",
+        DP_STATS_SHM_DEFAULT_COOKIE_INTERVAL,
+        DP_SFLOW_DEFAULT_RATE, DP_SFLOW_DEFAULT_POLLING,
+        DP_LEARN_DEFAULT_RATE, DP_PENDING_DEFAULT_TIMEOUT,
+        DP_PENDING_DEFAULT_MAX_HELD, DP_PORTS_BURST_MAX, DP_PORTS_BURST,
         ofp_rundir);
     exit(EXIT_SUCCESS);
 }
@@ -1,40 +1,55 @@
 bin_PROGRAMS += \
 	utilities/vlogconf \
 	utilities/dpctl \
+	utilities/ofp-bench \
 	utilities/ofp-discover \
-	utilities/ofp-kill
+	utilities/ofp-kill \
+	utilities/ofp-pktgen \
+	utilities/ofp-stats
 bin_SCRIPTS += utilities/ofp-pki
 noinst_SCRIPTS += utilities/ofp-pki-cgi utilities/ofp-parse-leaks
 
 EXTRA_DIST += \
 	utilities/dpctl.8.in \
+	utilities/ofp-bench.8.in \
 	utilities/ofp-discover.8.in \
 	utilities/ofp-kill.8.in \
 	utilities/ofp-parse-leaks.in \
 	utilities/ofp-pki-cgi.in \
 	utilities/ofp-pki.8.in \
 	utilities/ofp-pki.in \
+	utilities/ofp-pktgen.8.in \
+	utilities/ofp-stats.8.in \
 	utilities/vlogconf.8.in
 DISTCLEANFILES += \
 	utilities/dpctl.8 \
+	utilities/ofp-bench.8 \
 	utilities/ofp-discover.8 \
 	utilities/ofp-kill.8 \
 	utilities/ofp-parse-leaks \
 	utilities/ofp-pki \
 	utilities/ofp-pki.8 \
 	utilities/ofp-pki-cgi \
+	utilities/ofp-pktgen.8 \
+	utilities/ofp-stats.8 \
 	utilities/vlogconf.8
 
 man_MANS += \
 	utilities/dpctl.8 \
+	utilities/ofp-bench.8 \
 	utilities/ofp-discover.8 \
 	utilities/ofp-kill.8 \
 	utilities/ofp-pki.8 \
+	utilities/ofp-pktgen.8 \
+	utilities/ofp-stats.8 \
 	utilities/vlogconf.8
 
 utilities_dpctl_SOURCES = utilities/dpctl.c
 utilities_dpctl_LDADD = lib/libopenflow.a oflib/liboflib.a oflib-exp/liboflib_exp.a $(FAULT_LIBS) $(SSL_LIBS)
 
+utilities_ofp_bench_SOURCES = utilities/ofp-bench.c
+utilities_ofp_bench_LDADD = lib/libopenflow.a oflib/liboflib.a oflib-exp/liboflib_exp.a $(FAULT_LIBS) $(SSL_LIBS) $(PTHREAD_LIBS)
+
 utilities_vlogconf_SOURCES = utilities/vlogconf.c
 utilities_vlogconf_LDADD = lib/libopenflow.a
 
@@ -43,3 +58,9 @@ utilities_ofp_discover_LDADD = lib/libopenflow.a
 
 utilities_ofp_kill_SOURCES = utilities/ofp-kill.c
 utilities_ofp_kill_LDADD = lib/libopenflow.a
+
+utilities_ofp_pktgen_SOURCES = utilities/ofp-pktgen.c
+utilities_ofp_pktgen_LDADD = lib/libopenflow.a $(FAULT_LIBS)
+
+utilities_ofp_stats_SOURCES = utilities/ofp-stats.c
+utilities_ofp_stats_LDADD = lib/libopenflow.a $(FAULT_LIBS)
@@ -56,11 +56,14 @@
 #include "command-line.h"
 #include "compiler.h"
 #include "dpif.h"
+#include "dynamic-string.h"
 #include "openflow/nicira-ext.h"
 #include "openflow/openflow-ext.h"
+#include "ofp.h"
 #include "ofpbuf.h"
 #include "openflow/openflow.h"
 #include "packets.h"
+#include "poll-loop.h"
 #include "random.h"
 #include "socket-util.h"
 #include "timeval.h"
@@ -84,6 +87,15 @@
 
 static uint32_t global_xid = XID;
 
+/* Output format of the flows printed by stats-flow. */
+enum flow_format {
+    FLOW_FORMAT_DEFAULT,        /* Each reply as a whole, like other commands. */
+    FLOW_FORMAT_COMPACT,        /* One line of text per flow. */
+    FLOW_FORMAT_JSONL           /* One JSON object per flow and line. */
+};
+
+static enum flow_format flow_format = FLOW_FORMAT_DEFAULT;
+
 struct command {
     char *name;
     int min_args;
@@ -193,8 +205,15 @@ static struct ofl_exp_msg dpctl_exp_msg =
          .free      = ofl_exp_msg_free,
          .to_string = ofl_exp_msg_to_string};
 
+static struct ofl_exp_act dpctl_exp_act =
+        {.pack      = ofl_exp_act_pack,
+         .unpack    = ofl_exp_act_unpack,
+         .free      = ofl_exp_act_free,
+         .ofp_len   = ofl_exp_act_ofp_len,
+         .to_string = ofl_exp_act_to_string};
+
 static struct ofl_exp dpctl_exp =
-        {.act   = NULL,
+        {.act   = &dpctl_exp_act,
          .inst  = NULL,
          .match = NULL,
          .stats = NULL,
@@ -451,6 +470,190 @@ port_desc(struct vconn *vconn, int argc UNUSED, char *argv[] UNUSED) {
     dpctl_transact_and_print(vconn, (struct ofl_msg_header *)&req, NULL);
 }
 
+/* Writes 's' to stdout as a JSON string, with quotes and escapes. */
+static void
+print_json_string(const char *s) {
+    putchar('"');
+    for (; *s != '\0'; s++) {
+        unsigned char c = *s;
+        if (c == '"' || c == '\\') {
+            printf("\\%c", c);
+        } else if (c < 0x20) {
+            printf("\\u%04x", c);
+        } else {
+            putchar(c);
+        }
+    }
+    putchar('"');
+}
+
+static void
+print_flow_compact(struct ofl_flow_stats *s) {
+    size_t i;
+
+    printf("table=%u prio=%u cookie=0x%"PRIx64" duration=%u.%03us "
+           "idle_to=%u hard_to=%u pkts=%"PRIu64" bytes=%"PRIu64" match=",
+           s->table_id, s->priority, s->cookie, s->duration_sec,
+           s->duration_nsec / 1000000, s->idle_timeout, s->hard_timeout,
+           s->packet_count, s->byte_count);
+    ofl_structs_match_print(stdout, s->match, &dpctl_exp);
+    printf(" insts=[");
+    for (i = 0; i < s->instructions_num; i++) {
+        ofl_structs_instruction_print(stdout, s->instructions[i], &dpctl_exp);
+        if (i < s->instructions_num - 1) { printf(", "); }
+    }
+    printf("]\n");
+}
+
+static void
+print_flow_jsonl(struct ofl_flow_stats *s) {
+    char *str;
+    size_t i;
+
+    printf("{\"table\":%u,\"priority\":%u,\"cookie\":\"0x%"PRIx64"\","
+           "\"duration_sec\":%u,\"duration_nsec\":%u,"
+           "\"idle_timeout\":%u,\"hard_timeout\":%u,"
+           "\"packet_count\":%"PRIu64",\"byte_count\":%"PRIu64",\"match\":",
+           s->table_id, s->priority, s->cookie, s->duration_sec,
+           s->duration_nsec, s->idle_timeout, s->hard_timeout,
+           s->packet_count, s->byte_count);
+    str = ofl_structs_match_to_string(s->match, &dpctl_exp);
+    print_json_string(str);
+    free(str);
+    printf(",\"instructions\":[");
+    for (i = 0; i < s->instructions_num; i++) {
+        str = ofl_structs_instruction_to_string(s->instructions[i], &dpctl_exp);
+        print_json_string(str);
+        free(str);
+        if (i < s->instructions_num - 1) { putchar(','); }
+    }
+    printf("]}\n");
+}
+
+/* Prints the flow stats in the body of the raw flow stats reply 'mp', 'len'
+ * bytes long, decoding and releasing one flow at a time. */
+static void
+print_flow_stats_reply(struct ofp_multipart_reply *mp, size_t len,
+                       uint32_t xid) {
+    uint8_t *ptr = mp->body;
+    bool first = true;
+
+    len -= sizeof *mp;
+    if (flow_format == FLOW_FORMAT_DEFAULT) {
+        printf("\nRECEIVED (xid=0x%X):\n", xid);
+        ofl_message_type_print(stdout, OFPT_MULTIPART_REPLY);
+        printf("{type=\"");
+        ofl_stats_type_print(stdout, OFPMP_FLOW);
+        printf("\", flags=\"0x%"PRIx32"\", stats=[", ntohs(mp->flags));
+    }
+
+    while (len >= sizeof(struct ofp_flow_stats)) {
+        struct ofl_flow_stats *s;
+        size_t prev_len = len;
+        ofl_err error;
+
+        error = ofl_structs_flow_stats_unpack((struct ofp_flow_stats *)ptr,
+                                              ptr, &len, &s, &dpctl_exp);
+        if (error) {
+            ofp_fatal(0, "Error unpacking flow stats.");
+        }
+        ptr += prev_len - len;
+
+        switch (flow_format) {
+        case FLOW_FORMAT_DEFAULT:
+            if (!first) { printf(", "); }
+            ofl_structs_flow_stats_print(stdout, s, &dpctl_exp);
+            break;
+        case FLOW_FORMAT_COMPACT:
+            print_flow_compact(s);
+            break;
+        case FLOW_FORMAT_JSONL:
+            print_flow_jsonl(s);
+            break;
+        }
+        ofl_structs_free_flow_stats(s, &dpctl_exp);
+        first = false;
+    }
+
+    if (flow_format == FLOW_FORMAT_DEFAULT) {
+        printf("]}\n\n");
+    }
+}
+
+/* Sends the flow stats request 'req' and prints the flows of the replies as
+ * they arrive.  A switch spreads a large flow table over several replies
+ * flagged with OFPMPF_REPLY_MORE; each is printed and released before the
+ * next one is read, so memory use does not grow with the number of flows. */
+static void
+dpctl_dump_flows(struct vconn *vconn,
+                 struct ofl_msg_multipart_request_flow *req) {
+    struct ofpbuf *request;
+    uint8_t *buf;
+    size_t buf_size;
+    bool more = true;
+    int error;
+
+    if (flow_format == FLOW_FORMAT_DEFAULT) {
+        char *str = ofl_msg_to_string((struct ofl_msg_header *)req,
+                                      &dpctl_exp);
+        printf("\nSENDING (xid=0x%X):\n%s\n\n", global_xid, str);
+        free(str);
+    }
+
+    error = ofl_msg_pack((struct ofl_msg_header *)req, global_xid,
+                         &buf, &buf_size, &dpctl_exp);
+    if (error) {
+        ofp_fatal(0, "Error packing request.");
+    }
+    request = ofpbuf_new(0);
+    ofpbuf_use(request, buf, buf_size);
+    ofpbuf_put_uninit(request, buf_size);
+    error = vconn_send_block(vconn, request);
+    if (error) {
+        ofp_fatal(error, "Error sending request.");
+    }
+
+    while (more) {
+        struct ofp_multipart_reply *mp;
+        struct ofpbuf *reply;
+
+        error = vconn_recv_block(vconn, &reply);
+        if (error) {
+            ofp_fatal(error, "Error receiving reply.");
+        }
+        mp = reply->data;
+        if (ntohl(mp->header.xid) != global_xid) {
+            ofpbuf_delete(reply);
+            continue;
+        }
+
+        if (mp->header.type == OFPT_MULTIPART_REPLY
+            && reply->size >= sizeof *mp
+            && ntohs(mp->type) == OFPMP_FLOW) {
+            print_flow_stats_reply(mp, reply->size, global_xid);
+            more = (ntohs(mp->flags) & OFPMPF_REPLY_MORE) != 0;
+        } else {
+            /* Most likely an error: print it the usual way and stop. */
+            struct ofl_msg_header *msg;
+            uint32_t xid;
+            char *str;
+
+            error = ofl_msg_unpack(reply->data, reply->size, &msg, &xid,
+                                   &dpctl_exp);
+            if (error) {
+                ofp_fatal(0, "Error unpacking reply.");
+            }
+            str = ofl_msg_to_string(msg, &dpctl_exp);
+            fprintf(stderr, "\nRECEIVED (xid=0x%X):\n%s\n\n", xid, str);
+            free(str);
+            ofl_msg_free(msg, &dpctl_exp);
+            more = false;
+        }
+        ofpbuf_delete(reply);
+    }
+    fflush(stdout);
+}
+
 static void
 stats_flow(struct vconn *vconn, int argc, char *argv[]) {
     struct ofl_msg_multipart_request_flow req =
@@ -471,7 +674,7 @@ stats_flow(struct vconn *vconn, int argc, char *argv[]) {
         make_all_match(&(req.match));
     }
 
-    dpctl_transact_and_print(vconn, (struct ofl_msg_header *)&req, NULL);
+    dpctl_dump_flows(vconn, &req);
 }
 
 static void
@@ -592,9 +795,7 @@ set_config(struct vconn *vconn, int argc UNUSED, char *argv[]) {
 
 
 
-static void
-flow_mod(struct vconn *vconn, int argc, char *argv[]) {
-    struct ofl_msg_flow_mod msg =
+static const struct ofl_msg_flow_mod flow_mod_template =
             {{.type = OFPT_FLOW_MOD},
              .cookie = 0x0000000000000000ULL,
              .cookie_mask = 0x0000000000000000ULL,
@@ -611,22 +812,26 @@ flow_mod(struct vconn *vconn, int argc, char *argv[]) {
              .instructions_num = 0,
              .instructions = NULL};
 
-    parse_flow_mod_args(argv[0], &msg);
+/* Fills in 'msg' from the flow-mod command arguments "ARG [MATCH [INST...]]"
+ * in 'argv'. */
+static void
+parse_flow_mod(int argc, char *argv[], struct ofl_msg_flow_mod *msg) {
+    parse_flow_mod_args(argv[0], msg);
 
     if (argc > 1) {
-        size_t i, j;
-        size_t inst_num;
+        size_t i, j = 1;
+        size_t inst_num = 0;
         if (argc > 2){
             inst_num = argc - 2;
             j = 2;
-            parse_match(argv[1], &(msg.match));
+            parse_match(argv[1], &(msg->match));
         }
         else {
-            if(msg.command == OFPFC_DELETE)
-                inst_num = 0;
+            if(msg->command == OFPFC_DELETE)
+                parse_match(argv[1], &(msg->match));
             else {
-                parse_match(argv[1], &(msg.match));
-                if(msg.match->length <=4){
+                parse_match(argv[1], &(msg->match));
+                if(msg->match->length <=4){
                     inst_num = argc - 1;
                     j = 1;
                 }
@@ -634,19 +839,273 @@ flow_mod(struct vconn *vconn, int argc, char *argv[]) {
         }
         
         
-        msg.instructions_num = inst_num;
-        msg.instructions = xmalloc(sizeof(struct ofl_instruction_header *) * inst_num);
+        msg->instructions_num = inst_num;
+        msg->instructions = xmalloc(sizeof(struct ofl_instruction_header *) * inst_num);
 
         for (i=0; i < inst_num; i++) {
-            parse_inst(argv[j+i], &(msg.instructions[i]));
+            parse_inst(argv[j+i], &(msg->instructions[i]));
         }
     } else {
-        make_all_match(&(msg.match));
+        make_all_match(&(msg->match));
     }
+}
+
+static void
+flow_mod(struct vconn *vconn, int argc, char *argv[]) {
+    struct ofl_msg_flow_mod msg = flow_mod_template;
+
+    parse_flow_mod(argc, argv, &msg);
     dpctl_send_and_print(vconn, (struct ofl_msg_header *)&msg);
 }
 
 
+/* Flow control for the bulk flow commands: a barrier request follows every
+ * BULK_BARRIER_INTERVAL flow_mods, and sending pauses while
+ * BULK_MAX_BARRIERS barriers are unanswered. */
+#define BULK_BARRIER_INTERVAL 1000
+#define BULK_MAX_BARRIERS 4
+
+/* State of an add-flows, del-flows or replace-flows command.  Flow_mods are
+ * streamed over the connection without waiting for each one; the switch
+ * only replies to those that fail, identified by xid. */
+struct bulk_flows {
+    struct vconn *vconn;
+    const char *file_name;
+    uint32_t base_xid;          /* Xid of the first message sent. */
+    unsigned int *lines;        /* Line of 'file_name' that each message
+                                 * sent came from, by xid, 0 if none. */
+    size_t n_msgs;              /* Messages sent, including barriers. */
+    size_t allocated;           /* Elements allocated in 'lines'. */
+    size_t n_flows;             /* Flow_mods sent. */
+    size_t n_unbarriered;       /* Flow_mods sent since the last barrier. */
+    size_t n_errors;            /* Error replies received. */
+    unsigned int n_barriers;    /* Barriers awaiting their reply. */
+};
+
+/* Handles 'buf', received from the switch, and deletes it. */
+static void
+bulk_flows_process(struct bulk_flows *bf, struct ofpbuf *buf) {
+    struct ofp_header *oh = buf->data;
+
+    if (oh->type == OFPT_BARRIER_REPLY) {
+        bf->n_barriers--;
+    } else if (oh->type == OFPT_ERROR
+               && buf->size >= sizeof(struct ofp_error_msg)) {
+        struct ofp_error_msg *em = buf->data;
+        size_t ofs = ntohl(oh->xid) - bf->base_xid;
+
+        if (ofs < bf->n_msgs && bf->lines[ofs] != 0) {
+            fprintf(stderr, "%s:%u: ", bf->file_name, bf->lines[ofs]);
+        } else {
+            fprintf(stderr, "%s: (xid=0x%X) ", bf->file_name, ntohl(oh->xid));
+        }
+        ofl_error_type_print(stderr, ntohs(em->type));
+        fprintf(stderr, ", ");
+        ofl_error_code_print(stderr, ntohs(em->type), ntohs(em->code));
+        fprintf(stderr, "\n");
+        bf->n_errors++;
+    } else if (oh->type == OFPT_ECHO_REQUEST) {
+        struct ofpbuf *reply = make_echo_reply(oh);
+        if (vconn_send(bf->vconn, reply)) {
+            ofpbuf_delete(reply);
+        }
+    }
+    ofpbuf_delete(buf);
+}
+
+/* Processes the messages received from the switch.  If 'block' is true,
+ * waits until there are at most 'max_barriers' unanswered barriers. */
+static void
+bulk_flows_recv(struct bulk_flows *bf, bool block, unsigned int max_barriers) {
+    for (;;) {
+        struct ofpbuf *buf;
+        int error;
+
+        if (block && bf->n_barriers <= max_barriers) {
+            return;
+        }
+        error = vconn_recv(bf->vconn, &buf);
+        if (!error) {
+            bulk_flows_process(bf, buf);
+        } else if (error != EAGAIN) {
+            ofp_fatal(error, "Error receiving from switch");
+        } else if (!block) {
+            return;
+        } else {
+            vconn_recv_wait(bf->vconn);
+            poll_block();
+        }
+    }
+}
+
+/* Sends 'msg' to the switch as coming from line 'line' of the file.  Replies
+ * are processed while the connection is busy, so that neither side blocks
+ * on the other. */
+static void
+bulk_flows_send(struct bulk_flows *bf, struct ofl_msg_header *msg,
+                unsigned int line) {
+    struct ofpbuf *ofpbuf;
+    uint8_t *buf;
+    size_t buf_size;
+    int error;
+
+    error = ofl_msg_pack(msg, bf->base_xid + bf->n_msgs, &buf, &buf_size,
+                         &dpctl_exp);
+    if (error) {
+        ofp_fatal(0, "Error packing request.");
+    }
+    ofpbuf = ofpbuf_new(0);
+    ofpbuf_use(ofpbuf, buf, buf_size);
+    ofpbuf_put_uninit(ofpbuf, buf_size);
+
+    if (bf->n_msgs >= bf->allocated) {
+        bf->allocated = bf->allocated ? 2 * bf->allocated : 1024;
+        bf->lines = xrealloc(bf->lines, bf->allocated * sizeof *bf->lines);
+    }
+    bf->lines[bf->n_msgs++] = line;
+
+    while ((error = vconn_send(bf->vconn, ofpbuf)) == EAGAIN) {
+        bulk_flows_recv(bf, false, 0);
+        vconn_send_wait(bf->vconn);
+        vconn_recv_wait(bf->vconn);
+        poll_block();
+    }
+    if (error) {
+        ofp_fatal(error, "Error sending to switch");
+    }
+    bulk_flows_recv(bf, false, 0);
+}
+
+/* Sends a barrier request and, if more than 'max_barriers' are then
+ * unanswered, waits for replies. */
+static void
+bulk_flows_barrier(struct bulk_flows *bf, unsigned int max_barriers) {
+    struct ofl_msg_header req = {.type = OFPT_BARRIER_REQUEST};
+
+    /* Counted first, since sending may already process the reply. */
+    bf->n_barriers++;
+    bf->n_unbarriered = 0;
+    bulk_flows_send(bf, &req, 0);
+    bulk_flows_recv(bf, true, max_barriers);
+}
+
+/* Sends 'msg', parsed from line 'line', and frees it. */
+static void
+bulk_flows_send_flow_mod(struct bulk_flows *bf, struct ofl_msg_flow_mod *msg,
+                         unsigned int line) {
+    bulk_flows_send(bf, (struct ofl_msg_header *)msg, line);
+    ofl_msg_free((struct ofl_msg_header *)msg, &dpctl_exp);
+    bf->n_flows++;
+    if (++bf->n_unbarriered >= BULK_BARRIER_INTERVAL) {
+        bulk_flows_barrier(bf, BULK_MAX_BARRIERS - 1);
+    }
+}
+
+/* Sends a flow_mod for each line of 'file_name' ("-" for standard input),
+ * in the syntax of the flow-mod command, with 'command' as the default
+ * command.  Blank lines and lines starting with '#' are skipped.  Reports
+ * the errors received and the rate achieved, and exits with a failure status
+ * if there were errors.  If 'replace' is true, all flows are deleted
+ * first. */
+static void
+bulk_flows(struct vconn *vconn, const char *file_name, uint8_t command,
+           bool replace) {
+    struct bulk_flows bf;
+    long long int start;
+    unsigned int line = 0;
+    struct ds s;
+    FILE *stream;
+    double secs;
+
+    stream = !strcmp(file_name, "-") ? stdin : fopen(file_name, "r");
+    if (stream == NULL) {
+        ofp_fatal(errno, "%s: open failed", file_name);
+    }
+
+    memset(&bf, 0, sizeof bf);
+    bf.vconn = vconn;
+    bf.file_name = file_name;
+    bf.base_xid = global_xid;
+
+    start = time_msec();
+    if (replace) {
+        struct ofl_msg_flow_mod *msg = xmalloc(sizeof *msg);
+
+        *msg = flow_mod_template;
+        msg->command = OFPFC_DELETE;
+        msg->table_id = OFPTT_ALL;
+        make_all_match(&msg->match);
+        bulk_flows_send(&bf, (struct ofl_msg_header *)msg, 0);
+        ofl_msg_free((struct ofl_msg_header *)msg, &dpctl_exp);
+        /* The additions must not be reordered before the deletion. */
+        bulk_flows_barrier(&bf, 0);
+    }
+
+    ds_init(&s);
+    while (!ds_get_line(&s, stream)) {
+        struct ofl_msg_flow_mod *msg;
+        char *argv[16];
+        char *token, *saveptr = NULL;
+        int argc = 0;
+
+        line++;
+        for (token = strtok_r(ds_cstr(&s), " \t\r\n", &saveptr);
+             token != NULL; token = strtok_r(NULL, " \t\r\n", &saveptr)) {
+            if (argc == 0 && token[0] == '#') {
+                break;
+            }
+            if (argc >= ARRAY_SIZE(argv)) {
+                ofp_fatal(0, "%s:%u: too many arguments", file_name, line);
+            }
+            argv[argc++] = token;
+        }
+        if (argc == 0) {
+            continue;
+        }
+
+        msg = xmalloc(sizeof *msg);
+        *msg = flow_mod_template;
+        msg->command = command;
+        parse_flow_mod(argc, argv, msg);
+        bulk_flows_send_flow_mod(&bf, msg, line);
+    }
+    if (ferror(stream)) {
+        ofp_fatal(errno, "%s: read failed", file_name);
+    }
+    ds_destroy(&s);
+    if (stream != stdin) {
+        fclose(stream);
+    }
+
+    /* Errors for all the flow_mods have arrived once the last barrier is
+     * answered. */
+    bulk_flows_barrier(&bf, 0);
+
+    secs = (time_msec() - start) / 1000.0;
+    printf("%zu flow_mods in %.3f s (%.0f flow_mods/s), %zu errors\n",
+           bf.n_flows, secs, secs > 0 ? bf.n_flows / secs : 0.0, bf.n_errors);
+    free(bf.lines);
+    if (bf.n_errors) {
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void
+add_flows(struct vconn *vconn, int argc UNUSED, char *argv[]) {
+    bulk_flows(vconn, argv[0], OFPFC_ADD, false);
+}
+
+static void
+del_flows(struct vconn *vconn, int argc UNUSED, char *argv[]) {
+    bulk_flows(vconn, argv[0], OFPFC_DELETE, false);
+}
+
+static void
+replace_flows(struct vconn *vconn, int argc UNUSED, char *argv[]) {
+    bulk_flows(vconn, argv[0], OFPFC_ADD, true);
+}
+
+
 static void
 group_mod(struct vconn *vconn, int argc, char *argv[]) {
     struct ofl_msg_group_mod msg =
@@ -884,6 +1343,95 @@ queue_del(struct vconn *vconn, int argc UNUSED, char *argv[]) {
     dpctl_send_and_print(vconn, (struct ofl_msg_header *)&msg);
 }
 
+static void
+rx_stats(struct vconn *vconn, int argc, char *argv[]) {
+    struct ofl_exp_openflow_msg_rx_stats_request req =
+            {{{{.type = OFPT_EXPERIMENTER},
+               .experimenter_id = OPENFLOW_VENDOR_ID},
+              .type = OFP_EXT_RX_STATS_REQUEST},
+             .port_no = OFPP_ANY};
+
+    if (argc > 0 && parse_port(argv[0], &req.port_no)) {
+        ofp_fatal(0, "Error parsing port: %s.", argv[0]);
+    }
+
+    dpctl_transact_and_print(vconn, (struct ofl_msg_header *)&req, NULL);
+}
+
+/* Parses a responder entry: IP[=MAC][@VLAN], IPv4 addresses being stored as
+ * IPv4-mapped IPv6 addresses. */
+static void
+parse_responder_entry(char *str, bool need_eth,
+                      struct ofl_exp_openflow_responder_entry *e) {
+    char *ip, *eth, *vlan;
+    struct in_addr in4;
+    uint8_t *mask = NULL;
+
+    vlan = strchr(str, '@');
+    if (vlan != NULL) {
+        *vlan++ = '\0';
+        if (parse16(vlan, NULL, 0, VLAN_VID_MASK, &e->vlan_vid)) {
+            ofp_fatal(0, "Error parsing responder entry vlan: %s.", vlan);
+        }
+        e->vlan_vid |= OFPVID_PRESENT;
+    } else {
+        e->vlan_vid = OFPVID_NONE;
+    }
+
+    ip = str;
+    eth = strchr(str, '=');
+    if (eth != NULL) {
+        *eth++ = '\0';
+    }
+    if ((eth == NULL) == need_eth) {
+        ofp_fatal(0, "Error parsing responder entry: %s.", str);
+    }
+    memset(e->eth_addr, 0x00, OFP_ETH_ALEN);
+    if (eth != NULL && (parse_dl_addr(eth, e->eth_addr, &mask) || mask != NULL)) {
+        ofp_fatal(0, "Error parsing responder entry eth address: %s.", eth);
+    }
+
+    if (inet_pton(AF_INET, ip, &in4) == 1) {
+        memset(e->ip_addr, 0x00, 10);
+        e->ip_addr[10] = 0xff;
+        e->ip_addr[11] = 0xff;
+        memcpy(e->ip_addr + 12, &in4, sizeof in4);
+    } else if (inet_pton(AF_INET6, ip, e->ip_addr) != 1) {
+        ofp_fatal(0, "Error parsing responder entry ip address: %s.", ip);
+    }
+}
+
+static void
+responder_mod(struct vconn *vconn, int argc, char *argv[]) {
+    struct ofl_exp_openflow_msg_responder_mod msg =
+            {{{{.type = OFPT_EXPERIMENTER},
+               .experimenter_id = OPENFLOW_VENDOR_ID},
+              .type = OFP_EXT_RESPONDER_MOD},
+             .command = OFP_EXT_RESPONDER_ADD,
+             .entries_num = argc - 1,
+             .entries = NULL};
+    int i;
+
+    if (strcmp(argv[0], "add") == 0) {
+        msg.command = OFP_EXT_RESPONDER_ADD;
+    } else if (strcmp(argv[0], "del") == 0) {
+        msg.command = OFP_EXT_RESPONDER_DELETE;
+    } else if (strcmp(argv[0], "replace") == 0) {
+        msg.command = OFP_EXT_RESPONDER_REPLACE;
+    } else {
+        ofp_fatal(0, "Error parsing responder-mod command: %s.", argv[0]);
+    }
+
+    msg.entries = xmalloc(msg.entries_num * sizeof(struct ofl_exp_openflow_responder_entry));
+    for (i = 1; i < argc; i++) {
+        parse_responder_entry(argv[i], msg.command != OFP_EXT_RESPONDER_DELETE,
+                              &msg.entries[i - 1]);
+    }
+
+    dpctl_send_and_print(vconn, (struct ofl_msg_header *)&msg);
+    free(msg.entries);
+}
+
 static void
 get_async(struct vconn *vconn, int argc UNUSED, char *argv[] UNUSED){
 
@@ -916,6 +1464,9 @@ static struct command all_commands[] = {
     {"port-desc", 0, 0, port_desc},
     {"set-config", 1, 1, set_config},
     {"flow-mod", 1, 8/*+1 for each inst type*/, flow_mod },
+    {"add-flows", 1, 1, add_flows },
+    {"del-flows", 1, 1, del_flows },
+    {"replace-flows", 1, 1, replace_flows },
     {"group-mod", 1, UINT8_MAX, group_mod },
     {"meter-mod", 1, UINT8_MAX, meter_mod},
     {"get-async",0,0, get_async},
@@ -925,7 +1476,9 @@ static struct command all_commands[] = {
     {"set-desc", 1, 1, set_desc},
 
     {"queue-mod", 3, 3, queue_mod},
-    {"queue-del", 2, 2, queue_del}
+    {"queue-del", 2, 2, queue_del},
+    {"rx-stats", 0, 1, rx_stats},
+    {"responder-mod", 1, UINT8_MAX, responder_mod}
 };
 
 
@@ -989,12 +1542,14 @@ static void
 parse_options(int argc, char *argv[])
 {
     enum {
-        OPT_STRICT = UCHAR_MAX + 1
+        OPT_STRICT = UCHAR_MAX + 1,
+        OPT_FORMAT
     };
     static struct option long_options[] = {
         {"timeout", required_argument, 0, 't'},
         {"verbose", optional_argument, 0, 'v'},
         {"strict", no_argument, 0, OPT_STRICT},
+        {"format", required_argument, 0, OPT_FORMAT},
         {"help", no_argument, 0, 'h'},
         {"version", no_argument, 0, 'V'},
         {"xid", required_argument, 0, 'x'},
@@ -1039,6 +1594,18 @@ parse_options(int argc, char *argv[])
             global_xid = strtoul(optarg, NULL, 0);
             break;
 
+        case OPT_FORMAT:
+            if (!strcmp(optarg, "default")) {
+                flow_format = FLOW_FORMAT_DEFAULT;
+            } else if (!strcmp(optarg, "compact")) {
+                flow_format = FLOW_FORMAT_COMPACT;
+            } else if (!strcmp(optarg, "jsonl")) {
+                flow_format = FLOW_FORMAT_JSONL;
+            } else {
+                ofp_fatal(0, "unknown format \"%s\" on --format", optarg);
+            }
+            break;
+
         VCONN_SSL_OPTION_HANDLERS
 
         case '?':
@@ -1077,6 +1644,9 @@ usage(void)
             "\n"
             "  SWITCH set-config ARG                  set switch configuration\n"
             "  SWITCH flow-mod ARG [MATCH [INST...]]  send flow_mod message\n"
+            "  SWITCH add-flows FILE                  add flows from FILE\n"
+            "  SWITCH del-flows FILE                  delete flows in FILE\n"
+            "  SWITCH replace-flows FILE              replace all flows with FILE\n"
             "  SWITCH group-mod ARG [BUCARG ACT...]   send group_mod message\n"
             "  SWITCH meter-mod ARG [BANDARG ...]     send meter_mod message\n"
             "  SWITCH port-mod ARG                    send port_mod message\n"
@@ -1087,12 +1657,17 @@ usage(void)
             "  SWITCH set-desc DESC                   sets the DP description\n"
             "  SWITCH queue-mod PORT QUEUE BW         adds/modifies queue\n"
             "  SWITCH queue-del PORT QUEUE            deletes queue\n"
+            "  SWITCH rx-stats [PORT]                 print receive statistics\n"
+            "  SWITCH responder-mod CMD [ENTRY...]    add, del or replace ARP/ND\n"
+            "                                         responder entries\n"
             "\n",
             program_name, program_name);
      vconn_usage(true, false, false);
      vlog_usage();
      printf("\nOther options:\n"
             "  --strict                    use strict match for flow commands\n"
+            "  --format=FORMAT             print stats-flow as default, compact\n"
+            "                              (a line per flow) or jsonl (JSON Lines)\n"
             "  -t, --timeout=SECS          give up after SECS seconds\n"
             "  -h, --help                  display this help message\n"
             "  -V, --version               display version information\n");
@@ -1980,6 +2555,27 @@ parse_action(uint16_t type, char *str, struct ofl_action_header **act) {
             (*act) = a;
             break;
         }
+        case (OFPAT_EXPERIMENTER): {
+            char *token, *saveptr = NULL;
+            struct ofl_exp_openflow_act_respond *a = xmalloc(sizeof(struct ofl_exp_openflow_act_respond));
+
+            a->header.header.experimenter_id = OPENFLOW_VENDOR_ID;
+            a->header.subtype = OFP_EXT_ACT_RESPOND;
+            a->miss_port = OFPP_ANY;
+            a->max_len = 0;
+
+            token = strtok_r(str, KEY_VAL2, &saveptr);
+            if (token != NULL && parse_port(token, &(a->miss_port))) {
+                ofp_fatal(0, "Error parsing port in respond action: %s.", str);
+            }
+            token = strtok_r(NULL, KEY_VAL2, &saveptr);
+            if (token != NULL &&
+                parse16(token, NULL, 0, 0xffff - sizeof(struct ofp_header), &(a->max_len))) {
+                ofp_fatal(0, "Error parsing max_len in respond action: %s.", str);
+            }
+            (*act) = (struct ofl_action_header *)a;
+            break;
+        }
         default: {
             ofp_fatal(0, "Error parsing action: %s.", str);
         }
@@ -2030,7 +2626,6 @@ parse_inst(char *str, struct ofl_instruction_header **inst) {
         if (strncmp(str, inst_names[i].name, strlen(inst_names[i].name)) == 0) {
 
             s = str + strlen(inst_names[i].name);
-	    printf("%s\n", str);
             if (strncmp(s, KEY_VAL2, strlen(KEY_VAL2)) != 0) {
                 ofp_fatal(0, "Error parsing instruction: %s.", str);
             }
@@ -149,7 +149,8 @@ static struct names16 action_names[] = {
         {OFPAT_GROUP,          "group"},
         {OFPAT_SET_NW_TTL,     "nw_ttl"},
         {OFPAT_DEC_NW_TTL,     "nw_dec"},
-        {OFPAT_SET_FIELD,      "set_field"}
+        {OFPAT_SET_FIELD,      "set_field"},
+        {OFPAT_EXPERIMENTER,   "respond"}
 };
 
 static struct names16 band_names[] = {
@@ -0,0 +1,2159 @@
+/* Copyright (c) 2008 The Board of Trustees of The Leland Stanford
+ * Junior University
+ *
+ * We are making the OpenFlow specification and associated documentation
+ * (Software) available for public use and benefit with the expectation
+ * that others will use, modify and enhance the Software and contribute
+ * those enhancements back to the community. However, since we would
+ * like to make the Software available for broadest use, with as few
+ * restrictions as possible permission is hereby granted, free of
+ * charge, to any person obtaining a copy of this Software to deal in
+ * the Software under the copyrights without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * The name and trademarks of copyright holder(s) may NOT be used in
+ * advertising or publicity pertaining to the Software or any
+ * derivatives without specific, written prior permission.
+ */
+
+#include <config.h>
+#include <errno.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <linux/perf_event.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "oflib/ofl.h"
+#include "oflib/ofl-actions.h"
+#include "oflib/ofl-messages.h"
+#include "oflib/ofl-print.h"
+#include "oflib/ofl-structs.h"
+#include "oflib/oxm-match.h"
+#include "oflib-exp/ofl-exp.h"
+#include "oflib-exp/ofl-exp-openflow.h"
+
+#include "command-line.h"
+#include "compiler.h"
+#include "ofp.h"
+#include "netdev.h"
+#include "ofpbuf.h"
+#include "openflow/openflow.h"
+#include "openflow/openflow-ext.h"
+#include "packets.h"
+#include "pkt-queue.h"
+#include "pktmem.h"
+#include "poll-loop.h"
+#include "random.h"
+#include "rconn.h"
+#include "samples.h"
+#include "timeval.h"
+#include "util.h"
+#include "vconn.h"
+#include "vconn-ssl.h"
+
+#include "vlog.h"
+#define LOG_MODULE VLM_ofp_bench
+
+/* Every flow installed by the benchmark carries this cookie, so that they can
+ * all be removed at the end regardless of the test. */
+#define BENCH_COOKIE 0x0fbe0c4ULL
+
+/* Priority of the flows installed by the tests. */
+#define BENCH_PRIORITY 100
+
+/* Ethertype of the frames injected by the packet-in test. */
+#define BENCH_ETH_TYPE 0x88b5
+
+/* Maximum number of messages queued on a session before it stops generating
+ * new ones and waits for the switch to catch up. */
+#define SESSION_TXQ_LIMIT 64
+
+/* xid of the messages of the control connection. */
+#define CONTROL_XID 0xbe0c0000
+
+struct session;
+struct test;
+
+/* The test being run. */
+static const struct test *test;
+
+/* Number of operations per session: 'count', or for a batched test the
+ * number of batches needed for 'count'. */
+static unsigned int n_ops;
+
+/* -n, --count: number of operations per session (0: test default). */
+static unsigned int count;
+
+/* -s, --sessions: number of concurrent controller sessions. */
+static unsigned int n_sessions = 1;
+
+/* -b, --batch: number of flow_mods per barrier. */
+static unsigned int batch = 100;
+
+/* -w, --window: number of operations each session keeps in flight. */
+static unsigned int window = 1;
+
+/* --flows: number of flows installed before the stats test. */
+static unsigned int n_flows = 1000;
+
+/* --stats: type of the multipart request of the stats test. */
+static uint16_t stats_type = OFPMP_FLOW;
+
+/* --echo-interval: interval between echo probes during a test, in ms. */
+static unsigned int echo_interval;
+
+/* --size: size of the frames of the packet-out test, in bytes. */
+static unsigned int frame_size = 64;
+
+/* --out-port: port the packet-out test outputs to, 0 to have them dropped.
+ * May be OFPP_FLOOD or OFPP_ALL. */
+static unsigned int out_port;
+
+/* --push-vlan: push a VLAN tag in the packet-out test before the output? */
+static bool push_vlan;
+
+/* --packet-out-batch: send the packet_outs of each batch of the packet-out
+ * test in OFP_EXT_PACKET_OUT_BATCH messages? */
+static bool packet_out_batch;
+
+/* --fields: number of match fields of the decode test, 0 for each of 3, 8
+ * and 15. */
+static unsigned int n_fields;
+
+/* --netdev: network device whose link the port-status test toggles. */
+static const char *toggle_name;
+
+/* Results, shared by all sessions.  Latencies are in microseconds. */
+static struct samples op_latency;       /* Per operation of the test. */
+static struct samples pkt_in_latency;   /* packet-in test: inject to packet-in. */
+static struct samples echo_latency;     /* Echo requests. */
+static struct samples link_down_latency; /* port-status test: link down to
+                                          * port_status. */
+static struct samples toggle_latency;   /* port-status test: time taken to
+                                         * set the link state. */
+static unsigned long long int n_entries; /* stats test: flows or ports
+                                           * received. */
+static unsigned int n_errors;           /* OFPT_ERROR messages received. */
+static unsigned long long int n_released; /* packet-in-hold test: held
+                                           * packets released. */
+static unsigned long long int n_not_held; /* packet-in-hold test: packet-ins
+                                           * that were not coalesced. */
+static unsigned int n_failures;         /* Packets a test found handled
+                                         * wrongly. */
+
+/* An operation in flight, such as a batch of flow_mods waiting for its
+ * barrier reply. */
+struct pending {
+    long long int start;        /* When the operation started, in us. */
+};
+
+/* A controller session to the switch. */
+struct session {
+    unsigned int id;
+    struct rconn *rconn;
+    int n_txq;                  /* Messages queued on 'rconn'. */
+    bool connected;
+
+    unsigned int n_started;     /* Operations started. */
+    unsigned int n_done;        /* Operations completed. */
+    struct pending *pending;    /* 'window' slots, indexed by sequence. */
+
+    long long int next_echo;    /* When to send the next echo probe, in ms. */
+};
+
+/* A benchmark. */
+struct test {
+    const char *name;
+    unsigned int default_count;
+    bool batched;               /* Is an operation a batch of 'batch'? */
+
+    /* Prepares the switch over the control connection 'vconn'. */
+    void (*setup)(struct vconn *vconn);
+
+    /* Starts the next operation of 's', which has fewer than 'n_ops'
+     * started and fewer than 'window' in flight. */
+    void (*start)(struct session *s);
+
+    /* Handles 'msg', received on 's', which is not an echo or an error. */
+    void (*recv)(struct session *s, struct ofpbuf *msg);
+
+    /* Prints the results of a run of 'elapsed' seconds. */
+    void (*report)(double elapsed);
+};
+
+static void parse_options(int argc, char *argv[]);
+static void usage(void) NO_RETURN;
+
+static struct ofl_exp_msg bench_exp_msg =
+        {.pack      = ofl_exp_msg_pack,
+         .unpack    = ofl_exp_msg_unpack,
+         .free      = ofl_exp_msg_free,
+         .to_string = ofl_exp_msg_to_string};
+
+static struct ofl_exp bench_exp =
+        {.act   = NULL,
+         .inst  = NULL,
+         .match = NULL,
+         .stats = NULL,
+         .msg   = &bench_exp_msg};
+
+static struct ofpbuf *
+pack_msg(struct ofl_msg_header *msg, uint32_t xid)
+{
+    struct ofpbuf *buffer;
+    uint8_t *buf;
+    size_t buf_size;
+
+    if (ofl_msg_pack(msg, xid, &buf, &buf_size, &bench_exp)) {
+        ofp_fatal(0, "Error packing %s message.",
+                  ofl_message_type_to_string(msg->type));
+    }
+    buffer = ofpbuf_new(0);
+    ofpbuf_use(buffer, buf, buf_size);
+    ofpbuf_put_uninit(buffer, buf_size);
+    return buffer;
+}
+
+static void
+session_send(struct session *s, struct ofl_msg_header *msg, uint32_t xid)
+{
+    rconn_send(s->rconn, pack_msg(msg, xid), &s->n_txq);
+}
+
+static void
+session_send_barrier(struct session *s, uint32_t xid)
+{
+    struct ofl_msg_header msg = {.type = OFPT_BARRIER_REQUEST};
+
+    session_send(s, &msg, xid);
+}
+
+static void
+session_send_echo(struct session *s, uint32_t xid)
+{
+    long long int now = time_usec();
+    struct ofl_msg_echo msg =
+            {{.type = OFPT_ECHO_REQUEST},
+             .data_length = sizeof now,
+             .data = (uint8_t *) &now};
+
+    session_send(s, (struct ofl_msg_header *)&msg, xid);
+}
+
+/* Sends 'msg' on the control connection 'vconn'. */
+static void
+control_send(struct vconn *vconn, struct ofl_msg_header *msg)
+{
+    int error = vconn_send_block(vconn, pack_msg(msg, CONTROL_XID));
+    if (error) {
+        ofp_fatal(error, "%s: send failed", vconn_get_name(vconn));
+    }
+}
+
+/* Sends a barrier on the control connection 'vconn' and waits for its
+ * reply. */
+static void
+control_barrier(struct vconn *vconn)
+{
+    struct ofl_msg_header msg = {.type = OFPT_BARRIER_REQUEST};
+
+    control_send(vconn, &msg);
+    for (;;) {
+        struct ofp_header *oh;
+        struct ofpbuf *reply;
+        int error;
+
+        error = vconn_recv_block(vconn, &reply);
+        if (error) {
+            ofp_fatal(error, "%s: receive failed", vconn_get_name(vconn));
+        }
+        oh = reply->data;
+        if (oh->type == OFPT_ERROR) {
+            n_errors++;
+        } else if (oh->type == OFPT_ECHO_REQUEST) {
+            vconn_send_block(vconn, make_echo_reply(oh));
+        } else if (oh->type == OFPT_BARRIER_REPLY
+                   && oh->xid == htonl(CONTROL_XID)) {
+            ofpbuf_delete(reply);
+            return;
+        }
+        ofpbuf_delete(reply);
+    }
+}
+
+/* Fills in 'fm' to add flow 'dst' of the flows identified by 'src': the
+ * flows of the flow-mod and stats tests match on IPv4 addresses, and drop
+ * the packets.  The caller must free 'fm->match'. */
+static void
+make_ipv4_flow(struct ofl_msg_flow_mod *fm, uint32_t src, uint32_t dst)
+{
+    struct ofl_match *match = xmalloc(sizeof *match);
+
+    ofl_structs_match_init(match);
+    ofl_structs_match_put16(match, OXM_OF_ETH_TYPE, ETH_TYPE_IP);
+    ofl_structs_match_put32(match, OXM_OF_IPV4_SRC, htonl(src));
+    ofl_structs_match_put32(match, OXM_OF_IPV4_DST, htonl(dst));
+
+    memset(fm, 0, sizeof *fm);
+    fm->header.type = OFPT_FLOW_MOD;
+    fm->cookie = BENCH_COOKIE;
+    fm->table_id = 0;
+    fm->command = OFPFC_ADD;
+    fm->idle_timeout = OFP_FLOW_PERMANENT;
+    fm->hard_timeout = OFP_FLOW_PERMANENT;
+    fm->priority = BENCH_PRIORITY;
+    fm->buffer_id = OFP_NO_BUFFER;
+    fm->out_port = OFPP_ANY;
+    fm->out_group = OFPG_ANY;
+    fm->match = (struct ofl_match_header *) match;
+}
+
+/* Removes every flow installed by the benchmark. */
+static void
+remove_bench_flows(struct vconn *vconn)
+{
+    struct ofl_match match;
+    struct ofl_msg_flow_mod fm;
+
+    ofl_structs_match_init(&match);
+    memset(&fm, 0, sizeof fm);
+    fm.header.type = OFPT_FLOW_MOD;
+    fm.cookie = BENCH_COOKIE;
+    fm.cookie_mask = UINT64_MAX;
+    fm.table_id = OFPTT_ALL;
+    fm.command = OFPFC_DELETE;
+    fm.buffer_id = OFP_NO_BUFFER;
+    fm.out_port = OFPP_ANY;
+    fm.out_group = OFPG_ANY;
+    fm.match = (struct ofl_match_header *) &match;
+    control_send(vconn, (struct ofl_msg_header *)&fm);
+    control_barrier(vconn);
+}
+
+static void
+print_rate(const char *what, unsigned long long int n, double elapsed)
+{
+    printf("%llu %s in %.3f s: %.0f %s/s\n",
+           n, what, elapsed, elapsed > 0 ? n / elapsed : 0.0, what);
+}
+
+/* flow-mod test: each session adds 'count' flows, a barrier after every
+ * 'batch' of them, with up to 'window' barriers outstanding.  A batch is
+ * complete, and its latency taken, when its barrier reply arrives. */
+
+static void
+flow_mod_start(struct session *s)
+{
+    unsigned int seq = s->n_started++;
+    unsigned int first = seq * batch;
+    unsigned int i;
+
+    s->pending[seq % window].start = time_usec();
+    for (i = first; i < count && i - first < batch; i++) {
+        struct ofl_msg_flow_mod fm;
+
+        make_ipv4_flow(&fm, 0x0a000000 | s->id, i);
+        session_send(s, (struct ofl_msg_header *)&fm, seq);
+        ofl_structs_free_match(fm.match, NULL);
+    }
+    session_send_barrier(s, seq);
+}
+
+static void
+flow_mod_recv(struct session *s, struct ofpbuf *msg)
+{
+    struct ofp_header *oh = msg->data;
+
+    if (oh->type == OFPT_BARRIER_REPLY) {
+        struct pending *p = &s->pending[ntohl(oh->xid) % window];
+
+        samples_add(&op_latency, time_usec() - p->start);
+        s->n_done++;
+    }
+}
+
+static void
+flow_mod_report(double elapsed)
+{
+    print_rate("flow_mods", (unsigned long long int) n_sessions * count,
+               elapsed);
+    samples_print(&op_latency, "barrier", "us");
+}
+
+/* packet-in test: a table-miss flow sends packets to the controller.  Each
+ * session injects frames through the pipeline with a packet_out to
+ * OFPP_TABLE and answers each resulting packet-in with a flow_mod that
+ * releases the packet's buffer, followed by a barrier.  A frame's source
+ * address carries the session and its sequence number, so each session only
+ * answers its own packet-ins, although every session receives them all. */
+
+static void
+packet_in_setup(struct vconn *vconn)
+{
+    struct ofl_action_output output =
+            {{.type = OFPAT_OUTPUT, .len = sizeof(struct ofp_action_output)},
+             .port = OFPP_CONTROLLER, .max_len = 128};
+    struct ofl_action_header *actions[] = {&output.header};
+    struct ofl_instruction_actions apply =
+            {{.type = OFPIT_APPLY_ACTIONS},
+             .actions_num = 1, .actions = actions};
+    struct ofl_instruction_header *insts[] = {&apply.header};
+    struct ofl_match match;
+    struct ofl_msg_flow_mod fm;
+
+    if (count > 1 << 24 || n_sessions > 1 << 16) {
+        ofp_fatal(0, "the packet-in test supports up to %u packets and "
+                  "%u sessions", 1 << 24, 1 << 16);
+    }
+
+    ofl_structs_match_init(&match);
+    memset(&fm, 0, sizeof fm);
+    fm.header.type = OFPT_FLOW_MOD;
+    fm.cookie = BENCH_COOKIE;
+    fm.table_id = 0;
+    fm.command = OFPFC_ADD;
+    fm.priority = 0;
+    fm.buffer_id = OFP_NO_BUFFER;
+    fm.out_port = OFPP_ANY;
+    fm.out_group = OFPG_ANY;
+    fm.match = (struct ofl_match_header *) &match;
+    fm.instructions_num = 1;
+    fm.instructions = insts;
+    control_send(vconn, (struct ofl_msg_header *)&fm);
+    control_barrier(vconn);
+}
+
+static void
+make_bench_mac(uint8_t mac[ETH_ADDR_LEN], unsigned int session,
+               unsigned int seq)
+{
+    mac[0] = 0x02;
+    mac[1] = session >> 8;
+    mac[2] = session;
+    mac[3] = seq >> 16;
+    mac[4] = seq >> 8;
+    mac[5] = seq;
+}
+
+static void
+packet_in_start(struct session *s)
+{
+    unsigned int seq = s->n_started++;
+    uint8_t frame[ETH_TOTAL_MIN];
+    struct eth_header *eh = (struct eth_header *) frame;
+    struct ofl_action_output output =
+            {{.type = OFPAT_OUTPUT, .len = sizeof(struct ofp_action_output)},
+             .port = OFPP_TABLE, .max_len = 0};
+    struct ofl_action_header *actions[] = {&output.header};
+    struct ofl_msg_packet_out po =
+            {{.type = OFPT_PACKET_OUT},
+             .buffer_id = OFP_NO_BUFFER,
+             .in_port = OFPP_CONTROLLER,
+             .actions_num = 1,
+             .actions = actions,
+             .data_length = sizeof frame,
+             .data = frame};
+
+    memset(frame, 0, sizeof frame);
+    memset(eh->eth_dst, 0xff, ETH_ADDR_LEN);
+    make_bench_mac(eh->eth_src, s->id, seq);
+    eh->eth_type = htons(BENCH_ETH_TYPE);
+
+    s->pending[seq % window].start = time_usec();
+    session_send(s, (struct ofl_msg_header *)&po, seq);
+}
+
+static void
+packet_in_recv(struct session *s, struct ofpbuf *msg)
+{
+    struct ofp_header *oh = msg->data;
+
+    if (oh->type == OFPT_PACKET_IN) {
+        struct ofl_msg_packet_in *pin;
+        struct ofl_msg_flow_mod fm;
+        struct ofl_match *match;
+        struct eth_header *eh;
+        unsigned int seq;
+        uint32_t xid;
+
+        if (ofl_msg_unpack(msg->data, msg->size,
+                           (struct ofl_msg_header **) &pin, &xid, NULL)) {
+            return;
+        }
+        eh = (struct eth_header *) pin->data;
+        if (pin->data_length < ETH_HEADER_LEN
+            || eh->eth_type != htons(BENCH_ETH_TYPE)
+            || eh->eth_src[0] != 0x02
+            || ((eh->eth_src[1] << 8) | eh->eth_src[2]) != s->id) {
+            ofl_msg_free((struct ofl_msg_header *) pin, NULL);
+            return;
+        }
+        seq = (eh->eth_src[3] << 16) | (eh->eth_src[4] << 8) | eh->eth_src[5];
+        samples_add(&pkt_in_latency,
+                    time_usec() - s->pending[seq % window].start);
+
+        match = xmalloc(sizeof *match);
+        ofl_structs_match_init(match);
+        ofl_structs_match_put16(match, OXM_OF_ETH_TYPE, BENCH_ETH_TYPE);
+        ofl_structs_match_put_eth(match, OXM_OF_ETH_SRC, eh->eth_src);
+        memset(&fm, 0, sizeof fm);
+        fm.header.type = OFPT_FLOW_MOD;
+        fm.cookie = BENCH_COOKIE;
+        fm.table_id = 0;
+        fm.command = OFPFC_ADD;
+        fm.priority = BENCH_PRIORITY;
+        fm.buffer_id = pin->buffer_id;
+        fm.out_port = OFPP_ANY;
+        fm.out_group = OFPG_ANY;
+        fm.match = (struct ofl_match_header *) match;
+        session_send(s, (struct ofl_msg_header *)&fm, seq);
+        session_send_barrier(s, seq);
+
+        ofl_structs_free_match(fm.match, NULL);
+        ofl_msg_free((struct ofl_msg_header *) pin, NULL);
+    } else if (oh->type == OFPT_BARRIER_REPLY) {
+        struct pending *p = &s->pending[ntohl(oh->xid) % window];
+
+        samples_add(&op_latency, time_usec() - p->start);
+        s->n_done++;
+    }
+}
+
+static void
+packet_in_report(double elapsed)
+{
+    print_rate("flow setups", (unsigned long long int) n_sessions * count,
+               elapsed);
+    samples_print(&pkt_in_latency, "packet-in", "us");
+    samples_print(&op_latency, "flow setup", "us");
+}
+
+/* packet-in-hold test: checks and times the release of the packets the
+ * switch holds while a flow is set up, with --packet-in-hold on the
+ * datapath, through a two-table pipeline.  Table 0 pushes a VLAN tag and
+ * goes to table 1, whose table-miss flow sends packets to the controller.
+ * Each operation injects HOLD_FRAMES frames of a new flow with packet_outs
+ * to OFPP_TABLE and answers the packet-in of the first with a flow_mod to
+ * table 1 that sends the flow's packets to the controller, followed by a
+ * barrier.  The other frames, held by the switch, must come back in
+ * packet-ins before the barrier reply, with the single VLAN tag of one pass
+ * through table 0. */
+
+#define HOLD_FRAMES 4
+
+static void
+packet_in_hold_setup(struct vconn *vconn)
+{
+    struct ofl_action_push push =
+            {{.type = OFPAT_PUSH_VLAN, .len = sizeof(struct ofp_action_push)},
+             .ethertype = ETH_TYPE_VLAN};
+    struct ofl_action_header *push_actions[] = {&push.header};
+    struct ofl_instruction_actions apply_push =
+            {{.type = OFPIT_APPLY_ACTIONS},
+             .actions_num = 1, .actions = push_actions};
+    struct ofl_instruction_goto_table goto_table =
+            {{.type = OFPIT_GOTO_TABLE}, .table_id = 1};
+    struct ofl_instruction_header *insts0[] =
+            {&apply_push.header, &goto_table.header};
+    struct ofl_action_output output =
+            {{.type = OFPAT_OUTPUT, .len = sizeof(struct ofp_action_output)},
+             .port = OFPP_CONTROLLER, .max_len = OFPCML_NO_BUFFER};
+    struct ofl_action_header *output_actions[] = {&output.header};
+    struct ofl_instruction_actions apply_output =
+            {{.type = OFPIT_APPLY_ACTIONS},
+             .actions_num = 1, .actions = output_actions};
+    struct ofl_instruction_header *insts1[] = {&apply_output.header};
+    struct ofl_match match;
+    struct ofl_msg_flow_mod fm;
+
+    if (count > 1 << 24 || n_sessions > 1 << 16) {
+        ofp_fatal(0, "the packet-in-hold test supports up to %u flows and "
+                  "%u sessions", 1 << 24, 1 << 16);
+    }
+
+    ofl_structs_match_init(&match);
+    memset(&fm, 0, sizeof fm);
+    fm.header.type = OFPT_FLOW_MOD;
+    fm.cookie = BENCH_COOKIE;
+    fm.table_id = 0;
+    fm.command = OFPFC_ADD;
+    fm.priority = BENCH_PRIORITY;
+    fm.buffer_id = OFP_NO_BUFFER;
+    fm.out_port = OFPP_ANY;
+    fm.out_group = OFPG_ANY;
+    fm.match = (struct ofl_match_header *) &match;
+    fm.instructions_num = ARRAY_SIZE(insts0);
+    fm.instructions = insts0;
+    control_send(vconn, (struct ofl_msg_header *)&fm);
+
+    fm.table_id = 1;
+    fm.priority = 0;
+    fm.instructions_num = ARRAY_SIZE(insts1);
+    fm.instructions = insts1;
+    control_send(vconn, (struct ofl_msg_header *)&fm);
+    control_barrier(vconn);
+}
+
+static void
+packet_in_hold_start(struct session *s)
+{
+    unsigned int seq = s->n_started++;
+    uint8_t frame[ETH_TOTAL_MIN];
+    struct eth_header *eh = (struct eth_header *) frame;
+    struct ofl_action_output output =
+            {{.type = OFPAT_OUTPUT, .len = sizeof(struct ofp_action_output)},
+             .port = OFPP_TABLE, .max_len = 0};
+    struct ofl_action_header *actions[] = {&output.header};
+    struct ofl_msg_packet_out po =
+            {{.type = OFPT_PACKET_OUT},
+             .buffer_id = OFP_NO_BUFFER,
+             .in_port = OFPP_CONTROLLER,
+             .actions_num = 1,
+             .actions = actions,
+             .data_length = sizeof frame,
+             .data = frame};
+    unsigned int i;
+
+    memset(frame, 0, sizeof frame);
+    memset(eh->eth_dst, 0xff, ETH_ADDR_LEN);
+    make_bench_mac(eh->eth_src, s->id, seq);
+    eh->eth_type = htons(BENCH_ETH_TYPE);
+
+    /* The first byte of the payload numbers the frames of the flow. */
+    s->pending[seq % window].start = time_usec();
+    for (i = 0; i < HOLD_FRAMES; i++) {
+        frame[ETH_HEADER_LEN] = i;
+        session_send(s, (struct ofl_msg_header *)&po, seq);
+    }
+}
+
+static void
+packet_in_hold_recv(struct session *s, struct ofpbuf *msg)
+{
+    struct ofp_header *oh = msg->data;
+
+    if (oh->type == OFPT_PACKET_IN) {
+        struct ofl_msg_packet_in *pin;
+        struct eth_header *eh;
+        unsigned int n_tags;
+        size_t ofs;
+        uint32_t xid;
+
+        if (ofl_msg_unpack(msg->data, msg->size,
+                           (struct ofl_msg_header **) &pin, &xid, NULL)) {
+            return;
+        }
+        eh = (struct eth_header *) pin->data;
+        if (pin->data_length < ETH_TOTAL_MIN
+            || eh->eth_src[0] != 0x02
+            || ((eh->eth_src[1] << 8) | eh->eth_src[2]) != s->id) {
+            ofl_msg_free((struct ofl_msg_header *) pin, NULL);
+            return;
+        }
+
+        /* Each pass through table 0 adds a VLAN tag. */
+        n_tags = 0;
+        for (ofs = ETH_ADDR_LEN * 2;
+             ofs + 2 <= pin->data_length
+             && pin->data[ofs] == ETH_TYPE_VLAN >> 8
+             && pin->data[ofs + 1] == (ETH_TYPE_VLAN & 0xff);
+             ofs += VLAN_HEADER_LEN) {
+            n_tags++;
+        }
+        if (n_tags != 1) {
+            n_failures++;
+        }
+
+        if (pin->reason == OFPR_NO_MATCH && ofs + 2 < pin->data_length
+            && pin->data[ofs + 2] == 0) {
+            unsigned int seq = ((eh->eth_src[3] << 16)
+                                | (eh->eth_src[4] << 8) | eh->eth_src[5]);
+            struct ofl_action_output output =
+                    {{.type = OFPAT_OUTPUT,
+                      .len = sizeof(struct ofp_action_output)},
+                     .port = OFPP_CONTROLLER, .max_len = OFPCML_NO_BUFFER};
+            struct ofl_action_header *actions[] = {&output.header};
+            struct ofl_instruction_actions apply =
+                    {{.type = OFPIT_APPLY_ACTIONS},
+                     .actions_num = 1, .actions = actions};
+            struct ofl_instruction_header *insts[] = {&apply.header};
+            struct ofl_msg_flow_mod fm;
+            struct ofl_match *match;
+
+            samples_add(&pkt_in_latency,
+                        time_usec() - s->pending[seq % window].start);
+
+            match = xmalloc(sizeof *match);
+            ofl_structs_match_init(match);
+            ofl_structs_match_put_eth(match, OXM_OF_ETH_SRC, eh->eth_src);
+            memset(&fm, 0, sizeof fm);
+            fm.header.type = OFPT_FLOW_MOD;
+            fm.cookie = BENCH_COOKIE;
+            fm.table_id = 1;
+            fm.command = OFPFC_ADD;
+            fm.priority = BENCH_PRIORITY;
+            fm.buffer_id = OFP_NO_BUFFER;
+            fm.out_port = OFPP_ANY;
+            fm.out_group = OFPG_ANY;
+            fm.match = (struct ofl_match_header *) match;
+            fm.instructions_num = 1;
+            fm.instructions = insts;
+            session_send(s, (struct ofl_msg_header *)&fm, seq);
+            session_send_barrier(s, seq);
+            ofl_structs_free_match(fm.match, NULL);
+        } else if (pin->reason == OFPR_NO_MATCH) {
+            n_not_held++;
+        } else {
+            n_released++;
+        }
+        ofl_msg_free((struct ofl_msg_header *) pin, NULL);
+    } else if (oh->type == OFPT_BARRIER_REPLY) {
+        struct pending *p = &s->pending[ntohl(oh->xid) % window];
+        struct ofl_msg_flow_mod fm;
+        struct ofl_match *match;
+        uint8_t mac[ETH_ADDR_LEN];
+
+        samples_add(&op_latency, time_usec() - p->start);
+        s->n_done++;
+
+        /* The flow is done with, and the table would fill up. */
+        make_bench_mac(mac, s->id, ntohl(oh->xid));
+        match = xmalloc(sizeof *match);
+        ofl_structs_match_init(match);
+        ofl_structs_match_put_eth(match, OXM_OF_ETH_SRC, mac);
+        memset(&fm, 0, sizeof fm);
+        fm.header.type = OFPT_FLOW_MOD;
+        fm.table_id = 1;
+        fm.command = OFPFC_DELETE_STRICT;
+        fm.priority = BENCH_PRIORITY;
+        fm.buffer_id = OFP_NO_BUFFER;
+        fm.out_port = OFPP_ANY;
+        fm.out_group = OFPG_ANY;
+        fm.match = (struct ofl_match_header *) match;
+        session_send(s, (struct ofl_msg_header *)&fm, ntohl(oh->xid));
+        ofl_structs_free_match(fm.match, NULL);
+    }
+}
+
+static void
+packet_in_hold_report(double elapsed)
+{
+    unsigned long long int n_held = ((unsigned long long int) n_sessions
+                                     * count * (HOLD_FRAMES - 1));
+
+    print_rate("flow setups", (unsigned long long int) n_sessions * count,
+               elapsed);
+    printf("%llu of %llu held packets released, %llu sent to the "
+           "controller instead\n", n_released, n_held, n_not_held);
+    if (n_failures) {
+        printf("%u packets went through table 0 more than once\n",
+               n_failures);
+    }
+    samples_print(&pkt_in_latency, "packet-in", "us");
+    samples_print(&op_latency, "flow setup", "us");
+}
+
+/* packet-out test: each session sends 'count' packet_outs of --size byte
+ * frames, a barrier after every 'batch' of them, with up to 'window'
+ * barriers outstanding.  The packets are output to --out-port, after a VLAN
+ * tag is pushed with --push-vlan, or dropped without --out-port.  With
+ * --packet-out-batch a batch is sent in as few OFP_EXT_PACKET_OUT_BATCH
+ * messages as fit it. */
+
+static uint8_t *packet_out_frame;
+
+static void
+packet_out_setup(struct vconn *vconn UNUSED)
+{
+    struct eth_header *eh;
+
+    packet_out_frame = xcalloc(1, frame_size);
+    eh = (struct eth_header *) packet_out_frame;
+    memset(eh->eth_dst, 0xff, ETH_ADDR_LEN);
+    make_bench_mac(eh->eth_src, 0, 0);
+    eh->eth_type = htons(BENCH_ETH_TYPE);
+}
+
+static void
+packet_out_start(struct session *s)
+{
+    unsigned int seq = s->n_started++;
+    unsigned int first = seq * batch;
+    struct ofl_action_push push =
+            {{.type = OFPAT_PUSH_VLAN, .len = sizeof(struct ofp_action_push)},
+             .ethertype = ETH_TYPE_VLAN};
+    struct ofl_action_output output =
+            {{.type = OFPAT_OUTPUT, .len = sizeof(struct ofp_action_output)},
+             .port = out_port, .max_len = 0};
+    struct ofl_action_header *actions[2];
+    struct ofl_msg_packet_out po =
+            {{.type = OFPT_PACKET_OUT},
+             .buffer_id = OFP_NO_BUFFER,
+             .in_port = OFPP_CONTROLLER,
+             .actions_num = 0,
+             .actions = actions,
+             .data_length = frame_size,
+             .data = packet_out_frame};
+    unsigned int n = MIN(count - first, batch);
+    unsigned int i;
+
+    if (out_port) {
+        if (push_vlan) {
+            actions[po.actions_num++] = &push.header;
+        }
+        actions[po.actions_num++] = &output.header;
+    }
+
+    s->pending[seq % window].start = time_usec();
+    if (packet_out_batch) {
+        struct ofl_exp_openflow_packet_out_entry *entries;
+        struct ofl_exp_openflow_msg_packet_out_batch pob =
+                {{{{.type = OFPT_EXPERIMENTER},
+                   .experimenter_id = OPENFLOW_VENDOR_ID},
+                  .type = OFP_EXT_PACKET_OUT_BATCH},
+                 .entries_num = 0,
+                 .entries = NULL};
+        size_t entry_len = ROUND_UP(sizeof(struct openflow_ext_packet_out_entry)
+                                    + ofl_actions_ofp_total_len(actions, po.actions_num, NULL)
+                                    + frame_size, 8);
+        size_t max = (UINT16_MAX - sizeof(struct openflow_ext_packet_out_batch))
+                     / entry_len;
+
+        entries = xmalloc(n * sizeof *entries);
+        for (i = 0; i < n; i++) {
+            entries[i].buffer_id = po.buffer_id;
+            entries[i].in_port = po.in_port;
+            entries[i].actions_num = po.actions_num;
+            entries[i].actions = po.actions;
+            entries[i].data_length = po.data_length;
+            entries[i].data = po.data;
+        }
+        for (i = 0; i < n; i += pob.entries_num) {
+            pob.entries = &entries[i];
+            pob.entries_num = MIN(n - i, max);
+            session_send(s, (struct ofl_msg_header *)&pob, seq);
+        }
+        free(entries);
+    } else {
+        for (i = 0; i < n; i++) {
+            session_send(s, (struct ofl_msg_header *)&po, seq);
+        }
+    }
+    session_send_barrier(s, seq);
+}
+
+static void
+packet_out_report(double elapsed)
+{
+    print_rate("packet_outs", (unsigned long long int) n_sessions * count,
+               elapsed);
+    samples_print(&op_latency, "barrier", "us");
+}
+
+/* stats test: each session requests 'count' dumps of the statistics selected
+ * by --stats, after 'n_flows' flows were added to table 0.  A dump is
+ * complete when the reply without OFPMPF_REPLY_MORE arrives. */
+
+static void
+stats_setup(struct vconn *vconn)
+{
+    unsigned int i;
+
+    for (i = 0; i < n_flows; i++) {
+        struct ofl_msg_flow_mod fm;
+
+        make_ipv4_flow(&fm, 0x0affffff, i);
+        control_send(vconn, (struct ofl_msg_header *)&fm);
+        ofl_structs_free_match(fm.match, NULL);
+        if ((i + 1) % batch == 0) {
+            control_barrier(vconn);
+        }
+    }
+    control_barrier(vconn);
+}
+
+static void
+stats_start(struct session *s)
+{
+    unsigned int seq = s->n_started++;
+
+    s->pending[seq % window].start = time_usec();
+    if (stats_type == OFPMP_FLOW || stats_type == OFPMP_AGGREGATE) {
+        struct ofl_match match;
+        struct ofl_msg_multipart_request_flow req =
+                {{{.type = OFPT_MULTIPART_REQUEST},
+                  .type = stats_type, .flags = 0x0000},
+                 .cookie = 0x0000000000000000ULL,
+                 .cookie_mask = 0x0000000000000000ULL,
+                 .table_id = OFPTT_ALL,
+                 .out_port = OFPP_ANY,
+                 .out_group = OFPG_ANY,
+                 .match = (struct ofl_match_header *) &match};
+
+        ofl_structs_match_init(&match);
+        session_send(s, (struct ofl_msg_header *)&req, seq);
+    } else if (stats_type == OFPMP_PORT_STATS) {
+        struct ofl_msg_multipart_request_port req =
+                {{{.type = OFPT_MULTIPART_REQUEST},
+                  .type = OFPMP_PORT_STATS, .flags = 0x0000},
+                 .port_no = OFPP_ANY};
+
+        session_send(s, (struct ofl_msg_header *)&req, seq);
+    } else {
+        struct ofl_msg_multipart_request_header req =
+                {{.type = OFPT_MULTIPART_REQUEST},
+                 .type = stats_type, .flags = 0x0000};
+
+        session_send(s, (struct ofl_msg_header *)&req, seq);
+    }
+}
+
+static void
+stats_recv(struct session *s, struct ofpbuf *msg)
+{
+    struct ofp_multipart_reply *reply = msg->data;
+
+    if (reply->header.type != OFPT_MULTIPART_REPLY
+        || msg->size < sizeof *reply) {
+        return;
+    }
+    if (stats_type == OFPMP_FLOW) {
+        size_t n;
+
+        if (!ofl_utils_count_ofp_flow_stats(reply->body,
+                                            msg->size - sizeof *reply, &n)) {
+            n_entries += n;
+        }
+    } else if (stats_type == OFPMP_PORT_STATS) {
+        n_entries += (msg->size - sizeof *reply)
+                     / sizeof(struct ofp_port_stats);
+    } else if (stats_type == OFPMP_PORT_DESC) {
+        n_entries += (msg->size - sizeof *reply) / sizeof(struct ofp_port);
+    }
+    if (!(ntohs(reply->flags) & OFPMPF_REPLY_MORE)) {
+        struct pending *p = &s->pending[ntohl(reply->header.xid) % window];
+
+        samples_add(&op_latency, time_usec() - p->start);
+        s->n_done++;
+    }
+}
+
+static void
+stats_report(double elapsed)
+{
+    print_rate("dumps", (unsigned long long int) n_sessions * count,
+               elapsed);
+    if (stats_type == OFPMP_FLOW) {
+        print_rate("flows", n_entries, elapsed);
+    } else if (stats_type == OFPMP_PORT_STATS
+               || stats_type == OFPMP_PORT_DESC) {
+        print_rate("ports", n_entries, elapsed);
+    }
+    samples_print(&op_latency, "dump", "us");
+}
+
+/* echo test: each session sends 'count' echo requests, 'window' at a time.
+ * The echo replies themselves are handled with the probes of
+ * --echo-interval. */
+
+static void
+echo_start(struct session *s)
+{
+    session_send_echo(s, s->n_started++);
+}
+
+static void
+echo_recv(struct session *s UNUSED, struct ofpbuf *msg UNUSED)
+{
+}
+
+static void
+echo_report(double elapsed)
+{
+    print_rate("echos", (unsigned long long int) n_sessions * count, elapsed);
+}
+
+/* port-status test: each operation takes the link of the device given by
+ * --netdev down, waits for the switch to report the port down, brings the
+ * link back up and waits for the switch to report the port up.  The device
+ * is typically the peer of a veth pair whose other end is a port of the
+ * switch, or that port itself. */
+
+static struct netdev *toggle_netdev;
+static bool toggle_down;        /* Was the link last taken down? */
+
+static void
+port_status_setup(struct vconn *vconn UNUSED)
+{
+    int error;
+
+    if (!toggle_name) {
+        ofp_fatal(0, "the port-status test needs --netdev");
+    }
+    if (n_sessions > 1 || window > 1) {
+        ofp_fatal(0, "the port-status test runs one session with a window "
+                  "of 1");
+    }
+    error = netdev_open(toggle_name, NETDEV_ETH_TYPE_NONE, &toggle_netdev);
+    if (error) {
+        ofp_fatal(error, "%s: failed to open network device", toggle_name);
+    }
+    error = netdev_turn_flags_on(toggle_netdev, NETDEV_UP, false);
+    if (error) {
+        ofp_fatal(error, "%s: failed to bring up", toggle_name);
+    }
+}
+
+/* Sets the link state and starts timing the port_status.  Setting the state
+ * can take milliseconds by itself, during which the switch may already see
+ * the change, so the time it takes is recorded apart. */
+static void
+port_status_toggle(struct session *s, bool up)
+{
+    int error;
+
+    s->pending[0].start = time_usec();
+    toggle_down = !up;
+    error = (up ? netdev_turn_flags_on : netdev_turn_flags_off)(
+        toggle_netdev, NETDEV_UP, false);
+    if (error) {
+        ofp_fatal(error, "%s: failed to bring %s", toggle_name,
+                  up ? "up" : "down");
+    }
+    samples_add(&toggle_latency, time_usec() - s->pending[0].start);
+}
+
+static void
+port_status_start(struct session *s)
+{
+    s->n_started++;
+    port_status_toggle(s, false);
+}
+
+static void
+port_status_recv(struct session *s, struct ofpbuf *msg)
+{
+    struct ofp_port_status *ops = msg->data;
+    bool link_down;
+
+    if (ops->header.type != OFPT_PORT_STATUS || msg->size < sizeof *ops
+        || s->n_done >= s->n_started) {
+        return;
+    }
+    /* port_status messages that do not report the change just made, such
+     * as those of other ports, are ignored. */
+    link_down = (ntohl(ops->desc.state) & OFPPS_LINK_DOWN) != 0;
+    if (link_down && toggle_down) {
+        samples_add(&link_down_latency, time_usec() - s->pending[0].start);
+        port_status_toggle(s, true);
+    } else if (!link_down && !toggle_down) {
+        samples_add(&op_latency, time_usec() - s->pending[0].start);
+        s->n_done++;
+    }
+}
+
+static void
+port_status_report(double elapsed)
+{
+    print_rate("link toggles", count, elapsed);
+    samples_print(&link_down_latency, "link down", "us");
+    samples_print(&op_latency, "link up", "us");
+    samples_print(&toggle_latency, "set link", "us");
+    netdev_close(toggle_netdev);
+}
+
+/* decode test: runs without a switch.  It packs a flow_mod whose match has
+ * 3, 8 or 15 fields, and times 'count' decodes of the message by
+ * ofl_msg_unpack(), and of its match alone by oxm_pull_match(). */
+
+#define DECODE_DEFAULT_COUNT 1000000
+
+/* Fills in 'fm' with the flow_mod of the decode test, with a match of
+ * 'n' fields.  The caller must free 'fm->match'. */
+static void
+make_decode_flow(struct ofl_msg_flow_mod *fm, unsigned int n)
+{
+    static const uint8_t dst[ETH_ADDR_LEN] = {0x02, 0, 0, 0, 0, 0x01};
+    static const uint8_t src[ETH_ADDR_LEN] = {0x02, 0, 0, 0, 0, 0x02};
+    struct ofl_match *match;
+
+    make_ipv4_flow(fm, 0x0a000001, 0x0a000002);
+    match = (struct ofl_match *) fm->match;
+    if (n >= 8) {
+        ofl_structs_match_put32(match, OXM_OF_IN_PORT, 1);
+        ofl_structs_match_put_eth(match, OXM_OF_ETH_DST, (uint8_t *) dst);
+        ofl_structs_match_put_eth(match, OXM_OF_ETH_SRC, (uint8_t *) src);
+        ofl_structs_match_put8(match, OXM_OF_IP_PROTO, IPPROTO_TCP);
+        ofl_structs_match_put16(match, OXM_OF_TCP_DST, 80);
+    }
+    if (n >= 15) {
+        ofl_structs_match_put64(match, OXM_OF_METADATA, 0x1234);
+        ofl_structs_match_put16(match, OXM_OF_VLAN_VID, OFPVID_PRESENT | 10);
+        ofl_structs_match_put8(match, OXM_OF_VLAN_PCP, 3);
+        ofl_structs_match_put8(match, OXM_OF_IP_DSCP, 46);
+        ofl_structs_match_put8(match, OXM_OF_IP_ECN, 1);
+        ofl_structs_match_put16(match, OXM_OF_TCP_SRC, 1024);
+        ofl_structs_match_put64m(match, OXM_OF_TUNNEL_ID_W, 0x5000,
+                                 0xff00);
+    }
+}
+
+static void
+print_decode_rate(const char *what, unsigned int n, long long int usecs)
+{
+    double secs = usecs / 1e6;
+
+    printf("  %-24s %10.0f/s %8.1f ns\n", what, secs > 0 ? n / secs : 0.0,
+           n ? usecs * 1e3 / n : 0.0);
+}
+
+static void
+decode_run(unsigned int n)
+{
+    struct ofl_msg_flow_mod fm;
+    struct ofp_flow_mod *ofm;
+    struct ofpbuf *msg;
+    long long int start;
+    size_t match_len;
+    unsigned int i;
+
+    make_decode_flow(&fm, n);
+    msg = pack_msg((struct ofl_msg_header *)&fm, 0);
+    ofl_structs_free_match(fm.match, NULL);
+    ofm = msg->data;
+    match_len = ntohs(ofm->match.length) - (sizeof ofm->match - 4);
+
+    printf("%u fields, %zu byte flow_mod:\n", n, msg->size);
+
+    start = time_usec();
+    for (i = 0; i < count; i++) {
+        struct ofl_msg_header *decoded;
+        uint32_t xid;
+
+        if (ofl_msg_unpack(msg->data, msg->size, &decoded, &xid,
+                           &bench_exp)) {
+            ofp_fatal(0, "flow_mod of %u fields does not decode", n);
+        }
+        ofl_msg_free(decoded, &bench_exp);
+    }
+    print_decode_rate("ofl_msg_unpack", count, time_usec() - start);
+
+    start = time_usec();
+    for (i = 0; i < count; i++) {
+        struct ofl_match *match = xmalloc(sizeof *match);
+        struct ofpbuf b;
+
+        ofpbuf_use(&b, ofm->match.oxm_fields, match_len);
+        b.size = match_len;
+        if (oxm_pull_match(&b, match, match_len)) {
+            ofp_fatal(0, "match of %u fields does not decode", n);
+        }
+        match->header.type = OFPMT_OXM;
+        match->header.length = match_len;
+        ofl_structs_free_match((struct ofl_match_header *) match, NULL);
+    }
+    print_decode_rate("oxm_pull_match", count, time_usec() - start);
+
+    ofpbuf_delete(msg);
+}
+
+static void
+decode_bench(void)
+{
+    static const unsigned int all_n_fields[] = {3, 8, 15};
+    size_t i;
+
+    if (!count) {
+        count = DECODE_DEFAULT_COUNT;
+    }
+    printf("decode: %u operations each\n", count);
+    for (i = 0; i < ARRAY_SIZE(all_n_fields); i++) {
+        if (!n_fields || n_fields == all_n_fields[i]) {
+            decode_run(all_n_fields[i]);
+        }
+    }
+}
+
+#define QUEUE_DEFAULT_COUNT 1000000
+
+/* Packets the queue test moves out of the queue at a time, as
+ * hw_pkt_q_run() in the datapath does. */
+#define QUEUE_BURST 64
+
+/* State of the queue test's producer thread. */
+struct queue_producer {
+    struct pkt_queue *q;
+    long long int usecs;        /* Time taken to queue 'count' packets. */
+    bool done;                  /* Set, atomically, once it finished. */
+};
+
+static struct ofpbuf *
+queue_packet(void)
+{
+    struct ofpbuf *buffer = ofpbuf_new(frame_size);
+
+    ofpbuf_put_zeros(buffer, frame_size);
+    return buffer;
+}
+
+static void *
+queue_produce(void *p_)
+{
+    struct queue_producer *p = p_;
+    long long int start = time_usec();
+    unsigned int i;
+
+    for (i = 0; i < count; i++) {
+        pkt_queue_enqueue(p->q, queue_packet(), 1, OFPR_NO_MATCH);
+    }
+    p->usecs = time_usec() - start;
+    __atomic_store_n(&p->done, true, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static size_t
+queue_drain(struct pkt_queue *q)
+{
+    struct pkt_queue_entry entries[QUEUE_BURST];
+    size_t n, i;
+
+    n = pkt_queue_dequeue(q, entries, QUEUE_BURST);
+    for (i = 0; i < n; i++) {
+        ofpbuf_delete(entries[i].buffer);
+    }
+    return n;
+}
+
+static void
+queue_bench(void)
+{
+    struct queue_producer p;
+    unsigned long long int n_received, n_wakeups;
+    long long int start;
+    pthread_t thread;
+    unsigned int i;
+    int error;
+
+    if (!count) {
+        count = QUEUE_DEFAULT_COUNT;
+    }
+    printf("queue: %u packets of %u bytes, %d slots\n", count, frame_size,
+           PKT_QUEUE_SIZE);
+
+    /* Allocating, queuing, draining and freeing in one thread gives the
+     * cost of the queue without any sharing between threads. */
+    error = pkt_queue_create(&p.q);
+    if (error) {
+        ofp_fatal(error, "could not create packet queue");
+    }
+    start = time_usec();
+    for (i = 0; i < count; i++) {
+        pkt_queue_enqueue(p.q, queue_packet(), 1, OFPR_NO_MATCH);
+        if (i % QUEUE_BURST == QUEUE_BURST - 1) {
+            pkt_queue_clear_wakeup(p.q);
+            queue_drain(p.q);
+        }
+    }
+    while (queue_drain(p.q)) {
+        continue;
+    }
+    print_decode_rate("one thread", count, time_usec() - start);
+    pkt_queue_destroy(p.q);
+
+    /* A producer thread queues as fast as it can while this thread drains,
+     * sleeping in the poll loop whenever the queue runs empty. */
+    error = pkt_queue_create(&p.q);
+    if (error) {
+        ofp_fatal(error, "could not create packet queue");
+    }
+    p.done = false;
+    n_received = n_wakeups = 0;
+    start = time_usec();
+    error = pthread_create(&thread, NULL, queue_produce, &p);
+    if (error) {
+        ofp_fatal(error, "could not start producer thread");
+    }
+    for (;;) {
+        bool done = __atomic_load_n(&p.done, __ATOMIC_ACQUIRE);
+        size_t n;
+
+        pkt_queue_clear_wakeup(p.q);
+        n = queue_drain(p.q);
+        n_received += n;
+        if (!n) {
+            if (done) {
+                break;
+            }
+            /* The producer does not signal its end, so the timer catches
+             * a run whose last packets were dropped. */
+            pkt_queue_wait(p.q);
+            poll_timer_wait(10);
+            poll_block();
+            n_wakeups++;
+        }
+    }
+    pthread_join(thread, NULL);
+    print_decode_rate("producer thread", count, p.usecs);
+    print_decode_rate("consumer thread", n_received, time_usec() - start);
+    printf("  %llu received, %"PRIu64" dropped, %llu wakeups\n",
+           n_received, pkt_queue_get_dropped(p.q), n_wakeups);
+    pkt_queue_destroy(p.q);
+}
+
+#define PKTMEM_DEFAULT_COUNT 1000000
+
+/* Size and headroom of the buffers the pktmem test receives into, those of
+ * a port with a 1500-byte MTU in the datapath. */
+#define PKTMEM_RX_SIZE (VLAN_ETH_HEADER_LEN + 1500)
+#define PKTMEM_RX_HEADROOM (128 + 2)
+
+/* Event counters of this thread.  A counter that the kernel or the CPU does
+ * not provide has an fd of -1 and the errno of its failure. */
+enum bench_counter {
+    COUNTER_DTLB_READ_MISSES,
+    COUNTER_PAGE_FAULTS,
+    N_COUNTERS
+};
+
+struct bench_counters {
+    int fds[N_COUNTERS];
+    int errors[N_COUNTERS];
+    uint64_t values[N_COUNTERS];
+};
+
+static int
+bench_counter_open(uint32_t type, uint64_t config)
+{
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof attr);
+    attr.size = sizeof attr;
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static void
+bench_counters_start(struct bench_counters *c)
+{
+    int i;
+
+    c->fds[COUNTER_DTLB_READ_MISSES] = bench_counter_open(
+        PERF_TYPE_HW_CACHE,
+        PERF_COUNT_HW_CACHE_DTLB
+        | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+        | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    c->errors[COUNTER_DTLB_READ_MISSES] = errno;
+    c->fds[COUNTER_PAGE_FAULTS] = bench_counter_open(
+        PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS);
+    c->errors[COUNTER_PAGE_FAULTS] = errno;
+    for (i = 0; i < N_COUNTERS; i++) {
+        if (c->fds[i] >= 0) {
+            ioctl(c->fds[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(c->fds[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+static void
+bench_counters_stop(struct bench_counters *c)
+{
+    int i;
+
+    for (i = 0; i < N_COUNTERS; i++) {
+        c->values[i] = 0;
+        if (c->fds[i] >= 0) {
+            ioctl(c->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+            if (read(c->fds[i], &c->values[i], sizeof c->values[i])
+                != sizeof c->values[i]) {
+                c->errors[i] = errno;
+                close(c->fds[i]);
+                c->fds[i] = -1;
+                continue;
+            }
+            close(c->fds[i]);
+        }
+    }
+}
+
+static void
+print_counter(const struct bench_counters *c, enum bench_counter counter,
+              const char *what, unsigned int n)
+{
+    if (c->fds[counter] >= 0) {
+        printf("  %-24s %12.3f per packet\n", what,
+               n ? (double) c->values[counter] / n : 0.0);
+    } else {
+        printf("  %-24s unavailable (%s)\n", what,
+               strerror(c->errors[counter]));
+    }
+}
+
+/* Keeps 'n_in_flight' received packets in flight, allocated from 'pm', or
+ * from the heap if 'pm' is null.  Each of 'count' iterations frees one of
+ * them, picked at random so that the heap fragments as it does under
+ * real traffic, receives a new one in its place and clones it as the
+ * datapath does to output a packet to more than one port. */
+static void
+pktmem_run(struct pktmem *pm, unsigned int n_in_flight, const char *what)
+{
+    struct ofpbuf **packets = xmalloc(n_in_flight * sizeof *packets);
+    struct bench_counters counters;
+    uint8_t *frame = xcalloc(1, frame_size);
+    long long int start, usecs;
+    unsigned int i;
+
+    for (i = 0; i < n_in_flight; i++) {
+        packets[i] = pktmem_ofpbuf_clone_data(pm, frame, frame_size,
+                                              PKTMEM_RX_HEADROOM);
+    }
+
+    bench_counters_start(&counters);
+    start = time_usec();
+    for (i = 0; i < count; i++) {
+        unsigned int slot = random_range(n_in_flight);
+        struct ofpbuf *packet, *clone;
+
+        ofpbuf_delete(packets[slot]);
+        packet = pktmem_ofpbuf_new(pm, PKTMEM_RX_SIZE, PKTMEM_RX_HEADROOM);
+        ofpbuf_put(packet, frame, frame_size);
+        clone = pktmem_ofpbuf_clone(pm, packet, PKTMEM_RX_HEADROOM);
+        ofpbuf_delete(clone);
+        packets[slot] = packet;
+    }
+    usecs = time_usec() - start;
+    bench_counters_stop(&counters);
+
+    print_decode_rate(what, count, usecs);
+    print_counter(&counters, COUNTER_DTLB_READ_MISSES, "  dTLB read misses",
+                  count);
+    print_counter(&counters, COUNTER_PAGE_FAULTS, "  page faults", count);
+
+    for (i = 0; i < n_in_flight; i++) {
+        ofpbuf_delete(packets[i]);
+    }
+    free(packets);
+    free(frame);
+}
+
+/* Measures, without a switch, the allocation of packet buffers from the
+ * heap and from a packet memory region. */
+static void
+pktmem_bench(void)
+{
+    static const unsigned int all_n_in_flight[] = {1024, 32768};
+    size_t i;
+
+    if (!count) {
+        count = PKTMEM_DEFAULT_COUNT;
+    }
+    if (frame_size > PKTMEM_RX_SIZE) {
+        ofp_fatal(0, "pktmem: --size may be at most %d", PKTMEM_RX_SIZE);
+    }
+    random_init();
+    /* The test reports the regions itself. */
+    vlog_set_levels(VLM_pktmem, VLF_CONSOLE, VLL_WARN);
+    printf("pktmem: %u packets of %u bytes\n", count, frame_size);
+    for (i = 0; i < ARRAY_SIZE(all_n_in_flight); i++) {
+        unsigned int n = all_n_in_flight[i];
+        struct pktmem_stats stats;
+        struct pktmem *pm;
+        int error;
+
+        /* The packets in flight, a clone and some slack. */
+        error = pktmem_create((n + 64) * PKTMEM_BUF_SIZE, &pm);
+        if (error) {
+            ofp_fatal(error, "could not create packet memory");
+        }
+        pktmem_get_stats(pm, &stats);
+        printf("%u packets in flight, region of %"PRIu64" buffers backed by "
+               "%s\n", n, stats.n_buffers,
+               stats.hugetlb ? "hugetlbfs" : "transparent hugepages");
+        pktmem_run(NULL, n, "malloc");
+        pktmem_run(pm, n, "pktmem");
+        pktmem_get_stats(pm, &stats);
+        if (stats.n_exhausted || stats.n_oversize) {
+            printf("  %"PRIu64" pktmem buffers malloc()'d\n",
+                   stats.n_exhausted + stats.n_oversize);
+        }
+        pktmem_destroy(pm);
+    }
+}
+
+#ifdef HAVE_OPENSSL
+#define SSL_DEFAULT_COUNT 100000
+#define SSL_DEFAULT_PORT "6699"
+
+/* Opens a connection to 'name' and accepts it on 'pvconn', driving both
+ * ends' TLS handshakes and OpenFlow hello exchanges in this one thread. */
+static void
+ssl_connect_pair(struct pvconn *pvconn, const char *name,
+                 struct vconn **clientp, struct vconn **serverp)
+{
+    struct vconn *client, *server;
+    int client_error, server_error;
+    int error;
+
+    error = vconn_open(name, OFP_VERSION, &client);
+    if (error) {
+        ofp_fatal(error, "%s: connection failed", name);
+    }
+    server = NULL;
+    client_error = server_error = EAGAIN;
+    for (;;) {
+        if (!server) {
+            error = pvconn_accept(pvconn, OFP_VERSION, &server);
+            if (error && error != EAGAIN) {
+                ofp_fatal(error, "%s: accept failed", name);
+            }
+        }
+        if (client_error == EAGAIN) {
+            client_error = vconn_connect(client);
+        }
+        if (server && server_error == EAGAIN) {
+            server_error = vconn_connect(server);
+        }
+        if (client_error && client_error != EAGAIN) {
+            ofp_fatal(client_error, "%s: connection failed", name);
+        } else if (server_error && server_error != EAGAIN) {
+            ofp_fatal(server_error, "%s: accepted connection failed", name);
+        } else if (server && !client_error && !server_error) {
+            break;
+        }
+
+        if (!server) {
+            pvconn_wait(pvconn);
+        }
+        if (client_error == EAGAIN) {
+            vconn_connect_wait(client);
+        }
+        if (server && server_error == EAGAIN) {
+            vconn_connect_wait(server);
+        }
+        poll_block();
+    }
+    *clientp = client;
+    *serverp = server;
+}
+
+static void
+ssl_handshakes(struct pvconn *pvconn, const char *name, unsigned int n,
+               bool resume, const char *what)
+{
+    long long int start;
+    unsigned int i;
+
+    vconn_ssl_forget_sessions();
+    start = time_usec();
+    for (i = 0; i < n; i++) {
+        struct vconn *client, *server;
+
+        if (!resume) {
+            vconn_ssl_forget_sessions();
+        }
+        ssl_connect_pair(pvconn, name, &client, &server);
+        vconn_close(client);
+        vconn_close(server);
+    }
+    print_decode_rate(what, n, time_usec() - start);
+}
+
+static struct ofpbuf *
+ssl_echo_request(uint32_t xid)
+{
+    struct ofpbuf *msg = ofpbuf_new(frame_size);
+    struct ofp_header *oh = ofpbuf_put_zeros(msg, frame_size);
+
+    oh->version = OFP_VERSION;
+    oh->type = OFPT_ECHO_REQUEST;
+    oh->length = htons(frame_size);
+    oh->xid = htonl(xid);
+    return msg;
+}
+
+/* Sends 'count' echo requests from 'client' to 'server', as fast as the
+ * connection takes them, with messages coalesced up to 'coalesce' bytes. */
+static void
+ssl_throughput(struct vconn *client, struct vconn *server, size_t coalesce,
+               const char *what)
+{
+    unsigned int n_sent, n_received;
+    long long int start, usecs;
+
+    vconn_ssl_set_tx_coalesce(coalesce);
+    n_sent = n_received = 0;
+    start = time_usec();
+    while (n_received < count) {
+        int error;
+
+        while (n_sent < count) {
+            struct ofpbuf *msg = ssl_echo_request(n_sent);
+
+            error = vconn_send(client, msg);
+            if (error == EAGAIN) {
+                ofpbuf_delete(msg);
+                break;
+            } else if (error) {
+                ofp_fatal(error, "send failed");
+            }
+            n_sent++;
+        }
+        for (;;) {
+            struct ofpbuf *msg;
+
+            error = vconn_recv(server, &msg);
+            if (error == EAGAIN) {
+                break;
+            } else if (error) {
+                ofp_fatal(error, "receive failed");
+            }
+            ofpbuf_delete(msg);
+            n_received++;
+        }
+        if (n_received >= count) {
+            break;
+        }
+
+        if (n_sent < count) {
+            vconn_send_wait(client);
+        }
+        vconn_recv_wait(server);
+        poll_block();
+    }
+    usecs = time_usec() - start;
+    print_decode_rate(what, count, usecs);
+    printf("  %-24s %10.1f MB/s\n", "",
+           usecs ? (double) count * frame_size / usecs : 0.0);
+}
+
+/* Measures, without a switch, the connection setups and message rate of
+ * the SSL vconn, with both ends of each connection in this process. */
+static void
+ssl_bench(const char *port)
+{
+    struct vconn *client, *server;
+    struct pvconn *pvconn;
+    unsigned int n_handshakes;
+    char *listen_name, *name;
+    int error;
+
+    if (!vconn_ssl_is_configured()) {
+        ofp_fatal(0, "ssl needs --private-key, --certificate and --ca-cert");
+    }
+    if (!count) {
+        count = SSL_DEFAULT_COUNT;
+    }
+    n_handshakes = MAX(count / 100, 1);
+
+    listen_name = xasprintf("pssl:%s", port);
+    name = xasprintf("ssl:127.0.0.1:%s", port);
+    error = pvconn_open(listen_name, &pvconn);
+    if (error) {
+        ofp_fatal(error, "%s: listen failed", listen_name);
+    }
+
+    printf("ssl: %u connections, %u messages of %u bytes\n", n_handshakes,
+           count, frame_size);
+    ssl_handshakes(pvconn, name, n_handshakes, false, "full handshake");
+    ssl_handshakes(pvconn, name, n_handshakes, true, "resumed handshake");
+
+    ssl_connect_pair(pvconn, name, &client, &server);
+    ssl_throughput(client, server, VCONN_SSL_TX_COALESCE, "coalesced");
+    ssl_throughput(client, server, 0, "one record per message");
+    vconn_ssl_set_tx_coalesce(VCONN_SSL_TX_COALESCE);
+    vconn_close(client);
+    vconn_close(server);
+
+    pvconn_close(pvconn);
+    free(listen_name);
+    free(name);
+}
+#endif /* HAVE_OPENSSL */
+
+static const struct test all_tests[] = {
+    { "flow-mod", 100000, true, NULL, flow_mod_start, flow_mod_recv,
+      flow_mod_report },
+    { "packet-in", 10000, false, packet_in_setup, packet_in_start,
+      packet_in_recv, packet_in_report },
+    { "packet-in-hold", 1000, false, packet_in_hold_setup,
+      packet_in_hold_start, packet_in_hold_recv, packet_in_hold_report },
+    { "packet-out", 100000, true, packet_out_setup, packet_out_start,
+      flow_mod_recv, packet_out_report },
+    { "stats", 100, false, stats_setup, stats_start, stats_recv,
+      stats_report },
+    { "echo", 10000, false, NULL, echo_start, echo_recv, echo_report },
+    { "port-status", 100, false, port_status_setup, port_status_start,
+      port_status_recv, port_status_report },
+};
+
+
+/* The xids of the test's messages are their sequence numbers; echo probes
+ * use xids from this value upward, which no test reaches. */
+#define ECHO_PROBE_XID 0xec000000
+
+static void
+session_handle(struct session *s, struct ofpbuf *msg)
+{
+    struct ofp_header *oh = msg->data;
+
+    switch (oh->type) {
+    case OFPT_ECHO_REQUEST:
+        rconn_send(s->rconn, make_echo_reply(oh), &s->n_txq);
+        break;
+
+    case OFPT_ECHO_REPLY:
+        if (ntohs(oh->length) == sizeof *oh + sizeof(long long int)) {
+            long long int sent;
+
+            memcpy(&sent, oh + 1, sizeof sent);
+            samples_add(&echo_latency, time_usec() - sent);
+            if (test->start == echo_start && ntohl(oh->xid) < ECHO_PROBE_XID) {
+                s->n_done++;
+            }
+        }
+        break;
+
+    case OFPT_ERROR:
+        n_errors++;
+        if (msg->size >= sizeof(struct ofp_error_msg)) {
+            struct ofp_error_msg *em = msg->data;
+            VLOG_DBG(LOG_MODULE, "session %u: error type %"PRIu16" code "
+                     "%"PRIu16" (xid=%"PRIu32")", s->id, ntohs(em->type),
+                     ntohs(em->code), ntohl(oh->xid));
+        }
+        break;
+
+    default:
+        test->recv(s, msg);
+        break;
+    }
+}
+
+static bool
+session_done(const struct session *s)
+{
+    return s->n_done >= n_ops;
+}
+
+static void
+session_run(struct session *s)
+{
+    int i;
+
+    rconn_run(s->rconn);
+    if (!rconn_is_connected(s->rconn)) {
+        if (s->connected) {
+            ofp_fatal(0, "session %u: connection to %s lost", s->id,
+                      rconn_get_name(s->rconn));
+        }
+        return;
+    }
+    s->connected = true;
+
+    for (i = 0; i < 50; i++) {
+        struct ofpbuf *msg = rconn_recv(s->rconn);
+        if (!msg) {
+            break;
+        }
+        session_handle(s, msg);
+        ofpbuf_delete(msg);
+    }
+
+    while (s->n_txq < SESSION_TXQ_LIMIT && s->n_started < n_ops
+           && s->n_started - s->n_done < window) {
+        test->start(s);
+    }
+
+    if (echo_interval && !session_done(s) && time_msec() >= s->next_echo) {
+        session_send_echo(s, ECHO_PROBE_XID);
+        s->next_echo = time_msec() + echo_interval;
+    }
+}
+
+static void
+session_wait(struct session *s)
+{
+    rconn_run_wait(s->rconn);
+    rconn_recv_wait(s->rconn);
+    if (echo_interval && s->connected && !session_done(s)) {
+        poll_timer_wait(MAX(0, s->next_echo - time_msec()));
+    }
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct session *sessions;
+    struct vconn *vconn;
+    long long int start;
+    double elapsed;
+    unsigned int i;
+    int error;
+
+    set_program_name(argv[0]);
+    time_init();
+    vlog_init();
+    /* Keep the sessions' connection messages out of the report. */
+    vlog_set_levels(VLM_rconn, VLF_CONSOLE, VLL_WARN);
+    parse_options(argc, argv);
+    signal(SIGPIPE, SIG_IGN);
+
+    argc -= optind;
+    argv += optind;
+    if (argc == 1 && !strcmp(argv[0], "decode")) {
+        decode_bench();
+        return EXIT_SUCCESS;
+    }
+    if (argc == 1 && !strcmp(argv[0], "queue")) {
+        queue_bench();
+        return EXIT_SUCCESS;
+    }
+    if (argc == 1 && !strcmp(argv[0], "pktmem")) {
+        pktmem_bench();
+        return EXIT_SUCCESS;
+    }
+#ifdef HAVE_OPENSSL
+    if ((argc == 1 || argc == 2) && !strcmp(argv[0], "ssl")) {
+        ssl_bench(argc == 2 ? argv[1] : SSL_DEFAULT_PORT);
+        return EXIT_SUCCESS;
+    }
+#endif
+    if (argc != 2) {
+        ofp_fatal(0, "need exactly two non-option arguments; "
+                  "use --help for usage");
+    }
+    for (i = 0; i < ARRAY_SIZE(all_tests); i++) {
+        if (!strcmp(all_tests[i].name, argv[1])) {
+            test = &all_tests[i];
+        }
+    }
+    if (!test) {
+        ofp_fatal(0, "unknown test '%s'; use --help for help", argv[1]);
+    }
+    if (!count) {
+        count = test->default_count;
+    }
+    n_ops = test->batched ? (count + batch - 1) / batch : count;
+
+    error = vconn_open_block(argv[0], OFP_VERSION, &vconn);
+    if (error) {
+        ofp_fatal(error, "%s: connection failed", argv[0]);
+    }
+    remove_bench_flows(vconn);
+    if (test->setup) {
+        test->setup(vconn);
+    }
+
+    sessions = xcalloc(n_sessions, sizeof *sessions);
+    for (i = 0; i < n_sessions; i++) {
+        struct session *s = &sessions[i];
+
+        s->id = i;
+        s->rconn = rconn_create(0, 1);
+        s->pending = xcalloc(window, sizeof *s->pending);
+        error = rconn_connect(s->rconn, argv[0]);
+        if (error) {
+            ofp_fatal(error, "%s: connection failed", argv[0]);
+        }
+    }
+
+    /* The clock starts once every session is connected. */
+    start = 0;
+    for (;;) {
+        bool done = true;
+
+        for (i = 0; i < n_sessions; i++) {
+            struct session *s = &sessions[i];
+
+            if (!start) {
+                rconn_run(s->rconn);
+                if (!rconn_is_connected(s->rconn)) {
+                    done = false;
+                }
+                continue;
+            }
+            session_run(s);
+            if (!session_done(s)) {
+                done = false;
+            }
+        }
+        if (!start) {
+            if (done) {
+                start = time_usec();
+                continue;
+            }
+        } else if (done) {
+            break;
+        }
+
+        for (i = 0; i < n_sessions; i++) {
+            session_wait(&sessions[i]);
+        }
+        poll_block();
+    }
+    elapsed = (time_usec() - start) / 1e6;
+
+    printf("%s: %u session%s, %u operations each\n", test->name, n_sessions,
+           n_sessions == 1 ? "" : "s", count);
+    test->report(elapsed);
+    samples_print(&echo_latency, "echo", "us");
+    if (n_errors) {
+        printf("%u errors\n", n_errors);
+    }
+
+    for (i = 0; i < n_sessions; i++) {
+        rconn_destroy(sessions[i].rconn);
+        free(sessions[i].pending);
+    }
+    free(sessions);
+
+    remove_bench_flows(vconn);
+    vconn_close(vconn);
+    return n_errors || n_failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+static unsigned int
+parse_uint(const char *name, const char *arg, unsigned int min)
+{
+    char *tail;
+    unsigned long int value;
+
+    errno = 0;
+    value = strtoul(arg, &tail, 10);
+    if (errno || *tail != '\0' || value < min || value > UINT_MAX / 2) {
+        ofp_fatal(0, "%s: invalid value \"%s\"", name, arg);
+    }
+    return value;
+}
+
+static void
+parse_options(int argc, char *argv[])
+{
+    enum {
+        OPT_FLOWS = UCHAR_MAX + 1,
+        OPT_STATS,
+        OPT_ECHO_INTERVAL,
+        OPT_SIZE,
+        OPT_OUT_PORT,
+        OPT_PUSH_VLAN,
+        OPT_PACKET_OUT_BATCH,
+        OPT_FIELDS,
+        OPT_NETDEV
+    };
+    static struct option long_options[] = {
+        {"count", required_argument, 0, 'n'},
+        {"sessions", required_argument, 0, 's'},
+        {"batch", required_argument, 0, 'b'},
+        {"window", required_argument, 0, 'w'},
+        {"flows", required_argument, 0, OPT_FLOWS},
+        {"stats", required_argument, 0, OPT_STATS},
+        {"echo-interval", required_argument, 0, OPT_ECHO_INTERVAL},
+        {"size", required_argument, 0, OPT_SIZE},
+        {"out-port", required_argument, 0, OPT_OUT_PORT},
+        {"push-vlan", no_argument, 0, OPT_PUSH_VLAN},
+        {"packet-out-batch", no_argument, 0, OPT_PACKET_OUT_BATCH},
+        {"fields", required_argument, 0, OPT_FIELDS},
+        {"netdev", required_argument, 0, OPT_NETDEV},
+        {"timeout", required_argument, 0, 't'},
+        {"verbose", optional_argument, 0, 'v'},
+        {"help", no_argument, 0, 'h'},
+        {"version", no_argument, 0, 'V'},
+        VCONN_SSL_LONG_OPTIONS
+        {0, 0, 0, 0},
+    };
+    char *short_options = long_options_to_short_options(long_options);
+
+    for (;;) {
+        int c;
+
+        c = getopt_long(argc, argv, short_options, long_options, NULL);
+        if (c == -1) {
+            break;
+        }
+
+        switch (c) {
+        case 'n':
+            count = parse_uint("--count", optarg, 1);
+            break;
+
+        case 's':
+            n_sessions = parse_uint("--sessions", optarg, 1);
+            break;
+
+        case 'b':
+            batch = parse_uint("--batch", optarg, 1);
+            break;
+
+        case 'w':
+            window = parse_uint("--window", optarg, 1);
+            break;
+
+        case OPT_FLOWS:
+            n_flows = parse_uint("--flows", optarg, 0);
+            break;
+
+        case OPT_STATS:
+            if (!strcmp(optarg, "flow")) {
+                stats_type = OFPMP_FLOW;
+            } else if (!strcmp(optarg, "aggregate")) {
+                stats_type = OFPMP_AGGREGATE;
+            } else if (!strcmp(optarg, "table")) {
+                stats_type = OFPMP_TABLE;
+            } else if (!strcmp(optarg, "port")) {
+                stats_type = OFPMP_PORT_STATS;
+            } else if (!strcmp(optarg, "port-desc")) {
+                stats_type = OFPMP_PORT_DESC;
+            } else {
+                ofp_fatal(0, "unknown statistics \"%s\" on --stats", optarg);
+            }
+            break;
+
+        case OPT_ECHO_INTERVAL:
+            echo_interval = parse_uint("--echo-interval", optarg, 1);
+            break;
+
+        case OPT_SIZE:
+            frame_size = parse_uint("--size", optarg, ETH_TOTAL_MIN);
+            if (frame_size > UINT16_MAX - 128) {
+                ofp_fatal(0, "--size: frames of at most %d bytes fit in a "
+                          "packet_out", UINT16_MAX - 128);
+            }
+            break;
+
+        case OPT_OUT_PORT:
+            if (!strcmp(optarg, "flood")) {
+                out_port = OFPP_FLOOD;
+            } else if (!strcmp(optarg, "all")) {
+                out_port = OFPP_ALL;
+            } else {
+                out_port = parse_uint("--out-port", optarg, 1);
+            }
+            break;
+
+        case OPT_PUSH_VLAN:
+            push_vlan = true;
+            break;
+
+        case OPT_PACKET_OUT_BATCH:
+            packet_out_batch = true;
+            break;
+
+        case OPT_FIELDS:
+            n_fields = parse_uint("--fields", optarg, 1);
+            if (n_fields != 3 && n_fields != 8 && n_fields != 15) {
+                ofp_fatal(0, "--fields: the decode test has matches of 3, "
+                          "8 or 15 fields");
+            }
+            break;
+
+        case OPT_NETDEV:
+            toggle_name = optarg;
+            break;
+
+        case 't':
+            time_alarm(parse_uint("--timeout", optarg, 1));
+            break;
+
+        case 'h':
+            usage();
+
+        case 'V':
+            printf("%s %s compiled "__DATE__" "__TIME__"\n",
+                   program_name, VERSION BUILDNR);
+            exit(EXIT_SUCCESS);
+
+        case 'v':
+            vlog_set_verbosity(optarg);
+            break;
+
+        VCONN_SSL_OPTION_HANDLERS
+
+        case '?':
+            exit(EXIT_FAILURE);
+
+        default:
+            abort();
+        }
+    }
+    free(short_options);
+}
+
+static void
+usage(void)
+{
+    printf("%s: OpenFlow switch benchmark\n"
+           "usage: %s [OPTIONS] SWITCH TEST\n"
+           "   or: %s [OPTIONS] decode|queue|pktmem\n"
+           "   or: %s [OPTIONS] ssl [PORT]\n"
+           "where TEST is one of:\n"
+           "  flow-mod    flow_mod install rate, confirmed by barriers\n"
+           "  packet-in   packet-in to flow_mod round-trip latency\n"
+           "  packet-in-hold  release of the packets held during a flow\n"
+           "              setup, through two tables\n"
+           "  packet-out  packet_out rate, confirmed by barriers\n"
+           "  stats       multipart statistics dump rate\n"
+           "  echo        echo request latency\n"
+           "  port-status link down and up to port_status latency\n"
+           "decode measures the flow_mod decode rate of OFLib and queue the\n"
+           "packet queue between the hardware driver and the datapath, both\n"
+           "without a switch.  pktmem compares packet buffers from the heap\n"
+           "and from hugepage-backed packet memory, with dTLB misses.  ssl measures SSL connection setups and message\n"
+           "rates over connections to itself on PORT (default: 6699).\n",
+           program_name, program_name, program_name, program_name);
+    vconn_usage(true, false, false);
+    vlog_usage();
+    printf("\nOptions:\n"
+           "  -n, --count=N               operations per session\n"
+           "  -s, --sessions=N            run N concurrent sessions (default: 1)\n"
+           "  -b, --batch=N               flow_mods or packet_outs per barrier\n"
+           "                              (default: 100)\n"
+           "  -w, --window=N              operations in flight per session\n"
+           "                              (default: 1)\n"
+           "  --flows=N                   flows to add for stats (default: 1000)\n"
+           "  --stats=flow|aggregate|table|port|port-desc\n"
+           "                              statistics dumped by stats\n"
+           "  --netdev=DEVICE             device port-status toggles the link of\n"
+           "  --echo-interval=MS          also send an echo request every MS ms\n"
+           "  --size=BYTES                packet-out frame, queue and pktmem\n"
+           "                              packet and ssl message size\n"
+           "                              (default: 64)\n"
+           "  --out-port=PORT|flood|all   port packet-out sends to (default:\n"
+           "                              none, the packets are dropped)\n"
+           "  --push-vlan                 push a VLAN tag before packet-out's\n"
+           "                              output\n"
+           "  --packet-out-batch          send packet-out's batches as batch\n"
+           "                              messages (extension)\n"
+           "  --fields=3|8|15             match fields of decode (default:\n"
+           "                              each)\n"
+           "  -t, --timeout=SECS          give up after SECS seconds\n"
+           "  -h, --help                  display this help message\n"
+           "  -V, --version               display version information\n");
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,836 @@
+/* Copyright (c) 2008 The Board of Trustees of The Leland Stanford
+ * Junior University
+ *
+ * We are making the OpenFlow specification and associated documentation
+ * (Software) available for public use and benefit with the expectation
+ * that others will use, modify and enhance the Software and contribute
+ * those enhancements back to the community. However, since we would
+ * like to make the Software available for broadest use, with as few
+ * restrictions as possible permission is hereby granted, free of
+ * charge, to any person obtaining a copy of this Software to deal in
+ * the Software under the copyrights without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * The name and trademarks of copyright holder(s) may NOT be used in
+ * advertising or publicity pertaining to the Software or any
+ * derivatives without specific, written prior permission.
+ */
+
+#include <config.h>
+#include <errno.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <netinet/in.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "command-line.h"
+#include "compiler.h"
+#include "csum.h"
+#include "netdev.h"
+#include "ofpbuf.h"
+#include "packets.h"
+#include "poll-loop.h"
+#include "random.h"
+#include "samples.h"
+#include "timeval.h"
+#include "util.h"
+
+#include "vlog.h"
+#define LOG_MODULE VLM_ofp_pktgen
+
+/* Every generated frame ends with this trailer, where the receiver finds it
+ * whatever headers the datapath pushed, popped or rewrote on the way. */
+struct pktgen_trailer {
+    uint32_t run;               /* Random, identifies the frames of a run. */
+    uint32_t seq;               /* Sequence number, from 0. */
+    long long int sent;         /* time_usec() when the frame was built. */
+};
+
+/* Most frames sent in one run, so that sequence numbers never wrap. */
+#define PKTGEN_MAX_COUNT UINT32_MAX
+
+/* UDP or TCP destination port of the generated frames (discard). */
+#define PKTGEN_PORT 9
+
+/* Frames handed to the device, or read from it, in one go. */
+#define PKTGEN_BURST 32
+
+/* Most frames sent back to back with --burst. */
+#define PKTGEN_MAX_BURST 1024
+
+/* IPv6 extension headers, in the order given by --ipv6-ext. */
+enum ipv6_ext {
+    EXT_HOP,                    /* Hop-by-hop options, one PadN. */
+    EXT_DST,                    /* Destination options, one PadN. */
+    EXT_ROUTING,                /* Routing header with no segments left. */
+    EXT_FRAGMENT                /* Atomic fragment. */
+};
+#define MAX_IPV6_EXTS 8
+
+#define MAX_TAGS 8
+
+/* -r, --rate: frames per second, 0 for as fast as possible. */
+static unsigned long long int rate;
+
+/* -n, --count: frames to send, unless --duration is given. */
+static unsigned long long int count = 100000;
+
+/* -d, --duration: seconds to send for, 0 to send --count frames. */
+static unsigned int duration;
+
+/* -s, --size: range of frame sizes, without the FCS, or 0 for the smallest
+ * frame of at least ETH_TOTAL_MIN bytes that fits the headers. */
+static size_t min_size, max_size;
+
+/* --burst: frames sent back to back. */
+static size_t burst = PKTGEN_BURST;
+
+/* --flows: number of distinct 5-tuples. */
+static unsigned int n_flows = 1;
+
+/* --tcp: TCP instead of UDP. */
+static bool tcp;
+
+/* --ipv6, --ipv6-ext: IPv6 instead of IPv4, with these extension headers. */
+static bool ipv6;
+static enum ipv6_ext ipv6_exts[MAX_IPV6_EXTS];
+static size_t n_ipv6_exts;
+
+/* --vlan, --mpls: 802.1Q tags and MPLS labels, outermost first. */
+static uint16_t vlans[MAX_TAGS];
+static size_t n_vlans;
+static uint32_t mpls_labels[MAX_TAGS];
+static size_t n_mpls_labels;
+
+/* --wait: milliseconds to keep receiving after the last frame was sent. */
+static unsigned int wait_ms = 500;
+
+/* --pid: process, typically the datapath, whose CPU time per frame received
+ * is reported, or 0. */
+static pid_t cpu_pid;
+
+static uint8_t src_mac[ETH_ADDR_LEN];
+static uint8_t dst_mac[ETH_ADDR_LEN];
+static uint32_t run_id;
+
+/* Receive side statistics. */
+struct rx_stats {
+    unsigned long long int packets; /* Distinct frames of this run. */
+    unsigned long long int bytes;
+    unsigned long long int duplicates;
+    unsigned long long int reordered; /* Arrived after a later frame. */
+    uint32_t max_seq;
+    long long int first, last;  /* time_usec() of the first and last frame. */
+    uint8_t *seen;              /* Bitmap of the sequence numbers received. */
+    size_t seen_size;           /* Bytes in 'seen'. */
+    struct samples latency;     /* One-way latencies, in microseconds. */
+};
+
+static void parse_options(int argc, char *argv[]);
+static void usage(void) NO_RETURN;
+
+/* Returns the number of bytes of headers that precede the L4 payload. */
+static size_t
+headers_len(void)
+{
+    return (ETH_HEADER_LEN + n_vlans * VLAN_HEADER_LEN
+            + n_mpls_labels * MPLS_HEADER_LEN
+            + (ipv6 ? IPV6_HEADER_LEN + n_ipv6_exts * 8 : IP_HEADER_LEN)
+            + (tcp ? TCP_HEADER_LEN : UDP_HEADER_LEN));
+}
+
+static uint8_t
+ipv6_ext_type(enum ipv6_ext ext)
+{
+    switch (ext) {
+    case EXT_HOP:
+        return IPV6_TYPE_HBH;
+    case EXT_DST:
+        return IPV6_TYPE_DOH;
+    case EXT_ROUTING:
+        return IPV6_TYPE_RH;
+    case EXT_FRAGMENT:
+        return IPV6_TYPE_FH;
+    }
+    NOT_REACHED();
+}
+
+/* Builds frame 'seq', 'size' bytes long, in 'b', which must have room for
+ * it. */
+static void
+build_frame(struct ofpbuf *b, uint32_t seq, size_t size)
+{
+    unsigned int flow = seq % n_flows;
+    uint8_t l4_proto = tcp ? IP_TYPE_TCP : IP_TYPE_UDP;
+    struct pktgen_trailer trailer;
+    struct eth_header *eth;
+    uint16_t eth_type;
+    size_t l4_ofs, l4_len;
+    uint32_t partial, flow_be;
+    size_t i;
+
+    ofpbuf_clear(b);
+    eth_type = (n_mpls_labels ? ETH_TYPE_MPLS
+                : ipv6 ? ETH_TYPE_IPV6 : ETH_TYPE_IP);
+    eth = ofpbuf_put_uninit(b, ETH_HEADER_LEN);
+    memcpy(eth->eth_dst, dst_mac, ETH_ADDR_LEN);
+    memcpy(eth->eth_src, src_mac, ETH_ADDR_LEN);
+    eth->eth_type = htons(n_vlans ? ETH_TYPE_VLAN : eth_type);
+    for (i = 0; i < n_vlans; i++) {
+        struct vlan_header *vh = ofpbuf_put_uninit(b, VLAN_HEADER_LEN);
+
+        vh->vlan_tci = htons(vlans[i]);
+        vh->vlan_next_type = htons(i + 1 < n_vlans ? ETH_TYPE_VLAN
+                                   : eth_type);
+    }
+    for (i = 0; i < n_mpls_labels; i++) {
+        struct mpls_header *mh = ofpbuf_put_uninit(b, MPLS_HEADER_LEN);
+
+        mh->fields = htonl((mpls_labels[i] << MPLS_LABEL_SHIFT)
+                           | (i + 1 == n_mpls_labels ? MPLS_S_MASK : 0)
+                           | 64);
+    }
+
+    l4_len = size - (headers_len() - (tcp ? TCP_HEADER_LEN : UDP_HEADER_LEN));
+    if (ipv6) {
+        struct ipv6_header *ip6 = ofpbuf_put_zeros(b, IPV6_HEADER_LEN);
+
+        ip6->ipv6_ver_tc_fl = htonl(0x60000000);
+        ip6->ipv6_pay_len = htons(n_ipv6_exts * 8 + l4_len);
+        ip6->ipv6_next_hd = n_ipv6_exts ? ipv6_ext_type(ipv6_exts[0])
+                                        : l4_proto;
+        ip6->ipv6_hop_limit = 64;
+        flow_be = htonl(1 + flow);
+        ip6->ipv6_src.s6_addr[0] = 0xfd;
+        memcpy(&ip6->ipv6_src.s6_addr[12], &flow_be, sizeof flow_be);
+        ip6->ipv6_dst.s6_addr[0] = 0xfd;
+        ip6->ipv6_dst.s6_addr[1] = 0x01;
+        ip6->ipv6_dst.s6_addr[15] = 1;
+        partial = csum_continue(0, &ip6->ipv6_src, sizeof ip6->ipv6_src);
+        partial = csum_continue(partial, &ip6->ipv6_dst,
+                                sizeof ip6->ipv6_dst);
+
+        for (i = 0; i < n_ipv6_exts; i++) {
+            uint8_t *ext = ofpbuf_put_zeros(b, 8);
+
+            ext[0] = (i + 1 < n_ipv6_exts ? ipv6_ext_type(ipv6_exts[i + 1])
+                      : l4_proto);
+            switch (ipv6_exts[i]) {
+            case EXT_HOP:
+            case EXT_DST:
+                ext[2] = 1;     /* PadN option... */
+                ext[3] = 4;     /* ...with 4 bytes of padding. */
+                break;
+            case EXT_ROUTING:
+                ext[2] = 253;   /* Experimental routing type (RFC 4727). */
+                break;
+            case EXT_FRAGMENT: {
+                uint32_t id = htonl(seq);
+                memcpy(&ext[4], &id, sizeof id);
+                break;
+            }
+            }
+        }
+    } else {
+        struct ip_header *ip = ofpbuf_put_zeros(b, IP_HEADER_LEN);
+
+        ip->ip_ihl_ver = IP_IHL_VER(5, IP_VERSION);
+        ip->ip_tot_len = htons(IP_HEADER_LEN + l4_len);
+        ip->ip_id = htons(seq);
+        ip->ip_frag_off = htons(IP_DONT_FRAGMENT);
+        ip->ip_ttl = 64;
+        ip->ip_proto = l4_proto;
+        ip->ip_src = htonl(0x0a000001 + flow);
+        ip->ip_dst = htonl(0x0a010001);
+        ip->ip_csum = csum(ip, IP_HEADER_LEN);
+        partial = csum_add32(0, ip->ip_src);
+        partial = csum_add32(partial, ip->ip_dst);
+    }
+
+    l4_ofs = b->size;
+    if (tcp) {
+        struct tcp_header *th = ofpbuf_put_zeros(b, TCP_HEADER_LEN);
+
+        th->tcp_src = htons(1024 + flow % 64512);
+        th->tcp_dst = htons(PKTGEN_PORT);
+        th->tcp_seq = htonl(seq);
+        th->tcp_ctl = htons((5 << 12) | TCP_ACK);
+        th->tcp_winsz = htons(65535);
+    } else {
+        struct udp_header *uh = ofpbuf_put_zeros(b, UDP_HEADER_LEN);
+
+        uh->udp_src = htons(1024 + flow % 64512);
+        uh->udp_dst = htons(PKTGEN_PORT);
+        uh->udp_len = htons(l4_len);
+    }
+
+    ofpbuf_put_zeros(b, size - b->size - sizeof trailer);
+    trailer.run = run_id;
+    trailer.seq = seq;
+    trailer.sent = time_usec();
+    ofpbuf_put(b, &trailer, sizeof trailer);
+
+    partial = csum_add16(partial, htons(l4_proto));
+    partial = csum_add16(partial, htons(l4_len));
+    partial = csum_continue(partial, (uint8_t *) b->data + l4_ofs, l4_len);
+    if (tcp) {
+        struct tcp_header *th = (struct tcp_header *)
+                                    ((uint8_t *) b->data + l4_ofs);
+        th->tcp_csum = csum_finish(partial);
+    } else {
+        struct udp_header *uh = (struct udp_header *)
+                                    ((uint8_t *) b->data + l4_ofs);
+        uh->udp_csum = csum_finish(partial);
+        if (!uh->udp_csum) {
+            uh->udp_csum = htons(0xffff);
+        }
+    }
+}
+
+/* Accounts for frame 'b', received at 'now', if it belongs to this run. */
+static void
+rx_frame(struct rx_stats *rx, const struct ofpbuf *b, long long int now)
+{
+    struct pktgen_trailer trailer;
+    uint32_t seq;
+
+    if (b->size < ETH_HEADER_LEN + sizeof trailer) {
+        return;
+    }
+    memcpy(&trailer, (uint8_t *) b->data + b->size - sizeof trailer,
+           sizeof trailer);
+    if (trailer.run != run_id) {
+        return;
+    }
+
+    seq = trailer.seq;
+    if (seq / 8 >= rx->seen_size) {
+        size_t old_size = rx->seen_size;
+
+        rx->seen_size = MAX(rx->seen_size * 2, seq / 8 + 1);
+        rx->seen = xrealloc(rx->seen, rx->seen_size);
+        memset(rx->seen + old_size, 0, rx->seen_size - old_size);
+    }
+    if (rx->seen[seq / 8] & (1u << (seq % 8))) {
+        rx->duplicates++;
+        return;
+    }
+    rx->seen[seq / 8] |= 1u << (seq % 8);
+
+    if (!rx->packets) {
+        rx->first = now;
+    } else if (seq < rx->max_seq) {
+        rx->reordered++;
+    }
+    rx->max_seq = MAX(rx->max_seq, seq);
+    rx->last = now;
+    rx->packets++;
+    rx->bytes += b->size;
+    samples_add(&rx->latency, now - trailer.sent);
+}
+
+static void
+print_rate(const char *what, unsigned long long int packets,
+           unsigned long long int bytes, long long int usecs)
+{
+    double secs = usecs / 1e6;
+
+    printf("%s: %llu packets, %llu bytes in %.3f s", what, packets, bytes,
+           secs);
+    if (secs > 0) {
+        printf(": %.0f pps, %.1f Mbit/s", packets / secs,
+               bytes * 8 / secs / 1e6);
+    }
+    putchar('\n');
+}
+
+/* Returns the CPU time, user and system, that process 'pid' has used, in
+ * microseconds. */
+static long long int
+process_cpu_usec(pid_t pid)
+{
+    unsigned long long int utime, stime;
+    char file_name[64];
+    char line[1024];
+    FILE *stream;
+    char *p;
+
+    sprintf(file_name, "/proc/%ld/stat", (long int) pid);
+    stream = fopen(file_name, "r");
+    if (!stream) {
+        ofp_fatal(errno, "%s: open failed", file_name);
+    }
+    if (!fgets(line, sizeof line, stream)) {
+        ofp_fatal(0, "%s: read failed", file_name);
+    }
+    fclose(stream);
+
+    /* The command name, in parentheses, may contain spaces, so the fields
+     * are counted from the last parenthesis. */
+    p = strrchr(line, ')');
+    if (!p || sscanf(p + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u "
+                     "%llu %llu", &utime, &stime) != 2) {
+        ofp_fatal(0, "%s: could not parse \"%s\"", file_name, line);
+    }
+    return (utime + stime) * 1000000LL / sysconf(_SC_CLK_TCK);
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct ofpbuf *frames[PKTGEN_MAX_BURST];
+    unsigned long long int n_sent, n_tx, tx_bytes;
+    struct netdev *tx_netdev, *rx_netdev;
+    long long int start, stop, end;
+    long long int cpu_start;
+    struct rx_stats rx;
+    struct ofpbuf *rx_buf;
+    bool sending;
+    size_t i;
+    int error;
+
+    set_program_name(argv[0]);
+    time_init();
+    vlog_init();
+    random_init();
+    parse_options(argc, argv);
+
+    argc -= optind;
+    argv += optind;
+    if (argc != 2) {
+        ofp_fatal(0, "need exactly two non-option arguments; "
+                  "use --help for usage");
+    }
+    if (!min_size) {
+        min_size = max_size = MAX(ETH_TOTAL_MIN,
+                                  headers_len() + sizeof(struct pktgen_trailer));
+    } else if (headers_len() + sizeof(struct pktgen_trailer) > min_size) {
+        ofp_fatal(0, "frames of %zu bytes are too short for their headers; "
+                  "at least %zu bytes are needed", min_size,
+                  headers_len() + sizeof(struct pktgen_trailer));
+    }
+
+    error = netdev_open(argv[0], NETDEV_ETH_TYPE_ANY, &tx_netdev);
+    if (error) {
+        ofp_fatal(error, "%s: failed to open network device", argv[0]);
+    }
+    error = netdev_open(argv[1], NETDEV_ETH_TYPE_ANY, &rx_netdev);
+    if (error) {
+        ofp_fatal(error, "%s: failed to open network device", argv[1]);
+    }
+    netdev_turn_flags_on(rx_netdev, NETDEV_PROMISC, false);
+    if (max_size - ETH_HEADER_LEN - n_vlans * VLAN_HEADER_LEN
+        > netdev_get_mtu(tx_netdev)) {
+        ofp_fatal(0, "frames of %zu bytes exceed the MTU of %s (%d)",
+                  max_size, argv[0], netdev_get_mtu(tx_netdev));
+    }
+    memcpy(src_mac, netdev_get_etheraddr(tx_netdev), ETH_ADDR_LEN);
+    memcpy(dst_mac, netdev_get_etheraddr(rx_netdev), ETH_ADDR_LEN);
+    run_id = random_uint32();
+
+    for (i = 0; i < burst; i++) {
+        frames[i] = ofpbuf_new(max_size);
+    }
+    rx_buf = ofpbuf_new(VLAN_HEADER_LEN + VLAN_ETH_HEADER_LEN
+                        + netdev_get_mtu(rx_netdev));
+    memset(&rx, 0, sizeof rx);
+    samples_init(&rx.latency);
+    netdev_drain(rx_netdev);
+
+    n_sent = n_tx = tx_bytes = 0;
+    sending = true;
+    cpu_start = cpu_pid ? process_cpu_usec(cpu_pid) : 0;
+    start = time_usec();
+    stop = end = LLONG_MAX;
+    for (;;) {
+        long long int now = time_usec();
+        unsigned long long int due = 0;
+        int n_rx;
+
+        if (sending) {
+            due = duration ? PKTGEN_MAX_COUNT : count;
+            if (rate) {
+                /* A burst falls due as a whole. */
+                due = MIN(due, ((now - start) * rate / 1000000 / burst + 1)
+                               * burst);
+            }
+            if (n_sent < due) {
+                size_t n = MIN(due - n_sent, burst);
+                size_t n_bytes;
+
+                for (i = 0; i < n; i++) {
+                    size_t size = min_size;
+                    if (max_size > min_size) {
+                        size += random_range(max_size - min_size + 1);
+                    }
+                    build_frame(frames[i], n_sent + i, size);
+                }
+                n_tx += netdev_send_batch(tx_netdev, frames, n, 0, &n_bytes);
+                tx_bytes += n_bytes;
+                n_sent += n;
+            }
+            if ((duration && now - start >= duration * 1000000LL)
+                || n_sent >= (duration ? PKTGEN_MAX_COUNT : count)) {
+                sending = false;
+                stop = time_usec();
+                end = stop + wait_ms * 1000LL;
+            }
+        }
+
+        for (n_rx = 0; n_rx < PKTGEN_BURST; n_rx++) {
+            /* netdev_recv() needs headroom to reinsert a VLAN tag that the
+             * kernel took out of the frame. */
+            ofpbuf_clear(rx_buf);
+            ofpbuf_reserve(rx_buf, VLAN_HEADER_LEN);
+            if (netdev_recv(rx_netdev, rx_buf)) {
+                break;
+            }
+            rx_frame(&rx, rx_buf, time_usec());
+        }
+
+        if (!sending && (now >= end || rx.packets >= n_tx)) {
+            break;
+        }
+
+        netdev_recv_wait(rx_netdev);
+        if (n_rx == PKTGEN_BURST) {
+            poll_immediate_wake();
+        } else if (sending) {
+            if (!rate || n_sent < due) {
+                poll_immediate_wake();
+            } else {
+                /* Wait for the next frame to fall due. */
+                long long int next = start + n_sent * 1000000LL / rate;
+                poll_timer_wait(MAX(0, (next - now) / 1000));
+            }
+        } else {
+            poll_timer_wait(MAX(0, (end - now) / 1000));
+        }
+        poll_block();
+    }
+
+    print_rate("tx", n_tx, tx_bytes, stop - start);
+    if (n_tx < n_sent) {
+        printf("tx: %llu packets could not be sent\n", n_sent - n_tx);
+    }
+    print_rate("rx", rx.packets, rx.bytes, rx.last - rx.first);
+    printf("loss: %llu packets (%.3f%%), %llu reordered, %llu duplicates\n",
+           n_tx - MIN(n_tx, rx.packets),
+           n_tx ? 100.0 * (n_tx - MIN(n_tx, rx.packets)) / n_tx : 0.0,
+           rx.reordered, rx.duplicates);
+    samples_print(&rx.latency, "latency", "us");
+    if (cpu_pid) {
+        long long int cpu_usecs = process_cpu_usec(cpu_pid) - cpu_start;
+
+        printf("cpu: process %ld used %.3f s, %.0f ns per frame received\n",
+               (long int) cpu_pid, cpu_usecs / 1e6,
+               rx.packets ? cpu_usecs * 1e3 / rx.packets : 0.0);
+    }
+
+    samples_destroy(&rx.latency);
+    free(rx.seen);
+    ofpbuf_delete(rx_buf);
+    for (i = 0; i < burst; i++) {
+        ofpbuf_delete(frames[i]);
+    }
+    netdev_close(rx_netdev);
+    netdev_close(tx_netdev);
+    return EXIT_SUCCESS;
+}
+
+/* Parses 'arg', the argument of option 'name', as a number with an optional
+ * "k", "M" or "G" multiplier suffix. */
+static unsigned long long int
+parse_number(const char *name, const char *arg)
+{
+    unsigned long long int value;
+    char *tail;
+
+    errno = 0;
+    value = strtoull(arg, &tail, 10);
+    if (!errno && tail != arg) {
+        if (*tail == 'k') {
+            value *= 1000;
+            tail++;
+        } else if (*tail == 'M') {
+            value *= 1000000;
+            tail++;
+        } else if (*tail == 'G') {
+            value *= 1000000000;
+            tail++;
+        }
+        if (*tail == '\0') {
+            return value;
+        }
+    }
+    ofp_fatal(0, "%s: invalid value \"%s\"", name, arg);
+}
+
+static void
+parse_size(const char *arg)
+{
+    unsigned long int lo, hi;
+    char *tail;
+
+    lo = hi = strtoul(arg, &tail, 10);
+    if (*tail == '-') {
+        hi = strtoul(tail + 1, &tail, 10);
+    }
+    if (*tail != '\0' || lo < ETH_TOTAL_MIN || hi < lo || hi > 65535) {
+        ofp_fatal(0, "--size: \"%s\" is not a size or range of sizes between "
+                  "%d and 65535 bytes", arg, ETH_TOTAL_MIN);
+    }
+    min_size = lo;
+    max_size = hi;
+}
+
+/* Parses the comma-separated numbers in 'arg', the argument of option 'name',
+ * into 'values', which has room for MAX_TAGS, each at most 'max'. */
+static size_t
+parse_list(const char *name, const char *arg, uint32_t values[],
+           uint32_t max)
+{
+    char *copy = xstrdup(arg);
+    char *token, *save_ptr = NULL;
+    size_t n = 0;
+
+    for (token = strtok_r(copy, ",", &save_ptr); token;
+         token = strtok_r(NULL, ",", &save_ptr)) {
+        unsigned long int value;
+        char *tail;
+
+        value = strtoul(token, &tail, 10);
+        if (*tail != '\0' || value > max || n >= MAX_TAGS) {
+            ofp_fatal(0, "%s: invalid value \"%s\"", name, arg);
+        }
+        values[n++] = value;
+    }
+    free(copy);
+    return n;
+}
+
+static void
+parse_ipv6_exts(const char *arg)
+{
+    char *copy = xstrdup(arg);
+    char *token, *save_ptr = NULL;
+
+    n_ipv6_exts = 0;
+    for (token = strtok_r(copy, ",", &save_ptr); token;
+         token = strtok_r(NULL, ",", &save_ptr)) {
+        enum ipv6_ext ext;
+
+        if (!strcmp(token, "hop")) {
+            ext = EXT_HOP;
+        } else if (!strcmp(token, "dst")) {
+            ext = EXT_DST;
+        } else if (!strcmp(token, "rt")) {
+            ext = EXT_ROUTING;
+        } else if (!strcmp(token, "frag")) {
+            ext = EXT_FRAGMENT;
+        } else {
+            ofp_fatal(0, "--ipv6-ext: unknown extension header \"%s\"",
+                      token);
+        }
+        if (n_ipv6_exts >= MAX_IPV6_EXTS) {
+            ofp_fatal(0, "--ipv6-ext: at most %d extension headers",
+                      MAX_IPV6_EXTS);
+        }
+        ipv6_exts[n_ipv6_exts++] = ext;
+    }
+    free(copy);
+    ipv6 = true;
+}
+
+static void
+parse_options(int argc, char *argv[])
+{
+    enum {
+        OPT_FLOWS = UCHAR_MAX + 1,
+        OPT_TCP,
+        OPT_IPV6,
+        OPT_IPV6_EXT,
+        OPT_VLAN,
+        OPT_MPLS,
+        OPT_WAIT,
+        OPT_BURST,
+        OPT_PID
+    };
+    static struct option long_options[] = {
+        {"rate", required_argument, 0, 'r'},
+        {"count", required_argument, 0, 'n'},
+        {"duration", required_argument, 0, 'd'},
+        {"size", required_argument, 0, 's'},
+        {"flows", required_argument, 0, OPT_FLOWS},
+        {"tcp", no_argument, 0, OPT_TCP},
+        {"ipv6", no_argument, 0, OPT_IPV6},
+        {"ipv6-ext", required_argument, 0, OPT_IPV6_EXT},
+        {"vlan", required_argument, 0, OPT_VLAN},
+        {"mpls", required_argument, 0, OPT_MPLS},
+        {"wait", required_argument, 0, OPT_WAIT},
+        {"burst", required_argument, 0, OPT_BURST},
+        {"pid", required_argument, 0, OPT_PID},
+        {"verbose", optional_argument, 0, 'v'},
+        {"help", no_argument, 0, 'h'},
+        {"version", no_argument, 0, 'V'},
+        {0, 0, 0, 0},
+    };
+    char *short_options = long_options_to_short_options(long_options);
+
+    for (;;) {
+        uint32_t values[MAX_TAGS];
+        size_t i;
+        int c;
+
+        c = getopt_long(argc, argv, short_options, long_options, NULL);
+        if (c == -1) {
+            break;
+        }
+
+        switch (c) {
+        case 'r':
+            rate = parse_number("--rate", optarg);
+            break;
+
+        case 'n':
+            count = parse_number("--count", optarg);
+            if (count > PKTGEN_MAX_COUNT) {
+                ofp_fatal(0, "--count may be at most %"PRIu32,
+                          PKTGEN_MAX_COUNT);
+            }
+            break;
+
+        case 'd':
+            duration = parse_number("--duration", optarg);
+            break;
+
+        case 's':
+            parse_size(optarg);
+            break;
+
+        case OPT_FLOWS:
+            n_flows = parse_number("--flows", optarg);
+            if (!n_flows) {
+                ofp_fatal(0, "--flows must be at least 1");
+            }
+            break;
+
+        case OPT_TCP:
+            tcp = true;
+            break;
+
+        case OPT_IPV6:
+            ipv6 = true;
+            break;
+
+        case OPT_IPV6_EXT:
+            parse_ipv6_exts(optarg);
+            break;
+
+        case OPT_VLAN:
+            n_vlans = parse_list("--vlan", optarg, values, VLAN_VID_MAX);
+            for (i = 0; i < n_vlans; i++) {
+                vlans[i] = values[i];
+            }
+            break;
+
+        case OPT_MPLS:
+            n_mpls_labels = parse_list("--mpls", optarg, mpls_labels,
+                                       MPLS_LABEL_MAX);
+            break;
+
+        case OPT_WAIT:
+            wait_ms = parse_number("--wait", optarg);
+            break;
+
+        case OPT_BURST:
+            burst = parse_number("--burst", optarg);
+            if (!burst || burst > PKTGEN_MAX_BURST) {
+                ofp_fatal(0, "--burst must be between 1 and %d",
+                          PKTGEN_MAX_BURST);
+            }
+            break;
+
+        case OPT_PID:
+            cpu_pid = parse_number("--pid", optarg);
+            if (cpu_pid <= 0) {
+                ofp_fatal(0, "--pid: invalid value \"%s\"", optarg);
+            }
+            process_cpu_usec(cpu_pid);
+            break;
+
+        case 'h':
+            usage();
+
+        case 'V':
+            printf("%s %s compiled "__DATE__" "__TIME__"\n",
+                   program_name, VERSION BUILDNR);
+            exit(EXIT_SUCCESS);
+
+        case 'v':
+            vlog_set_verbosity(optarg);
+            break;
+
+        case '?':
+            exit(EXIT_FAILURE);
+
+        default:
+            abort();
+        }
+    }
+    free(short_options);
+}
+
+static void
+usage(void)
+{
+    printf("%s: traffic generator and latency probe\n"
+           "usage: %s [OPTIONS] TX-NETDEV RX-NETDEV\n"
+           "Sends frames on TX-NETDEV and receives them back on RX-NETDEV.\n",
+           program_name, program_name);
+    vlog_usage();
+    printf("\nOptions:\n"
+           "  -r, --rate=PPS              send PPS frames per second\n"
+           "                              (default: as fast as possible)\n"
+           "  -n, --count=N               send N frames (default: 100000)\n"
+           "  -d, --duration=SECS         send for SECS seconds instead\n"
+           "  -s, --size=BYTES[-BYTES]    frame size or range (default: the\n"
+           "                              smallest that fits, at least 60)\n"
+           "  --flows=N                   vary the 5-tuple over N flows\n"
+           "  --tcp                       send TCP instead of UDP\n"
+           "  --ipv6                      send IPv6 instead of IPv4\n"
+           "  --ipv6-ext=EXT[,EXT...]     add IPv6 extension headers, each\n"
+           "                              one of hop, dst, rt or frag\n"
+           "  --vlan=VID[,VID...]         push 802.1Q tags, outermost first\n"
+           "  --mpls=LABEL[,LABEL...]     push MPLS labels, outermost first\n"
+           "  --wait=MS                   receive for MS ms after the last\n"
+           "                              frame is sent (default: 500)\n"
+           "  --burst=N                   send N frames back to back\n"
+           "                              (default: 32)\n"
+           "  --pid=PID                   report the CPU time process PID\n"
+           "                              uses per frame received\n"
+           "  -h, --help                  display this help message\n"
+           "  -V, --version               display version information\n");
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,293 @@
+/* Copyright (c) 2008 The Board of Trustees of The Leland Stanford
+ * Junior University
+ *
+ * We are making the OpenFlow specification and associated documentation
+ * (Software) available for public use and benefit with the expectation
+ * that others will use, modify and enhance the Software and contribute
+ * those enhancements back to the community. However, since we would
+ * like to make the Software available for broadest use, with as few
+ * restrictions as possible permission is hereby granted, free of
+ * charge, to any person obtaining a copy of this Software to deal in
+ * the Software under the copyrights without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * The name and trademarks of copyright holder(s) may NOT be used in
+ * advertising or publicity pertaining to the Software or any
+ * derivatives without specific, written prior permission.
+ */
+
+#include <config.h>
+#include <errno.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "command-line.h"
+#include "compiler.h"
+#include "poll-loop.h"
+#include "stats-shm.h"
+#include "timeval.h"
+#include "util.h"
+
+#include "vlog.h"
+#define LOG_MODULE VLM_ofp_stats
+
+/* Kinds of statistics to print, as bits of (1 << enum stats_shm_type). */
+static unsigned int types;
+
+/* -i, --interval: milliseconds between reads, 0 to read once. */
+static unsigned int interval;
+
+/* -c, --count: number of reads with --interval, 0 for no limit. */
+static unsigned int count;
+
+static const char *type_names[STATS_SHM_N_TYPES] = {
+    "ports", "queues", "tables", "groups", "meters", "cookies"
+};
+
+static void parse_options(int argc, char *argv[]);
+static void usage(void) NO_RETURN;
+
+static void
+print_header(const struct stats_shm_snapshot *snap)
+{
+    time_t secs = snap->time / 1000;
+    long long int age = time_wall_msec() - snap->time;
+    char buf[32];
+
+    strftime(buf, sizeof buf, "%Y-%m-%d %H:%M:%S", localtime(&secs));
+    printf("datapath %012"PRIx64" at %s.%03lld, updated every %u ms",
+           snap->datapath_id, buf, snap->time % 1000, snap->interval);
+    if (age > 3 * snap->interval + 1000) {
+        printf(" (stale for %lld s)", age / 1000);
+    }
+    putchar('\n');
+}
+
+static void
+print_snapshot(const struct stats_shm_snapshot *snap)
+{
+    size_t i;
+
+    print_header(snap);
+    if (types & (1u << STATS_SHM_PORTS)) {
+        for (i = 0; i < snap->n_ports; i++) {
+            const struct stats_shm_port *p = &snap->ports[i];
+
+            printf("  port %"PRIu32": rx pkts=%"PRIu64", bytes=%"PRIu64", "
+                   "drop=%"PRIu64", errs=%"PRIu64", frame=%"PRIu64", "
+                   "over=%"PRIu64", crc=%"PRIu64"\n"
+                   "           tx pkts=%"PRIu64", bytes=%"PRIu64", "
+                   "drop=%"PRIu64", errs=%"PRIu64", coll=%"PRIu64"\n",
+                   p->port_no, p->rx_packets, p->rx_bytes, p->rx_dropped,
+                   p->rx_errors, p->rx_frame_err, p->rx_over_err,
+                   p->rx_crc_err, p->tx_packets, p->tx_bytes, p->tx_dropped,
+                   p->tx_errors, p->collisions);
+        }
+    }
+    if (types & (1u << STATS_SHM_QUEUES)) {
+        for (i = 0; i < snap->n_queues; i++) {
+            const struct stats_shm_queue *q = &snap->queues[i];
+
+            printf("  queue %"PRIu32" of port %"PRIu32": tx pkts=%"PRIu64", "
+                   "bytes=%"PRIu64", errs=%"PRIu64"\n",
+                   q->queue_id, q->port_no, q->tx_packets, q->tx_bytes,
+                   q->tx_errors);
+        }
+    }
+    if (types & (1u << STATS_SHM_TABLES)) {
+        for (i = 0; i < snap->n_tables; i++) {
+            const struct stats_shm_table *t = &snap->tables[i];
+
+            /* Most tables are never used; only list those that are. */
+            if (t->active_count || t->lookup_count) {
+                printf("  table %"PRIu8": active=%"PRIu32", "
+                       "lookups=%"PRIu64", matched=%"PRIu64"\n",
+                       t->table_id, t->active_count, t->lookup_count,
+                       t->matched_count);
+            }
+        }
+    }
+    if (types & (1u << STATS_SHM_GROUPS)) {
+        for (i = 0; i < snap->n_groups; i++) {
+            const struct stats_shm_group *g = &snap->groups[i];
+
+            printf("  group %"PRIu32": refs=%"PRIu32", pkts=%"PRIu64", "
+                   "bytes=%"PRIu64"\n",
+                   g->group_id, g->ref_count, g->packet_count, g->byte_count);
+        }
+    }
+    if (types & (1u << STATS_SHM_METERS)) {
+        for (i = 0; i < snap->n_meters; i++) {
+            const struct stats_shm_meter *m = &snap->meters[i];
+
+            printf("  meter %"PRIu32": flows=%"PRIu32", pkts=%"PRIu64", "
+                   "bytes=%"PRIu64"\n",
+                   m->meter_id, m->flow_count, m->packet_in_count,
+                   m->byte_in_count);
+        }
+    }
+    if (types & (1u << STATS_SHM_COOKIES)) {
+        for (i = 0; i < snap->n_cookies; i++) {
+            const struct stats_shm_cookie *c = &snap->cookies[i];
+
+            printf("  cookie 0x%"PRIx64": flows=%"PRIu64", pkts=%"PRIu64", "
+                   "bytes=%"PRIu64"\n",
+                   c->cookie, c->n_flows, c->packet_count, c->byte_count);
+        }
+    }
+    fflush(stdout);
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct stats_shm_reader *reader;
+    unsigned int n_reads;
+    int error;
+    int i;
+
+    set_program_name(argv[0]);
+    time_init();
+    vlog_init();
+    parse_options(argc, argv);
+
+    argc -= optind;
+    argv += optind;
+    if (argc < 1) {
+        ofp_fatal(0, "need at least one non-option argument; "
+                  "use --help for usage");
+    }
+    for (i = 1; i < argc; i++) {
+        int j;
+
+        for (j = 0; j < STATS_SHM_N_TYPES; j++) {
+            if (!strcmp(argv[i], type_names[j])) {
+                types |= 1u << j;
+                break;
+            }
+        }
+        if (j >= STATS_SHM_N_TYPES) {
+            ofp_fatal(0, "unknown statistics \"%s\"; use --help for usage",
+                      argv[i]);
+        }
+    }
+    if (!types) {
+        types = (1u << STATS_SHM_N_TYPES) - 1;
+    }
+
+    error = stats_shm_open(argv[0], &reader);
+    if (error) {
+        ofp_fatal(error, "%s: failed to open", argv[0]);
+    }
+
+    for (n_reads = 0; ; ) {
+        struct stats_shm_snapshot snap;
+
+        error = stats_shm_read(reader, &snap);
+        if (!error) {
+            print_snapshot(&snap);
+            stats_shm_snapshot_destroy(&snap);
+        } else if (!interval || error != EAGAIN) {
+            ofp_fatal(error, "%s: failed to read statistics", argv[0]);
+        }
+
+        if (!interval || (count && ++n_reads >= count)) {
+            break;
+        }
+        poll_timer_wait(interval);
+        poll_block();
+    }
+
+    stats_shm_close(reader);
+    return EXIT_SUCCESS;
+}
+
+static void
+parse_options(int argc, char *argv[])
+{
+    static struct option long_options[] = {
+        {"interval", required_argument, 0, 'i'},
+        {"count", required_argument, 0, 'c'},
+        {"verbose", optional_argument, 0, 'v'},
+        {"help", no_argument, 0, 'h'},
+        {"version", no_argument, 0, 'V'},
+        {0, 0, 0, 0},
+    };
+    char *short_options = long_options_to_short_options(long_options);
+
+    for (;;) {
+        int c;
+
+        c = getopt_long(argc, argv, short_options, long_options, NULL);
+        if (c == -1) {
+            break;
+        }
+
+        switch (c) {
+        case 'i':
+            interval = atoi(optarg);
+            break;
+
+        case 'c':
+            count = atoi(optarg);
+            break;
+
+        case 'h':
+            usage();
+
+        case 'V':
+            printf("%s %s compiled "__DATE__" "__TIME__"\n",
+                   program_name, VERSION BUILDNR);
+            exit(EXIT_SUCCESS);
+
+        case 'v':
+            vlog_set_verbosity(optarg);
+            break;
+
+        case '?':
+            exit(EXIT_FAILURE);
+
+        default:
+            abort();
+        }
+    }
+    free(short_options);
+}
+
+static void
+usage(void)
+{
+    printf("%s: reads datapath statistics from shared memory\n"
+           "usage: %s [OPTIONS] FILE [STATS...]\n"
+           "where FILE was given to ofdatapath --stats-shm and each STATS\n"
+           "is one of ports, queues, tables, groups, meters or cookies\n"
+           "(default: all).\n",
+           program_name, program_name);
+    vlog_usage();
+    printf("\nOptions:\n"
+           "  -i, --interval=MS           read every MS ms until killed\n"
+           "  -c, --count=N               with -i, read N times\n"
+           "  -h, --help                  display this help message\n"
+           "  -V, --version               display version information\n");
+    exit(EXIT_SUCCESS);
+}